@@ -0,0 +1,144 @@
+// Library agent benchmark.
+//
+// Serves a generated vault from an AgentServer on its own thread and
+// measures, over the Unix domain socket: the round trip of one lookup at a
+// time from a single client (latency percentiles), then the throughput of
+// many concurrent clients, each waiting for every answer and then keeping
+// several requests in flight.
+//
+// Options: --entries N, --clients N, --requests N (per client), --depth N, --socket <path>
+
+#include "../src/agent_protocol.h"
+#include "../src/agent_server.h"
+#include "../src/password_generator.h"
+#include "../src/vault.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+
+static double Milliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string ServiceName(int i) { return "service" + std::to_string(i) + ".example.com"; }
+
+// Lookups of random entries, depth requests in flight; false on a wrong answer.
+// With depth 1, latencies gets the round trip of each.
+static bool RunClient(const char* socketPath, int entries, int requests, int depth, unsigned seed,
+                      std::vector<double>* latencies) {
+    AgentClient client;
+    if (!client.connect(socketPath)) return false;
+    std::mt19937 rng(seed);
+    AgentStatus status;
+    std::string reply;
+    int sent = 0, received = 0;
+    while (received < requests) {
+        auto start = std::chrono::steady_clock::now();
+        while (sent < requests && sent - received < depth) {
+            if (!client.send(AGENT_LOOKUP, ServiceName((int)(rng() % entries)))) return false;
+            sent++;
+        }
+        if (!client.receive(status, reply) || status != AGENT_OK || reply.size() != 16) return false;
+        if (latencies) latencies->push_back(Milliseconds(start) * 1000.0);
+        received++;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int entries = 100000;
+    int clients = 32;
+    int requests = 20000;
+    int depth = 16;
+    std::string socketPath = "/tmp/passgen_agent_bench.sock";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--entries") && i + 1 < argc) entries = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--clients") && i + 1 < argc) clients = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--requests") && i + 1 < argc) requests = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc) depth = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--socket") && i + 1 < argc) socketPath = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--entries N] [--clients N] [--requests N] [--depth N] [--socket path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Vault vault;
+    PasswordGenerator generator;
+    for (int i = 0; i < entries; i++) vault.append(ServiceName(i), generator.generate(16), 0);
+    AgentServer server;
+    auto start = std::chrono::steady_clock::now();
+    if (!server.load(vault)) {
+        fprintf(stderr, "ERROR: cannot allocate memory for %d entries\n", entries);
+        return 1;
+    }
+    printf("%d entries loaded in %.1f ms (%s)\n", entries, Milliseconds(start),
+           server.secretsLocked() ? "locked" : "not locked: over the mlock limit");
+    if (!server.listen(socketPath.c_str())) {
+        fprintf(stderr, "ERROR: cannot listen on %s: %s\n", socketPath.c_str(), strerror(errno));
+        return 1;
+    }
+    std::atomic<bool> stop(false);
+    std::thread serving([&] {
+        while (!stop.load() && server.run()) {}
+    });
+
+    // One caller, one request at a time
+    std::vector<double> latencies;
+    latencies.reserve(requests);
+    RunClient(socketPath.c_str(), entries, std::min(requests, 1000), 1, 1, nullptr);  // Warm up
+    start = std::chrono::steady_clock::now();
+    bool ok = RunClient(socketPath.c_str(), entries, requests, 1, 2, &latencies);
+    double ms = Milliseconds(start);
+    std::sort(latencies.begin(), latencies.end());
+    if (ok) {
+        printf("1 client, round trips    %9.0f req/s  p50 %.1f us  p99 %.1f us  max %.1f us\n", requests / ms * 1000.0,
+               latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back());
+    }
+
+    for (int inFlight : {1, depth}) {
+        std::atomic<int> failures(0);
+        std::vector<std::thread> threads;
+        start = std::chrono::steady_clock::now();
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back([&, c] {
+                if (!RunClient(socketPath.c_str(), entries, requests, inFlight, 100 + c, nullptr)) failures++;
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        ms = Milliseconds(start);
+        ok = ok && failures == 0;
+        printf("%d clients, depth %-3d    %9.0f req/s  (%d requests in %.0f ms)\n", clients, inFlight,
+               (double)clients * requests / ms * 1000.0, clients * requests, ms);
+    }
+
+    stop = true;
+    server.wake();
+    serving.join();
+    printf("%llu requests served, %u hardware threads\n", (unsigned long long)server.served,
+           std::thread::hardware_concurrency());
+    server.close();
+    if (!ok) {
+        fprintf(stderr, "ERROR: wrong or missing answers\n");
+        return 1;
+    }
+    return 0;
+}
+
+#else
+
+int main() {
+    fprintf(stderr, "ERROR: the agent needs Linux (epoll, SO_PEERCRED)\n");
+    return 1;
+}
+
+#endif
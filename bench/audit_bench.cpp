@@ -0,0 +1,120 @@
+// Full-library audit benchmark.
+//
+// Fills a vault (default 1M entries, with some reused passwords and a
+// spread of ages) and runs the strength, breach, reuse and age checks
+// through AuditPipeline at increasing thread counts, reporting the time to
+// a published snapshot, throughput and speedup over one thread. Then it
+// edits one entry and times the re-audit, and reports the longest time the
+// calling (UI) thread spent inside update().
+//
+// Options: --entries N, --threads N (default 1, 2, 4, ... up to the core
+//          count), --breach <breach_corpus.bin> [--filter <breach_corpus.filter>]
+
+#include "../src/audit_checks.h"
+#include "../src/password_generator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct AuditTiming {
+    double totalMs;     // update() that started the audit until the snapshot is published
+    double maxUpdateMs; // Longest single update() call
+};
+
+// Poll like the UI does, with a short sleep standing in for the rest of a frame
+static AuditTiming AuditUntilPublished(AuditPipeline& pipeline, const Vault& vault) {
+    AuditTiming timing = {0.0, 0.0};
+    auto start = std::chrono::steady_clock::now();
+    for (;;) {
+        auto before = std::chrono::steady_clock::now();
+        pipeline.update(vault);
+        double updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before).count();
+        if (updateMs > timing.maxUpdateMs) timing.maxUpdateMs = updateMs;
+        if (!pipeline.busy() && pipeline.snapshot().valid && pipeline.snapshot().revision == vault.revision) break;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    timing.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return timing;
+}
+
+int main(int argc, char** argv) {
+    int entries = 1000000;
+    std::vector<int> threadCounts;
+    const char* breachPath = nullptr;
+    const char* filterPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--entries") && i + 1 < argc) entries = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threadCounts.push_back(std::max(1, atoi(argv[++i])));
+        else if (!strcmp(argv[i], "--breach") && i + 1 < argc) breachPath = argv[++i];
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filterPath = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--entries N] [--threads N]... [--breach corpus.bin [--filter corpus.filter]]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threadCounts.empty()) {
+        int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+        for (int t = 1; t < cores; t *= 2) threadCounts.push_back(t);
+        threadCounts.push_back(cores);
+    }
+
+    BreachDb breachDb;
+    if (breachPath && !breachDb.open(breachPath)) {
+        fprintf(stderr, "ERROR: %s is not a breach corpus file\n", breachPath);
+        return 1;
+    }
+    if (filterPath && !breachDb.loadFilter(filterPath)) {
+        fprintf(stderr, "ERROR: %s is not a filter for %s\n", filterPath, breachPath);
+        return 1;
+    }
+
+    // Every 50th entry reuses an earlier password; ages spread over three years
+    Vault vault;
+    PasswordGenerator generator;
+    std::mt19937 rng(1);
+    int64_t now = (int64_t)time(nullptr);
+    for (int i = 0; i < entries; i++) {
+        vault.serviceNames.push_back("service");
+        vault.passwords.push_back(i % 50 == 49 ? vault.passwords[rng() % i] : generator.generate(8 + (int)(rng() % 12)));
+        vault.modifiedAt.push_back(now - (int64_t)(rng() % (3 * 365)) * 86400);
+    }
+    vault.revision = 1;
+
+    printf("entries: %d, breach corpus: %s, cores: %u\n\n", entries,
+           breachDb.isOpen() ? (breachDb.hasFilter() ? "yes (filtered)" : "yes") : "no", std::thread::hardware_concurrency());
+    printf("threads  full audit ms  Mentries/s  speedup  re-audit ms  max update ms\n");
+
+    double baseline = 0.0;
+    for (int threads : threadCounts) {
+        AuditPipeline pipeline(threads);
+        AddLibraryAudits(pipeline, breachDb);
+        AuditTiming full = AuditUntilPublished(pipeline, vault);
+
+        // One edit: the reuse index only re-indexes the changed entry
+        pipeline.beginVaultChange();
+        vault.setPassword(entries / 2, generator.generate(16));
+        vault.revision++;
+        pipeline.endVaultChange();
+        AuditTiming edit = AuditUntilPublished(pipeline, vault);
+
+        if (baseline == 0.0) baseline = full.totalMs;
+        printf("%7d  %13.1f  %10.2f  %6.2fx  %11.1f  %13.2f\n", threads, full.totalMs, entries / full.totalMs / 1000.0,
+               baseline / full.totalMs, edit.totalMs, std::max(full.maxUpdateMs, edit.maxUpdateMs));
+
+        if (threads == threadCounts.back()) {
+            const AuditSnapshot& s = pipeline.snapshot();
+            size_t weak = 0, breached = 0, reused = 0, stale = 0;
+            for (size_t i = 0; i < s.columns[AUDIT_STRENGTH].size(); i++) {
+                weak += s.columns[AUDIT_STRENGTH][i] == STRENGTH_WEAK;
+                breached += s.columns[AUDIT_BREACH][i] == BREACH_FOUND;
+                reused += s.columns[AUDIT_REUSE][i] != REUSE_NONE;
+                stale += s.columns[AUDIT_AGE][i] == AGE_STALE;
+            }
+            printf("\nweak: %zu, breached: %zu, reused or near-duplicate: %zu, stale: %zu\n", weak, breached, reused, stale);
+        }
+    }
+    return 0;
+}
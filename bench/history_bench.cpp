@@ -0,0 +1,148 @@
+// Entry history benchmark.
+//
+// Builds a vault (default 20k entries) whose journal holds a history of the
+// given depths for every entry (default 0, 10 and 50 versions: each version
+// a regenerated password, every fifth a rename), then reports per depth:
+// journal size and bytes per version, open time with the lazy history index
+// next to an eager decode of every version, index memory and process peak
+// RSS, latency of previousVersion() for the latest version, and the time to
+// compact the journal down to the retention limit.
+//
+// Options: --entries N, --depths a,b,c, --dir <temp directory>
+
+#include "../src/password_generator.h"
+#include "../src/vault.h"
+#include "../src/vault_journal.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <sys/resource.h>
+#endif
+
+static double Milliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Peak resident set of the process in MB, 0 where unavailable
+static double PeakRssMb() {
+#if !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss / 1024.0;
+#endif
+    return 0.0;
+}
+
+int main(int argc, char** argv) {
+    int entries = 20000;
+    std::vector<int> depths = {0, 10, 50};
+    std::string dir = "/tmp";
+    if (const char* temp = getenv("TEMP")) dir = temp;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--entries") && i + 1 < argc) entries = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--depths") && i + 1 < argc) {
+            depths.clear();
+            for (const char* p = argv[++i]; *p; p = strchr(p, ',') ? strchr(p, ',') + 1 : p + strlen(p)) {
+                depths.push_back(std::max(0, atoi(p)));
+            }
+        } else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--entries N] [--depths a,b,c] [--dir temp-directory]\n", argv[0]);
+            return 1;
+        }
+    }
+    std::string vaultPath = dir + "/history_bench.dat";
+    std::string journalPath = journalPathFor(vaultPath);
+    printf("entries: %d, retention %zu versions\n\n", entries, VaultJournal::DEFAULT_HISTORY_LIMIT);
+
+    PasswordGenerator generator;
+    for (int depth : depths) {
+        remove(journalPath.c_str());
+        Vault vault;
+        std::mt19937 rng(7);
+        for (int i = 0; i < entries; i++) {
+            vault.append("service" + std::to_string(i) + ".example.com", generator.generate(16), 1000);
+        }
+        if (!saveVault(vault, vaultPath.c_str())) {
+            fprintf(stderr, "ERROR: cannot write %s\n", vaultPath.c_str());
+            return 1;
+        }
+
+        // One batch per generation of versions; the vault keeps the latest
+        {
+            VaultJournal journal;
+            Vault current;
+            loadVault(current, vaultPath.c_str());
+            journal.open(current, journalPath.c_str());
+            for (int d = 0; d < depth; d++) {
+                for (int i = 0; i < entries; i++) {
+                    std::string name = vault.serviceNames[i];
+                    if (rng() % 5 == 0) name = "service" + std::to_string(i) + ".example.com (v" + std::to_string(d) + ")";
+                    std::string password = generator.generate(16);
+                    journal.addHistory(vault.serviceNames[i], vault.passwords[i], 1000 + d, name, password);
+                    vault.serviceNames[i] = name;
+                    vault.passwords[i] = password;
+                }
+                journal.commit();
+            }
+            // The vault file gets the latest versions, the journal keeps all of them
+            saveVault(vault, vaultPath.c_str());
+            journal.setHistoryLimit(SIZE_MAX);
+            journal.reset(vault);
+        }
+        double journalMb = std::filesystem::file_size(journalPath) / 1e6;
+
+        Vault loaded;
+        VaultJournal journal;
+        auto start = std::chrono::steady_clock::now();
+        bool ok = loadVault(loaded, vaultPath.c_str()) && journal.open(loaded, journalPath.c_str());
+        double openMs = Milliseconds(start);
+        double rssAfterOpen = PeakRssMb();
+
+        HistoryVersion version;
+        start = std::chrono::steady_clock::now();
+        size_t latest = 0;
+        for (size_t i = 0; i < loaded.size(); i++) {
+            latest += journal.previousVersion(loaded.serviceNames[i], loaded.passwords[i], version);
+        }
+        double latestUs = loaded.size() ? Milliseconds(start) * 1000.0 / loaded.size() : 0.0;
+
+        // What loading every version at startup would cost
+        start = std::chrono::steady_clock::now();
+        size_t decoded = 0;
+        for (size_t i = 0; i < loaded.size(); i++) {
+            std::string name = loaded.serviceNames[i], password = loaded.passwords[i];
+            while (decoded < journal.historySize() && journal.previousVersion(name, password, version)) {
+                name = version.serviceName;
+                password = version.password;
+                decoded++;
+            }
+        }
+        double eagerMs = Milliseconds(start);
+        ok = ok && latest == (depth > 0 ? loaded.size() : 0) && decoded == journal.historySize();
+
+        size_t indexBytes = journal.historyIndexBytes();
+        size_t versions = journal.historySize();
+        start = std::chrono::steady_clock::now();
+        ok = journal.reset(loaded) && ok;
+        double compactMs = Milliseconds(start);
+        double compactedMb = std::filesystem::file_size(journalPath) / 1e6;
+
+        printf("depth %d: %zu versions, journal %.2f MB (%.0f B/version)%s\n", depth, versions, journalMb,
+               versions ? journalMb * 1e6 / versions : 0.0, ok ? "" : "  MISMATCH");
+        printf("  open %8.1f ms lazy, eager decode of all versions +%.1f ms\n", openMs, eagerMs);
+        printf("  index %6.2f MB, peak RSS %.1f MB\n", indexBytes / 1e6, rssAfterOpen);
+        printf("  latest version %5.2f us/entry\n", latestUs);
+        printf("  compact %8.1f ms -> %.2f MB, %zu versions kept\n\n", compactMs, compactedMb, journal.historySize());
+    }
+    remove(vaultPath.c_str());
+    remove(journalPath.c_str());
+    return 0;
+}
@@ -0,0 +1,186 @@
+// Streaming import benchmark.
+//
+// Writes a synthetic Bitwarden-style export (default 1M rows, CSV and JSON,
+// with quoted notes containing separators and line breaks) to the temp
+// directory, then for each format reports:
+//   scan   - field scanner throughput, SSE2 vs scalar (CSV only)
+//   parse  - parser alone, entries discarded: MB/s and peak RSS growth, which
+//            stays flat however large the export is
+//   import - into an empty vault with the journal as one commit: MB/s and
+//            peak RSS growth (mostly the imported entries themselves)
+//   replay - reopening the journal, as on the next start
+//
+// Options: --rows N, --dir <temp directory>
+// Peak RSS is read from /proc (Linux only).
+
+#include "../src/password_generator.h"
+#include "../src/vault_import.h"
+#include "../src/vault_journal.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Peak resident set in MB since the last ResetPeakRss(), 0 where unsupported
+static double PeakRssMb() {
+#if defined(__linux__)
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) return 0.0;
+    char line[256];
+    double kb = 0.0;
+    while (fgets(line, sizeof(line), status)) {
+        if (!strncmp(line, "VmHWM:", 6)) kb = atof(line + 6);
+    }
+    fclose(status);
+    return kb / 1024.0;
+#else
+    return 0.0;
+#endif
+}
+
+static void ResetPeakRss() {
+#if defined(__linux__)
+    if (FILE* refs = fopen("/proc/self/clear_refs", "w")) {
+        fputs("5", refs);
+        fclose(refs);
+    }
+#endif
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void WriteExports(const std::string& csvPath, const std::string& jsonPath, int rows) {
+    FILE* csv = fopen(csvPath.c_str(), "wb");
+    FILE* json = fopen(jsonPath.c_str(), "wb");
+    if (!csv || !json) {
+        fprintf(stderr, "ERROR: cannot write to the temp directory\n");
+        exit(1);
+    }
+    PasswordGenerator generator;
+    std::mt19937 rng(7);
+    fputs("folder,favorite,type,name,notes,fields,reprompt,login_uri,login_username,login_password,login_totp\n", csv);
+    fputs("{\"encrypted\":false,\"folders\":[],\"items\":[", json);
+    for (int i = 0; i < rows; i++) {
+        std::string password = generator.generate(10 + (int)(rng() % 15));
+        std::string quoted, escaped;
+        for (char c : password) {
+            if (c == '"') quoted += '"';
+            if (c == '"' || c == '\\') escaped += '\\';
+            quoted += c;
+            escaped += c;
+        }
+        bool notes = rng() % 4 == 0;
+        fprintf(csv, "%s,0,login,service-%d,%s,,0,https://service-%d.example.com/login,user%d@example.com,\"%s\",\n",
+                i % 10 == 0 ? "Work" : "", i, notes ? "\"Recovery codes, see \"\"vault\"\"\nline two\"" : "", i, i, quoted.c_str());
+        fprintf(json, "%s{\"id\":\"%08x-0000-4000-8000-%012d\",\"organizationId\":null,\"folderId\":null,\"type\":1,\"reprompt\":0,"
+                      "\"name\":\"service-%d\",\"notes\":%s,\"favorite\":false,\"login\":{\"uris\":[{\"match\":null,"
+                      "\"uri\":\"https://service-%d.example.com/login\"}],\"username\":\"user%d@example.com\",\"password\":\"%s\","
+                      "\"totp\":null},\"collectionIds\":null}",
+                i > 0 ? "," : "", (unsigned)rng(), i, i, notes ? "\"Recovery codes, see \\\"vault\\\"\\nline two\"" : "null", i, i,
+                escaped.c_str());
+    }
+    fputs("]}\n", json);
+    fclose(csv);
+    fclose(json);
+}
+
+static void ScanBench(const std::string& csvPath) {
+    FILE* in = fopen(csvPath.c_str(), "rb");
+    std::vector<char> data(64 << 20);
+    data.resize(fread(data.data(), 1, data.size(), in));
+    fclose(in);
+    const char* end = data.data() + data.size();
+
+    size_t hits[2] = {0, 0};
+    double seconds[2];
+    for (int simd = 0; simd < 2; simd++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < 4; repeat++) {
+            for (const char* p = data.data(); p < end; p++) {
+                p = simd ? findAnyOf(p, end, ',', '\n', '"') : findAnyOfScalar(p, end, ',', '\n', '"');
+                hits[simd] += p < end;
+            }
+        }
+        seconds[simd] = Seconds(start);
+    }
+    printf("  scan    scalar %7.0f MB/s   sse2 %7.0f MB/s   (%zu stops per pass%s)\n", 4 * data.size() / 1e6 / seconds[0],
+           4 * data.size() / 1e6 / seconds[1], hits[1] / 4, hits[0] == hits[1] ? "" : ", MISMATCH");
+}
+
+static void FormatBench(const char* label, const std::string& path, ImportFormat format, const std::string& dir) {
+    printf("%s\n", label);
+    if (format == IMPORT_CSV) ScanBench(path);
+
+    // Parse only
+    ResetPeakRss();
+    double baseline = PeakRssMb();
+    FILE* in = fopen(path.c_str(), "rb");
+    ImportResult parsed;
+    size_t entries = 0;
+    auto start = std::chrono::steady_clock::now();
+    parseExport(in, format, [&](std::string&, std::string&) { entries++; }, parsed);
+    double seconds = Seconds(start);
+    fclose(in);
+    printf("  parse   %7.1f MB/s  %9zu entries  peak RSS +%.1f MB\n", parsed.bytes / 1e6 / seconds, entries, PeakRssMb() - baseline);
+
+    // Import into an empty vault with a journal
+    std::string vaultPath = dir + "/import_bench.dat";
+    remove(vaultPath.c_str());
+    std::string journalPath = journalPathFor(vaultPath);
+    {
+        Vault vault;
+        VaultJournal journal;
+        journal.open(vault, journalPath.c_str());
+        ResetPeakRss();
+        baseline = PeakRssMb();
+        start = std::chrono::steady_clock::now();
+        ImportResult result = importVault(vault, &journal, path.c_str(), format);
+        seconds = Seconds(start);
+        if (!result.ok) {
+            fprintf(stderr, "ERROR: import failed: %s\n", result.error);
+            exit(1);
+        }
+        size_t payload = 0;
+        for (size_t i = 0; i < vault.size(); i++) payload += vault.serviceNames[i].size() + vault.passwords[i].size();
+        printf("  import  %7.1f MB/s  %9zu entries  peak RSS +%.1f MB (entry text %.1f MB), journal %.1f MB\n",
+               result.bytes / 1e6 / seconds, result.imported, PeakRssMb() - baseline, payload / 1e6, journal.size() / 1e6);
+    }
+
+    // Replay on the next start
+    Vault vault;
+    VaultJournal journal;
+    start = std::chrono::steady_clock::now();
+    journal.open(vault, journalPath.c_str());
+    printf("  replay  %7.1f ms     %9zu entries\n", Seconds(start) * 1000.0, vault.size());
+    journal.close();
+    remove(journalPath.c_str());
+}
+
+int main(int argc, char** argv) {
+    int rows = 1000000;
+    std::string dir = "/tmp";
+    if (const char* temp = getenv("TEMP")) dir = temp;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rows") && i + 1 < argc) rows = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--rows N] [--dir temp-directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::string csvPath = dir + "/import_bench.csv", jsonPath = dir + "/import_bench.json";
+    WriteExports(csvPath, jsonPath, rows);
+    printf("rows: %d\n\n", rows);
+    FormatBench("csv (Bitwarden)", csvPath, IMPORT_CSV, dir);
+    FormatBench("json (Bitwarden)", jsonPath, IMPORT_JSON, dir);
+    remove(csvPath.c_str());
+    remove(jsonPath.c_str());
+    return 0;
+}
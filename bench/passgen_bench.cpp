@@ -0,0 +1,678 @@
+// Micro-benchmark suite over the hot paths, in the style of Google Benchmark:
+// each case runs for a calibrated number of iterations (at least
+// --benchmark_min_time seconds) and reports time per iteration plus items
+// or bytes per second. Results can be written as JSON in Google Benchmark's
+// schema and compared against an earlier run to catch regressions:
+//
+//   passgen_bench --benchmark_out=base.json
+//   passgen_bench --benchmark_repetitions=5 --compare=base.json
+//
+// --compare lists the change of every case found in both runs (the median
+// when repeated) and exits with 1 if any got slower by more than
+// --regression_threshold percent (default 10).
+//
+// Cases: generation (single per length, batch), RNG engines, vault save and
+// load at 1k/100k/1M entries, encryption and segment compression
+// throughput, search (linear scan, merged index), strength scoring and
+// library startup. A build with -DPASSGEN_BENCH_UI (linking raylib, with
+// embedded_assets.h) adds text measurement and drawing, a library frame and
+// UI startup; those need a display, see bench/ui_bench.cpp.
+//
+// Options: --benchmark_filter=<regex>, --benchmark_min_time=<seconds>,
+//          --benchmark_repetitions=N, --benchmark_format=console|json,
+//          --benchmark_out=<file.json>, --benchmark_list_tests,
+//          --compare=<baseline.json>, --regression_threshold=<percent>,
+//          --dir=<temp directory>
+
+#include "../src/audit_checks.h"
+#include "../src/block_codec.h"
+#include "../src/password_generator.h"
+#include "../src/vault.h"
+#include "../src/vault_journal.h"
+#include "../src/vault_set.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(PASSGEN_BENCH_UI)
+    #include "raylib.h"
+    #include "embedded_assets.h"
+    #include "../src/app_ui.h"
+#endif
+
+// Timing of one run of a case: the loop while (state.keepRunning()) is
+// timed, setup before it is not
+class BenchState {
+private:
+    uint64_t total;
+    uint64_t remaining;
+    bool running = false;
+    std::chrono::steady_clock::time_point start;
+    std::clock_t cpuStart = 0;
+
+public:
+    double realNs = 0.0;
+    double cpuNs = 0.0;
+    double items = 0.0;  // Processed over all iterations, for items per second
+    double bytes = 0.0;
+    std::string error;
+
+    explicit BenchState(uint64_t iterations) : total(iterations), remaining(iterations) {}
+
+    uint64_t iterations() const { return total; }
+
+    bool keepRunning() {
+        if (remaining == total && !running) resumeTiming();
+        if (remaining > 0) {
+            remaining--;
+            return true;
+        }
+        pauseTiming();
+        return false;
+    }
+
+    void pauseTiming() {
+        if (!running) return;
+        realNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        cpuNs += (double)(std::clock() - cpuStart) * 1e9 / CLOCKS_PER_SEC;
+        running = false;
+    }
+
+    void resumeTiming() {
+        running = true;
+        cpuStart = std::clock();
+        start = std::chrono::steady_clock::now();
+    }
+
+    void setItemsProcessed(double count) { items = count; }
+    void setBytesProcessed(double count) { bytes = count; }
+    void skip(const char* reason) { error = reason; }
+};
+
+struct BenchCase {
+    std::string name;
+    std::function<void(BenchState&)> run;
+};
+
+struct BenchResult {
+    std::string name;
+    const char* aggregate = nullptr;  // Null for a single repetition
+    int repetition = 0;
+    uint64_t iterations = 0;
+    double realNs = 0.0, cpuNs = 0.0;  // Per iteration
+    double itemsPerSecond = 0.0, bytesPerSecond = 0.0;
+};
+
+static std::vector<BenchCase>& Cases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+static void Register(std::string name, std::function<void(BenchState&)> run) {
+    Cases().push_back({std::move(name), std::move(run)});
+}
+
+static std::string tempDir = "/tmp";
+static std::vector<std::string> fixtureFiles;  // Removed on exit
+
+// Shared inputs, built on first use
+
+static std::string FixtureName(std::mt19937& rng) {
+    static const char* sites[] = {"google", "github", "amazon", "netflix", "paypal", "dropbox", "spotify", "steam",
+                                  "linkedin", "reddit", "gitlab", "microsoft", "apple", "slack", "mybank", "airline"};
+    static const char* domains[] = {".com", ".com", ".org", ".net", ".io", ".de"};
+    std::string name = std::string(sites[rng() % 16]) + domains[rng() % 6];
+    if (rng() % 3 == 0) name = "user" + std::to_string(rng() % 50000) + "@" + name;
+    return name;
+}
+
+static Vault& FixtureVault(size_t entries) {
+    static std::map<size_t, std::unique_ptr<Vault>> vaults;
+    std::unique_ptr<Vault>& vault = vaults[entries];
+    if (!vault) {
+        vault.reset(new Vault());
+        PasswordGenerator generator;
+        std::mt19937 rng(42);
+        for (size_t i = 0; i < entries; i++) vault->append(FixtureName(rng), generator.generate(16), 0);
+    }
+    return *vault;
+}
+
+static const std::string& FixtureFile(size_t entries) {
+    static std::map<size_t, std::string> files;
+    std::string& path = files[entries];
+    if (path.empty()) {
+        path = tempDir + "/passgen_bench_" + std::to_string(entries) + ".dat";
+        remove(journalPathFor(path).c_str());
+        saveVault(FixtureVault(entries), path.c_str());
+        fixtureFiles.push_back(path);
+    }
+    return path;
+}
+
+static double FileBytes(const std::string& path) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    return error ? 0.0 : (double)size;
+}
+
+// Defeat dead-code elimination of a computed value
+static volatile uint64_t sink;
+
+static void RegisterCoreCases() {
+    for (int length : {12, 16, 32, 64}) {
+        Register("generate/length:" + std::to_string(length), [length](BenchState& state) {
+            PasswordGenerator generator;
+            while (state.keepRunning()) sink = sink + generator.generate(length).size();
+            state.setItemsProcessed((double)state.iterations());
+            state.setBytesProcessed((double)state.iterations() * length);
+        });
+    }
+    Register("generate/batch:1000/length:16", [](BenchState& state) {
+        PasswordGenerator generator;
+        std::vector<std::string> batch(1000);
+        while (state.keepRunning()) {
+            for (std::string& password : batch) password = generator.generate(16);
+            sink = sink + batch.back().size();
+        }
+        state.setItemsProcessed((double)state.iterations() * 1000);
+    });
+
+    // Picking 4096 characters of the generator's 70 with each engine
+    auto rngCase = [](const char* name, auto makeEngine) {
+        Register(std::string("rng/") + name, [makeEngine](BenchState& state) {
+            auto engine = makeEngine();
+            std::uniform_int_distribution<> pick(0, 69);
+            while (state.keepRunning()) {
+                uint64_t sum = 0;
+                for (int i = 0; i < 4096; i++) sum += pick(engine);
+                sink = sink + sum;
+            }
+            state.setItemsProcessed((double)state.iterations() * 4096);
+        });
+    };
+    rngCase("mt19937", [] { return std::mt19937(std::random_device()()); });
+    rngCase("mt19937_64", [] { return std::mt19937_64(std::random_device()()); });
+    rngCase("minstd_rand", [] { return std::minstd_rand(std::random_device()()); });
+    Register("rng/random_device", [](BenchState& state) {
+        std::random_device device;
+        std::uniform_int_distribution<> pick(0, 69);
+        while (state.keepRunning()) {
+            uint64_t sum = 0;
+            for (int i = 0; i < 4096; i++) sum += pick(device);
+            sink = sink + sum;
+        }
+        state.setItemsProcessed((double)state.iterations() * 4096);
+    });
+
+    for (size_t entries : {(size_t)1000, (size_t)100000, (size_t)1000000}) {
+        std::string suffix = "/entries:" + std::to_string(entries);
+        Register("vault/save" + suffix, [entries](BenchState& state) {
+            Vault& vault = FixtureVault(entries);
+            std::string path = tempDir + "/passgen_bench_save.dat";
+            while (state.keepRunning()) {
+                if (!saveVault(vault, path.c_str())) state.skip("cannot write the vault file");
+            }
+            state.setItemsProcessed((double)state.iterations() * entries);
+            state.setBytesProcessed((double)state.iterations() * FileBytes(path));
+            remove(path.c_str());
+        });
+        Register("vault/load" + suffix, [entries](BenchState& state) {
+            const std::string& path = FixtureFile(entries);
+            Vault vault;
+            while (state.keepRunning()) {
+                if (!loadVault(vault, path.c_str())) state.skip("cannot read the vault file");
+            }
+            state.setItemsProcessed((double)state.iterations() * entries);
+            state.setBytesProcessed((double)state.iterations() * FileBytes(path));
+        });
+    }
+
+    Register("encrypt/bytes:1048576", [](BenchState& state) {
+        std::string plain(1 << 20, 'x');
+        while (state.keepRunning()) sink = sink + (uint8_t)encrypt(plain)[4095];
+        state.setBytesProcessed((double)state.iterations() * plain.size());
+    });
+
+    // One 16 KB segment of service names and passwords, as the vault file has them
+    std::vector<uint8_t> segment;
+    {
+        PasswordGenerator generator;
+        std::mt19937 rng(7);
+        while (segment.size() < 16384) {
+            std::string line = FixtureName(rng) + "|" + generator.generate(16) + "\n";
+            segment.insert(segment.end(), line.begin(), line.end());
+        }
+    }
+    for (BlockCodec codec : {CODEC_LZ4, CODEC_ZSTD}) {
+        if (!codecAvailable(codec)) continue;
+        std::string name = codecName(codec);
+        Register("segment/compress/" + name, [codec, segment](BenchState& state) {
+            SegmentCodec segmentCodec;
+            segmentCodec.setup(codec, 0, trainDictionary(segment.data(), segment.size(), 4096));
+            std::vector<uint8_t> stored(segmentCodec.bound(segment.size()));
+            size_t storedSize = 0;
+            while (state.keepRunning()) sink = sink + segmentCodec.compress(segment.data(), segment.size(), stored.data(), storedSize);
+            state.setBytesProcessed((double)state.iterations() * segment.size());
+        });
+        Register("segment/decompress/" + name, [codec, segment](BenchState& state) {
+            SegmentCodec segmentCodec;
+            segmentCodec.setup(codec, 0, trainDictionary(segment.data(), segment.size(), 4096));
+            std::vector<uint8_t> stored(segmentCodec.bound(segment.size())), raw(segment.size());
+            size_t storedSize = 0;
+            BlockCodec used = segmentCodec.compress(segment.data(), segment.size(), stored.data(), storedSize);
+            while (state.keepRunning()) {
+                if (!segmentCodec.decompress(used, stored.data(), storedSize, raw.data(), raw.size())) state.skip("decompression failed");
+            }
+            state.setBytesProcessed((double)state.iterations() * segment.size());
+        });
+    }
+
+    Register("search/linear/entries:100000", [](BenchState& state) {
+        Vault& vault = FixtureVault(100000);
+        std::string query = lowerAscii("user4242@");
+        while (state.keepRunning()) {
+            size_t matches = 0;
+            for (const std::string& name : vault.serviceNames) matches += containsIgnoreCase(name, query);
+            sink = sink + matches;
+        }
+        state.setItemsProcessed((double)state.iterations() * vault.size());
+    });
+    Register("search/vault_set/entries:100000", [](BenchState& state) {
+        VaultSet set;
+        if (!set.open(FixtureFile(100000).c_str())) {
+            state.skip("cannot open the vault file");
+            return;
+        }
+        set.search("warm");  // Builds the merged index and fills the name cache
+        while (state.keepRunning()) sink = sink + set.search("user4242@").size();
+        state.setItemsProcessed((double)state.iterations() * set.entryCount(0));
+    });
+
+    Register("strength/entropy", [](BenchState& state) {
+        Vault& vault = FixtureVault(1000);
+        while (state.keepRunning()) {
+            double bits = 0.0;
+            for (const std::string& password : vault.passwords) bits += PasswordEntropyBits(password);
+            sink = sink + (uint64_t)bits;
+        }
+        state.setItemsProcessed((double)state.iterations() * vault.size());
+    });
+
+    // What the application does before its first frame, without the window
+    Register("startup/library/entries:100000", [](BenchState& state) {
+        const std::string& path = FixtureFile(100000);
+        std::string journalPath = journalPathFor(path);
+        while (state.keepRunning()) {
+            Vault vault;
+            if (!loadVault(vault, path.c_str()) || !VaultJournal::replay(vault, journalPath.c_str())) {
+                state.skip("cannot read the vault file");
+            }
+            sink = sink + vault.size();
+        }
+        state.setItemsProcessed((double)state.iterations() * 100000);
+    });
+}
+
+#if defined(PASSGEN_BENCH_UI)
+
+static UiFonts* uiFonts = nullptr;
+
+static void RegisterUiCases() {
+    static const char* text = "github.com (work) - admin";
+    Register("text/measure", [](BenchState& state) {
+        while (state.keepRunning()) sink = sink + (uint64_t)MeasureTextEx(uiFonts->font16, text, 16, 1.0f).x;
+        state.setItemsProcessed((double)state.iterations());
+    });
+    Register("text/measure_cached", [](BenchState& state) {
+        TextLayoutCache layout;
+        while (state.keepRunning()) sink = sink + (uint64_t)layout.measure(uiFonts->font16, text, 16).x;
+        state.setItemsProcessed((double)state.iterations());
+    });
+    Register("text/draw:32", [](BenchState& state) {
+        RenderTexture2D target = LoadRenderTexture(SCREEN_WIDTH, LIBRARY_VIEW_HEIGHT);
+        while (state.keepRunning()) {
+            BeginTextureMode(target);
+            for (int i = 0; i < 32; i++) DrawCrispText(uiFonts->font16, text, {10.0f, 10.0f + i * 12.0f}, 16, WHITE);
+            EndTextureMode();
+        }
+        UnloadRenderTexture(target);
+        state.setItemsProcessed((double)state.iterations() * 32);
+    });
+    Register("frame/library/entries:1000", [](BenchState& state) {
+        std::unique_ptr<AppState> app(new AppState());
+        app->persistLibrary = false;
+        app->useClipboard = false;
+        app->library = FixtureVault(1000);
+        app->showLibrary = true;
+        RenderTexture2D target = LoadRenderTexture(SCREEN_WIDTH, LIBRARY_VIEW_HEIGHT);
+        FrameInput input;
+        input.mouse = {200.0f, 220.0f};
+        while (state.keepRunning()) {
+            UpdateChrome(*app, *uiFonts);
+            BeginTextureMode(target);
+            UpdateAndDrawFrame(*app, *uiFonts, input);
+            EndTextureMode();
+        }
+        UnloadRenderTexture(target);
+        state.setItemsProcessed((double)state.iterations());
+    });
+    // Fonts, application state and the library: what main() and its startup loader do
+    Register("startup/ui/entries:100000", [](BenchState& state) {
+        std::string path = FixtureFile(100000);
+        while (state.keepRunning()) {
+            UiFonts fonts = LoadUiFonts(FONT_DATA, FONT_SIZE);
+            std::unique_ptr<AppState> app(new AppState());
+            app->vaultPath = path.c_str();
+            app->persistLibrary = false;
+            LoadLibrary(*app);
+            sink = sink + app->library.size();
+            app.reset();
+            UnloadUiFonts(fonts);
+        }
+        state.setItemsProcessed((double)state.iterations());
+    });
+}
+
+#endif
+
+// Run a case for enough iterations to fill minTime, like Google Benchmark:
+// grow tenfold while far off, then aim at 1.4x minTime
+static BenchResult RunCase(const BenchCase& benchCase, double minTime, std::string& error) {
+    uint64_t iterations = 1;
+    for (;;) {
+        BenchState state(iterations);
+        benchCase.run(state);
+        if (!state.error.empty()) {
+            error = state.error;
+            return BenchResult();
+        }
+        double seconds = state.realNs / 1e9;
+        if (seconds >= minTime || iterations >= 1000000000) {
+            BenchResult result;
+            result.name = benchCase.name;
+            result.iterations = iterations;
+            result.realNs = state.realNs / iterations;
+            result.cpuNs = state.cpuNs / iterations;
+            result.itemsPerSecond = seconds > 0.0 ? state.items / seconds : 0.0;
+            result.bytesPerSecond = seconds > 0.0 ? state.bytes / seconds : 0.0;
+            return result;
+        }
+        double multiplier = minTime * 1.4 / std::max(seconds, 1e-9);
+        if (seconds / minTime <= 0.1) multiplier = std::min(multiplier, 10.0);
+        iterations = std::max(iterations + 1, (uint64_t)std::min(iterations * multiplier, 1e9));
+    }
+}
+
+static BenchResult Aggregate(const std::vector<BenchResult>& runs, const char* name) {
+    BenchResult result = runs[0];
+    result.aggregate = name;
+    auto reduce = [&](double BenchResult::*field) {
+        std::vector<double> values;
+        for (const BenchResult& run : runs) values.push_back(run.*field);
+        std::sort(values.begin(), values.end());
+        double mean = 0.0;
+        for (double value : values) mean += value / values.size();
+        if (!strcmp(name, "mean")) return mean;
+        if (!strcmp(name, "median")) {
+            size_t middle = values.size() / 2;
+            return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+        }
+        double variance = 0.0;
+        for (double value : values) variance += (value - mean) * (value - mean) / std::max<size_t>(1, values.size() - 1);
+        return std::sqrt(variance);
+    };
+    result.realNs = reduce(&BenchResult::realNs);
+    result.cpuNs = reduce(&BenchResult::cpuNs);
+    result.itemsPerSecond = reduce(&BenchResult::itemsPerSecond);
+    result.bytesPerSecond = reduce(&BenchResult::bytesPerSecond);
+    return result;
+}
+
+static std::string DisplayName(const BenchResult& result) {
+    return result.aggregate ? result.name + "_" + result.aggregate : result.name;
+}
+
+static std::string FormatTime(double ns) {
+    char text[32];
+    if (ns < 1e3) snprintf(text, sizeof(text), "%.1f ns", ns);
+    else if (ns < 1e6) snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+    else if (ns < 1e9) snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+    else snprintf(text, sizeof(text), "%.3f s", ns / 1e9);
+    return text;
+}
+
+static void PrintConsole(const BenchResult& result) {
+    char rates[64] = "";
+    if (result.bytesPerSecond > 0.0) snprintf(rates, sizeof(rates), "%9.1f MB/s", result.bytesPerSecond / 1e6);
+    if (result.itemsPerSecond > 0.0) {
+        size_t used = strlen(rates);
+        snprintf(rates + used, sizeof(rates) - used, "%s%9.3g items/s", used ? "  " : "", result.itemsPerSecond);
+    }
+    printf("%-40s %12s %12s %11llu  %s\n", DisplayName(result).c_str(), FormatTime(result.realNs).c_str(),
+           FormatTime(result.cpuNs).c_str(), (unsigned long long)result.iterations, rates);
+    fflush(stdout);
+}
+
+static void WriteJson(FILE* out, const std::vector<BenchResult>& results, const char* executable, double minTime,
+                      int repetitions) {
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+#if defined(NDEBUG)
+    const char* buildType = "release";
+#else
+    const char* buildType = "debug";
+#endif
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n    \"executable\": \"%s\",\n", date, executable);
+    fprintf(out, "    \"num_cpus\": %u,\n    \"library_build_type\": \"%s\",\n", std::thread::hardware_concurrency(),
+            buildType);
+    fprintf(out, "    \"min_time\": %g,\n    \"repetitions\": %d\n  },\n  \"benchmarks\": [\n", minTime, repetitions);
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        fprintf(out, "    {\n      \"name\": \"%s\",\n      \"run_name\": \"%s\",\n", DisplayName(result).c_str(),
+                result.name.c_str());
+        if (result.aggregate) {
+            fprintf(out, "      \"run_type\": \"aggregate\",\n      \"aggregate_name\": \"%s\",\n", result.aggregate);
+        } else {
+            fprintf(out, "      \"run_type\": \"iteration\",\n      \"repetition_index\": %d,\n", result.repetition);
+        }
+        fprintf(out, "      \"repetitions\": %d,\n      \"iterations\": %llu,\n", repetitions,
+                (unsigned long long)result.iterations);
+        fprintf(out, "      \"real_time\": %.6e,\n      \"cpu_time\": %.6e,\n      \"time_unit\": \"ns\"", result.realNs,
+                result.cpuNs);
+        if (result.bytesPerSecond > 0.0) fprintf(out, ",\n      \"bytes_per_second\": %.6e", result.bytesPerSecond);
+        if (result.itemsPerSecond > 0.0) fprintf(out, ",\n      \"items_per_second\": %.6e", result.itemsPerSecond);
+        fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// real_time in ns of every case in a JSON file of this or Google Benchmark;
+// a case's median replaces its single runs
+static bool ReadBaseline(const char* path, std::map<std::string, double>& times) {
+    FILE* in = fopen(path, "rb");
+    if (!in) return false;
+    std::string json;
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) json.append(buffer, n);
+    fclose(in);
+
+    size_t at = 0;
+    while ((at = json.find("\"name\":", at)) != std::string::npos) {
+        size_t open = json.find('"', at + 7);
+        size_t close = open == std::string::npos ? open : json.find('"', open + 1);
+        if (close == std::string::npos) break;
+        std::string name = json.substr(open + 1, close - open - 1);
+        size_t next = json.find("\"name\":", close);
+        size_t timeAt = json.find("\"real_time\":", close);
+        at = close;
+        if (timeAt == std::string::npos || timeAt > next) continue;
+        double value = strtod(json.c_str() + timeAt + 12, nullptr);
+        size_t unitAt = json.find("\"time_unit\":", close);
+        if (unitAt != std::string::npos && unitAt < next) {
+            std::string unit = json.substr(unitAt + 12, 8);
+            if (unit.find("\"us\"") != std::string::npos) value *= 1e3;
+            else if (unit.find("\"ms\"") != std::string::npos) value *= 1e6;
+            else if (unit.find("\"s\"") != std::string::npos) value *= 1e9;
+        }
+        static const char medianSuffix[] = "_median";
+        size_t suffixLength = sizeof(medianSuffix) - 1;
+        if (name.size() > suffixLength && name.compare(name.size() - suffixLength, suffixLength, medianSuffix) == 0) {
+            times[name.substr(0, name.size() - suffixLength)] = value;
+        } else if (name.find("_mean") == std::string::npos && name.find("_stddev") == std::string::npos &&
+                   !times.count(name)) {
+            times[name] = value;
+        }
+    }
+    return true;
+}
+
+static const char* FlagValue(const char* arg, const char* flag) {
+    size_t length = strlen(flag);
+    return !strncmp(arg, flag, length) && arg[length] == '=' ? arg + length + 1 : nullptr;
+}
+
+int main(int argc, char** argv) {
+    std::string filter = ".*";
+    double minTime = 0.5;
+    int repetitions = 1;
+    bool json = false, list = false;
+    const char* outPath = nullptr;
+    const char* comparePath = nullptr;
+    double threshold = 10.0;
+    if (const char* temp = getenv("TEMP")) tempDir = temp;
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        if ((value = FlagValue(argv[i], "--benchmark_filter"))) filter = value;
+        else if ((value = FlagValue(argv[i], "--benchmark_min_time"))) minTime = std::max(0.001, atof(value));
+        else if ((value = FlagValue(argv[i], "--benchmark_repetitions"))) repetitions = std::max(1, atoi(value));
+        else if ((value = FlagValue(argv[i], "--benchmark_format"))) json = !strcmp(value, "json");
+        else if ((value = FlagValue(argv[i], "--benchmark_out"))) outPath = value;
+        else if ((value = FlagValue(argv[i], "--compare"))) comparePath = value;
+        else if ((value = FlagValue(argv[i], "--regression_threshold"))) threshold = atof(value);
+        else if ((value = FlagValue(argv[i], "--dir"))) tempDir = value;
+        else if (!strcmp(argv[i], "--benchmark_list_tests")) list = true;
+        else {
+            fprintf(stderr, "usage: %s [--benchmark_filter=regex] [--benchmark_min_time=seconds] [--benchmark_repetitions=N]\n"
+                            "       [--benchmark_format=console|json] [--benchmark_out=file.json] [--benchmark_list_tests]\n"
+                            "       [--compare=baseline.json] [--regression_threshold=percent] [--dir=temp-directory]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    std::map<std::string, double> baseline;
+    if (comparePath && !ReadBaseline(comparePath, baseline)) {
+        fprintf(stderr, "ERROR: cannot read %s\n", comparePath);
+        return 1;
+    }
+
+    RegisterCoreCases();
+#if defined(PASSGEN_BENCH_UI)
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    auto windowStart = std::chrono::steady_clock::now();
+    InitWindow(SCREEN_WIDTH, LIBRARY_VIEW_HEIGHT, "passgen_bench");
+    double windowMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - windowStart).count();
+    UiFonts fonts;
+    if (IsWindowReady()) {
+        fonts = LoadUiFonts(FONT_DATA, FONT_SIZE);
+        uiFonts = &fonts;
+        RegisterUiCases();
+        if (!json) printf("window created in %.1f ms\n", windowMs);
+    } else {
+        fprintf(stderr, "no window (no display?), UI cases skipped\n");
+    }
+#endif
+
+    std::regex pattern;
+    try {
+        pattern = std::regex(filter);
+    } catch (const std::regex_error&) {
+        fprintf(stderr, "ERROR: bad --benchmark_filter %s\n", filter.c_str());
+        return 1;
+    }
+
+    if (!json && !list) printf("%-40s %12s %12s %11s\n", "Benchmark", "Time", "CPU", "Iterations");
+    std::vector<BenchResult> results;
+    std::map<std::string, double> current;  // Median or single real time, for the comparison
+    for (const BenchCase& benchCase : Cases()) {
+        if (!std::regex_search(benchCase.name, pattern)) continue;
+        if (list) {
+            printf("%s\n", benchCase.name.c_str());
+            continue;
+        }
+        std::vector<BenchResult> runs;
+        std::string error;
+        for (int r = 0; r < repetitions && error.empty(); r++) {
+            BenchResult result = RunCase(benchCase, minTime, error);
+            result.repetition = r;
+            if (error.empty()) runs.push_back(result);
+        }
+        if (!error.empty()) {
+            fprintf(stderr, "%s: skipped, %s\n", benchCase.name.c_str(), error.c_str());
+            continue;
+        }
+        for (const BenchResult& run : runs) {
+            results.push_back(run);
+            if (!json) PrintConsole(run);
+        }
+        if (repetitions > 1) {
+            for (const char* aggregate : {"mean", "median", "stddev"}) {
+                results.push_back(Aggregate(runs, aggregate));
+                if (!json) PrintConsole(results.back());
+            }
+        }
+        current[benchCase.name] = repetitions > 1 ? Aggregate(runs, "median").realNs : runs[0].realNs;
+    }
+    if (list) return 0;
+
+    if (json) WriteJson(stdout, results, argv[0], minTime, repetitions);
+    if (outPath) {
+        FILE* out = fopen(outPath, "wb");
+        if (!out) {
+            fprintf(stderr, "ERROR: cannot write %s\n", outPath);
+            return 1;
+        }
+        WriteJson(out, results, argv[0], minTime, repetitions);
+        fclose(out);
+    }
+    for (const std::string& path : fixtureFiles) remove(path.c_str());
+
+    int regressions = 0;
+    if (comparePath) {
+        FILE* report = json ? stderr : stdout;
+        fprintf(report, "\nchange against %s (real time; + is slower):\n", comparePath);
+        for (const auto& entry : current) {
+            auto base = baseline.find(entry.first);
+            if (base == baseline.end() || base->second <= 0.0) continue;
+            double change = (entry.second - base->second) / base->second * 100.0;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            fprintf(report, "%-40s %12s -> %12s  %+7.1f%%%s\n", entry.first.c_str(), FormatTime(base->second).c_str(),
+                    FormatTime(entry.second).c_str(), change, regressed ? "  REGRESSION" : "");
+        }
+        if (regressions) fprintf(report, "%d cases slower by more than %.0f%%\n", regressions, threshold);
+    }
+
+#if defined(PASSGEN_BENCH_UI)
+    if (uiFonts) UnloadUiFonts(fonts);
+    if (IsWindowReady()) CloseWindow();
+#endif
+    return regressions ? 1 : 0;
+}
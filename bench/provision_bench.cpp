@@ -0,0 +1,165 @@
+// Batch provisioning benchmark.
+//
+// Writes a list of service account names (default 100k) to the temp
+// directory, then reports:
+//   generate  - 16 character passwords one at a time with generate(), and
+//               in bulk with generateBatch(), which also enforces the policy
+//   provision - end to end, from the list to a committed journal (read,
+//               generate, journal, commit), then the CSV for the
+//               provisioning system; into an empty vault and into one that
+//               holds as many entries already, all checked for duplicates
+//   by hand   - what the UI took per name before: ADD NEW and a rename,
+//               each committed; timed on the first 1000 names and scaled up
+//   replay    - reopening the journal, as on the next start
+//
+// Options: --names N, --dir <temp directory>
+
+#include "../src/password_generator.h"
+#include "../src/vault_journal.h"
+#include "../src/vault_provision.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static volatile uint64_t sink;
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string ServiceName(int i) {
+    char name[64];
+    snprintf(name, sizeof(name), "svc-%06d.corp.example.com", i);
+    return name;
+}
+
+static void WriteNames(const std::string& path, int names) {
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "ERROR: cannot write to the temp directory\n");
+        exit(1);
+    }
+    for (int i = 0; i < names; i++) fprintf(out, "%s\n", ServiceName(i).c_str());
+    fclose(out);
+}
+
+static void GenerateBench(int names) {
+    PasswordGenerator generator;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < names; i++) sink = sink + generator.generate(16).size();
+    double single = Seconds(start);
+
+    std::vector<std::string> batch;
+    start = std::chrono::steady_clock::now();
+    generator.generateBatch(batch, names, 16);
+    double bulk = Seconds(start);
+    size_t compliant = std::count_if(batch.begin(), batch.end(), PasswordGenerator::meetsPolicy);
+    printf("generate   one by one %7.1f ms   batch %7.1f ms   (%zu of %zu meet the policy)\n", single * 1000.0,
+           bulk * 1000.0, compliant, batch.size());
+}
+
+static void ProvisionBench(const char* label, const std::string& namesPath, int existing, const std::string& dir) {
+    std::string vaultPath = dir + "/provision_bench.dat";
+    std::string journalPath = journalPathFor(vaultPath);
+    std::string csvPath = dir + "/provision_bench.csv";
+    remove(journalPath.c_str());
+    {
+        Vault vault;
+        for (int i = 0; i < existing; i++) vault.append("existing-" + ServiceName(i), "Existing-Passw0rd!", 0);
+        VaultJournal journal;
+        journal.open(vault, journalPath.c_str());
+        PasswordGenerator generator;
+        size_t first = vault.size();
+
+        FILE* in = fopen(namesPath.c_str(), "rb");
+        auto start = std::chrono::steady_clock::now();
+        ProvisionResult result = provisionVault(vault, &journal, in, 16, generator);
+        double seconds = Seconds(start);
+        fclose(in);
+        if (!result.ok) {
+            fprintf(stderr, "ERROR: provisioning failed: %s\n", result.error);
+            exit(1);
+        }
+
+        FILE* csv = fopen(csvPath.c_str(), "wb");
+        start = std::chrono::steady_clock::now();
+        bool written = csv && writeProvisionCsv(vault, first, csv);
+        if (csv) written = fclose(csv) == 0 && written;
+        double csvSeconds = Seconds(start);
+        if (!written) {
+            fprintf(stderr, "ERROR: cannot write %s\n", csvPath.c_str());
+            exit(1);
+        }
+        printf("provision  %-14s %7.1f ms  %8zu entries (%.0f/s), csv %.1f ms, journal %.1f MB\n", label, seconds * 1000.0,
+               result.created, result.created / seconds, csvSeconds * 1000.0, journal.size() / 1e6);
+    }
+
+    // Replay on the next start
+    Vault vault;
+    VaultJournal journal;
+    auto start = std::chrono::steady_clock::now();
+    journal.open(vault, journalPath.c_str());
+    printf("replay     %-14s %7.1f ms  %8zu entries\n", label, Seconds(start) * 1000.0, vault.size());
+    journal.close();
+    remove(journalPath.c_str());
+    remove(csvPath.c_str());
+}
+
+// ADD NEW, then a rename, each a commit of its own as in AddLibraryEntry()
+// and ReplaceLibraryEntry()
+static void ByHandBench(int names, const std::string& dir) {
+    std::string journalPath = journalPathFor(dir + "/provision_bench.dat");
+    remove(journalPath.c_str());
+    int timed = std::min(names, 1000);
+    Vault vault;
+    VaultJournal journal;
+    journal.open(vault, journalPath.c_str());
+    PasswordGenerator generator;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < timed; i++) {
+        std::string password = generator.generate(16);
+        vault.add("new_service", password);
+        int64_t modified = vault.modifiedAt.back();
+        journal.add("new_service", password, modified);
+        journal.commit();
+        std::string name = ServiceName(i);
+        journal.addHistory("new_service", password, modified, name, password);
+        journal.replace(vault.size() - 1, name, password, modified);
+        vault.replace(vault.size() - 1, std::move(name), std::move(password), modified);
+        journal.commit();
+    }
+    double seconds = Seconds(start);
+    printf("by hand    %-14s %7.1f ms  %8d entries, %.2f ms each, %.1f s for all %d\n", "empty vault", seconds * 1000.0,
+           timed, seconds * 1000.0 / timed, seconds / timed * names, names);
+    journal.close();
+    remove(journalPath.c_str());
+}
+
+int main(int argc, char** argv) {
+    int names = 100000;
+    std::string dir = "/tmp";
+    if (const char* temp = getenv("TEMP")) dir = temp;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--names") && i + 1 < argc) names = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--names N] [--dir temp-directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::string namesPath = dir + "/provision_bench.txt";
+    WriteNames(namesPath, names);
+    printf("names: %d\n\n", names);
+    GenerateBench(names);
+    ProvisionBench("empty vault", namesPath, 0, dir);
+    ProvisionBench("full vault", namesPath, names, dir);
+    ByHandBench(names, dir);
+    remove(namesPath.c_str());
+    return 0;
+}
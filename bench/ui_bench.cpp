@@ -0,0 +1,158 @@
+// Headless UI rendering benchmark.
+//
+// Drives the generator and library views through scripted input for N
+// frames and renders into an offscreen render texture, reporting CPU frame
+// time, draw calls, vertices and heap allocations per frame.
+//
+// raylib needs a GL context but never presents here, so a hidden window is
+// enough. On a GPU-less Linux box run it against Mesa's software rasterizer:
+//
+//   xvfb-run -a env LIBGL_ALWAYS_SOFTWARE=1 ./ui_bench --frames 2000
+//
+// Options: --frames N, --entries N (default runs 1000 and 100000),
+//          --view main|library (default runs both),
+//          --assert-no-alloc (exit with 1 if a steady-state frame allocates)
+// Without a display it exits with 77, which ctest reports as skipped.
+//
+// Steady-state frames are the ones whose scripted input doesn't mutate state
+// (no clicks, SPACE or ENTER) and that don't start a library audit; those
+// must never touch the global allocator on the render thread.
+
+#include "raylib.h"
+#include "embedded_assets.h"
+#include "../src/app_ui.h"
+#include "../src/ui_script.h"
+#include "../src/alloc_counter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+PASSGEN_DEFINE_ALLOC_COUNTER()
+
+struct BenchResult {
+    double meanMs, p50Ms, p99Ms, maxMs;
+    double drawCalls, vertices;
+    double allocsPerFrame;
+    uint64_t maxAllocs;
+    double bytesPerFrame;
+    int steadyFramesAllocating;
+    int firstAllocatingFrame;
+};
+
+static BenchResult RunBench(const UiFonts& fonts, RenderTexture2D target, bool library, int entries, int frames) {
+    AppState app;
+    PrepareScriptedApp(app, entries);
+    app.showLibrary = library;
+
+    std::vector<double> frameMs(frames);
+    std::vector<uint64_t> frameAllocs(frames);
+    std::vector<bool> frameStartedAudit(frames);
+    double drawCalls = 0.0, vertices = 0.0, bytes = 0.0;
+
+    const int warmup = 30;
+    for (int f = -warmup; f < frames; f++) {
+        FrameInput input = ScriptedInput(f + warmup, library);
+        uint64_t allocsBefore = AllocCounter::allocations().load(std::memory_order_relaxed);
+        uint64_t bytesBefore = AllocCounter::bytes().load(std::memory_order_relaxed);
+        uint64_t auditsBefore = app.audits.runsStarted();
+        auto start = std::chrono::steady_clock::now();
+
+        UpdateChrome(app, fonts);
+        BeginTextureMode(target);
+        UpdateAndDrawFrame(app, fonts, input);
+        EndTextureMode();   // Flushes the batch, i.e. submits this frame's draw calls
+
+        auto end = std::chrono::steady_clock::now();
+        if (f < 0) continue;
+
+        frameMs[f] = std::chrono::duration<double, std::milli>(end - start).count();
+        frameAllocs[f] = AllocCounter::allocations().load(std::memory_order_relaxed) - allocsBefore;
+        bytes += (double)(AllocCounter::bytes().load(std::memory_order_relaxed) - bytesBefore);
+        frameStartedAudit[f] = app.audits.runsStarted() != auditsBefore;
+        drawCalls += FrameStats().drawCalls;
+        vertices += FrameStats().vertices();
+
+        // The script never leaves its view, but keep it pinned anyway
+        app.showLibrary = library;
+    }
+    app.chrome.unload();
+
+    BenchResult r = {};
+    r.firstAllocatingFrame = -1;
+    double sum = 0.0;
+    uint64_t allocSum = 0;
+    for (int f = 0; f < frames; f++) {
+        sum += frameMs[f];
+        allocSum += frameAllocs[f];
+        if (frameAllocs[f] > r.maxAllocs) r.maxAllocs = frameAllocs[f];
+        // Starting an audit (possibly deferred from an earlier edit) snapshots the library
+        bool steady = IsSteadyState(ScriptedInput(f + warmup, library)) && !frameStartedAudit[f];
+        if (frameAllocs[f] > 0 && steady) {
+            if (r.firstAllocatingFrame < 0) r.firstAllocatingFrame = f;
+            r.steadyFramesAllocating++;
+        }
+    }
+    std::sort(frameMs.begin(), frameMs.end());
+    r.meanMs = sum / frames;
+    r.p50Ms = frameMs[frames / 2];
+    r.p99Ms = frameMs[std::min(frames - 1, frames * 99 / 100)];
+    r.maxMs = frameMs[frames - 1];
+    r.drawCalls = drawCalls / frames;
+    r.vertices = vertices / frames;
+    r.allocsPerFrame = (double)allocSum / frames;
+    r.bytesPerFrame = bytes / frames;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    int frames = 1000;
+    std::vector<int> entryCounts = {1000, 100000};
+    std::vector<bool> views = {false, true};
+    bool assertNoAlloc = false;
+    AllocCounter::trackThisThread();
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--entries") && i + 1 < argc) entryCounts = {atoi(argv[++i])};
+        else if (!strcmp(argv[i], "--view") && i + 1 < argc) views = {!strcmp(argv[++i], "library")};
+        else if (!strcmp(argv[i], "--assert-no-alloc")) assertNoAlloc = true;
+        else {
+            fprintf(stderr, "usage: %s [--frames N] [--entries N] [--view main|library] [--assert-no-alloc]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(SCREEN_WIDTH, LIBRARY_VIEW_HEIGHT, "passgen ui bench");
+    if (!IsWindowReady()) {
+        fprintf(stderr, "no window (no display?), nothing to render\n");
+        return 77;
+    }
+    UiFonts fonts = LoadUiFonts(FONT_DATA, FONT_SIZE);
+    RenderTexture2D target = LoadRenderTexture(SCREEN_WIDTH, LIBRARY_VIEW_HEIGHT);
+
+    int failures = 0;
+    printf("%-8s %8s %9s %9s %9s %9s %7s %8s %11s %10s %13s\n",
+           "view", "entries", "mean ms", "p50 ms", "p99 ms", "max ms", "draws", "verts", "allocs/frm", "bytes/frm", "steady allocs");
+    for (bool library : views) {
+        for (int entries : entryCounts) {
+            BenchResult r = RunBench(fonts, target, library, entries, frames);
+            printf("%-8s %8d %9.4f %9.4f %9.4f %9.4f %7.1f %8.1f %11.2f %10.1f %13d\n",
+                   library ? "library" : "main", entries, r.meanMs, r.p50Ms, r.p99Ms, r.maxMs,
+                   r.drawCalls, r.vertices, r.allocsPerFrame, r.bytesPerFrame, r.steadyFramesAllocating);
+            if (assertNoAlloc && r.steadyFramesAllocating > 0) {
+                fprintf(stderr, "FAIL: %s view with %d entries allocated in %d steady-state frames (first: frame %d)\n",
+                        library ? "library" : "main", entries, r.steadyFramesAllocating, r.firstAllocatingFrame);
+                failures++;
+            }
+        }
+    }
+
+    UnloadRenderTexture(target);
+    UnloadUiFonts(fonts);
+    CloseWindow();
+    return failures > 0 ? 1 : 0;
+}
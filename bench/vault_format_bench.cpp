@@ -0,0 +1,149 @@
+// Vault file format benchmark.
+//
+// Fills a vault (default 1M entries; service names built from common sites,
+// accounts and labels, generated passwords) and saves and loads it in every
+// segment codec: none, LZ4 and, in builds with PASSGEN_HAVE_ZSTD, zstd at
+// several levels, each with and without the trained dictionary. Reports file
+// size, ratio against the plain text and save/load times next to the
+// original format (one encrypted text, read whole with getline).
+//
+// Options: --entries N, --segment <bytes>, --dir <temp directory>
+// Build with zstd: add -DPASSGEN_HAVE_ZSTD and link libzstd.
+
+#include "../src/password_generator.h"
+#include "../src/vault.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static double Milliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void FillVault(Vault& vault, int entries) {
+    static const char* sites[] = {"google", "github", "amazon", "netflix", "paypal", "dropbox", "spotify", "steam",
+                                  "linkedin", "twitter", "facebook", "instagram", "reddit", "gitlab", "atlassian",
+                                  "microsoft", "apple", "ebay", "slack", "zoom", "adobe", "digitalocean", "cloudflare",
+                                  "mybank", "creditunion", "insurance", "utilities", "airline", "hotel", "pharmacy"};
+    static const char* domains[] = {".com", ".com", ".com", ".org", ".net", ".io", ".co.uk", ".de"};
+    static const char* labels[] = {"", "", "", " (work)", " (personal)", " - admin", " - shared", " (old)"};
+    PasswordGenerator generator;
+    std::mt19937 rng(11);
+    for (int i = 0; i < entries; i++) {
+        std::string name = std::string(sites[rng() % 30]) + domains[rng() % 8];
+        if (rng() % 3 == 0) name = "user" + std::to_string(rng() % 5000) + "@" + name;
+        name += labels[rng() % 8];
+        vault.append(std::move(name), generator.generate(12 + (int)(rng() % 13)), 0);
+    }
+}
+
+// The format and code before segments: one XOR-encrypted text
+static void SaveOriginal(const Vault& vault, const char* path) {
+    std::ostringstream oss;
+    for (size_t j = 0; j < vault.serviceNames.size(); j++) {
+        oss << vault.serviceNames[j] << "|" << vault.passwords[j] << std::endl;
+    }
+    std::string encryptedData = encrypt(oss.str());
+    std::ofstream outFile(path, std::ios::binary);
+    outFile.write(encryptedData.c_str(), encryptedData.length());
+}
+
+static void LoadOriginal(Vault& vault, const char* path) {
+    std::ifstream inFile(path, std::ios::binary);
+    std::string encryptedData((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+    std::string decryptedData = decrypt(encryptedData);
+    std::istringstream iss(decryptedData);
+    std::string line;
+    while (std::getline(iss, line)) {
+        size_t pos = line.find('|');
+        if (pos != std::string::npos) {
+            vault.serviceNames.push_back(line.substr(0, pos));
+            vault.passwords.push_back(line.substr(pos + 1));
+        }
+    }
+}
+
+static void Report(const char* label, const std::string& path, size_t textSize, double saveMs, double loadMs, bool ok) {
+    double size = (double)std::filesystem::file_size(path);
+    printf("  %-18s %8.2f MB  %5.2fx  save %7.1f ms  load %7.1f ms%s\n", label, size / 1e6, textSize / size, saveMs, loadMs,
+           ok ? "" : "  MISMATCH");
+}
+
+int main(int argc, char** argv) {
+    int entries = 1000000;
+    size_t segmentSize = VAULT_SEGMENT_SIZE;
+    std::string dir = "/tmp";
+    if (const char* temp = getenv("TEMP")) dir = temp;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--entries") && i + 1 < argc) entries = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--segment") && i + 1 < argc) segmentSize = (size_t)std::max(256, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--entries N] [--segment bytes] [--dir temp-directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Vault vault;
+    FillVault(vault, entries);
+    size_t textSize = 0;
+    for (size_t i = 0; i < vault.size(); i++) textSize += vault.serviceNames[i].size() + vault.passwords[i].size() + 2;
+    printf("entries: %d, text %.2f MB, segments of %zu bytes\n\n", entries, textSize / 1e6, segmentSize);
+    std::string path = dir + "/vault_format_bench.dat";
+
+    auto start = std::chrono::steady_clock::now();
+    SaveOriginal(vault, path.c_str());
+    double saveMs = Milliseconds(start);
+    Vault loaded;
+    start = std::chrono::steady_clock::now();
+    LoadOriginal(loaded, path.c_str());
+    double loadMs = Milliseconds(start);
+    Report("original", path, textSize, saveMs, loadMs, loaded.passwords == vault.passwords);
+
+    struct Config {
+        const char* label;
+        BlockCodec codec;
+        int level;
+        bool dictionary;
+    };
+    const Config configs[] = {
+        {"none", CODEC_NONE, 0, false},
+        {"lz4", CODEC_LZ4, 0, false},
+        {"lz4 + dict", CODEC_LZ4, 0, true},
+        {"zstd 1", CODEC_ZSTD, 1, false},
+        {"zstd 1 + dict", CODEC_ZSTD, 1, true},
+        {"zstd 3", CODEC_ZSTD, 3, false},
+        {"zstd 3 + dict", CODEC_ZSTD, 3, true},
+        {"zstd 9 + dict", CODEC_ZSTD, 9, true},
+        {"zstd 19 + dict", CODEC_ZSTD, 19, true},
+    };
+    for (const Config& config : configs) {
+        if (!codecAvailable(config.codec)) continue;
+        VaultFileOptions options;
+        options.codec = config.codec;
+        options.level = config.level;
+        options.dictionary = config.dictionary;
+        options.segmentSize = segmentSize;
+        start = std::chrono::steady_clock::now();
+        bool ok = saveVault(vault, path.c_str(), options);
+        saveMs = Milliseconds(start);
+        Vault reloaded;
+        start = std::chrono::steady_clock::now();
+        ok = loadVault(reloaded, path.c_str()) && ok;
+        loadMs = Milliseconds(start);
+        Report(config.label, path, textSize, saveMs, loadMs, ok && reloaded.passwords == vault.passwords);
+    }
+#if !defined(PASSGEN_HAVE_ZSTD)
+    printf("\n(zstd rows need a build with -DPASSGEN_HAVE_ZSTD -lzstd)\n");
+#endif
+    remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Multi-vault benchmark.
+//
+// Writes several vault files (default 4 of 250k entries, with service names
+// built from common sites, accounts and labels) and compares opening them
+// lazily in a VaultSet against loading each in full. Then runs a series of
+// cross-vault searches, the first decoding every segment and building the
+// merged index, the rest served by the index and the name cache, once with
+// a cache that holds every name and once with a budget far below it.
+//
+// Options: --vaults N, --entries N (per vault), --budget MB, --dir <temp directory>
+
+#include "../src/password_generator.h"
+#include "../src/vault.h"
+#include "../src/vault_set.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <sys/resource.h>
+#endif
+
+static double Milliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Peak resident set of the process in MB, 0 where unavailable
+static double PeakRssMb() {
+#if !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss / 1024.0;
+#endif
+    return 0.0;
+}
+
+static void FillVault(Vault& vault, int entries, unsigned seed) {
+    static const char* sites[] = {"google", "github", "amazon", "netflix", "paypal", "dropbox", "spotify", "steam",
+                                  "linkedin", "twitter", "facebook", "instagram", "reddit", "gitlab", "atlassian",
+                                  "microsoft", "apple", "ebay", "slack", "zoom", "adobe", "digitalocean", "cloudflare",
+                                  "mybank", "creditunion", "insurance", "utilities", "airline", "hotel", "pharmacy"};
+    static const char* domains[] = {".com", ".com", ".com", ".org", ".net", ".io", ".co.uk", ".de"};
+    static const char* labels[] = {"", "", "", " (work)", " (personal)", " - admin", " - shared", " (old)"};
+    PasswordGenerator generator;
+    std::mt19937 rng(seed);
+    for (int i = 0; i < entries; i++) {
+        std::string name = std::string(sites[rng() % 30]) + domains[rng() % 8];
+        if (rng() % 3 == 0) name = "user" + std::to_string(rng() % 50000) + "@" + name;
+        name += labels[rng() % 8];
+        vault.append(std::move(name), generator.generate(16), 0);
+    }
+}
+
+static void RunSearches(VaultSet& set, const char* label) {
+    // Common, rare and absent names
+    const char* queries[] = {"github", "user4242@", "user31337@", "pharmacy.de (old)", "nosuchservice", "user4242@"};
+    printf("%s\n", label);
+    for (const char* query : queries) {
+        VaultSearchStats stats;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<VaultMatch> matches = set.search(query, SIZE_MAX, &stats);
+        double ms = Milliseconds(start);
+        printf("  %-20s %7zu matches %8.1f ms  segments: %5zu skipped %5zu searched %5zu decoded\n", query, matches.size(),
+               ms, stats.segmentsSkipped, stats.segmentsSearched, stats.segmentsDecoded);
+    }
+    NameCache& cache = set.nameCache();
+    printf("  name cache %.1f MB in %zu segments, %llu evictions; merged index %.2f MB; peak RSS %.1f MB\n\n",
+           cache.memoryBytes() / 1e6, cache.segments(), (unsigned long long)cache.evictions, set.indexBytes() / 1e6,
+           PeakRssMb());
+}
+
+int main(int argc, char** argv) {
+    int vaults = 4;
+    int entries = 250000;
+    size_t budgetMb = 4;
+    std::string dir = "/tmp";
+    if (const char* temp = getenv("TEMP")) dir = temp;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--vaults") && i + 1 < argc) vaults = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--entries") && i + 1 < argc) entries = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--budget") && i + 1 < argc) budgetMb = (size_t)std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--vaults N] [--entries N] [--budget MB] [--dir temp-directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> paths;
+    for (int v = 0; v < vaults; v++) {
+        Vault vault;
+        FillVault(vault, entries, 100 + v);
+        paths.push_back(dir + "/vault_set_bench" + std::to_string(v) + ".dat");
+        remove(journalPathFor(paths.back()).c_str());
+        if (!saveVault(vault, paths.back().c_str())) {
+            fprintf(stderr, "ERROR: cannot write %s\n", paths.back().c_str());
+            return 1;
+        }
+    }
+    printf("%d vaults of %d entries\n\n", vaults, entries);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        VaultSet set;
+        for (const std::string& path : paths) set.open(path.c_str());
+        double lazyMs = Milliseconds(start);
+        size_t segments = 0;
+        for (size_t v = 0; v < set.size(); v++) segments += set.segmentCount(v);
+        printf("lazy open    %8.1f ms  (%zu segments indexed, peak RSS %.1f MB)\n", lazyMs, segments, PeakRssMb());
+    }
+    start = std::chrono::steady_clock::now();
+    {
+        Vault vault;
+        for (const std::string& path : paths) loadVault(vault, path.c_str());
+        printf("full loads   %8.1f ms  (one vault at a time)\n\n", Milliseconds(start));
+    }
+
+    {
+        VaultSet set;
+        for (const std::string& path : paths) set.open(path.c_str());
+        set.nameCache().setBudget((size_t)1 << 40);
+        RunSearches(set, "search, unbounded name cache:");
+    }
+    {
+        VaultSet set;
+        for (const std::string& path : paths) set.open(path.c_str());
+        set.nameCache().setBudget(budgetMb << 20);
+        char label[64];
+        snprintf(label, sizeof(label), "search, %zu MB name cache:", budgetMb);
+        RunSearches(set, label);
+    }
+    for (const std::string& path : paths) remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Concurrent writers benchmark.
+//
+// Two handles on the same vault files stand in for two processes, say the
+// GUI and a script. For vaults of 10k, 100k and 1M entries (up to
+// --entries), the script commits batches of 1, 100 and 10000 changed
+// passwords, each under the vault's lock, and the GUI takes them in. Reports:
+//   notice - whether the watcher saw the commit
+//   merge  - VaultJournal::merge() of the new batch into the GUI's library
+//   reload - what the GUI did before: load the vault file and replay the
+//            journal from scratch
+//   begin  - lock, catchUp() and unlock with nothing to merge, which every
+//            edit in the GUI now pays
+// Best of --runs; the libraries are compared after every merge.
+//
+// Options: --entries N, --runs N, --dir <temp directory>
+
+#include "../src/vault.h"
+#include "../src/vault_journal.h"
+#include "../src/vault_sync.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+static double Ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Fail(const char* what) {
+    fprintf(stderr, "ERROR: %s\n", what);
+    exit(1);
+}
+
+static void SyncBench(size_t entries, int runs, const std::string& dir) {
+    std::string vaultPath = dir + "/vault_sync_bench.dat";
+    std::string journalPath = journalPathFor(vaultPath);
+    {
+        Vault vault;
+        char name[64];
+        for (size_t i = 0; i < entries; i++) {
+            snprintf(name, sizeof(name), "svc-%07zu.corp.example.com", i);
+            vault.append(name, "Initial-Passw0rd!", 0);
+        }
+        if (!saveVault(vault, vaultPath.c_str())) Fail("cannot write the vault file");
+        remove(journalPath.c_str());
+    }
+
+    // Each opens the files under the lock, as LoadLibrary() and passgen_cli do
+    VaultLock guiLock, scriptLock;
+    Vault gui, script;
+    VaultJournal guiJournal, scriptJournal;
+    VaultWatcher watcher;
+    auto open = [&](VaultLock& lock, Vault& vault, VaultJournal& journal) {
+        VaultLockGuard guard(lock);
+        if (!guard.locked || !loadVault(vault, vaultPath.c_str()) || !journal.open(vault, journalPath.c_str())) {
+            Fail("cannot open the vault");
+        }
+    };
+    if (!guiLock.open(vaultPath) || !scriptLock.open(vaultPath)) Fail("cannot open the lock file");
+    open(guiLock, gui, guiJournal);
+    open(scriptLock, script, scriptJournal);
+    watcher.watch(journalPath);
+
+    std::mt19937 rng(42);
+    char password[32];
+    for (size_t change : {(size_t)1, (size_t)100, (size_t)10000}) {
+        if (change > entries) break;
+        double merge = 1e30, reload = 1e30;
+        bool noticed = true, same = true;
+        for (int run = 0; run < runs; run++) {
+            // The script: lock, catch up, change passwords, commit
+            {
+                VaultLockGuard guard(scriptLock);
+                if (scriptJournal.catchUp(script) == MERGE_RELOAD) Fail("the script lost the journal");
+                for (size_t i = 0; i < change; i++) {
+                    size_t index = rng() % entries;
+                    snprintf(password, sizeof(password), "Changed-%08x!", (unsigned)rng());
+                    scriptJournal.replace(index, script.serviceNames[index], password, run + 1);
+                    script.replace(index, std::string(script.serviceNames[index]), password, run + 1);
+                }
+                if (!scriptJournal.commit()) Fail("cannot commit");
+            }
+            noticed = watcher.changed() && noticed;  // Polling, off Linux, may not have looked yet
+
+            auto start = std::chrono::steady_clock::now();
+            JournalMerge merged = guiJournal.merge(gui);
+            merge = std::min(merge, Ms(start));
+            if (merged != MERGE_EDITED) Fail("the merge found something else than the edits");
+            same = same && gui.passwords == script.passwords;
+
+            Vault reloaded;
+            start = std::chrono::steady_clock::now();
+            {
+                VaultLockGuard guard(guiLock);
+                if (!loadVault(reloaded, vaultPath.c_str()) || !VaultJournal::replay(reloaded, journalPath.c_str())) {
+                    Fail("cannot reload the vault");
+                }
+            }
+            reload = std::min(reload, Ms(start));
+            same = same && reloaded.passwords == script.passwords;
+        }
+        printf("%8zu entries  %6zu changed   notice %-3s  merge %9.3f ms   reload %9.1f ms  %s\n", entries, change,
+               noticed ? "yes" : "no", merge, reload, same ? "" : "LIBRARIES DIFFER");
+    }
+
+    double begin = 1e30;
+    for (int run = 0; run < 1000; run++) {
+        auto start = std::chrono::steady_clock::now();
+        guiLock.lock();
+        guiJournal.catchUp(gui);
+        guiLock.unlock();
+        begin = std::min(begin, Ms(start));
+    }
+    printf("%8zu entries  begin (lock, catch up, unlock) %.3f ms, journal %.1f MB\n\n", entries, begin,
+           guiJournal.size() / 1e6);
+
+    guiJournal.close();
+    scriptJournal.close();
+    remove(journalPath.c_str());
+    remove(vaultPath.c_str());
+    remove(lockPathFor(vaultPath).c_str());
+}
+
+int main(int argc, char** argv) {
+    size_t entries = 1000000;
+    int runs = 5;
+    std::string dir = "/tmp";
+    if (const char* temp = getenv("TEMP")) dir = temp;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--entries") && i + 1 < argc) entries = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc) runs = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--dir") && i + 1 < argc) dir = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--entries N] [--runs N] [--dir temp-directory]\n", argv[0]);
+            return 1;
+        }
+    }
+    for (size_t size = 10000; size <= entries; size *= 10) SyncBench(size, runs, dir);
+    if (entries < 10000) SyncBench(entries, runs, dir);
+    return 0;
+}
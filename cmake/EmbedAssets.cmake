@@ -0,0 +1,38 @@
+# Writes embedded_assets.h, the font and icon as byte arrays, the same header
+# push_and_release.bat generates on Windows. Run as a build step:
+#
+#   cmake -DFONT=<ttf> -DICON=<png> -DOUTPUT=<header> -P EmbedAssets.cmake
+#
+# C++17 has no #embed, and an assembler incbin would need a variant per
+# toolchain, so the bytes are written out as source.
+
+function(append_bytes out array size_name file)
+    file(READ "${file}" hex HEX)
+    string(LENGTH "${hex}" digits)
+    math(EXPR bytes "${digits} / 2")
+    # 16 bytes a line
+    string(REGEX REPLACE "(................................)" "\\1\n" hex "${hex}")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," hex "${hex}")
+    string(APPEND ${out} "const unsigned char ${array}[] = {\n${hex}\n};\n")
+    string(APPEND ${out} "const int ${size_name} = ${bytes};\n\n")
+    set(${out} "${${out}}" PARENT_SCOPE)
+endfunction()
+
+foreach(variable FONT ICON OUTPUT)
+    if(NOT DEFINED ${variable})
+        message(FATAL_ERROR "EmbedAssets.cmake needs -D${variable}=<path>")
+    endif()
+endforeach()
+
+set(header "// Auto-generated embedded assets\n\n")
+append_bytes(header FONT_DATA FONT_SIZE "${FONT}")
+append_bytes(header ICON_DATA ICON_SIZE "${ICON}")
+
+# Leave an unchanged header alone so its dependents are not rebuilt
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+    if(previous STREQUAL header)
+        return()
+    endif()
+endif()
+file(WRITE "${OUTPUT}" "${header}")
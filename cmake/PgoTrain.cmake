@@ -0,0 +1,86 @@
+# The training workload of PGO builds, run by the pgo_train target of a
+# build configured with -DPASSGEN_PGO=GENERATE:
+#
+#   cmake -DBIN_DIR=<build dir> -DPGO_DIR=<profile dir> [-DEXE_SUFFIX=.exe]
+#         [-DPROFDATA=<llvm-profdata>] -P PgoTrain.cmake
+#
+# Each program profiles its own object files (raylib's are shared by every
+# program that links it), so the workload runs the programs that ship:
+#   - PassGen --script: the scripted generator and library frames of
+#     ui_bench, rendered in a hidden window (text layout, drawing, rlgl)
+#   - passgen_cli: import, provisioning, compaction, search and backup of a
+#     40k entry vault
+# and the benchmarks a PGO build is judged by: ui_bench, and passgen_bench
+# (generation, single and in batches, vault save and load, search, strength
+# scoring and startup) with its UI cases. The graphical programs need a
+# display; without one they are skipped (run under xvfb-run to include
+# them). With Clang, the raw profiles are merged into passgen.profdata for
+# the USE build.
+
+foreach(variable BIN_DIR PGO_DIR)
+    if(NOT DEFINED ${variable})
+        message(FATAL_ERROR "PgoTrain.cmake needs -D${variable}=<path>")
+    endif()
+endforeach()
+
+set(work "${PGO_DIR}/work")
+file(REMOVE_RECURSE "${work}")
+file(MAKE_DIRECTORY "${work}")
+
+function(train program)
+    set(executable "${BIN_DIR}/${program}${EXE_SUFFIX}")
+    if(NOT EXISTS "${executable}")
+        message(STATUS "pgo_train: ${program} not built, skipped")
+        return()
+    endif()
+    string(JOIN " " shown ${ARGN})
+    message(STATUS "pgo_train: ${program} ${shown}")
+    execute_process(COMMAND "${executable}" ${ARGN} WORKING_DIRECTORY "${work}"
+                    RESULT_VARIABLE result OUTPUT_QUIET)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "pgo_train: ${program} failed (${result})")
+    endif()
+endfunction()
+
+if(WIN32 OR APPLE OR DEFINED ENV{DISPLAY} OR DEFINED ENV{WAYLAND_DISPLAY})
+    train(PassGen --script 2000)
+    train(ui_bench --frames 500)
+    train(passgen_bench_ui "--benchmark_filter=text|frame|startup/ui" --benchmark_min_time=0.2 "--dir=${work}")
+else()
+    message(STATUS "pgo_train: no display, PassGen and the UI benchmarks skipped")
+endif()
+
+# An export to import: names with the structure of real ones, distinct passwords
+set(csv "name,url,username,password\n")
+set(names "")
+foreach(i RANGE 1 20000)
+    math(EXPR site "${i} % 97")
+    string(RANDOM LENGTH 16 password)
+    string(APPEND csv "account${i}.site${site}.example.com,https://site${site}.example.com,user${i},${password}\n")
+    string(APPEND names "svc${i}.site${site}.example.com\n")
+endforeach()
+file(WRITE "${work}/export.csv" "${csv}")
+file(WRITE "${work}/names.txt" "${names}")
+
+set(vault "${work}/passwords.dat")
+train(passgen_cli --vault "${vault}" import "${work}/export.csv")
+train(passgen_cli --vault "${vault}" provision "${work}/names.txt" --csv "${work}/accounts.csv")
+train(passgen_cli --vault "${vault}" compact)
+train(passgen_cli --vault "${vault}" count)
+train(passgen_cli --vault "${vault}" search site42 --limit 100000)
+train(passgen_cli --vault "${vault}" export "${work}/backup.pgb" --compress)
+train(passgen_cli --vault "${vault}" restore "${work}/backup.pgb")
+
+train(passgen_bench "--benchmark_filter=generate|vault/(save|load)|search|strength|startup"
+      --benchmark_min_time=0.2 "--dir=${work}")
+
+file(REMOVE_RECURSE "${work}")
+
+if(PROFDATA)
+    file(GLOB raw "${PGO_DIR}/*.profraw")
+    execute_process(COMMAND "${PROFDATA}" merge -o "${PGO_DIR}/passgen.profdata" ${raw} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "pgo_train: llvm-profdata merge failed")
+    endif()
+endif()
+message(STATUS "pgo_train: profiles in ${PGO_DIR}; reconfigure with -DPASSGEN_PGO=USE and rebuild")
@@ -0,0 +1,104 @@
+#ifndef PASSGEN_H
+#define PASSGEN_H
+
+/*
+ * libpassgen: password generation and the encrypted vault, without the UI.
+ *
+ * A C ABI over the same code the application, passgen_cli and passgen_agent
+ * use (the header-only modules in src/, which are the C++ API). Handles are
+ * opaque; a handle may be used from one thread at a time. Strings are UTF-8
+ * and NUL-terminated. Functions that fill a caller's buffer take its size
+ * and report the size needed, terminator included, so a call with a null
+ * buffer asks for the size.
+ *
+ * Link the static library as is. To use the shared library, define
+ * PASSGEN_SHARED before including this header.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(PASSGEN_SHARED)
+    #if defined(_WIN32)
+        #if defined(PASSGEN_BUILDING)
+            #define PASSGEN_API __declspec(dllexport)
+        #else
+            #define PASSGEN_API __declspec(dllimport)
+        #endif
+    #else
+        #define PASSGEN_API __attribute__((visibility("default")))
+    #endif
+#else
+    #define PASSGEN_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped on any incompatible change to the functions below */
+#define PASSGEN_ABI_VERSION 1
+
+typedef enum passgen_status {
+    PASSGEN_OK = 0,
+    PASSGEN_ERROR_ARGUMENT,  /* Null handle, bad index or length, '|' in a name or a line break in an entry */
+    PASSGEN_ERROR_BUFFER,    /* The caller's buffer is too small; the size needed was stored */
+    PASSGEN_ERROR_NOT_FOUND,
+    PASSGEN_ERROR_IO,        /* The file can't be opened or written */
+    PASSGEN_ERROR_FORMAT,    /* The file is damaged or uses a codec this build lacks */
+    PASSGEN_ERROR_MEMORY
+} passgen_status;
+
+typedef struct passgen_generator passgen_generator;
+typedef struct passgen_vault passgen_vault;
+
+PASSGEN_API uint32_t passgen_abi_version(void);
+PASSGEN_API const char* passgen_status_string(passgen_status status);
+
+/* Zero memory that held a password, in a way the compiler keeps */
+PASSGEN_API void passgen_wipe(void* data, size_t size);
+
+/* Random passwords of letters, digits and symbols, every character drawn from the OS's random source */
+PASSGEN_API passgen_generator* passgen_generator_create(void);
+PASSGEN_API void passgen_generator_destroy(passgen_generator* generator);
+
+/* A password of length characters (4 to 1024) into out */
+PASSGEN_API passgen_status passgen_generate(passgen_generator* generator, int length, char* out, size_t outSize);
+
+/* A library of entries: a service name and its password. Passwords are
+ * wiped from memory when they are replaced, removed or destroyed. */
+PASSGEN_API passgen_vault* passgen_vault_create(void);
+PASSGEN_API void passgen_vault_destroy(passgen_vault* vault);
+
+/* Replace the contents with the vault file at path and the edits its
+ * journal holds (path with a .journal extension). The journal is only read.
+ * Waits for a process writing the vault (see passgen_cli and the app). A
+ * vault in a read-only directory, where the lock file can't be created, is
+ * read without the lock. */
+PASSGEN_API passgen_status passgen_vault_load(passgen_vault* vault, const char* path);
+
+/* Write the whole library to the vault file at path and start its journal
+ * afresh, keeping entry history; a running application reloads. Waits for a
+ * process writing the vault. */
+PASSGEN_API passgen_status passgen_vault_save(passgen_vault* vault, const char* path);
+
+PASSGEN_API size_t passgen_vault_size(const passgen_vault* vault);
+
+/* Service name and password of an entry; either buffer may be null. On
+ * PASSGEN_OK or PASSGEN_ERROR_BUFFER, *nameSize and *passwordSize hold the
+ * sizes needed. */
+PASSGEN_API passgen_status passgen_vault_entry(const passgen_vault* vault, size_t index, char* name, size_t* nameSize,
+                                               char* password, size_t* passwordSize);
+
+/* Index of the first entry named name */
+PASSGEN_API passgen_status passgen_vault_find(const passgen_vault* vault, const char* name, size_t* index);
+
+PASSGEN_API passgen_status passgen_vault_add(passgen_vault* vault, const char* name, const char* password);
+PASSGEN_API passgen_status passgen_vault_set_password(passgen_vault* vault, size_t index, const char* password);
+PASSGEN_API passgen_status passgen_vault_remove(passgen_vault* vault, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,461 +1,104 @@
 #include "raylib.h"
 #include "embedded_assets.h"
-#include <string>
-#include <random>
-#include <algorithm>
-#include <fstream>
-#include <sstream>
-#include <vector>
-
-class PasswordGenerator {
-private:
-    std::string chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*";
-    std::random_device rd;
-    std::mt19937 gen;
-    
-public:
-    PasswordGenerator() : gen(rd()) {}
-    
-    std::string generate(int length) {
-        std::string password;
-        std::uniform_int_distribution<> dis(0, chars.size() - 1);
-        
-        for (int i = 0; i < length; ++i) {
-            password += chars[dis(gen)];
+#include "src/app_ui.h"
+#include "src/profiler_overlay.h"
+#include "src/startup_loader.h"
+#include "src/ui_script.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    StartupLoader::Clock::time_point launched = StartupLoader::Clock::now();  // Startup is timed from here
+    const int screenWidth = SCREEN_WIDTH;
+    const int screenHeight = MAIN_VIEW_HEIGHT;
+
+    // Options come before the vault files:
+    //   --script N           play the UI benchmark's input script on a generated
+    //                        library for N frames, half in each view, in a hidden
+    //                        window, then exit. It is the training run of PGO
+    //                        builds (see cmake/PgoTrain.cmake).
+    //   --clear-after SECS   clear a copied password after SECS seconds (default 30, 0 never)
+    //   --paste-once         clear a copied password once it has been pasted (X11)
+    int scriptFrames = 0;
+    int clearAfter = SecretClipboard::DEFAULT_CLEAR_SECONDS;
+    bool pasteOnce = false;
+    int firstVault = 1;
+    for (; firstVault < argc; firstVault++) {
+        if (firstVault + 1 < argc && !strcmp(argv[firstVault], "--script")) {
+            scriptFrames = std::max(2, atoi(argv[++firstVault]));
+        } else if (firstVault + 1 < argc && !strcmp(argv[firstVault], "--clear-after")) {
+            clearAfter = atoi(argv[++firstVault]);
+        } else if (!strcmp(argv[firstVault], "--paste-once")) {
+            pasteOnce = true;
+        } else {
+            break;
         }
-        return password;
-    }
-};
-
-// Encryption functions
-std::string encrypt(const std::string& data) {
-    std::string result = data;
-    for (size_t i = 0; i < result.length(); i++) {
-        result[i] ^= 0x7F;  // Simple XOR encryption
-    }
-    return result;
-}
-
-std::string decrypt(const std::string& data) {
-    return encrypt(data);  // XOR is symmetric, so encrypt = decrypt
-}
-
-// Helper function for crisp text rendering
-void DrawCrispText(Font font, const char* text, Vector2 position, float fontSize, Color tint) {
-    // The key to crisp text is using integer positions and proper spacing
-    
-    // Round to nearest integer for better alignment
-    position.x = roundf(position.x);
-    position.y = roundf(position.y);
-    
-    // For small fonts, ensure perfect pixel alignment by using integer positions
-    if (fontSize <= 20.0f) {
-        position.x = (int)position.x;
-        position.y = (int)position.y;
-    }
-    
-    // For table rows, ensure consistent vertical alignment
-    if (position.y >= 195.0f && position.y <= 350.0f) {
-        // Ensure rows are aligned to 2-pixel boundaries for better appearance
-        position.y = (int)(position.y / 2) * 2;
     }
-    
-    // Use consistent spacing parameter (1.0f) for all text
-    // This ensures proper glyph spacing and prevents blurry rendering
-    DrawTextEx(font, text, position, fontSize, 1.0f, tint);
-}
-
-int main() {
-    const int screenWidth = 450;
-    const int screenHeight = 280;
+    if (scriptFrames > 0) SetConfigFlags(FLAG_WINDOW_HIDDEN);
 
     InitWindow(screenWidth, screenHeight, "Password Generator");
-    SetTargetFPS(60);
-
-    // Load FreePixel fonts from embedded data with improved rendering settings
-    // Using consistent font generation parameters for crisp rendering
-    int fontBaseSize = 120;  // Higher base size for better quality
-    int fontChars = 95;      // Standard ASCII character set
-    
-    // Load fonts with consistent parameters for all sizes
-    Font font24 = LoadFontFromMemory(".ttf", FONT_DATA, FONT_SIZE, fontBaseSize, 0, fontChars);
-    Font font20 = LoadFontFromMemory(".ttf", FONT_DATA, FONT_SIZE, fontBaseSize, 0, fontChars);
-    Font font18 = LoadFontFromMemory(".ttf", FONT_DATA, FONT_SIZE, fontBaseSize, 0, fontChars);
-    Font font16 = LoadFontFromMemory(".ttf", FONT_DATA, FONT_SIZE, fontBaseSize, 0, fontChars);
-    Font font14 = LoadFontFromMemory(".ttf", FONT_DATA, FONT_SIZE, fontBaseSize, 0, fontChars);
-
-    // Apply point filtering to all fonts for crisp pixel-perfect rendering
-    SetTextureFilter(font24.texture, TEXTURE_FILTER_POINT);
-    SetTextureFilter(font20.texture, TEXTURE_FILTER_POINT);
-    SetTextureFilter(font18.texture, TEXTURE_FILTER_POINT);
-    SetTextureFilter(font16.texture, TEXTURE_FILTER_POINT);
-    SetTextureFilter(font14.texture, TEXTURE_FILTER_POINT);
-
-    // Set window icon from embedded data
-    Image iconImage = LoadImageFromMemory(".png", ICON_DATA, ICON_SIZE);
-    if (iconImage.data != NULL) {
-        SetWindowIcon(iconImage);
-        UnloadImage(iconImage);
-    }
-
-    PasswordGenerator passGen;
-    std::string password = "";
-    int passwordLength = 12;
-    bool copied = false;
-    int copiedTimer = 0;
-    bool showLibrary = false;
-    int editingIndex = -1;
-    char editBuffer[32] = "";
-    int scrollOffset = 0;
-    std::vector<std::string> libraryPasswords = {"aBc123XyZ!", "P@ssW0rd789", "SecureKey456", "MyS3cur3P@ss"};
-    std::vector<std::string> serviceNames = {"facebook", "gmail", "github", "twitter"};
-
-    // Load from encrypted file
-    std::ifstream inFile("passwords.dat", std::ios::binary);
-    if (inFile.is_open()) {
-        serviceNames.clear();
-        libraryPasswords.clear();
-        std::string encryptedData((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
-        inFile.close();
-
-        if (!encryptedData.empty()) {
-            std::string decryptedData = decrypt(encryptedData);
-            std::istringstream iss(decryptedData);
-            std::string line;
-            while (std::getline(iss, line)) {
-                size_t pos = line.find('|');
-                if (pos != std::string::npos) {
-                    serviceNames.push_back(line.substr(0, pos));
-                    libraryPasswords.push_back(line.substr(pos + 1));
-                }
-            }
-        }
+    SetTargetFPS(scriptFrames > 0 ? 0 : 60);
+
+    // A small rasterization of the font for the first frames; the loader
+    // brings the full one, the window icon and the library
+    UiFonts fonts = LoadUiFonts(FONT_DATA, FONT_SIZE, UI_FONT_FIRST_SIZE);
+
+    AppState app;
+    app.clipboard.setClearAfter(clearAfter);
+    app.clipboard.setPasteOnce(pasteOnce);
+    StartupLoader::Job job;
+    job.fontData = FONT_DATA;
+    job.fontDataSize = FONT_SIZE;
+    job.iconData = ICON_DATA;
+    job.iconDataSize = ICON_SIZE;
+    if (scriptFrames > 0) {
+        PrepareScriptedApp(app, 1000);
+        job.openVaults = false;
+    } else {
+        app.library.passwords = {"aBc123XyZ!", "P@ssW0rd789", "SecureKey456", "MyS3cur3P@ss"};
+        app.library.serviceNames = {"facebook", "gmail", "github", "twitter"};
+        job.vaultPaths.assign(argv + firstVault, argv + argc);  // passwords.dat if none
     }
-
-    while (!WindowShouldClose()) {
-        // Center calculations
-        float centerX = screenWidth / 2.0f;
-
-        // Slider for password length (wider)
-        Rectangle sliderBar = {centerX - 120.0f, 68.0f, 240.0f, 10.0f};
-        Rectangle sliderKnob = {centerX - 120.0f + (passwordLength - 4) * 240.0f / 46.0f - 5.0f, 63.0f, 10.0f, 20.0f};
-
-        if (CheckCollisionPointRec(GetMousePosition(), sliderBar) && IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-            float mouseX = GetMousePosition().x;
-            passwordLength = 4 + (int)((mouseX - (centerX - 120.0f)) * 46.0f / 240.0f);
-            if (passwordLength < 4) passwordLength = 4;
-            if (passwordLength > 50) passwordLength = 50;
-        }
-
-        // Input handling
-        if (IsKeyPressed(KEY_SPACE) || IsKeyPressed(KEY_ENTER)) {
-            password = passGen.generate(passwordLength);
-            copied = false;
-        }
-        if (IsKeyPressed(KEY_C) && !password.empty()) {
-            SetClipboardText(password.c_str());
-            copied = true;
-            copiedTimer = 120; // 2 seconds at 60 FPS
+    StartupLoader loader(launched);
+    loader.start(app, std::move(job));
+    bool loaded = false;
+
+    int windowHeight = screenHeight;
+    for (int frame = 0; !WindowShouldClose() && (scriptFrames == 0 || frame < scriptFrames); frame++) {
+        PROFILE_ZONE("frame");
+
+        if (!loaded) loaded = loader.poll(app, fonts);
+        SyncLibrary(app);
+        ImportDroppedFiles(app);
+        app.clipboard.update();
+        FrameInput input;
+        if (scriptFrames > 0) {
+            app.showLibrary = frame >= scriptFrames / 2;
+            input = ScriptedInput(frame, app.showLibrary);
+        } else {
+            input = PollFrameInput();
         }
-
-        if (copiedTimer > 0) copiedTimer--;
-        if (copiedTimer == 0) copied = false;
+        UpdateChrome(app, fonts);
 
         BeginDrawing();
-        ClearBackground(BLACK); // Dark theme background
-
-        // Top bar with title (centered)
-        DrawRectangle(0, 0, screenWidth, 40, BLUE); 
-        Vector2 titleSize = MeasureTextEx(font20, "Password Generator", 20, 1.0f);
-        DrawCrispText(font20, "Password Generator", {centerX - titleSize.x/2, 10}, 20, WHITE);
-
-        // Password length with slider (centered)
-        const char* lengthText = TextFormat("Length: %d", passwordLength);
-        Vector2 lengthSize = MeasureTextEx(font18, lengthText, 18, 1.0f);
-        DrawCrispText(font18, lengthText, {centerX - lengthSize.x/2, 50}, 18, WHITE);
-
-        DrawRectangleRec(sliderBar, DARKGRAY);
-        DrawRectangleRec(sliderKnob, LIME);
-        DrawCrispText(font16, "4", {centerX - 140.0f, 65.0f}, 16, LIGHTGRAY);
-        DrawCrispText(font16, "50", {centerX + 130.0f, 65.0f}, 16, LIGHTGRAY);
-
-        // Generate button area (auto-width, centered)
-        Vector2 genSize = MeasureTextEx(font18, "Generate (SPACE)", 18, 1.0f);
-        float buttonWidth = genSize.x + 20.0f; // Add padding
-        Rectangle genButton = {centerX - buttonWidth/2.0f, 95.0f, buttonWidth, 35.0f};
-        DrawRectangleRec(genButton, LIME);
-        float genButtonCenterY = genButton.y + genButton.height/2.0f - genSize.y/2.0f;
-        DrawCrispText(font18, "Generate (SPACE)", {centerX - genSize.x/2, genButtonCenterY}, 18, BLACK);
-
-        if (CheckCollisionPointRec(GetMousePosition(), genButton) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-            password = passGen.generate(passwordLength);
-            copied = false;
-        }
-
-        if (!showLibrary) {
-            // Main generator view
-            Rectangle passBox = {15.0f, 140.0f, (float)(screenWidth - 30), 50.0f};
-            DrawRectangleRec(passBox, DARKGRAY);
-            DrawRectangleLinesEx(passBox, 2, BLUE);
-
-            if (!password.empty()) {
-                const char* passText = password.c_str();
-                Vector2 textSize = MeasureTextEx(font18, passText, 18, 1.0f);
-                if (textSize.x > screenWidth - 50) {
-                    Vector2 smallerTextSize = MeasureTextEx(font16, passText, 16, 1.0f);
-                    DrawCrispText(font16, passText, {centerX - smallerTextSize.x/2.0f, 155.0f}, 16, LIME);
-                } else {
-                    DrawCrispText(font18, passText, {centerX - textSize.x/2.0f, 155.0f}, 18, LIME);
-                }
-            } else {
-                Vector2 placeholderSize = MeasureTextEx(font16, "Generated password appears here", 16, 1.0f);
-                DrawCrispText(font16, "Generated password appears here", {centerX - placeholderSize.x/2.0f, 155.0f}, 16, LIGHTGRAY);
-            }
-
-            // Copy and Library buttons
-            Rectangle copyButton = {15.0f, 205.0f, 200.0f, 35.0f};
-            Rectangle libraryButton = {235.0f, 205.0f, 200.0f, 35.0f};
-
-            DrawRectangleRec(copyButton, GREEN);
-            DrawRectangleRec(libraryButton, BLUE);
-
-            const char* copyText = copied ? "Copied to clipboard!" : "COPY";
-            Vector2 copySize = MeasureTextEx(font18, copyText, 18, 1.0f);
-            Vector2 libSize = MeasureTextEx(font18, "LIBRARY", 18, 1.0f);
-
-            DrawCrispText(font18, copyText, {115.0f - copySize.x/2.0f, 213.0f}, 18, WHITE);
-            DrawCrispText(font18, "LIBRARY", {335.0f - libSize.x/2.0f, 213.0f}, 18, WHITE);
-
-            if (CheckCollisionPointRec(GetMousePosition(), copyButton) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !password.empty()) {
-                SetClipboardText(password.c_str());
-                copied = true;
-                copiedTimer = 120;
-            }
-
-            if (CheckCollisionPointRec(GetMousePosition(), libraryButton) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                showLibrary = true;
-                SetWindowSize(screenWidth, 400);
-            }
-        } else {
-            // Library view
-            Vector2 libraryTitleSize = MeasureTextEx(font18, "Password Library (Encrypted)", 18, 1.0f);
-            DrawCrispText(font18, "Password Library (Encrypted)", {centerX - libraryTitleSize.x/2.0f, 145}, 18, LIME);
-
-            Rectangle libraryArea = {15.0f, 170.0f, (float)(screenWidth - 30), 180.0f};
-            DrawRectangleRec(libraryArea, DARKGRAY);
-            DrawRectangleLinesEx(libraryArea, 2, BLUE);
-
-            // Table headers (always visible) - use integer positions for pixel-perfect alignment
-            DrawCrispText(font16, "Service Name", {25, 175}, 16, LIME);
-            DrawCrispText(font16, "Password", {150, 175}, 16, LIME);
-            DrawCrispText(font16, "Actions", {320, 175}, 16, LIME);
-
-            // Header separator line
-            DrawLine(20, 190, 415, 190, BLUE);
-
-            // Enable scissor test for clipping content only
-            BeginScissorMode(15, 195, screenWidth - 35, 155);
-
-            // Scroll handling
-            int maxVisible = 7; // Reduced to leave space below table
-            int totalItems = (int)serviceNames.size();
-
-            if (totalItems > maxVisible) {
-                float mouseWheel = GetMouseWheelMove();
-                scrollOffset -= (int)mouseWheel;
-                if (scrollOffset < 0) scrollOffset = 0;
-                if (scrollOffset > totalItems - maxVisible) scrollOffset = totalItems - maxVisible; // Remove extra padding
-            }
-
-            // Display services
-            for (int i = 0; i < std::min(totalItems - scrollOffset, maxVisible); i++) {
-                int itemIndex = i + scrollOffset;
-                // Use integer positions for pixel-perfect alignment
-                float yPos = 195.0f + i * 20.0f;
-
-                if (editingIndex == itemIndex) {
-                    // Edit mode for service name
-                    Rectangle editBox = {25.0f, yPos - 2.0f, 120.0f, 18.0f};
-                    DrawRectangleRec(editBox, WHITE);
-                    DrawRectangleLinesEx(editBox, 1, BLUE);
-                    DrawCrispText(font14, editBuffer, {30, yPos}, 14, BLACK);
-
-                    int key = GetCharPressed();
-                    while (key > 0) {
-                        if ((key >= 32) && (key <= 125) && (strlen(editBuffer) < 30)) {
-                            int len = strlen(editBuffer);
-                            editBuffer[len] = (char)key;
-                            editBuffer[len+1] = '\0';
-                        }
-                        key = GetCharPressed();
-                    }
-
-                    if (IsKeyPressed(KEY_BACKSPACE) && strlen(editBuffer) > 0) {
-                        editBuffer[strlen(editBuffer)-1] = '\0';
-                    }
-
-                    if (IsKeyPressed(KEY_ENTER) && strlen(editBuffer) > 0) {
-                        serviceNames[itemIndex] = std::string(editBuffer);
-                        editingIndex = -1;
-
-                        // Save to encrypted file
-                        std::ostringstream oss;
-                        for (size_t j = 0; j < serviceNames.size(); j++) {
-                            oss << serviceNames[j] << "|" << libraryPasswords[j] << std::endl;
-                        }
-                        std::string encryptedData = encrypt(oss.str());
-                        std::ofstream outFile("passwords.dat", std::ios::binary);
-                        if (outFile.is_open()) {
-                            outFile.write(encryptedData.c_str(), encryptedData.length());
-                            outFile.close();
-                        }
-                    }
-
-                    if (IsKeyPressed(KEY_ESCAPE)) {
-                        editingIndex = -1;
-                    }
-
-                    // Show password in second column during edit
-                    std::string password = libraryPasswords[itemIndex];
-                    if (password.length() > 15) password = password.substr(0, 15) + "...";
-                    DrawCrispText(font14, password.c_str(), {150, yPos}, 14, LIME);
-                } else {
-                    // Display mode - Service name column
-                    Rectangle nameArea = {25.0f, yPos - 2.0f, 120.0f, 18.0f};
-                    if (CheckCollisionPointRec(GetMousePosition(), nameArea) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                        editingIndex = itemIndex;
-                        strcpy(editBuffer, serviceNames[itemIndex].c_str());
-                    }
-
-                    std::string serviceName = serviceNames[itemIndex];
-                    if (serviceName.length() > 12) serviceName = serviceName.substr(0, 12) + "...";
-                    DrawCrispText(font14, serviceName.c_str(), {25, yPos}, 14, WHITE);
-
-                    // Password column
-                    std::string password = libraryPasswords[itemIndex];
-                    if (password.length() > 15) password = password.substr(0, 15) + "...";
-                    DrawCrispText(font14, password.c_str(), {150, yPos}, 14, LIME);
-                }
-
-                Vector2 copyTextSize = MeasureTextEx(font14, "COPY", 14, 1.0f);
-                float copyBtnWidth = copyTextSize.x + 10.0f;
-
-                Rectangle copyBtn = {280.0f, yPos - 2.0f, copyBtnWidth, 18.0f};
-                Rectangle genBtn = {285.0f + copyBtnWidth, yPos - 2.0f, 35.0f, 18.0f};
-                Rectangle delBtn = {325.0f + copyBtnWidth, yPos - 2.0f, 35.0f, 18.0f};
-
-                DrawRectangleRec(copyBtn, BLUE);
-                DrawRectangleRec(genBtn, GREEN);
-                DrawRectangleRec(delBtn, RED);
-
-                // Use integer positions for button text to ensure pixel-perfect alignment
-                DrawCrispText(font14, "COPY", {284.0f, yPos}, 14, WHITE);
-                DrawCrispText(font14, "GEN", {290.0f + copyBtnWidth, yPos}, 14, WHITE);
-                DrawCrispText(font14, "DEL", {330.0f + copyBtnWidth, yPos}, 14, WHITE);
-
-                if (CheckCollisionPointRec(GetMousePosition(), copyBtn) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                    SetClipboardText(libraryPasswords[itemIndex].c_str());
-                }
-
-                if (CheckCollisionPointRec(GetMousePosition(), genBtn) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                    libraryPasswords[itemIndex] = passGen.generate(passwordLength);
-
-                    // Save to encrypted file
-                    std::ostringstream oss;
-                    for (size_t j = 0; j < serviceNames.size(); j++) {
-                        oss << serviceNames[j] << "|" << libraryPasswords[j] << std::endl;
-                    }
-                    std::string encryptedData = encrypt(oss.str());
-                    std::ofstream outFile("passwords.dat", std::ios::binary);
-                    if (outFile.is_open()) {
-                        outFile.write(encryptedData.c_str(), encryptedData.length());
-                        outFile.close();
-                    }
-                }
-
-                if (CheckCollisionPointRec(GetMousePosition(), delBtn) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                    serviceNames.erase(serviceNames.begin() + itemIndex);
-                    libraryPasswords.erase(libraryPasswords.begin() + itemIndex);
-                    if (scrollOffset > 0 && itemIndex == totalItems - 1) scrollOffset--;
-
-                    // Save to encrypted file
-                    std::ostringstream oss;
-                    for (size_t j = 0; j < serviceNames.size(); j++) {
-                        oss << serviceNames[j] << "|" << libraryPasswords[j] << std::endl;
-                    }
-                    std::string encryptedData = encrypt(oss.str());
-                    std::ofstream outFile("passwords.dat", std::ios::binary);
-                    if (outFile.is_open()) {
-                        outFile.write(encryptedData.c_str(), encryptedData.length());
-                        outFile.close();
-                    }
-                }
-
-                // Row separator line
-                if (i < std::min(totalItems - scrollOffset, maxVisible) - 1) {
-                    DrawLine(20, yPos + 16, 410, yPos + 16, BLUE);
-                }
-            }
-
-            EndScissorMode();
-
-            // Scrollbar (inside library area)
-            if (totalItems > maxVisible) {
-                float scrollBarHeight = (maxVisible - 1) * 20.0f + 14.0f; // Height based on actual content area
-                Rectangle scrollBar = {412.0f, 195.0f, 5.0f, scrollBarHeight};
-                DrawRectangleRec(scrollBar, DARKGRAY);
-
-                float thumbHeight = (float)maxVisible / totalItems * scrollBarHeight;
-                if (thumbHeight < 10.0f) thumbHeight = 10.0f; // Minimum thumb size
-                float thumbY = 195.0f + ((float)scrollOffset / (totalItems - maxVisible)) * (scrollBarHeight - thumbHeight);
-                Rectangle scrollThumb = {412.0f, thumbY, 5.0f, thumbHeight};
-                DrawRectangleRec(scrollThumb, LIME);
-            }
-
-            // Back button (left side)
-            Rectangle backButton = {15.0f, 360.0f, 80.0f, 30.0f};
-            DrawRectangleRec(backButton, DARKGRAY);
-            Vector2 backTextSize = MeasureTextEx(font16, "BACK", 16, 1.0f);
-            DrawCrispText(font16, "BACK", {15.0f + (80.0f - backTextSize.x)/2, 367.0f}, 16, WHITE);
-
-            // Add new entry button (right side)
-            Rectangle addButton = {355.0f, 360.0f, 80.0f, 30.0f};
-            DrawRectangleRec(addButton, BLUE);
-            Vector2 addTextSize = MeasureTextEx(font16, "ADD NEW", 16, 1.0f);
-            DrawCrispText(font16, "ADD NEW", {355.0f + (80.0f - addTextSize.x)/2, 367.0f}, 16, WHITE);
-
-            if (CheckCollisionPointRec(GetMousePosition(), addButton) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                serviceNames.push_back("new_service");
-                libraryPasswords.push_back(passGen.generate(passwordLength));
-
-                // Save to encrypted file
-                std::ostringstream oss;
-                for (size_t j = 0; j < serviceNames.size(); j++) {
-                    oss << serviceNames[j] << "|" << libraryPasswords[j] << std::endl;
-                }
-                std::string encryptedData = encrypt(oss.str());
-                std::ofstream outFile("passwords.dat", std::ios::binary);
-                if (outFile.is_open()) {
-                    outFile.write(encryptedData.c_str(), encryptedData.length());
-                    outFile.close();
-                }
-            }
+        UpdateAndDrawFrame(app, fonts, input);
+        ProfilerEndFrame(fonts.font14);
+        EndDrawing();
+        loader.frameDrawn();
 
-            if (CheckCollisionPointRec(GetMousePosition(), backButton) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                showLibrary = false;
-                SetWindowSize(screenWidth, screenHeight);
-                editingIndex = -1;
-            }
+        // Library view is taller than the generator view
+        if (windowHeight != ViewHeight(app)) {
+            windowHeight = ViewHeight(app);
+            SetWindowSize(screenWidth, windowHeight);
         }
-
-        EndDrawing();
     }
 
-    UnloadFont(font24);
-    UnloadFont(font20);
-    UnloadFont(font18);
-    UnloadFont(font16);
-    UnloadFont(font14);
+    loader.finish(app, fonts);
+    FlushPendingEntries(app);
+    app.clipboard.close();  // Before the window: the fallback clears through it
+    app.chrome.unload();
+    UnloadUiFonts(fonts);
     CloseWindow();
     return 0;
-}
\ No newline at end of file
+}
@@ -143,11 +143,19 @@ copy bin\artifacts\embedded_assets.h embedded_assets.h >nul
 
 REM Compile executable
 echo [INFO] Compiling executable...
-cl /EHsc /MD /I raylib\include main.cpp icon.res raylib\lib\raylib.lib user32.lib gdi32.lib winmm.lib shell32.lib msvcrt.lib /Fe:bin\PassGen.exe /link /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup
+cl /std:c++17 /EHsc /MD /I raylib\include main.cpp icon.res raylib\lib\raylib.lib user32.lib gdi32.lib winmm.lib shell32.lib bcrypt.lib msvcrt.lib /Fe:bin\PassGen.exe /link /SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup
 
 REM Clean up build artifacts
 del main.obj 2>nul
 
+REM Compile libpassgen: static library, and DLL with its import library (C ABI in include\passgen.h).
+REM Programs linking passgen_static.lib get bcrypt.lib from src\password_generator.h's #pragma.
+echo [INFO] Compiling libpassgen...
+cl /c /std:c++17 /EHsc /MD /O2 src\passgen.cpp /Fo:bin\artifacts\passgen.obj
+lib /nologo /OUT:bin\passgen_static.lib bin\artifacts\passgen.obj
+cl /LD /std:c++17 /EHsc /MD /O2 /DPASSGEN_SHARED /DPASSGEN_BUILDING src\passgen.cpp bcrypt.lib /Fe:bin\passgen.dll /Fo:bin\artifacts\passgen_dll.obj
+del bin\artifacts\passgen.obj bin\artifacts\passgen_dll.obj 2>nul
+
 REM Move icon.res to bin\artifacts after compilation
 echo [INFO] Moving icon.res to bin\artifacts...
 copy icon.res bin\artifacts\icon.res >nul
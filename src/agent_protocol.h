@@ -0,0 +1,179 @@
+#pragma once
+#include "secure_memory.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+// Binary protocol of the library agent (src/agent_server.h). Every message
+// is a uint32 length, little-endian, followed by that many bytes:
+//
+//   request:  uint8 op, then the op's payload
+//     AGENT_PING      nothing
+//     AGENT_LOOKUP    the service name; answered with its password
+//     AGENT_GENERATE  uint8 length; answered with a new password
+//   response: uint8 status, then the password for AGENT_OK
+//
+// Requests may be pipelined; responses come back in request order.
+enum AgentOp : uint8_t {
+    AGENT_PING,
+    AGENT_LOOKUP,
+    AGENT_GENERATE
+};
+
+enum AgentStatus : uint8_t {
+    AGENT_OK,
+    AGENT_NOT_FOUND,
+    AGENT_BAD_REQUEST
+};
+
+static constexpr uint32_t AGENT_MAX_MESSAGE = 4096;
+static constexpr int AGENT_MIN_GENERATE = 4;
+static constexpr int AGENT_MAX_GENERATE = 128;
+
+inline void putAgentMessage(std::vector<uint8_t>& out, uint8_t head, std::string_view payload) {
+    uint32_t length = (uint32_t)payload.size() + 1;
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(length >> (8 * i)));
+    out.push_back(head);
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// $XDG_RUNTIME_DIR/passgen-agent.sock, or else agent.sock in a directory of
+// the user's own in /tmp, created with mode 0700 so nobody else can put a
+// socket there first. Empty if that directory exists but belongs to someone
+// else or is open to others.
+inline std::string agentSocketPath() {
+    if (const char* runtime = getenv("XDG_RUNTIME_DIR")) return std::string(runtime) + "/passgen-agent.sock";
+#if defined(__linux__)
+    std::string directory = "/tmp/passgen-agent-" + std::to_string(getuid());
+    struct stat info;
+    if (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) return "";
+    if (lstat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) || info.st_uid != getuid() ||
+        (info.st_mode & 077) != 0) {
+        return "";
+    }
+    return directory + "/agent.sock";
+#else
+    return "/tmp/passgen-agent.sock";
+#endif
+}
+
+#if defined(__linux__)
+
+// Blocking client. request() is one round trip; send() and receive() keep
+// several requests in flight on the one connection.
+class AgentClient {
+private:
+    int fd = -1;
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> in;  // Received, starting at the next response
+    size_t inStart = 0;
+
+    bool flush() {
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = ::send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += (size_t)n;
+        }
+        secureZero(out.data(), out.size());
+        out.clear();
+        return true;
+    }
+
+public:
+    AgentClient() = default;
+    ~AgentClient() { close(); }
+    AgentClient(const AgentClient&) = delete;
+    AgentClient& operator=(const AgentClient&) = delete;
+
+    bool connect(const char* socketPath) {
+        close();
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (strlen(socketPath) >= sizeof(address.sun_path)) return false;
+        strcpy(address.sun_path, socketPath);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return false;
+        if (::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+            close();
+            return false;
+        }
+        // Only an agent of this user gets our requests, and answers them
+        ucred credentials = {};
+        socklen_t length = sizeof(credentials);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0 || credentials.uid != getuid()) {
+            close();
+            errno = EACCES;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        secureZero(in.data(), in.size());
+        in.clear();
+        inStart = 0;
+        out.clear();
+    }
+
+    bool isConnected() const { return fd >= 0; }
+
+    bool send(AgentOp op, std::string_view payload) {
+        putAgentMessage(out, op, payload);
+        return flush();
+    }
+
+    // The next response; its password, if any, goes to reply
+    bool receive(AgentStatus& status, std::string& reply) {
+        for (;;) {
+            size_t available = in.size() - inStart;
+            if (available >= 4) {
+                const uint8_t* p = in.data() + inStart;
+                uint32_t length = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+                if (length == 0 || length > AGENT_MAX_MESSAGE) return false;
+                if (available >= 4 + (size_t)length) {
+                    status = (AgentStatus)p[4];
+                    reply.assign((const char*)p + 5, length - 1);
+                    secureZero(in.data() + inStart, 4 + (size_t)length);
+                    inStart += 4 + (size_t)length;
+                    if (inStart == in.size()) {
+                        in.clear();
+                        inStart = 0;
+                    }
+                    return true;
+                }
+            }
+            if (inStart > 0) {
+                in.erase(in.begin(), in.begin() + inStart);
+                inStart = 0;
+            }
+            size_t used = in.size();
+            in.resize(used + 16384);
+            ssize_t n = recv(fd, in.data() + used, 16384, 0);
+            in.resize(used + (n > 0 ? (size_t)n : 0));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+        }
+    }
+
+    bool request(AgentOp op, std::string_view payload, AgentStatus& status, std::string& reply) {
+        return send(op, payload) && receive(status, reply);
+    }
+};
+
+#endif
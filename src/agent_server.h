@@ -0,0 +1,364 @@
+#pragma once
+#include "agent_protocol.h"
+#include "password_generator.h"
+#include "profiler.h"
+#include "secure_memory.h"
+#include "vault.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #include <cerrno>
+
+// Library agent: answers lookups and password generation over a Unix
+// domain socket (protocol in src/agent_protocol.h). One thread serves every
+// connection through epoll; sockets are non-blocking and requests pipelined
+// on a connection are answered in one write.
+//
+// Passwords are kept in a single page-locked buffer. Only peers running as
+// an allowed user (by default the agent's own) get past accept(): the
+// kernel's SO_PEERCRED says who they are, and the socket file is created
+// readable by its owner only.
+class AgentServer {
+public:
+    static constexpr int MAX_EVENTS = 64;
+    static constexpr size_t READ_CHUNK = 16384;
+    static constexpr size_t MAX_PENDING_OUTPUT = 1 << 20;  // Per connection; stop reading until it drains
+
+private:
+    struct Connection {
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        size_t outSent = 0;
+        uint32_t events = 0;
+    };
+
+    struct Entry {
+        uint32_t passwordOffset;
+        uint32_t passwordLength;
+    };
+
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    int watchedFd = -1;  // Not ours to close
+    std::string socketPath;
+    std::unordered_map<int, Connection> connections;
+    std::vector<uid_t> allowedUids;
+
+    // Names in one plain block, passwords in locked memory; the index points
+    // into the names. The first entry of a name wins.
+    std::string names;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string_view, uint32_t> index;
+    SecureBuffer secrets;
+    PasswordGenerator generator;
+
+    bool peerAllowed(int fd) const {
+        ucred credentials = {};
+        socklen_t length = sizeof(credentials);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) return false;
+        for (uid_t uid : allowedUids) {
+            if (uid == credentials.uid) return true;
+        }
+        return false;
+    }
+
+    void acceptPeers() {
+        for (;;) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;  // EAGAIN, or out of descriptors until some close
+            }
+            if (!peerAllowed(fd)) {
+                ::close(fd);
+                rejected++;
+                continue;
+            }
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+            connections[fd].events = EPOLLIN;
+        }
+    }
+
+    void drop(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        secureZero(it->second.out.data(), it->second.out.size());
+        connections.erase(it);
+    }
+
+    // Answer every complete request in the input; false on a malformed message
+    bool answer(Connection& connection) {
+        size_t at = 0;
+        std::vector<uint8_t>& in = connection.in;
+        while (in.size() - at >= 4 && connection.out.size() < MAX_PENDING_OUTPUT) {
+            const uint8_t* p = in.data() + at;
+            uint32_t length = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+            if (length == 0 || length > AGENT_MAX_MESSAGE) return false;
+            if (in.size() - at < 4 + (size_t)length) break;
+            respond((AgentOp)p[4], std::string_view((const char*)p + 5, length - 1), connection.out);
+            at += 4 + (size_t)length;
+            served++;
+        }
+        in.erase(in.begin(), in.begin() + at);
+        return true;
+    }
+
+    void respond(AgentOp op, std::string_view payload, std::vector<uint8_t>& out) {
+        switch (op) {
+            case AGENT_PING:
+                putAgentMessage(out, AGENT_OK, {});
+                return;
+            case AGENT_LOOKUP: {
+                auto it = index.find(payload);
+                if (it == index.end()) {
+                    putAgentMessage(out, AGENT_NOT_FOUND, {});
+                    return;
+                }
+                const Entry& entry = entries[it->second];
+                putAgentMessage(out, AGENT_OK,
+                                std::string_view((const char*)secrets.data() + entry.passwordOffset, entry.passwordLength));
+                return;
+            }
+            case AGENT_GENERATE:
+                if (payload.size() == 1 && (uint8_t)payload[0] >= AGENT_MIN_GENERATE && (uint8_t)payload[0] <= AGENT_MAX_GENERATE) {
+                    std::string password = generator.generate((uint8_t)payload[0]);
+                    putAgentMessage(out, AGENT_OK, password);
+                    secureZero(&password[0], password.size());
+                    return;
+                }
+                break;
+        }
+        putAgentMessage(out, AGENT_BAD_REQUEST, {});
+    }
+
+    // Write what the socket takes; false if the peer is gone
+    bool flush(Connection& connection, int fd) {
+        std::vector<uint8_t>& out = connection.out;
+        while (connection.outSent < out.size()) {
+            ssize_t n = ::send(fd, out.data() + connection.outSent, out.size() - connection.outSent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) return false;
+            connection.outSent += (size_t)n;
+        }
+        if (connection.outSent == out.size()) {
+            secureZero(out.data(), out.size());
+            out.clear();
+            connection.outSent = 0;
+        }
+        return true;
+    }
+
+    void serve(int fd, uint32_t events) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        Connection& connection = it->second;
+        bool closed = (events & EPOLLERR) != 0;
+        if (events & (EPOLLIN | EPOLLHUP)) {
+            for (;;) {
+                size_t used = connection.in.size();
+                connection.in.resize(used + READ_CHUNK);
+                ssize_t n = recv(fd, connection.in.data() + used, READ_CHUNK, 0);
+                connection.in.resize(used + (n > 0 ? (size_t)n : 0));
+                if (n > 0 && (size_t)n == READ_CHUNK) continue;
+                if (n < 0 && errno == EINTR) continue;
+                closed = closed || n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+                break;
+            }
+        }
+        if (!answer(connection) || !flush(connection, fd) || (closed && connection.out.empty())) {
+            drop(fd);
+            return;
+        }
+
+        // Wait for room to write while output is pending; stop reading while it's backed up
+        uint32_t wanted = (connection.out.size() < MAX_PENDING_OUTPUT ? (uint32_t)EPOLLIN : 0) |
+                          (connection.out.empty() ? 0 : (uint32_t)EPOLLOUT);
+        if (wanted != connection.events) {
+            epoll_event event = {};
+            event.events = wanted;
+            event.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+            connection.events = wanted;
+        }
+    }
+
+public:
+    uint64_t served = 0;    // Requests answered
+    uint64_t rejected = 0;  // Peers turned away by their credentials
+
+    AgentServer() { allowedUids.push_back(getuid()); }
+    ~AgentServer() { close(); }
+    AgentServer(const AgentServer&) = delete;
+    AgentServer& operator=(const AgentServer&) = delete;
+
+    void allowUid(uid_t uid) { allowedUids.push_back(uid); }
+
+    // Take over the library: passwords move into locked memory and are wiped
+    // from the vault. Call again to reload, between runs; after a failure
+    // the agent serves an empty library.
+    bool load(Vault& vault) {
+        PROFILE_ZONE("agent.load");
+        size_t passwordBytes = 0, nameBytes = 0;
+        for (size_t i = 0; i < vault.size(); i++) {
+            passwordBytes += vault.passwords[i].size();
+            nameBytes += vault.serviceNames[i].size();
+        }
+        index.clear();
+        entries.clear();
+        names.clear();
+        if (passwordBytes >= UINT32_MAX || !secrets.allocate(passwordBytes + 1)) return false;
+        names.reserve(nameBytes);
+        entries.reserve(vault.size());
+        uint32_t offset = 0;
+        for (size_t i = 0; i < vault.size(); i++) {
+            std::string& password = vault.passwords[i];
+            memcpy(secrets.data() + offset, password.data(), password.size());
+            entries.push_back({offset, (uint32_t)password.size()});
+            offset += (uint32_t)password.size();
+            secureZero(&password[0], password.size());
+            names += vault.serviceNames[i];
+        }
+        index.reserve(vault.size());
+        size_t at = 0;
+        for (size_t i = 0; i < vault.size(); i++) {
+            index.emplace(std::string_view(names).substr(at, vault.serviceNames[i].size()), (uint32_t)i);
+            at += vault.serviceNames[i].size();
+        }
+        return true;
+    }
+
+    size_t entryCount() const { return entries.size(); }
+    bool secretsLocked() const { return secrets.isLocked(); }
+    size_t connectionCount() const { return connections.size(); }
+
+    // Bind the socket at path. A stale socket file is replaced; one another
+    // agent still answers on is left alone (false, errno EADDRINUSE).
+    bool listen(const char* path) {
+        close();
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(address.sun_path)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        strcpy(address.sun_path, path);
+
+        struct stat info;
+        if (lstat(path, &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                errno = EEXIST;
+                return false;
+            }
+            AgentClient probe;
+            if (probe.connect(path)) {
+                errno = EADDRINUSE;
+                return false;
+            }
+            unlink(path);
+        }
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) return false;
+        mode_t mask = umask(077);
+        bool bound = bind(listenFd, (sockaddr*)&address, sizeof(address)) == 0;
+        umask(mask);
+        if (!bound) {
+            close();
+            return false;
+        }
+        socketPath = path;
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        bool ok = ::listen(listenFd, SOMAXCONN) == 0 && epollFd >= 0 && wakeFd >= 0 &&
+                  epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == 0;
+        event.data.fd = wakeFd;
+        if (!ok || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Serve until wake() is called; false on an epoll failure
+    bool run() {
+        epoll_event events[MAX_EVENTS];
+        for (;;) {
+            int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            bool woken = false;
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptPeers();
+                } else if (fd == wakeFd) {
+                    uint64_t count;
+                    if (read(wakeFd, &count, sizeof(count)) == sizeof(count)) woken = true;
+                } else if (fd == watchedFd) {
+                    woken = true;  // The caller reads it
+                } else {
+                    serve(fd, events[i].events);
+                }
+            }
+            if (woken) return true;
+        }
+    }
+
+    // Also return from run() while fd is readable, e.g. a VaultWatcher's;
+    // call after listen()
+    bool watch(int fd) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) return false;
+        watchedFd = fd;
+        return true;
+    }
+
+    // Make run() return, e.g. to reload or stop. Safe from a signal handler
+    // or another thread.
+    void wake() {
+        uint64_t one = 1;
+        if (wakeFd >= 0 && write(wakeFd, &one, sizeof(one)) < 0) {
+            // The counter is already set: run() is returning anyway
+        }
+    }
+
+    void close() {
+        while (!connections.empty()) drop(connections.begin()->first);
+        if (listenFd >= 0) ::close(listenFd);
+        if (epollFd >= 0) ::close(epollFd);
+        if (wakeFd >= 0) ::close(wakeFd);
+        listenFd = epollFd = wakeFd = watchedFd = -1;
+        if (!socketPath.empty()) unlink(socketPath.c_str());
+        socketPath.clear();
+    }
+};
+
+#endif
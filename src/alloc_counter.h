@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Global allocation counters. They only move in a binary that expands
+// PASSGEN_DEFINE_ALLOC_COUNTER() in exactly one translation unit, which
+// replaces the global operator new/delete with counting versions, and only
+// for threads that called trackThisThread(): the render loop must stay
+// allocation-free, background audit workers may allocate.
+struct AllocCounter {
+    static bool& tracked() {
+        thread_local bool enabled = false;
+        return enabled;
+    }
+
+    static void trackThisThread() { tracked() = true; }
+
+    static std::atomic<uint64_t>& allocations() {
+        static std::atomic<uint64_t> count{0};
+        return count;
+    }
+
+    static std::atomic<uint64_t>& bytes() {
+        static std::atomic<uint64_t> total{0};
+        return total;
+    }
+
+    static void* allocate(std::size_t size) {
+        if (tracked()) {
+            allocations().fetch_add(1, std::memory_order_relaxed);
+            bytes().fetch_add(size, std::memory_order_relaxed);
+        }
+        void* p = std::malloc(size ? size : 1);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+};
+
+#define PASSGEN_DEFINE_ALLOC_COUNTER() \
+    void* operator new(std::size_t size) { return AllocCounter::allocate(size); } \
+    void* operator new[](std::size_t size) { return AllocCounter::allocate(size); } \
+    void operator delete(void* p) noexcept { std::free(p); } \
+    void operator delete[](void* p) noexcept { std::free(p); } \
+    void operator delete(void* p, std::size_t) noexcept { std::free(p); } \
+    void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,952 @@
+#pragma once
+#include "raylib.h"
+#include "render_stats.h"
+#include "ui_cache.h"
+#include "frame_arena.h"
+#include "widgets.h"
+#include "profiler.h"
+#include "password_generator.h"
+#include "vault.h"
+#include "vault_import.h"
+#include "vault_journal.h"
+#include "vault_provision.h"
+#include "vault_set.h"
+#include "vault_sync.h"
+#include "undo_log.h"
+#include "audit_checks.h"
+#include "clipboard.h"  // Last: with PASSGEN_X11_CLIPBOARD it brings in Xlib's macros
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+const int SCREEN_WIDTH = 450;
+const int MAIN_VIEW_HEIGHT = 280;
+const int LIBRARY_VIEW_HEIGHT = 400;
+
+struct UiFonts {
+    Font font24;
+    Font font20;
+    Font font18;
+    Font font16;
+    Font font14;
+};
+
+// FreePixel is rasterized once, at a higher base size for better quality; the
+// five sizes share it, scaled down with point filtering for crisp pixels
+static constexpr int UI_FONT_BASE_SIZE = 120;
+static constexpr int UI_FONT_GLYPHS = 95;   // Standard ASCII character set
+static constexpr int UI_FONT_PADDING = 4;   // As LoadFontFromMemory()
+
+// A font before its atlas is uploaded. Rasterizing needs no GL context, so
+// the startup loader does it on its own thread; UploadFont() must run on the
+// main thread.
+struct FontPixels {
+    Font font = {};
+    Image atlas = {};
+};
+
+// LoadFontFromMemory() without the texture upload
+inline FontPixels RasterizeUiFont(const unsigned char* fontData, int fontDataSize, int baseSize) {
+    FontPixels pixels;
+    auto* glyphs = LoadFontData(fontData, fontDataSize, baseSize, nullptr, UI_FONT_GLYPHS, FONT_DEFAULT);
+    if (!glyphs) return pixels;
+    Rectangle* recs = nullptr;
+    pixels.atlas = GenImageFontAtlas(glyphs, &recs, UI_FONT_GLYPHS, baseSize, UI_FONT_PADDING, 0);
+    // Glyph images in alpha, as ImageDrawText() expects
+    for (int i = 0; i < UI_FONT_GLYPHS; i++) {
+        UnloadImage(glyphs[i].image);
+        glyphs[i].image = ImageFromImage(pixels.atlas, recs[i]);
+    }
+    // Positional: the count, padding and glyph fields were renamed in raylib 4
+    pixels.font = {baseSize, UI_FONT_GLYPHS, UI_FONT_PADDING, {}, recs, glyphs};
+    return pixels;
+}
+
+inline Font UploadFont(FontPixels& pixels) {
+    if (!pixels.atlas.data) return GetFontDefault();
+    Font font = pixels.font;
+    font.texture = LoadTextureFromImage(pixels.atlas);
+    SetTextureFilter(font.texture, TEXTURE_FILTER_POINT);
+    UnloadImage(pixels.atlas);
+    pixels = FontPixels();
+    return font;
+}
+
+inline UiFonts UiFontsFrom(Font font) {
+    return {font, font, font, font, font};
+}
+
+// Load FreePixel from embedded data
+inline UiFonts LoadUiFonts(const unsigned char* fontData, int fontDataSize, int baseSize = UI_FONT_BASE_SIZE) {
+    FontPixels pixels = RasterizeUiFont(fontData, fontDataSize, baseSize);
+    return UiFontsFrom(UploadFont(pixels));
+}
+
+inline void UnloadUiFonts(UiFonts& fonts) {
+    UnloadFont(fonts.font24);  // The others share it
+    fonts = UiFonts();
+}
+
+// Input consumed by one frame. Polled from raylib by the app, scripted by the UI benchmark.
+struct FrameInput {
+    Vector2 mouse = {0.0f, 0.0f};
+    bool mouseDown = false;
+    bool mousePressed = false;
+    bool rightPressed = false;
+    float wheel = 0.0f;
+    bool keySpace = false;
+    bool keyEnter = false;
+    bool keyC = false;
+    bool keyBackspace = false;
+    bool keyEscape = false;
+    bool keyUndo = false;
+    bool keyRedo = false;
+    bool keyTab = false;
+    int chars[16] = {0};
+    int charCount = 0;
+};
+
+inline FrameInput PollFrameInput() {
+    FrameInput input;
+    input.mouse = GetMousePosition();
+    input.mouseDown = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    input.mousePressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    input.rightPressed = IsMouseButtonPressed(MOUSE_RIGHT_BUTTON);
+    input.wheel = GetMouseWheelMove();
+    input.keySpace = IsKeyPressed(KEY_SPACE);
+    input.keyEnter = IsKeyPressed(KEY_ENTER);
+    input.keyC = IsKeyPressed(KEY_C);
+    input.keyBackspace = IsKeyPressed(KEY_BACKSPACE);
+    input.keyEscape = IsKeyPressed(KEY_ESCAPE);
+    bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    input.keyUndo = control && !shift && IsKeyPressed(KEY_Z);
+    input.keyRedo = control && (IsKeyPressed(KEY_Y) || (shift && IsKeyPressed(KEY_Z)));
+    input.keyTab = IsKeyPressed(KEY_TAB);
+    int key = GetCharPressed();
+    while (key > 0) {
+        if (input.charCount < 16) input.chars[input.charCount++] = key;
+        key = GetCharPressed();
+    }
+    return input;
+}
+
+struct AppState {
+    PasswordGenerator passGen;
+    std::string password = "";
+    int passwordLength = 12;
+    bool copied = false;
+    int copiedTimer = 0;
+    bool showLibrary = false;
+    int editingIndex = -1;
+    char editBuffer[MAX_SERVICE_NAME + 1] = "";
+    int scrollOffset = 0;
+    Vault library;
+    VaultJournal journal;  // Every edit is appended, folded into the vault file now and then; keeps entry history
+    UndoLog undo;          // Library edits of this session
+    VaultLock vaultLock;       // Held while reading the vault's files and from each edit to its commit
+    VaultWatcher journalWatch; // Batches other processes append are merged as they come
+    int vaultBusyTimer = 0;    // Frames left of "Vault busy" after an edit found the lock taken
+    bool libraryChanging = false;  // From BeginLibraryChange() to EndLibraryChange()
+
+    // Entries added while another process held the vault's lock; added,
+    // and wiped here, once it is free
+    std::vector<std::pair<std::string, std::string>> pendingAdds;
+
+    // Vault files given on the command line; the active one is the library,
+    // the others are only indexed until switched to
+    std::vector<std::string> vaultPaths;
+    size_t activeVault = 0;
+    VaultSet vaults;
+
+    // Set while the startup loader opens the vaults and the breach corpus on
+    // its thread; until StartupLoader::poll() clears it, frames keep away
+    // from the library and everything above
+    bool libraryLoading = false;
+
+    // Offline breach corpus (optional)
+    const char* breachDbPath = "breach_corpus.bin";
+    const char* breachFilterPath = "breach_corpus.filter";
+    BreachDb breachDb;
+
+    // Strength, breach, reuse and age audits of the library (AuditColumn)
+    AuditPipeline audits;
+
+    // Side effects, switched off by the headless benchmark
+    const char* vaultPath = "passwords.dat";
+    bool persistLibrary = true;
+    bool useClipboard = true;
+
+    // Copied passwords are cleared after a timeout, or after the first paste
+    SecretClipboard clipboard;
+
+    // Retained chrome layer and constant-string measurements
+    StaticLayer chrome;
+    TextLayoutCache layout;
+
+    // Interactive rectangles of the current frame
+    WidgetLayer widgets;
+
+    // Transient strings of the current frame, reset at the start of every frame
+    FrameArena arena;
+
+    // Measurement of the generated password, redone only when it changes
+    char measuredPassword[64] = "";
+    Vector2 measuredPasswordSize = {0.0f, 0.0f};
+    bool measuredPasswordSmall = false;
+
+    AppState() { AddLibraryAudits(audits, breachDb); }
+    AppState(const AppState&) = delete;
+    AppState& operator=(const AppState&) = delete;
+};
+
+inline int ViewHeight(const AppState& app) {
+    return app.showLibrary ? LIBRARY_VIEW_HEIGHT : MAIN_VIEW_HEIGHT;
+}
+
+// Load the vault file and replay its journal
+inline void LoadLibrary(AppState& app) {
+    // Another process may be compacting them; a vault that can't be locked
+    // is still read, but not written. A reload in the middle of an edit
+    // keeps the lock it holds.
+    if (app.persistLibrary && !app.vaultLock.isLocked() && !app.vaultLock.open(app.vaultPath)) {
+        TraceLog(LOG_WARNING, "VAULT: %s can't be locked, changes to the library won't be saved", app.vaultPath);
+        app.persistLibrary = false;
+    }
+    VaultLockGuard guard(app.vaultLock);
+    std::error_code error;
+    if (!loadVault(app.library, app.vaultPath) && std::filesystem::exists(app.vaultPath, error)) {
+        // Damaged, or compressed with a codec this build lacks: never save over it
+        TraceLog(LOG_WARNING, "VAULT: %s can't be read, changes to the library won't be saved", app.vaultPath);
+        app.persistLibrary = false;
+        return;
+    }
+    std::string journalPath = journalPathFor(app.vaultPath);
+    if (app.persistLibrary && !app.journal.open(app.library, journalPath.c_str())) {
+        // Edits replayed from it may be half applied: keep both files as they are
+        TraceLog(LOG_WARNING, "VAULT: %s can't be opened, changes to the library won't be saved", journalPath.c_str());
+        app.persistLibrary = false;
+    }
+    if (app.persistLibrary) app.journalWatch.watch(journalPath);
+}
+
+// Drop the library and load it again from its files; the session's undo
+// goes with it
+inline void ReloadLibrary(AppState& app) {
+    AuditVaultChange change(app.audits);
+    app.journal.close();
+    app.journalWatch.close();
+    app.undo.clear();
+    for (std::string& password : app.library.passwords) secureZero(&password[0], password.size());
+    app.library.truncate(0);
+    app.library.modifiedAt.clear();
+    app.library.revision++;
+    app.persistLibrary = true;
+    app.editingIndex = -1;
+    LoadLibrary(app);
+}
+
+// Open the vault files given on the command line, the first one as the library
+inline void OpenVaults(AppState& app, std::vector<std::string> paths) {
+    app.vaultPaths = std::move(paths);
+    if (app.vaultPaths.empty()) app.vaultPaths.push_back(app.vaultPath);
+    for (const std::string& path : app.vaultPaths) {
+        if (!app.vaults.open(path.c_str())) TraceLog(LOG_WARNING, "VAULT: %s can't be indexed", path.c_str());
+    }
+    app.activeVault = 0;
+    app.vaultPath = app.vaultPaths[0].c_str();
+    LoadLibrary(app);
+}
+
+// Tab in the library: make the next vault the library. Its edits are in
+// the journal already; undo doesn't reach across vaults.
+inline void SwitchVault(AppState& app) {
+    // Entries waiting for the lock belong to this vault
+    if (app.vaultPaths.size() < 2 || !app.pendingAdds.empty()) return;
+    app.activeVault = (app.activeVault + 1) % app.vaultPaths.size();
+    app.vaultPath = app.vaultPaths[app.activeVault].c_str();
+    app.scrollOffset = 0;
+    ReloadLibrary(app);
+}
+
+// Where library edits are journaled, or null when they aren't persisted that way
+inline VaultJournal* LibraryJournal(AppState& app) {
+    return app.persistLibrary && app.journal.isOpen() ? &app.journal : nullptr;
+}
+
+// Apply what merging the journal found. Undo doesn't reach across
+// processes: the indexes it holds may have moved. False if the entries did.
+inline bool TakeLibraryMerge(AppState& app, JournalMerge merged) {
+    if (merged == MERGE_NONE) return true;
+    app.undo.clear();
+    if (merged == MERGE_RELOAD) {
+        TraceLog(LOG_INFO, "VAULT: %s was rewritten by another process, loading it again", app.vaultPath);
+        ReloadLibrary(app);
+        return false;
+    }
+    if (merged == MERGE_EDITED) app.editingIndex = -1;
+    return merged == MERGE_APPENDED;
+}
+
+// Ends a change begun by BeginLibraryChange(), or nothing
+inline void EndLibraryChange(AppState& app) {
+    if (app.vaultLock.isLocked()) app.vaultLock.unlock();
+    if (app.libraryChanging) app.audits.endVaultChange();
+    app.libraryChanging = false;
+}
+
+// Frames "Vault busy" stays up, 2 seconds at 60 FPS
+const int VAULT_BUSY_FRAMES = 120;
+
+// Call before every library edit: takes the vault's lock, held until
+// CommitLibraryChange() or EndLibraryChange(), and what other processes
+// committed meanwhile. False, without the lock, when another process holds
+// it: the UI thread never waits for a commit or compaction elsewhere, and
+// shows "Vault busy" instead. Unless the edit only appends, also false when
+// what was committed moved the entries it would address by index. The edit
+// is dropped then.
+inline bool BeginLibraryChange(AppState& app, bool appendsOnly = false) {
+    if (LibraryJournal(app) && !app.vaultLock.tryLock()) {
+        if (app.vaultBusyTimer == 0) TraceLog(LOG_INFO, "VAULT: %s is busy in another process", app.vaultPath);
+        app.vaultBusyTimer = VAULT_BUSY_FRAMES;
+        return false;
+    }
+    app.audits.beginVaultChange();
+    app.libraryChanging = true;
+    if (!LibraryJournal(app)) return true;
+    if (TakeLibraryMerge(app, app.journal.catchUp(app.library)) || appendsOnly) return true;
+    EndLibraryChange(app);
+    return false;
+}
+
+// Call after every library edit, once its journal records are written. The
+// edit is committed to the journal; when the journal holds enough edits, or
+// isn't open, the vault file is rewritten instead.
+inline void CommitLibraryChange(AppState& app) {
+    app.library.revision++;
+    if (app.persistLibrary && !(app.journal.isOpen() && app.journal.commit() && !app.journal.wantsCompaction())) {
+        // The journal only starts over once the vault file holds its edits
+        if (!saveVault(app.library, app.vaultPath)) {
+            TraceLog(LOG_WARNING, "VAULT: %s can't be written, edits stay in the journal", app.vaultPath);
+        } else if (app.journal.isOpen() && !app.journal.reset(app.library)) {
+            TraceLog(LOG_WARNING, "VAULT: journal of %s can't be started over, the file is written again on the next edit",
+                     app.vaultPath);
+        }
+    }
+    EndLibraryChange(app);
+}
+
+// Between BeginLibraryChange() and CommitLibraryChange()
+inline void AppendLibraryEntry(AppState& app, const std::string& serviceName, const std::string& password) {
+    Vault& library = app.library;
+    library.add(serviceName, password);
+    size_t index = library.size() - 1;
+    if (VaultJournal* journal = LibraryJournal(app)) journal->add(serviceName, password, library.modifiedAt[index]);
+    app.undo.push(addCommand(index, serviceName, password, library.modifiedAt[index]));
+}
+
+// While the vault is busy the entry waits in pendingAdds: an append
+// addresses no index another process could move
+inline void AddLibraryEntry(AppState& app, const std::string& serviceName, const std::string& password) {
+    if (!app.pendingAdds.empty() || !BeginLibraryChange(app, true)) {
+        app.pendingAdds.emplace_back(serviceName, password);
+        return;
+    }
+    AppendLibraryEntry(app, serviceName, password);
+    CommitLibraryChange(app);
+}
+
+// The entries that waited for the lock, in one commit; the lock is taken
+inline void AddPendingEntries(AppState& app) {
+    for (std::pair<std::string, std::string>& entry : app.pendingAdds) {
+        AppendLibraryEntry(app, entry.first, entry.second);
+        secureZero(&entry.second[0], entry.second.size());
+    }
+    app.pendingAdds.clear();
+    CommitLibraryChange(app);
+}
+
+// Once a frame: take in what other processes committed to the library, then
+// add the entries that waited for the lock if it is free now
+inline void SyncLibrary(AppState& app) {
+    if (app.libraryLoading) return;
+    if (LibraryJournal(app) && app.journalWatch.changed()) {
+        AuditVaultChange change(app.audits);
+        TakeLibraryMerge(app, app.journal.merge(app.library));
+    }
+    if (!app.pendingAdds.empty() && BeginLibraryChange(app, true)) AddPendingEntries(app);
+}
+
+// On exit the entries still waiting for the lock are added, waiting for it
+inline void FlushPendingEntries(AppState& app) {
+    if (app.pendingAdds.empty() || !LibraryJournal(app) || !app.vaultLock.lock()) return;
+    if (BeginLibraryChange(app, true)) AddPendingEntries(app);
+    app.vaultLock.unlock();
+}
+
+inline void EraseLibraryEntry(AppState& app, int index) {
+    if (!BeginLibraryChange(app)) return;
+    Vault& library = app.library;
+    app.undo.push(eraseCommand(library, index));
+    if (VaultJournal* journal = LibraryJournal(app)) journal->erase(index);
+    secureZero(&library.passwords[index][0], library.passwords[index].size());
+    library.erase(index);
+    CommitLibraryChange(app);
+}
+
+// Change an entry, keeping its current version in the journal's history
+inline void ReplaceLibraryEntry(AppState& app, int index, std::string serviceName, std::string password) {
+    if (!BeginLibraryChange(app)) return;
+    Vault& library = app.library;
+    int64_t modified = index < (int)library.modifiedAt.size() ? library.modifiedAt[index] : 0;
+    int64_t newModified = password != library.passwords[index] ? (int64_t)time(nullptr) : modified;
+    if (VaultJournal* journal = LibraryJournal(app)) {
+        journal->addHistory(library.serviceNames[index], library.passwords[index], modified, serviceName, password);
+        journal->replace(index, serviceName, password, newModified);
+    }
+    app.undo.push(replaceCommand(library, index, serviceName, password, newModified));
+    library.replace(index, std::move(serviceName), std::move(password), newModified);
+    CommitLibraryChange(app);
+}
+
+// Step an entry back to its previous version; that version's own history
+// stays, the undone one is dropped at the next compaction
+inline bool RevertLibraryEntry(AppState& app, int index) {
+    if (!BeginLibraryChange(app)) return false;
+    Vault& library = app.library;
+    HistoryVersion version;
+    if (!app.journal.previousVersion(library.serviceNames[index], library.passwords[index], version)) {
+        EndLibraryChange(app);
+        return false;
+    }
+    if (VaultJournal* journal = LibraryJournal(app)) {
+        journal->replace(index, version.serviceName, version.password, version.modifiedAt);
+    }
+    app.undo.push(replaceCommand(library, index, version.serviceName, version.password, version.modifiedAt));
+    library.replace(index, std::string(version.serviceName), std::string(version.password), version.modifiedAt);
+    CommitLibraryChange(app);
+    return true;
+}
+
+// Ctrl+Z / Ctrl+Y in the library
+inline bool UndoLibraryEdit(AppState& app, bool redo) {
+    if (!BeginLibraryChange(app)) return false;
+    Vault& library = app.library;
+    bool applied = redo ? app.undo.redo(library, LibraryJournal(app)) : app.undo.undo(library, LibraryJournal(app));
+    if (!applied) {
+        if (app.journal.isOpen()) app.journal.rollback();
+        EndLibraryChange(app);
+        return false;
+    }
+    CommitLibraryChange(app);
+    return true;
+}
+
+// Publish finished audits and restart them when the library changed; never blocks
+inline void UpdateBackgroundAudits(AppState& app) {
+    if (!app.libraryLoading) app.audits.update(app.library);
+}
+
+// Audit result for a row of the current library, 0 while it is being computed
+inline uint8_t LibraryAudit(const AppState& app, AuditColumn column, int itemIndex) {
+    return app.audits.result(column, itemIndex, app.library.revision);
+}
+
+inline void CopySecret(AppState& app, const char* text) {
+    if (app.useClipboard) app.clipboard.copy(text);
+}
+
+// Helper function for crisp text rendering
+inline void DrawCrispText(Font font, const char* text, Vector2 position, float fontSize, Color tint) {
+    // The key to crisp text is using integer positions and proper spacing
+
+    // Round to nearest integer for better alignment
+    position.x = roundf(position.x);
+    position.y = roundf(position.y);
+
+    // For small fonts, ensure perfect pixel alignment by using integer positions
+    if (fontSize <= 20.0f) {
+        position.x = (int)position.x;
+        position.y = (int)position.y;
+    }
+
+    // For table rows, ensure consistent vertical alignment
+    if (position.y >= 195.0f && position.y <= 350.0f) {
+        // Ensure rows are aligned to 2-pixel boundaries for better appearance
+        position.y = (int)(position.y / 2) * 2;
+    }
+
+    // Use consistent spacing parameter (1.0f) for all text
+    // This ensures proper glyph spacing and prevents blurry rendering
+    DrawTextEx(font, text, position, fontSize, 1.0f, tint);
+    CountTextQuads(font, text);
+}
+
+// Static chrome shared by both views: title bar, slider track and labels, generate button
+inline void DrawCommonChrome(TextLayoutCache& layout, const UiFonts& fonts, int screenWidth) {
+    float centerX = screenWidth / 2.0f;
+
+    DrawUiRect({0.0f, 0.0f, (float)screenWidth, 40.0f}, BLUE);
+    Vector2 titleSize = layout.measure(fonts.font20, "Password Generator", 20);
+    DrawCrispText(fonts.font20, "Password Generator", {centerX - titleSize.x/2, 10}, 20, WHITE);
+
+    DrawUiRect({centerX - 120.0f, 68.0f, 240.0f, 10.0f}, DARKGRAY);
+    DrawCrispText(fonts.font16, "4", {centerX - 140.0f, 65.0f}, 16, LIGHTGRAY);
+    DrawCrispText(fonts.font16, "50", {centerX + 130.0f, 65.0f}, 16, LIGHTGRAY);
+
+    Vector2 genSize = layout.measure(fonts.font18, "Generate (SPACE)", 18);
+    float buttonWidth = genSize.x + 20.0f;
+    Rectangle genButton = {centerX - buttonWidth/2.0f, 95.0f, buttonWidth, 35.0f};
+    DrawUiRect(genButton, LIME);
+    float genButtonCenterY = genButton.y + genButton.height/2.0f - genSize.y/2.0f;
+    DrawCrispText(fonts.font18, "Generate (SPACE)", {centerX - genSize.x/2, genButtonCenterY}, 18, BLACK);
+}
+
+// Static chrome of the generator view: password box and button backgrounds
+inline void DrawMainChrome(TextLayoutCache& layout, const UiFonts& fonts, int screenWidth) {
+    Rectangle passBox = {15.0f, 140.0f, (float)(screenWidth - 30), 50.0f};
+    DrawUiRect(passBox, DARKGRAY);
+    DrawUiRectLines(passBox, 2, BLUE);
+
+    DrawUiRect({15.0f, 205.0f, 200.0f, 35.0f}, GREEN);
+    DrawUiRect({235.0f, 205.0f, 200.0f, 35.0f}, BLUE);
+
+    Vector2 libSize = layout.measure(fonts.font18, "LIBRARY", 18);
+    DrawCrispText(fonts.font18, "LIBRARY", {335.0f - libSize.x/2.0f, 213.0f}, 18, WHITE);
+}
+
+// Static chrome of the library view: table frame, headers and bottom buttons
+inline void DrawLibraryChrome(TextLayoutCache& layout, const UiFonts& fonts, int screenWidth) {
+    float centerX = screenWidth / 2.0f;
+
+    Vector2 libraryTitleSize = layout.measure(fonts.font18, "Password Library (Encrypted)", 18);
+    DrawCrispText(fonts.font18, "Password Library (Encrypted)", {centerX - libraryTitleSize.x/2.0f, 145}, 18, LIME);
+
+    Rectangle libraryArea = {15.0f, 170.0f, (float)(screenWidth - 30), 180.0f};
+    DrawUiRect(libraryArea, DARKGRAY);
+    DrawUiRectLines(libraryArea, 2, BLUE);
+
+    // Table headers (always visible) - use integer positions for pixel-perfect alignment
+    DrawCrispText(fonts.font16, "Service Name", {25, 175}, 16, LIME);
+    DrawCrispText(fonts.font16, "Password", {150, 175}, 16, LIME);
+    DrawCrispText(fonts.font16, "Actions", {320, 175}, 16, LIME);
+
+    // Header separator line
+    DrawUiLine(20, 190, 415, 190, BLUE);
+
+    // Back button (left side)
+    DrawUiRect({15.0f, 360.0f, 80.0f, 30.0f}, DARKGRAY);
+    Vector2 backTextSize = layout.measure(fonts.font16, "BACK", 16);
+    DrawCrispText(fonts.font16, "BACK", {15.0f + (80.0f - backTextSize.x)/2, 367.0f}, 16, WHITE);
+
+    // Add new entry button (right side)
+    DrawUiRect({355.0f, 360.0f, 80.0f, 30.0f}, BLUE);
+    Vector2 addTextSize = layout.measure(fonts.font16, "ADD NEW", 16);
+    DrawCrispText(fonts.font16, "ADD NEW", {355.0f + (80.0f - addTextSize.x)/2, 367.0f}, 16, WHITE);
+}
+
+// Re-render static chrome when the view changed. Must run outside
+// BeginDrawing()/BeginTextureMode() since it binds its own render target.
+inline void UpdateChrome(AppState& app, const UiFonts& fonts) {
+    int viewKey = app.showLibrary ? 1 : 0;
+    if (!app.chrome.needsRebuild(SCREEN_WIDTH, ViewHeight(app), viewKey)) return;
+
+    PROFILE_ZONE("layout.chrome");
+    app.chrome.beginRebuild(SCREEN_WIDTH, ViewHeight(app), viewKey);
+    ClearBackground(BLACK); // Dark theme background
+    DrawCommonChrome(app.layout, fonts, SCREEN_WIDTH);
+    if (!app.showLibrary) DrawMainChrome(app.layout, fonts, SCREEN_WIDTH);
+    else DrawLibraryChrome(app.layout, fonts, SCREEN_WIDTH);
+    app.chrome.endRebuild();
+}
+
+// Widget ids; library rows use ROW_WIDGET_BASE + row * 4 + column
+enum : uint32_t {
+    WIDGET_SLIDER = 1,
+    WIDGET_GENERATE,
+    WIDGET_COPY,
+    WIDGET_LIBRARY,
+    WIDGET_BACK,
+    WIDGET_ADD,
+    ROW_WIDGET_BASE = 0x1000
+};
+
+enum RowColumn { ROW_NAME = 0, ROW_COPY, ROW_GEN, ROW_DEL };
+
+inline uint32_t RowWidget(int itemIndex, RowColumn column) {
+    return ROW_WIDGET_BASE + (uint32_t)itemIndex * 4 + column;
+}
+
+// Row highlights for reused and near-duplicate passwords
+const Color REUSE_EXACT_COLOR = {110, 40, 0, 255};
+const Color REUSE_NEAR_COLOR = {70, 60, 0, 255};
+
+// Library table geometry
+const int LIBRARY_MAX_VISIBLE = 7; // Reduced to leave space below table
+
+inline float RowY(int visibleRow) {
+    // Use integer positions for pixel-perfect alignment
+    return 195.0f + visibleRow * 20.0f;
+}
+
+struct RowButtons {
+    Rectangle name, copy, gen, del;
+};
+
+inline RowButtons RowLayout(float yPos, float copyBtnWidth) {
+    return {
+        {25.0f, yPos - 2.0f, 120.0f, 18.0f},
+        {280.0f, yPos - 2.0f, copyBtnWidth, 18.0f},
+        {285.0f + copyBtnWidth, yPos - 2.0f, 35.0f, 18.0f},
+        {325.0f + copyBtnWidth, yPos - 2.0f, 35.0f, 18.0f},
+    };
+}
+
+// Import exports dropped onto the window (see vault_import.h), provision lists of
+// service names (.txt, see vault_provision.h), and show the first new row
+inline void ImportDroppedFiles(AppState& app) {
+    if (app.libraryLoading || !IsFileDropped()) return;  // Dropped files wait for the library
+#if defined(RAYLIB_VERSION_MAJOR) && (RAYLIB_VERSION_MAJOR > 4 || RAYLIB_VERSION_MINOR >= 2)
+    FilePathList dropped = LoadDroppedFiles();
+    unsigned int count = dropped.count;
+    char** paths = dropped.paths;
+#else
+    int count = 0;
+    char** paths = GetDroppedFiles(&count);
+#endif
+    // Each file is a commit of its own, all under one hold of the lock
+    bool locked = BeginLibraryChange(app, true);
+    size_t firstNew = app.library.size();
+    for (unsigned int i = 0; locked && i < (unsigned int)count; i++) {
+        size_t before = app.library.size();
+        size_t length = strlen(paths[i]);
+        if (length >= 4 && strcmp(paths[i] + length - 4, ".txt") == 0) {
+            // A list of service names: provision each with a password of the slider's length
+            FILE* in = fopen(paths[i], "rb");
+            ProvisionResult result;
+            if (in) {
+                result = provisionVault(app.library, LibraryJournal(app), in, app.passwordLength, app.passGen);
+                fclose(in);
+            }
+            if (result.ok) TraceLog(LOG_INFO, "PROVISION: %s: %zu entries, %zu skipped", paths[i], result.created, result.skipped);
+            else TraceLog(LOG_WARNING, "PROVISION: %s: %s", paths[i], in ? result.error : "cannot open the file");
+        } else {
+            ImportResult result = importVault(app.library, LibraryJournal(app), paths[i]);
+            if (result.ok) TraceLog(LOG_INFO, "IMPORT: %s: %zu entries, %zu skipped, %zu names cut to %zu bytes", paths[i],
+                                    result.imported, result.skipped, result.shortened, MAX_SERVICE_NAME);
+            else TraceLog(LOG_WARNING, "IMPORT: %s: %s", paths[i], result.error);
+        }
+        if (app.library.size() > before) app.undo.push(importCommand(before, app.library.size() - before));
+    }
+    EndLibraryChange(app);
+#if defined(RAYLIB_VERSION_MAJOR) && (RAYLIB_VERSION_MAJOR > 4 || RAYLIB_VERSION_MINOR >= 2)
+    UnloadDroppedFiles(dropped);
+#else
+    ClearDroppedFiles();
+#endif
+    if (app.library.size() > firstNew) {
+        app.showLibrary = true;
+        app.editingIndex = -1;
+        app.scrollOffset = (int)std::min(firstNew, app.library.size() - std::min<size_t>(app.library.size(), LIBRARY_MAX_VISIBLE));
+    }
+}
+
+// Handle one frame of input and draw it into the current render target.
+// Layout registers widgets, the widget layer resolves the mouse once, input
+// is applied, and only then is anything drawn.
+inline void UpdateAndDrawFrame(AppState& app, const UiFonts& fonts, const FrameInput& input) {
+    const int screenWidth = SCREEN_WIDTH;
+    std::vector<std::string>& serviceNames = app.library.serviceNames;
+    std::vector<std::string>& libraryPasswords = app.library.passwords;
+
+    // Center calculations
+    float centerX = screenWidth / 2.0f;
+
+    // Layout
+    Rectangle sliderBar = {centerX - 120.0f, 68.0f, 240.0f, 10.0f};
+    Vector2 genSize = app.layout.measure(fonts.font18, "Generate (SPACE)", 18);
+    float buttonWidth = genSize.x + 20.0f; // Add padding
+    Rectangle genButton = {centerX - buttonWidth/2.0f, 95.0f, buttonWidth, 35.0f};
+    Rectangle copyButton = {15.0f, 205.0f, 200.0f, 35.0f};
+    Rectangle libraryButton = {235.0f, 205.0f, 200.0f, 35.0f};
+    Rectangle backButton = {15.0f, 360.0f, 80.0f, 30.0f};
+    Rectangle addButton = {355.0f, 360.0f, 80.0f, 30.0f};
+    float copyBtnWidth = app.layout.measure(fonts.font14, "COPY", 14).x + 10.0f;
+
+    WidgetLayer& widgets = app.widgets;
+    widgets.begin();
+    widgets.add(WIDGET_SLIDER, sliderBar);
+    widgets.add(WIDGET_GENERATE, genButton);
+
+    if (!app.showLibrary) {
+        widgets.add(WIDGET_COPY, copyButton);
+        widgets.add(WIDGET_LIBRARY, libraryButton);
+    } else {
+        // Scroll handling
+        int totalItems = app.libraryLoading ? 0 : (int)serviceNames.size();
+        if (totalItems > LIBRARY_MAX_VISIBLE) {
+            app.scrollOffset -= (int)input.wheel;
+            if (app.scrollOffset < 0) app.scrollOffset = 0;
+            if (app.scrollOffset > totalItems - LIBRARY_MAX_VISIBLE) app.scrollOffset = totalItems - LIBRARY_MAX_VISIBLE; // Remove extra padding
+        }
+
+        int visibleRows = std::min(totalItems - app.scrollOffset, LIBRARY_MAX_VISIBLE);
+        for (int i = 0; i < visibleRows; i++) {
+            int itemIndex = i + app.scrollOffset;
+            RowButtons row = RowLayout(RowY(i), copyBtnWidth);
+            if (app.editingIndex != itemIndex) widgets.add(RowWidget(itemIndex, ROW_NAME), row.name);
+            widgets.add(RowWidget(itemIndex, ROW_COPY), row.copy);
+            widgets.add(RowWidget(itemIndex, ROW_GEN), row.gen);
+            widgets.add(RowWidget(itemIndex, ROW_DEL), row.del);
+        }
+        widgets.add(WIDGET_BACK, backButton);
+        if (!app.libraryLoading) widgets.add(WIDGET_ADD, addButton);
+    }
+
+    {   // Input handling
+        PROFILE_ZONE("input");
+        widgets.resolve(input.mouse, input.mouseDown, input.mousePressed);
+
+        if (widgets.held(WIDGET_SLIDER)) {
+            float mouseX = input.mouse.x;
+            app.passwordLength = 4 + (int)((mouseX - (centerX - 120.0f)) * 46.0f / 240.0f);
+            if (app.passwordLength < 4) app.passwordLength = 4;
+            if (app.passwordLength > 50) app.passwordLength = 50;
+        }
+
+        if (input.keySpace || input.keyEnter || widgets.clicked(WIDGET_GENERATE)) {
+            app.password = app.passGen.generate(app.passwordLength);
+            app.copied = false;
+        }
+        if ((input.keyC || widgets.clicked(WIDGET_COPY)) && !app.password.empty()) {
+            CopySecret(app, app.password.c_str());
+            app.copied = true;
+            app.copiedTimer = 120; // 2 seconds at 60 FPS
+        }
+
+        if (app.copiedTimer > 0) app.copiedTimer--;
+        if (app.copiedTimer == 0) app.copied = false;
+        if (app.vaultBusyTimer > 0) app.vaultBusyTimer--;
+
+        if (widgets.clicked(WIDGET_LIBRARY)) {
+            app.showLibrary = true;
+        }
+
+        if (app.showLibrary && app.editingIndex >= 0 && app.editingIndex < (int)serviceNames.size()) {
+            // Edit mode for service name
+            for (int c = 0; c < input.charCount; c++) {
+                int key = input.chars[c];
+                // '|' ends the name in the vault file
+                if ((key >= 32) && (key <= 125) && key != '|' && (strlen(app.editBuffer) < MAX_SERVICE_NAME)) {
+                    int len = strlen(app.editBuffer);
+                    app.editBuffer[len] = (char)key;
+                    app.editBuffer[len+1] = '\0';
+                }
+            }
+
+            if (input.keyBackspace && strlen(app.editBuffer) > 0) {
+                app.editBuffer[strlen(app.editBuffer)-1] = '\0';
+            }
+
+            if (input.keyEnter && strlen(app.editBuffer) > 0) {
+                int index = app.editingIndex;
+                app.editingIndex = -1;
+
+                if (serviceNames[index] != app.editBuffer) ReplaceLibraryEntry(app, index, app.editBuffer, libraryPasswords[index]);
+            }
+
+            if (input.keyEscape) {
+                app.editingIndex = -1;
+            }
+        }
+
+        // Library row actions, resolved from the single hovered widget
+        uint32_t hovered = widgets.hovered();
+        if (input.mousePressed && hovered >= ROW_WIDGET_BASE) {
+            int itemIndex = (int)((hovered - ROW_WIDGET_BASE) / 4);
+            RowColumn column = (RowColumn)((hovered - ROW_WIDGET_BASE) % 4);
+
+            if (column == ROW_NAME) {
+                // Older vaults may hold longer names; those are not cut short by an edit
+                if (serviceNames[itemIndex].size() <= MAX_SERVICE_NAME) {
+                    app.editingIndex = itemIndex;
+                    snprintf(app.editBuffer, sizeof(app.editBuffer), "%s", serviceNames[itemIndex].c_str());
+                } else {
+                    TraceLog(LOG_WARNING, "VAULT: names over %zu bytes can't be edited here", MAX_SERVICE_NAME);
+                }
+            } else if (column == ROW_COPY) {
+                CopySecret(app, libraryPasswords[itemIndex].c_str());
+            } else if (column == ROW_GEN) {
+                ReplaceLibraryEntry(app, itemIndex, serviceNames[itemIndex], app.passGen.generate(app.passwordLength));
+            } else if (column == ROW_DEL) {
+                int totalItems = (int)serviceNames.size();
+                if (app.scrollOffset > 0 && itemIndex == totalItems - 1) app.scrollOffset--;
+                if (app.editingIndex == itemIndex) app.editingIndex = -1;
+                else if (app.editingIndex > itemIndex) app.editingIndex--;
+
+                EraseLibraryEntry(app, itemIndex);
+            }
+        }
+
+        // Right-click on GEN brings back the password it replaced
+        if (input.rightPressed && hovered >= ROW_WIDGET_BASE && (hovered - ROW_WIDGET_BASE) % 4 == ROW_GEN) {
+            RevertLibraryEntry(app, (int)((hovered - ROW_WIDGET_BASE) / 4));
+        }
+
+        if (widgets.clicked(WIDGET_ADD)) {
+            AddLibraryEntry(app, "new_service", app.passGen.generate(app.passwordLength));
+        }
+
+        bool libraryKeys = app.showLibrary && app.editingIndex < 0 && !app.libraryLoading;
+        if (libraryKeys && (input.keyUndo || input.keyRedo) && UndoLibraryEdit(app, input.keyRedo)) {
+            int lastPage = std::max(0, (int)serviceNames.size() - LIBRARY_MAX_VISIBLE);
+            if (app.scrollOffset > lastPage) app.scrollOffset = lastPage;
+        }
+
+        if (libraryKeys && input.keyTab) SwitchVault(app);
+
+        if (widgets.clicked(WIDGET_BACK)) {
+            app.showLibrary = false;
+            app.editingIndex = -1;
+        }
+    }
+
+    UpdateBackgroundAudits(app);
+
+    // Drawing
+    FrameStats().reset();
+    app.arena.reset();
+    app.chrome.draw();
+
+    // Password length with slider (centered)
+    const char* lengthText = app.arena.format("Length: %d", app.passwordLength);
+    Vector2 lengthSize = MeasureTextEx(fonts.font18, lengthText, 18, 1.0f);
+    DrawCrispText(fonts.font18, lengthText, {centerX - lengthSize.x/2, 50}, 18, WHITE);
+
+    Rectangle sliderKnob = {centerX - 120.0f + (app.passwordLength - 4) * 240.0f / 46.0f - 5.0f, 63.0f, 10.0f, 20.0f};
+    DrawUiRect(sliderKnob, LIME);
+
+    if (!app.showLibrary) {
+        // Main generator view
+        PROFILE_ZONE("draw.main");
+        if (!app.password.empty()) {
+            const char* passText = app.password.c_str();
+            if (strcmp(app.measuredPassword, passText) != 0) {
+                snprintf(app.measuredPassword, sizeof(app.measuredPassword), "%s", passText);
+                Vector2 textSize = MeasureTextEx(fonts.font18, passText, 18, 1.0f);
+                app.measuredPasswordSmall = textSize.x > screenWidth - 50;
+                app.measuredPasswordSize = app.measuredPasswordSmall ? MeasureTextEx(fonts.font16, passText, 16, 1.0f) : textSize;
+            }
+            if (app.measuredPasswordSmall) {
+                DrawCrispText(fonts.font16, passText, {centerX - app.measuredPasswordSize.x/2.0f, 155.0f}, 16, LIME);
+            } else {
+                DrawCrispText(fonts.font18, passText, {centerX - app.measuredPasswordSize.x/2.0f, 155.0f}, 18, LIME);
+            }
+        } else {
+            Vector2 placeholderSize = app.layout.measure(fonts.font16, "Generated password appears here", 16);
+            DrawCrispText(fonts.font16, "Generated password appears here", {centerX - placeholderSize.x/2.0f, 155.0f}, 16, LIGHTGRAY);
+        }
+
+        // Copy button label (backgrounds come from the chrome layer)
+        const char* copyText = app.copied ? "Copied to clipboard!" : "COPY";
+        Vector2 copySize = app.layout.measure(fonts.font18, copyText, 18);
+        DrawCrispText(fonts.font18, copyText, {115.0f - copySize.x/2.0f, 213.0f}, 18, WHITE);
+    } else {
+        // Library view (frame, headers and bottom buttons come from the chrome layer)
+        PROFILE_ZONE("draw.library");
+
+        // Enable scissor test for clipping content only
+        BeginScissorMode(15, 195, screenWidth - 35, 155);
+
+        int totalItems = app.libraryLoading ? 0 : (int)serviceNames.size();
+        if (app.libraryLoading) {
+            Vector2 loadingSize = app.layout.measure(fonts.font14, "Loading library...", 14);
+            DrawCrispText(fonts.font14, "Loading library...", {centerX - loadingSize.x/2.0f, 255.0f}, 14, LIGHTGRAY);
+        }
+        int visibleRows = std::min(totalItems - app.scrollOffset, LIBRARY_MAX_VISIBLE);
+
+        // Display services
+        for (int i = 0; i < visibleRows; i++) {
+            int itemIndex = i + app.scrollOffset;
+            float yPos = RowY(i);
+            RowButtons row = RowLayout(yPos, copyBtnWidth);
+
+            // Highlight rows whose password is reused or a near duplicate
+            uint8_t reuse = LibraryAudit(app, AUDIT_REUSE, itemIndex);
+            if (reuse & REUSE_EXACT) DrawUiRect({20.0f, yPos - 2.0f, 390.0f, 18.0f}, REUSE_EXACT_COLOR);
+            else if (reuse & REUSE_NEAR) DrawUiRect({20.0f, yPos - 2.0f, 390.0f, 18.0f}, REUSE_NEAR_COLOR);
+
+            if (app.editingIndex == itemIndex) {
+                // Edit mode for service name
+                DrawUiRect(row.name, WHITE);
+                DrawUiRectLines(row.name, 1, BLUE);
+                // The end of a long name, where the typing happens
+                size_t length = strlen(app.editBuffer);
+                char shown[20];
+                if (length > 15) snprintf(shown, sizeof(shown), "...%s", app.editBuffer + length - 12);
+                DrawCrispText(fonts.font14, length > 15 ? shown : app.editBuffer, {30, yPos}, 14, BLACK);
+            } else {
+                // Display mode - Service name column
+                const char* serviceName = app.arena.truncate(serviceNames[itemIndex], 12);
+                DrawCrispText(fonts.font14, serviceName, {25, yPos}, 14, WHITE);
+            }
+
+            // Password column: breached passwords in red, weak ones in yellow
+            const char* password = app.arena.truncate(libraryPasswords[itemIndex], 15);
+            Color passwordColor = LIME;
+            if (LibraryAudit(app, AUDIT_BREACH, itemIndex) == BREACH_FOUND) passwordColor = RED;
+            else if (LibraryAudit(app, AUDIT_STRENGTH, itemIndex) == STRENGTH_WEAK) passwordColor = YELLOW;
+            DrawCrispText(fonts.font14, password, {150, yPos}, 14, passwordColor);
+
+            DrawUiRect(row.copy, BLUE);
+            DrawUiRect(row.gen, GREEN);
+            DrawUiRect(row.del, RED);
+
+            // Use integer positions for button text to ensure pixel-perfect alignment
+            DrawCrispText(fonts.font14, "COPY", {284.0f, yPos}, 14, WHITE);
+            DrawCrispText(fonts.font14, "GEN", {290.0f + copyBtnWidth, yPos}, 14, WHITE);
+            DrawCrispText(fonts.font14, "DEL", {330.0f + copyBtnWidth, yPos}, 14, WHITE);
+
+            // Row separator line
+            if (i < visibleRows - 1) {
+                DrawUiLine(20, yPos + 16, 410, yPos + 16, BLUE);
+            }
+        }
+
+        EndScissorMode();
+
+        // Scrollbar (inside library area)
+        if (totalItems > LIBRARY_MAX_VISIBLE) {
+            float scrollBarHeight = (LIBRARY_MAX_VISIBLE - 1) * 20.0f + 14.0f; // Height based on actual content area
+            Rectangle scrollBar = {412.0f, 195.0f, 5.0f, scrollBarHeight};
+            DrawUiRect(scrollBar, DARKGRAY);
+
+            float thumbHeight = (float)LIBRARY_MAX_VISIBLE / totalItems * scrollBarHeight;
+            if (thumbHeight < 10.0f) thumbHeight = 10.0f; // Minimum thumb size
+            float thumbY = 195.0f + ((float)app.scrollOffset / (totalItems - LIBRARY_MAX_VISIBLE)) * (scrollBarHeight - thumbHeight);
+            Rectangle scrollThumb = {412.0f, thumbY, 5.0f, thumbHeight};
+            DrawUiRect(scrollThumb, LIME);
+        }
+
+        // Another process holds the vault's lock: in place of the vault's name
+        if (app.vaultBusyTimer > 0 || !app.pendingAdds.empty()) {
+            const char* busyText = app.pendingAdds.empty() ? "Vault busy, try again" : "Vault busy, adding when free";
+            Vector2 busySize = app.layout.measure(fonts.font14, busyText, 14);
+            DrawCrispText(fonts.font14, busyText, {centerX - busySize.x/2.0f, 368.0f}, 14, ORANGE);
+        } else if (!app.libraryLoading && app.vaultPaths.size() > 1) {
+            // Which vault is the library, Tab switches
+            const char* path = app.vaultPath;
+            for (const char* c = path; *c; c++) {
+                if (*c == '/' || *c == '\\') path = c + 1;
+            }
+            const char* vaultText = app.arena.format("%s  %zu/%zu", path, app.activeVault + 1, app.vaultPaths.size());
+            Vector2 vaultSize = MeasureTextEx(fonts.font14, vaultText, 14, 1.0f);
+            DrawCrispText(fonts.font14, vaultText, {centerX - vaultSize.x/2.0f, 368.0f}, 14, LIGHTGRAY);
+        }
+    }
+}
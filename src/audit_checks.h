@@ -0,0 +1,129 @@
+#pragma once
+#include "audit_pipeline.h"
+#include "breach_db.h"
+#include "reuse_audit.h"
+#include <cmath>
+
+// The library audits run by AuditPipeline, in column order
+enum AuditColumn {
+    AUDIT_STRENGTH = 0,
+    AUDIT_BREACH,
+    AUDIT_REUSE,
+    AUDIT_AGE
+};
+
+enum PasswordStrength : uint8_t {
+    STRENGTH_UNKNOWN = 0,
+    STRENGTH_WEAK,    // Under 40 bits
+    STRENGTH_FAIR,    // Under 60 bits
+    STRENGTH_STRONG
+};
+
+enum BreachStatus : uint8_t {
+    BREACH_UNKNOWN = 0,
+    BREACH_CLEAN,
+    BREACH_FOUND
+};
+
+enum PasswordAge : uint8_t {
+    AGE_UNKNOWN = 0,
+    AGE_CURRENT,
+    AGE_STALE
+};
+
+// Brute-force entropy estimate: length times log2 of the character classes
+// used. The 16 possible alphabets are tabulated once instead of calling
+// log2 per password.
+inline double PasswordEntropyBits(std::string_view password) {
+    static const double* bitsPerChar = []() {
+        static double table[16];
+        for (int classes = 0; classes < 16; classes++) {
+            int alphabet = (classes & 1 ? 26 : 0) + (classes & 2 ? 26 : 0) + (classes & 4 ? 10 : 0) + (classes & 8 ? 33 : 0);
+            table[classes] = alphabet > 0 ? std::log2((double)alphabet) : 0.0;
+        }
+        return table;
+    }();
+    int classes = 0;
+    for (char c : password) {
+        if (c >= 'a' && c <= 'z') classes |= 1;
+        else if (c >= 'A' && c <= 'Z') classes |= 2;
+        else if (c >= '0' && c <= '9') classes |= 4;
+        else classes |= 8;
+    }
+    return password.size() * bitsPerChar[classes];
+}
+
+class StrengthCheck : public AuditCheck {
+public:
+    const char* name() const override { return "strength"; }
+
+    void run(const AuditInput& input, size_t first, size_t last, uint8_t* out) const override {
+        for (size_t i = first; i < last; i++) {
+            double bits = PasswordEntropyBits(input.password(i));
+            out[i] = bits < 40.0 ? STRENGTH_WEAK : bits < 60.0 ? STRENGTH_FAIR : STRENGTH_STRONG;
+        }
+    }
+};
+
+// Lookups in the offline breach corpus; results stay unknown while it isn't open
+class BreachCheck : public AuditCheck {
+private:
+    const BreachDb& db;
+
+public:
+    explicit BreachCheck(const BreachDb& breachDb) : db(breachDb) {}
+    const char* name() const override { return "breach"; }
+
+    void run(const AuditInput& input, size_t first, size_t last, uint8_t* out) const override {
+        if (!db.isOpen()) return;
+        for (size_t i = first; i < last; i++) out[i] = db.containsPassword(input.password(i)) ? BREACH_FOUND : BREACH_CLEAN;
+    }
+};
+
+// Exact and near-duplicate reuse. The index is cross-entry state, so it is
+// brought up to date incrementally in begin() and only read per entry.
+class ReuseCheck : public AuditCheck {
+private:
+    ReuseAudit reuse;
+
+public:
+    const char* name() const override { return "reuse"; }
+
+    void begin(const AuditInput& input, ThreadPool& pool) override {
+        auto passwordAt = [&](size_t i) { return input.password(i); };
+        auto parallel = [&](size_t count, auto body) { pool.parallelForWait(0, count, ReuseAudit::BULK_MIN, body); };
+        reuse.sync(input.revision, input.size(), passwordAt, parallel);
+    }
+
+    void run(const AuditInput& input, size_t first, size_t last, uint8_t* out) const override {
+        (void)input;
+        for (size_t i = first; i < last; i++) out[i] = reuse.flags(i);
+    }
+
+    const ReuseAudit& index() const { return reuse; }
+};
+
+// Passwords not changed for maxAgeDays; entries without a timestamp stay unknown
+class AgeCheck : public AuditCheck {
+private:
+    int64_t maxAgeSeconds;
+
+public:
+    explicit AgeCheck(int maxAgeDays = 365) : maxAgeSeconds((int64_t)maxAgeDays * 86400) {}
+    const char* name() const override { return "age"; }
+
+    void run(const AuditInput& input, size_t first, size_t last, uint8_t* out) const override {
+        for (size_t i = first; i < last && i < input.modifiedAt.size(); i++) {
+            int64_t modified = input.modifiedAt[i];
+            if (modified > 0) out[i] = input.capturedAt - modified > maxAgeSeconds ? AGE_STALE : AGE_CURRENT;
+        }
+    }
+};
+
+// Register the standard checks in AuditColumn order
+inline void AddLibraryAudits(AuditPipeline& pipeline, const BreachDb& breachDb) {
+    pipeline.addCheck(std::make_unique<StrengthCheck>());
+    pipeline.addCheck(std::make_unique<BreachCheck>(breachDb));
+    pipeline.addCheck(std::make_unique<ReuseCheck>());
+    pipeline.addCheck(std::make_unique<AgeCheck>());
+}
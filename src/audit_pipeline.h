@@ -0,0 +1,249 @@
+#pragma once
+#include "profiler.h"
+#include "secure_memory.h"
+#include "thread_pool.h"
+#include "vault.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Copy of the library an audit works on, so checks never race with edits.
+// Taken on a pool thread in chunks, see AuditPipeline. Passwords are packed
+// back to back into one buffer (cheaper than copying a million
+// std::strings) and wiped afterwards.
+struct AuditInput {
+    uint64_t revision = 0;
+    int64_t capturedAt = 0;             // Unix time of the capture
+    std::string secrets;
+    std::vector<size_t> offsets;        // size() + 1 entries
+    std::vector<int64_t> modifiedAt;    // Same length as the vault's, may be shorter than size()
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    std::string_view password(size_t index) const {
+        return std::string_view(secrets.data() + offsets[index], offsets[index + 1] - offsets[index]);
+    }
+
+    // Sized once, so the buffer is never reallocated with passwords in it
+    void reserve(size_t entries, size_t secretBytes) {
+        secrets.resize(secretBytes);
+        offsets.resize(entries + 1);
+        offsets[0] = 0;
+    }
+
+    // Entries [first, last) of the vault, after those before first
+    void copyFrom(const Vault& vault, size_t first, size_t last) {
+        size_t offset = offsets[first];
+        for (size_t i = first; i < last; i++) {
+            vault.passwords[i].copy(&secrets[offset], vault.passwords[i].size());
+            offset += vault.passwords[i].size();
+            offsets[i + 1] = offset;
+        }
+        if (first < vault.modifiedAt.size()) {
+            size_t end = std::min(last, vault.modifiedAt.size());
+            modifiedAt.insert(modifiedAt.end(), vault.modifiedAt.begin() + first, vault.modifiedAt.begin() + end);
+        }
+    }
+
+    void wipe() {
+        secureZero(&secrets[0], secrets.size());
+    }
+};
+
+// One check of the audit, e.g. strength or breach lookup. A check owns one
+// result byte per entry; 0 means "not determined".
+class AuditCheck {
+public:
+    virtual ~AuditCheck() = default;
+    virtual const char* name() const = 0;
+
+    // Once per audit on a pool thread, before any run(). Audits never
+    // overlap, so this may update state that run() then reads. Heavy
+    // cross-entry work can fan out with pool.parallelForWait().
+    virtual void begin(const AuditInput& input, ThreadPool& pool) {
+        (void)input;
+        (void)pool;
+    }
+
+    // Results for entries [first, last) into out[first..last); called
+    // concurrently on disjoint ranges
+    virtual void run(const AuditInput& input, size_t first, size_t last, uint8_t* out) const = 0;
+};
+
+// Results of one audit, one column per check
+struct AuditSnapshot {
+    uint64_t revision = 0;
+    bool valid = false;
+    std::vector<std::vector<uint8_t>> columns;
+};
+
+// Runs every registered check over the whole library on a work-stealing pool.
+//
+// The UI calls update() once per frame. It never blocks: it publishes a
+// finished audit by swapping the front and back snapshots, cancels an
+// audit whose vault revision is outdated, and starts the next one once the
+// previous has drained. The front snapshot is only read and swapped on the
+// UI thread; workers write only the back one.
+//
+// The vault is copied on the pool too, GRAIN entries at a time under
+// captureMutex. The UI holds it around every change of the vault (see
+// beginVaultChange()), so it waits for one chunk at most, and a change
+// made while the copy is under way cancels the run.
+class AuditPipeline {
+public:
+    static constexpr size_t GRAIN = 2048;  // Entries per task at the finest split
+
+private:
+    struct Run {
+        AuditInput input;
+        const Vault* vault = nullptr;  // Read only under captureMutex, until captured
+        AuditSnapshot* out = nullptr;
+        bool captured = false;         // Under captureMutex
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> done{false};
+
+        ~Run() { input.wipe(); }  // Also when the pool dropped its tasks
+    };
+
+    std::vector<std::unique_ptr<AuditCheck>> checks;
+    AuditSnapshot snapshots[2];
+    int front = 0;
+    std::shared_ptr<Run> active;
+    uint64_t started = 0;
+    std::mutex captureMutex;
+    int vaultChanges = 0;  // Nesting of beginVaultChange(), UI thread only
+    ThreadPool pool;  // Declared last: joined before the checks and snapshots it uses go away
+
+    // Sizes, then passwords, a chunk per hold of the mutex; false if the
+    // vault changed meanwhile
+    bool capture(Run& run) {
+        PROFILE_ZONE("audit.capture");
+        size_t entries = 0, secretBytes = 0;
+        for (size_t first = 0;; first += GRAIN) {
+            std::lock_guard<std::mutex> hold(captureMutex);
+            if (run.cancelled.load(std::memory_order_relaxed)) return false;
+            entries = run.vault->size();
+            if (first >= entries) break;
+            for (size_t i = first; i < std::min(first + GRAIN, entries); i++) secretBytes += run.vault->passwords[i].size();
+        }
+        run.input.reserve(entries, secretBytes);
+        for (size_t first = 0; first < entries; first += GRAIN) {
+            std::lock_guard<std::mutex> hold(captureMutex);
+            if (run.cancelled.load(std::memory_order_relaxed)) return false;
+            run.input.copyFrom(*run.vault, first, std::min(first + GRAIN, entries));
+        }
+        std::lock_guard<std::mutex> hold(captureMutex);
+        run.captured = true;
+        return !run.cancelled.load(std::memory_order_relaxed);
+    }
+
+    // O(1) on the UI thread: copying the vault and clearing the columns
+    // happen on the pool
+    void start(const Vault& vault) {
+        auto run = std::make_shared<Run>();
+        run->input.revision = vault.revision;
+        run->input.capturedAt = (int64_t)time(nullptr);
+        run->vault = &vault;
+        run->out = &snapshots[1 - front];
+        run->out->revision = vault.revision;
+        run->out->valid = false;
+        active = run;
+        started++;
+
+        pool.submit([this, run]() {
+            if (!capture(*run)) {
+                run->input.wipe();
+                run->done.store(true, std::memory_order_release);
+                return;
+            }
+            run->out->columns.resize(checks.size());
+            for (std::vector<uint8_t>& column : run->out->columns) column.assign(run->input.size(), 0);
+            {
+                PROFILE_ZONE("audit.begin");
+                for (std::unique_ptr<AuditCheck>& check : checks) {
+                    if (run->cancelled.load(std::memory_order_relaxed)) break;
+                    check->begin(run->input, pool);
+                }
+            }
+            pool.parallelFor(0, run->input.size(), GRAIN,
+                [this, run](size_t first, size_t last) {
+                    if (run->cancelled.load(std::memory_order_relaxed)) return;
+                    PROFILE_ZONE("audit.chunk");
+                    for (size_t c = 0; c < checks.size(); c++) checks[c]->run(run->input, first, last, run->out->columns[c].data());
+                },
+                [run]() {
+                    run->input.wipe();
+                    run->done.store(true, std::memory_order_release);
+                });
+        });
+    }
+
+public:
+    explicit AuditPipeline(int threads = 0) : pool(threads) {}
+    ~AuditPipeline() { cancel(); }
+
+    // Register before the first update(); returns the check's column
+    int addCheck(std::unique_ptr<AuditCheck> check) {
+        checks.push_back(std::move(check));
+        return (int)checks.size() - 1;
+    }
+
+    AuditCheck* check(int column) { return checks[column].get(); }
+
+    void update(const Vault& vault) {
+        if (active && active->done.load(std::memory_order_acquire)) {
+            if (!active->cancelled.load(std::memory_order_relaxed)) {
+                front = 1 - front;
+                snapshots[front].valid = true;
+            }
+            active.reset();
+        }
+        if (active && active->input.revision != vault.revision) active->cancelled.store(true, std::memory_order_relaxed);
+        if (!active && (!snapshots[front].valid || snapshots[front].revision != vault.revision)) start(vault);
+    }
+
+    void cancel() {
+        if (active) active->cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    // Around every change of the vault passed to update(), on the UI
+    // thread; calls nest. Waits for at most one chunk of a copy under way,
+    // which is then cancelled: update() starts the audit again.
+    void beginVaultChange() {
+        if (vaultChanges++ > 0) return;
+        captureMutex.lock();
+        if (active && !active->captured) active->cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    void endVaultChange() {
+        if (--vaultChanges == 0) captureMutex.unlock();
+    }
+
+    bool busy() const { return active != nullptr; }
+    uint64_t runsStarted() const { return started; }
+    int threadCount() const { return pool.size(); }
+    const AuditSnapshot& snapshot() const { return snapshots[front]; }
+
+    // Result of a check for an entry of the given vault revision, 0 if not available
+    uint8_t result(int column, size_t index, uint64_t revision) const {
+        const AuditSnapshot& current = snapshots[front];
+        if (!current.valid || current.revision != revision || index >= current.columns[column].size()) return 0;
+        return current.columns[column][index];
+    }
+};
+
+// Holds a vault change of an AuditPipeline for a scope
+struct AuditVaultChange {
+    AuditPipeline& pipeline;
+
+    explicit AuditVaultChange(AuditPipeline& audits) : pipeline(audits) { pipeline.beginVaultChange(); }
+    ~AuditVaultChange() { pipeline.endVaultChange(); }
+    AuditVaultChange(const AuditVaultChange&) = delete;
+    AuditVaultChange& operator=(const AuditVaultChange&) = delete;
+};
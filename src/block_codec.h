@@ -0,0 +1,212 @@
+#pragma once
+#include "lz4_block.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(PASSGEN_HAVE_ZSTD)
+    #include <zstd.h>
+#endif
+
+// Compression of file segments. LZ4 is built in; zstd is available when the
+// build defines PASSGEN_HAVE_ZSTD and links libzstd. Both can use a shared
+// dictionary, which helps most when segments are small.
+enum BlockCodec : uint8_t {
+    CODEC_NONE = 0,
+    CODEC_LZ4 = 1,
+    CODEC_ZSTD = 2
+};
+
+inline bool codecAvailable(BlockCodec codec) {
+#if defined(PASSGEN_HAVE_ZSTD)
+    return codec <= CODEC_ZSTD;
+#else
+    return codec <= CODEC_LZ4;
+#endif
+}
+
+inline const char* codecName(BlockCodec codec) {
+    return codec == CODEC_LZ4 ? "lz4" : codec == CODEC_ZSTD ? "zstd" : "none";
+}
+
+// "none", "lz4", "zstd" or "zstd:<level>"; false for unknown or unavailable codecs
+inline bool parseCodec(const char* text, BlockCodec& codec, int& level) {
+    level = 0;
+    if (!strcmp(text, "none")) codec = CODEC_NONE;
+    else if (!strcmp(text, "lz4")) codec = CODEC_LZ4;
+    else if (!strncmp(text, "zstd", 4) && (text[4] == '\0' || text[4] == ':')) {
+        codec = CODEC_ZSTD;
+        if (text[4] == ':') level = atoi(text + 5);
+    } else {
+        return false;
+    }
+    return codecAvailable(codec);
+}
+
+// Builds a dictionary from a sample, in the spirit of zstd's COVER trainer:
+// the sample is split into one epoch per dictionary segment, and from each
+// epoch the window whose 8-byte shingles are most frequent across the whole
+// sample is taken. Taken shingles stop counting, so segments don't repeat.
+// The best segments go last, closest to the data they will be matched from.
+inline std::vector<uint8_t> trainDictionary(const uint8_t* sample, size_t size, size_t maxSize) {
+    const size_t SHINGLE = 8, SEGMENT = 32;
+    std::vector<uint8_t> dictionary;
+    if (size < SEGMENT * 16 || maxSize < SEGMENT) return dictionary;
+
+    // Frequencies are counted per hash bucket; collisions only blur the scores
+    const int BUCKET_LOG = 18;
+    auto bucketAt = [&](size_t i) {
+        uint64_t v;
+        memcpy(&v, sample + i, SHINGLE);
+        return (size_t)((v * 0x9E3779B97F4A7C15ULL) >> (64 - BUCKET_LOG));
+    };
+    std::vector<uint32_t> frequency((size_t)1 << BUCKET_LOG);
+    for (size_t i = 0; i + SHINGLE <= size; i++) frequency[bucketAt(i)]++;
+
+    size_t segments = std::min(maxSize / SEGMENT, size / (SEGMENT * 4));
+    size_t epoch = size / segments;
+    const size_t shingles = SEGMENT - SHINGLE + 1;
+    std::vector<std::pair<uint64_t, size_t>> picks;  // Score, position
+    std::vector<uint32_t> counts;
+    for (size_t e = 0; e < segments; e++) {
+        size_t start = e * epoch;
+        size_t last = std::min(start + epoch, size - SEGMENT + 1);
+        if (last <= start) break;
+        counts.resize(last - start + shingles - 1);
+        for (size_t i = 0; i < counts.size(); i++) {
+            uint32_t count = frequency[bucketAt(start + i)];
+            counts[i] = count > 1 ? count : 0;  // Shingles seen once are noise, e.g. random passwords
+        }
+        uint64_t windowScore = 0, bestScore = 0;
+        size_t best = start;
+        for (size_t i = 0; i < counts.size(); i++) {
+            windowScore += counts[i];
+            if (i >= shingles) windowScore -= counts[i - shingles];
+            if (i + 1 >= shingles && windowScore > bestScore) {
+                bestScore = windowScore;
+                best = start + i + 1 - shingles;
+            }
+        }
+        if (bestScore == 0) continue;
+        picks.emplace_back(bestScore, best);
+        for (size_t i = best; i < best + shingles; i++) frequency[bucketAt(i)] = 0;
+    }
+
+    std::sort(picks.begin(), picks.end());
+    for (const auto& pick : picks) dictionary.insert(dictionary.end(), sample + pick.second, sample + pick.second + SEGMENT);
+    return dictionary;
+}
+
+// Compresses and decompresses segments with one codec, level and dictionary
+class SegmentCodec {
+private:
+    BlockCodec codec = CODEC_NONE;
+    int level = 0;
+    std::vector<uint8_t> dictionary;
+    Lz4Block lz4;
+#if defined(PASSGEN_HAVE_ZSTD)
+    ZSTD_CCtx* cctx = nullptr;
+    ZSTD_DCtx* dctx = nullptr;
+    ZSTD_CDict* cdict = nullptr;
+    ZSTD_DDict* ddict = nullptr;
+
+    void freeZstd() {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+        cctx = nullptr;
+        dctx = nullptr;
+        cdict = nullptr;
+        ddict = nullptr;
+    }
+#endif
+
+public:
+    SegmentCodec() = default;
+    SegmentCodec(const SegmentCodec&) = delete;
+    SegmentCodec& operator=(const SegmentCodec&) = delete;
+    ~SegmentCodec() {
+#if defined(PASSGEN_HAVE_ZSTD)
+        freeZstd();
+#endif
+        secureZero(dictionary.data(), dictionary.size());
+    }
+
+    // level is for zstd, 0 meaning its default
+    void setup(BlockCodec useCodec, int useLevel, std::vector<uint8_t> dict) {
+        codec = useCodec;
+        level = useLevel;
+        secureZero(dictionary.data(), dictionary.size());
+        dictionary = std::move(dict);
+#if defined(PASSGEN_HAVE_ZSTD)
+        freeZstd();
+        if (codec == CODEC_ZSTD) {
+            if (level == 0) level = ZSTD_CLEVEL_DEFAULT;
+            cctx = ZSTD_createCCtx();
+            dctx = ZSTD_createDCtx();
+            if (!dictionary.empty()) {
+                cdict = ZSTD_createCDict(dictionary.data(), dictionary.size(), level);
+                ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+            }
+        }
+#endif
+    }
+
+    BlockCodec segmentCodec() const { return codec; }
+    const std::vector<uint8_t>& dictionaryBytes() const { return dictionary; }
+
+    size_t bound(size_t size) const {
+#if defined(PASSGEN_HAVE_ZSTD)
+        if (codec == CODEC_ZSTD) return ZSTD_compressBound(size);
+#endif
+        return Lz4Block::bound(size);
+    }
+
+    // Compress into dst, which must hold bound(size) bytes. Returns the codec
+    // the segment ended up in: CODEC_NONE, with the bytes copied, when
+    // compression didn't shrink them.
+    BlockCodec compress(const uint8_t* src, size_t size, uint8_t* dst, size_t& storedSize) {
+        storedSize = size;
+        if (codec == CODEC_LZ4) {
+            storedSize = lz4.compress(src, size, dst, dictionary.data(), dictionary.size());
+        }
+#if defined(PASSGEN_HAVE_ZSTD)
+        if (codec == CODEC_ZSTD) {
+            size_t result = cdict ? ZSTD_compress_usingCDict(cctx, dst, bound(size), src, size, cdict)
+                                  : ZSTD_compressCCtx(cctx, dst, bound(size), src, size, level);
+            storedSize = ZSTD_isError(result) ? size : result;
+        }
+#endif
+        if (codec != CODEC_NONE && storedSize < size) return codec;
+        if (size > 0) memcpy(dst, src, size);
+        storedSize = size;
+        return CODEC_NONE;
+    }
+
+    // Decompress exactly rawSize bytes of a segment stored with storedCodec
+    bool decompress(BlockCodec storedCodec, const uint8_t* src, size_t size, uint8_t* dst, size_t rawSize) {
+        switch (storedCodec) {
+            case CODEC_NONE:
+                if (size != rawSize) return false;
+                if (size > 0) memcpy(dst, src, size);
+                return true;
+            case CODEC_LZ4:
+                return Lz4Block::decompress(src, size, dst, rawSize, dictionary.data(), dictionary.size());
+#if defined(PASSGEN_HAVE_ZSTD)
+            case CODEC_ZSTD: {
+                if (!dctx) dctx = ZSTD_createDCtx();
+                if (!ddict && !dictionary.empty()) ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+                size_t result = ddict ? ZSTD_decompress_usingDDict(dctx, dst, rawSize, src, size, ddict)
+                                      : ZSTD_decompressDCtx(dctx, dst, rawSize, src, size);
+                return !ZSTD_isError(result) && result == rawSize;
+            }
+#endif
+            default:
+                return false;
+        }
+    }
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include "fuse_filter.h"
+#include "mapped_file.h"
+#include "sha1.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+// Offline breached-password corpus.
+//
+// File layout (little endian):
+//   BreachDbHeader
+//   uint64_t fanout[65537]   index of the first record of every 16-bit prefix
+//   uint8_t  records[count][20]   SHA-1 digests, sorted ascending, unique
+//
+// The file is memory-mapped; a lookup reads one fan-out pair and then
+// interpolation-searches a bucket of roughly count / 65536 records, which
+// for uniformly distributed hashes lands within a page or two of the target.
+//
+// An optional binary fuse filter (breach_corpus.filter, ~1.1 bytes per hash,
+// built by tools/breach_filter) is held in memory and consulted first, so
+// all but ~0.4% of negative lookups never touch the mapped file.
+
+struct BreachDbHeader {
+    char magic[8];        // "PGBRCH1\0"
+    uint32_t version;     // 1
+    uint32_t recordSize;  // 20
+    uint64_t count;
+};
+
+const char BREACH_DB_MAGIC[8] = {'P', 'G', 'B', 'R', 'C', 'H', '1', '\0'};
+const int BREACH_FANOUT_SIZE = 65537;
+
+// First 8 bytes after the 16-bit bucket prefix, big endian, used as the interpolation key
+inline uint64_t BreachKey(const uint8_t* digest) {
+    uint64_t key = 0;
+    for (int i = 2; i < 10; i++) key = (key << 8) | digest[i];
+    return key;
+}
+
+// First 8 bytes of the digest, big endian, used as the filter key
+inline uint64_t BreachFilterKey(const uint8_t* digest) {
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) key = (key << 8) | digest[i];
+    return key;
+}
+
+class BreachDb {
+private:
+    MappedFile file;
+    FuseFilterSet filter;
+    const uint64_t* fanout = nullptr;
+    const uint8_t* records = nullptr;
+    uint64_t recordCount = 0;
+
+public:
+    bool open(const char* path) {
+        close();
+        if (!file.open(path)) return false;
+
+        size_t tableBytes = sizeof(BreachDbHeader) + BREACH_FANOUT_SIZE * sizeof(uint64_t);
+        if (file.size() < tableBytes) { close(); return false; }
+
+        // Sizes by division: a damaged count must not wrap around
+        BreachDbHeader header;
+        memcpy(&header, file.data(), sizeof(header));
+        size_t recordBytes = file.size() - tableBytes;
+        if (memcmp(header.magic, BREACH_DB_MAGIC, 8) != 0 || header.version != 1 || header.recordSize != 20 ||
+            recordBytes % 20 != 0 || header.count != recordBytes / 20) {
+            close();
+            return false;
+        }
+
+        // contains() trusts the fan-out table to stay within the records
+        const uint64_t* table = (const uint64_t*)(file.data() + sizeof(BreachDbHeader));
+        bool ordered = table[0] == 0 && table[BREACH_FANOUT_SIZE - 1] == header.count;
+        for (int i = 1; i < BREACH_FANOUT_SIZE && ordered; i++) ordered = table[i - 1] <= table[i];
+        if (!ordered) {
+            close();
+            return false;
+        }
+
+        fanout = table;
+        records = file.data() + tableBytes;
+        recordCount = header.count;
+        return true;
+    }
+
+    // The filter must have been built from this corpus; a stale one would hide breaches
+    bool loadFilter(const char* path) {
+        if (!filter.load(path)) return false;
+        if (filter.sourceCount != recordCount) {
+            filter.shards.clear();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        file.close();
+        filter.shards.clear();
+        fanout = nullptr;
+        records = nullptr;
+        recordCount = 0;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+    bool hasFilter() const { return !filter.shards.empty(); }
+    uint64_t count() const { return recordCount; }
+    const uint8_t* record(uint64_t index) const { return records + index * 20; }
+
+    bool contains(const Sha1Digest& digest) const {
+        if (!records) return false;
+        const uint8_t* target = digest.bytes;
+        if (!filter.mayContain(BreachFilterKey(target))) return false;
+
+        uint32_t prefix = ((uint32_t)target[0] << 8) | target[1];
+        uint64_t lo = fanout[prefix];
+        uint64_t hi = fanout[prefix + 1];  // Exclusive
+        if (lo >= hi) return false;
+
+        // Interpolation search on the 64-bit key; hashes are uniform so this
+        // usually converges in two or three probes
+        uint64_t key = BreachKey(target);
+        for (int probe = 0; probe < 4 && hi - lo > 8; probe++) {
+            uint64_t keyLo = BreachKey(records + lo * 20);
+            uint64_t keyHi = BreachKey(records + (hi - 1) * 20);
+            if (key < keyLo || key > keyHi) return false;
+            if (keyHi == keyLo) break;
+
+            double fraction = (double)(key - keyLo) / (double)(keyHi - keyLo);
+            uint64_t mid = lo + (uint64_t)(fraction * (double)(hi - 1 - lo));
+            int cmp = memcmp(records + mid * 20, target, 20);
+            if (cmp == 0) return true;
+            if (cmp < 0) lo = mid + 1;
+            else hi = mid;
+        }
+
+        // Binary search over whatever is left
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            int cmp = memcmp(records + mid * 20, target, 20);
+            if (cmp == 0) return true;
+            if (cmp < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return false;
+    }
+
+    bool containsPassword(std::string_view password) const {
+        return contains(Sha1::hash(password));
+    }
+};
+
+// Streaming writer for the corpus file. Digests must arrive in ascending
+// order (the published "ordered by hash" corpus already is); duplicates are
+// dropped.
+class BreachDbWriter {
+private:
+    FILE* out = nullptr;
+    uint64_t* fanout = nullptr;
+    uint64_t count = 0;
+    uint8_t last[20] = {0};
+
+public:
+    ~BreachDbWriter() {
+        if (out) fclose(out);
+        delete[] fanout;
+    }
+
+    bool begin(const char* path) {
+        out = fopen(path, "wb");
+        if (!out) return false;
+        fanout = new uint64_t[BREACH_FANOUT_SIZE]();
+
+        // Header and fan-out table are rewritten in finish()
+        BreachDbHeader header = {};
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(fanout, sizeof(uint64_t), BREACH_FANOUT_SIZE, out);
+        return ferror(out) == 0;
+    }
+
+    // Returns false if the digest is out of order
+    bool add(const Sha1Digest& digest) {
+        if (count > 0) {
+            int cmp = memcmp(digest.bytes, last, 20);
+            if (cmp == 0) return true;
+            if (cmp < 0) return false;
+        }
+        fwrite(digest.bytes, 20, 1, out);
+        memcpy(last, digest.bytes, 20);
+        // Count per prefix for now, turned into start offsets in finish()
+        fanout[(((uint32_t)digest.bytes[0] << 8) | digest.bytes[1]) + 1]++;
+        count++;
+        return true;
+    }
+
+    uint64_t written() const { return count; }
+
+    bool finish() {
+        if (!out) return false;
+        for (int i = 1; i < BREACH_FANOUT_SIZE; i++) fanout[i] += fanout[i - 1];
+
+        BreachDbHeader header = {};
+        memcpy(header.magic, BREACH_DB_MAGIC, 8);
+        header.version = 1;
+        header.recordSize = 20;
+        header.count = count;
+
+        fseek(out, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, out);
+        fwrite(fanout, sizeof(uint64_t), BREACH_FANOUT_SIZE, out);
+        bool ok = ferror(out) == 0;
+        ok = fclose(out) == 0 && ok;
+        out = nullptr;
+        return ok;
+    }
+};
@@ -0,0 +1,400 @@
+#pragma once
+#include "raylib.h"
+#include "secure_memory.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(PASSGEN_X11_CLIPBOARD) && defined(__linux__)
+    #define PASSGEN_CLIPBOARD_X11
+    // Xlib's Font (a resource id) would clash with raylib's Font
+    #define Font XFont
+    #include <X11/Xlib.h>
+    #include <X11/Xatom.h>
+    #undef Font
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #define PASSGEN_CLIPBOARD_WIN32
+    // secure_memory.h includes windows.h without winuser.h, whose names clash
+    // with raylib's (CloseWindow, DrawText, ...); declare the few used here
+    #if !defined(_WINUSER_)
+    extern "C" {
+    __declspec(dllimport) BOOL WINAPI OpenClipboard(HWND owner);
+    __declspec(dllimport) BOOL WINAPI CloseClipboard(void);
+    __declspec(dllimport) BOOL WINAPI EmptyClipboard(void);
+    __declspec(dllimport) HANDLE WINAPI SetClipboardData(UINT format, HANDLE data);
+    __declspec(dllimport) DWORD WINAPI GetClipboardSequenceNumber(void);
+    __declspec(dllimport) UINT WINAPI RegisterClipboardFormatA(LPCSTR name);
+    }
+    #define CF_UNICODETEXT 13
+    #endif
+#endif
+
+// Puts passwords on the system clipboard and takes them off again: after a
+// timeout, and with paste-once after the first paste, but only while the
+// clipboard still holds what was copied. A worker thread keeps the time, so
+// clearing doesn't depend on the render loop running.
+//
+//   X11 (build with PASSGEN_X11_CLIPBOARD, link libX11): owns the CLIPBOARD
+//       selection on a connection of its own and hands the text out on each
+//       request, so pastes can be counted and the selection dropped after
+//       the first. Wayland sessions run the application on XWayland, which
+//       forwards pastes of Wayland clients as such requests. Clipboard
+//       managers that honor KDE's password hint don't keep a copy.
+//   Windows: the worker sets the text, marked to stay out of clipboard
+//       history and cloud sync, and clears it if the clipboard's sequence
+//       number hasn't moved since. No paste-once: that needs delayed
+//       rendering, i.e. a window procedure of its own.
+//   Elsewhere, or with no X display: raylib's clipboard on the main thread,
+//       with the timeout checked by update().
+class SecretClipboard {
+public:
+    static constexpr int DEFAULT_CLEAR_SECONDS = 30;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int clearAfterSeconds = DEFAULT_CLEAR_SECONDS;
+    bool pasteOnce = false;
+    bool started = false;
+    bool native = false;
+
+    // Requests to the worker
+    std::mutex mutex;
+    std::condition_variable wakeWorker;
+    std::string pending;
+    bool copyRequested = false;
+    bool clearRequested = false;
+    bool stopping = false;
+    int pendingClearAfter = 0;
+    bool pendingPasteOnce = false;
+    std::thread worker;
+
+    // raylib fallback
+    std::string copied;
+    bool timed = false;
+    Clock::time_point deadline;
+
+#if defined(PASSGEN_CLIPBOARD_X11)
+    Display* display = nullptr;
+    ::Window window = 0;
+    int wakeFd = -1;
+#endif
+
+    static void wipe(std::string& text) {
+        secureZero(&text[0], text.size());
+        text.clear();
+    }
+
+    void start() {
+        started = true;
+#if defined(PASSGEN_CLIPBOARD_X11)
+        display = XOpenDisplay(nullptr);
+        if (!display) return;
+        window = XCreateSimpleWindow(display, DefaultRootWindow(display), 0, 0, 1, 1, 0, 0, 0);
+        wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wakeFd < 0) {
+            XDestroyWindow(display, window);
+            XCloseDisplay(display);
+            display = nullptr;
+            return;
+        }
+        native = true;
+        worker = std::thread([this] { runX11(); });
+#elif defined(PASSGEN_CLIPBOARD_WIN32)
+        native = true;
+        worker = std::thread([this] { runWin32(); });
+#endif
+    }
+
+    void wake() {
+#if defined(PASSGEN_CLIPBOARD_X11)
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+#else
+        wakeWorker.notify_one();
+#endif
+    }
+
+#if defined(PASSGEN_CLIPBOARD_X11)
+    void runX11() {
+        Atom clipboard = XInternAtom(display, "CLIPBOARD", False);
+        Atom targets = XInternAtom(display, "TARGETS", False);
+        Atom utf8 = XInternAtom(display, "UTF8_STRING", False);
+        Atom passwordHint = XInternAtom(display, "x-kde-passwordManagerHint", False);
+
+        std::string secret;
+        bool owned = false;
+        bool once = false;
+        bool timedClear = false;
+        Clock::time_point clearAt;
+
+        auto release = [&] {
+            if (owned && XGetSelectionOwner(display, clipboard) == window) {
+                XSetSelectionOwner(display, clipboard, None, CurrentTime);
+            }
+            owned = false;
+            wipe(secret);
+            XFlush(display);
+        };
+
+        for (;;) {
+            bool copyNow = false, clearNow = false, stop = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (copyRequested) {
+                    wipe(secret);
+                    secret.swap(pending);
+                    once = pendingPasteOnce;
+                    timedClear = pendingClearAfter > 0;
+                    clearAt = Clock::now() + std::chrono::seconds(pendingClearAfter);
+                    copyRequested = false;
+                    copyNow = true;
+                }
+                clearNow = clearRequested;
+                clearRequested = false;
+                stop = stopping;
+            }
+            if (copyNow) {
+                XSetSelectionOwner(display, clipboard, window, CurrentTime);
+                owned = XGetSelectionOwner(display, clipboard) == window;
+                if (!owned) wipe(secret);
+            }
+            if (clearNow || stop || (owned && timedClear && Clock::now() >= clearAt)) release();
+            if (stop) break;
+
+            while (XPending(display)) {
+                XEvent event;
+                XNextEvent(display, &event);
+                if (event.type == SelectionClear && event.xselectionclear.selection == clipboard) {
+                    // Someone else copied; what we held is gone from the clipboard
+                    owned = false;
+                    wipe(secret);
+                } else if (event.type == SelectionRequest) {
+                    const XSelectionRequestEvent& request = event.xselectionrequest;
+                    XEvent reply = {};
+                    reply.xselection.type = SelectionNotify;
+                    reply.xselection.requestor = request.requestor;
+                    reply.xselection.selection = request.selection;
+                    reply.xselection.target = request.target;
+                    reply.xselection.time = request.time;
+                    reply.xselection.property = None;
+                    // Obsolete clients leave the property to the owner
+                    Atom property = request.property != None ? request.property : request.target;
+                    bool pasted = false;
+                    if (owned && request.selection == clipboard) {
+                        if (request.target == targets) {
+                            Atom offered[] = {targets, utf8, XA_STRING, passwordHint};
+                            XChangeProperty(display, request.requestor, property, XA_ATOM, 32, PropModeReplace,
+                                            (const unsigned char*)offered, 4);
+                            reply.xselection.property = property;
+                        } else if (request.target == passwordHint) {
+                            XChangeProperty(display, request.requestor, property, XA_STRING, 8, PropModeReplace,
+                                            (const unsigned char*)"secret", 6);
+                            reply.xselection.property = property;
+                        } else if (request.target == utf8 || request.target == XA_STRING) {
+                            XChangeProperty(display, request.requestor, property, request.target, 8, PropModeReplace,
+                                            (const unsigned char*)secret.data(), (int)secret.size());
+                            reply.xselection.property = property;
+                            pasted = true;
+                        }
+                    }
+                    XSendEvent(display, request.requestor, False, NoEventMask, &reply);
+                    if (pasted && once) release();
+                }
+            }
+            XFlush(display);
+
+            int timeoutMs = -1;
+            if (owned && timedClear) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(clearAt - Clock::now()).count();
+                timeoutMs = left > 0 ? (int)left + 1 : 0;
+            }
+            pollfd fds[2] = {{ConnectionNumber(display), POLLIN, 0}, {wakeFd, POLLIN, 0}};
+            poll(fds, 2, timeoutMs);
+            if (fds[1].revents & POLLIN) {
+                uint64_t count;
+                ssize_t got = read(wakeFd, &count, sizeof(count));
+                (void)got;
+            }
+        }
+    }
+#endif
+
+#if defined(PASSGEN_CLIPBOARD_WIN32)
+    static bool openClipboard() {
+        // Another program may have it open for a moment
+        for (int attempt = 0; attempt < 20; attempt++) {
+            if (OpenClipboard(NULL)) return true;
+            Sleep(5);
+        }
+        return false;
+    }
+
+    static HGLOBAL globalCopy(const void* data, size_t size) {
+        HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, size);
+        if (!memory) return NULL;
+        memcpy(GlobalLock(memory), data, size);
+        GlobalUnlock(memory);
+        return memory;
+    }
+
+    // The clipboard's sequence number afterwards, 0 on failure
+    static DWORD put(const std::string& text) {
+        int wideLength = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, nullptr, 0);
+        if (wideLength <= 0) return 0;
+        std::wstring wide((size_t)wideLength, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &wide[0], wideLength);
+        HGLOBAL memory = globalCopy(wide.data(), wide.size() * sizeof(wchar_t));
+        secureZero(&wide[0], wide.size() * sizeof(wchar_t));
+        if (!memory) return 0;
+        if (!openClipboard()) {
+            GlobalFree(memory);
+            return 0;
+        }
+        EmptyClipboard();
+        bool ok = SetClipboardData(CF_UNICODETEXT, memory) != NULL;
+        if (!ok) GlobalFree(memory);
+        // Keep it out of clipboard history, cloud clipboard and monitoring tools
+        static const char* const privacyFormats[] = {"ExcludeClipboardContentFromMonitorProcessing",
+                                                     "CanIncludeInClipboardHistory", "CanUploadToCloudClipboard"};
+        for (const char* name : privacyFormats) {
+            DWORD no = 0;
+            HGLOBAL flag = globalCopy(&no, sizeof(no));
+            if (flag && !SetClipboardData(RegisterClipboardFormatA(name), flag)) GlobalFree(flag);
+        }
+        CloseClipboard();
+        return ok ? GetClipboardSequenceNumber() : 0;
+    }
+
+    static void clearIfUnchanged(DWORD sequence) {
+        if (sequence == 0 || GetClipboardSequenceNumber() != sequence || !openClipboard()) return;
+        EmptyClipboard();
+        CloseClipboard();
+    }
+
+    void runWin32() {
+        DWORD sequence = 0;
+        bool timedClear = false;
+        Clock::time_point clearAt;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            if (copyRequested) {
+                std::string secret;
+                secret.swap(pending);
+                timedClear = pendingClearAfter > 0;
+                clearAt = Clock::now() + std::chrono::seconds(pendingClearAfter);
+                copyRequested = false;
+                lock.unlock();
+                sequence = put(secret);
+                wipe(secret);
+                lock.lock();
+            }
+            bool clearNow = clearRequested || (sequence && timedClear && Clock::now() >= clearAt);
+            clearRequested = false;
+            // On exit, a password with a timeout goes; one without stays for pasting
+            if (stopping && timedClear) clearNow = true;
+            if (clearNow) {
+                lock.unlock();
+                clearIfUnchanged(sequence);
+                sequence = 0;
+                lock.lock();
+            }
+            if (stopping) break;
+
+            auto requested = [this] { return copyRequested || clearRequested || stopping; };
+            if (sequence && timedClear) wakeWorker.wait_until(lock, clearAt, requested);
+            else wakeWorker.wait(lock, requested);
+        }
+    }
+#endif
+
+public:
+    SecretClipboard() = default;
+    SecretClipboard(const SecretClipboard&) = delete;
+    SecretClipboard& operator=(const SecretClipboard&) = delete;
+    ~SecretClipboard() { close(); }
+
+    // Seconds until a copied password is cleared, 0 to leave it; from the next copy on
+    void setClearAfter(int seconds) { clearAfterSeconds = seconds > 0 ? seconds : 0; }
+    int clearAfter() const { return clearAfterSeconds; }
+
+    // Clear after the first paste, where the backend can tell (X11)
+    void setPasteOnce(bool enabled) { pasteOnce = enabled; }
+
+    void copy(const char* text) {
+        if (!started) start();
+        if (!native) {
+            SetClipboardText(text);
+            wipe(copied);
+            copied = text;
+            timed = clearAfterSeconds > 0;
+            deadline = Clock::now() + std::chrono::seconds(clearAfterSeconds);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wipe(pending);
+            pending = text;
+            pendingClearAfter = clearAfterSeconds;
+            pendingPasteOnce = pasteOnce;
+            copyRequested = true;
+        }
+        wake();
+    }
+
+    // Clear now, if the clipboard still holds the last password copied
+    void clear() {
+        if (native) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                clearRequested = true;
+            }
+            wake();
+        } else if (!copied.empty()) {
+            const char* current = GetClipboardText();
+            if (current && copied == current) SetClipboardText("");
+            wipe(copied);
+            timed = false;
+        }
+    }
+
+    // Once per frame; only the raylib fallback has anything to do
+    void update() {
+        if (!native && timed && Clock::now() >= deadline) clear();
+    }
+
+    // Stop the worker. A password with a timeout is cleared now; under X11
+    // the selection goes with the connection either way.
+    void close() {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake();
+            worker.join();
+        } else if (timed) {
+            clear();
+        }
+#if defined(PASSGEN_CLIPBOARD_X11)
+        if (display) {
+            XDestroyWindow(display, window);
+            XCloseDisplay(display);
+            display = nullptr;
+        }
+        if (wakeFd >= 0) ::close(wakeFd);
+        wakeFd = -1;
+#endif
+        wipe(pending);
+        wipe(copied);
+    }
+};
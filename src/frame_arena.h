@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+// Per-frame linear scratch memory for transient strings.
+// Reset once per frame; everything handed out is valid until the next reset.
+// The buffer is allocated once up front, so a steady-state frame never
+// reaches the global allocator. When the arena runs out, requests fall back
+// to an empty string instead of growing.
+class FrameArena {
+private:
+    char* buffer;
+    size_t capacity;
+    size_t used = 0;
+
+public:
+    explicit FrameArena(size_t bytes = 16 * 1024) : buffer((char*)std::malloc(bytes)), capacity(buffer ? bytes : 0) {}
+    ~FrameArena() { std::free(buffer); }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void reset() { used = 0; }
+    size_t bytesUsed() const { return used; }
+
+    char* allocate(size_t bytes) {
+        if (capacity - used < bytes) return nullptr;
+        char* p = buffer + used;
+        used += bytes;
+        return p;
+    }
+
+    // NUL-terminated copy of text
+    const char* copy(std::string_view text) {
+        char* p = allocate(text.size() + 1);
+        if (!p) return "";
+        memcpy(p, text.data(), text.size());
+        p[text.size()] = '\0';
+        return p;
+    }
+
+    // printf into the arena, replaces TextFormat() for per-frame labels
+    const char* format(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        int length = vsnprintf(buffer + used, capacity - used, fmt, args);
+        va_end(args);
+        if (length < 0 || (size_t)length >= capacity - used) return "";
+        const char* p = buffer + used;
+        used += length + 1;
+        return p;
+    }
+
+    // text itself if it fits in maxChars, otherwise its first maxChars followed by "..."
+    // text must be NUL-terminated at text.size() (e.g. a view over a std::string)
+    const char* truncate(std::string_view text, size_t maxChars) {
+        if (text.size() <= maxChars) return text.data();
+        char* p = allocate(maxChars + 4);
+        if (!p) return "";
+        memcpy(p, text.data(), maxChars);
+        memcpy(p + maxChars, "...", 4);
+        return p;
+    }
+};
@@ -0,0 +1,281 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Binary fuse filter with 8-bit fingerprints (Graf & Lemire, "Binary Fuse
+// Filters: Fast and Smaller Than Xor Filters", 2022): about 9 bits per key
+// and a 1/256 false-positive rate, three memory accesses per query.
+// Keys must be distinct 64-bit values.
+class BinaryFuse8 {
+public:
+    uint64_t seed = 0;
+    uint32_t segmentLength = 0;
+    uint32_t segmentLengthMask = 0;
+    uint32_t segmentCount = 0;
+    uint32_t segmentCountLength = 0;
+    uint32_t arrayLength = 0;
+    std::vector<uint8_t> fingerprints;
+
+    static uint64_t murmur64(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    bool contains(uint64_t key) const {
+        if (arrayLength == 0) return false;
+        uint64_t hash = murmur64(key + seed);
+        uint8_t f = fingerprint(hash);
+        uint32_t h0 = (uint32_t)mulhi(hash, segmentCountLength);
+        uint32_t h1 = h0 + segmentLength;
+        uint32_t h2 = h1 + segmentLength;
+        h1 ^= (uint32_t)(hash >> 18) & segmentLengthMask;
+        h2 ^= (uint32_t)hash & segmentLengthMask;
+        return (f ^ fingerprints[h0] ^ fingerprints[h1] ^ fingerprints[h2]) == 0;
+    }
+
+    size_t sizeInBytes() const { return fingerprints.size(); }
+
+    // Build from distinct keys; returns false if construction did not converge
+    bool populate(const uint64_t* keys, uint32_t size) {
+        allocate(size);
+        if (size == 0) return true;
+
+        uint64_t rngCounter = 0x726b2b9d438b9d4dULL;
+        seed = splitmix64(rngCounter);
+
+        uint32_t capacity = arrayLength;
+        std::vector<uint64_t> reverseOrder(size + 1, 0);
+        std::vector<uint32_t> alone(capacity);
+        std::vector<uint8_t> t2count(capacity, 0);
+        std::vector<uint8_t> reverseH(size);
+        std::vector<uint64_t> t2hash(capacity, 0);
+
+        uint32_t blockBits = 1;
+        while (((uint32_t)1 << blockBits) < segmentCount) blockBits++;
+        uint32_t block = (uint32_t)1 << blockBits;
+        std::vector<uint32_t> startPos(block);
+        uint32_t h012[5];
+
+        reverseOrder[size] = 1;  // Sentinel
+        for (int attempt = 0;; attempt++) {
+            if (attempt >= 100) return false;
+
+            // Counting-sort the hashes by segment so the peeling below walks memory in order
+            for (uint32_t i = 0; i < block; i++) startPos[i] = (uint32_t)(((uint64_t)i * size) >> blockBits);
+            for (uint32_t i = 0; i < size; i++) {
+                uint64_t hash = murmur64(keys[i] + seed);
+                uint64_t segmentIndex = hash >> (64 - blockBits);
+                while (reverseOrder[startPos[segmentIndex]] != 0) segmentIndex = (segmentIndex + 1) & (block - 1);
+                reverseOrder[startPos[segmentIndex]] = hash;
+                startPos[segmentIndex]++;
+            }
+
+            bool error = false;
+            for (uint32_t i = 0; i < size; i++) {
+                uint64_t hash = reverseOrder[i];
+                uint32_t h0 = slot(0, hash), h1 = slot(1, hash), h2 = slot(2, hash);
+                t2count[h0] += 4;
+                t2hash[h0] ^= hash;
+                t2count[h1] += 4;
+                t2count[h1] ^= 1;
+                t2hash[h1] ^= hash;
+                t2count[h2] += 4;
+                t2count[h2] ^= 2;
+                t2hash[h2] ^= hash;
+                error = error || t2count[h0] < 4 || t2count[h1] < 4 || t2count[h2] < 4;
+            }
+
+            if (!error) {
+                // Peel cells holding a single key
+                uint32_t queueSize = 0;
+                for (uint32_t i = 0; i < capacity; i++) {
+                    alone[queueSize] = i;
+                    queueSize += (t2count[i] >> 2) == 1 ? 1 : 0;
+                }
+                uint32_t stackSize = 0;
+                while (queueSize > 0) {
+                    uint32_t index = alone[--queueSize];
+                    if ((t2count[index] >> 2) != 1) continue;
+
+                    uint64_t hash = t2hash[index];
+                    h012[0] = slot(0, hash);
+                    h012[1] = slot(1, hash);
+                    h012[2] = slot(2, hash);
+                    h012[3] = h012[0];
+                    h012[4] = h012[1];
+                    uint8_t found = t2count[index] & 3;
+                    reverseH[stackSize] = found;
+                    reverseOrder[stackSize] = hash;
+                    stackSize++;
+
+                    for (int k = 1; k <= 2; k++) {
+                        uint32_t other = h012[found + k];
+                        alone[queueSize] = other;
+                        queueSize += (t2count[other] >> 2) == 2 ? 1 : 0;
+                        t2count[other] -= 4;
+                        t2count[other] ^= mod3((uint8_t)(found + k));
+                        t2hash[other] ^= hash;
+                    }
+                }
+
+                if (stackSize == size) {
+                    // Assign fingerprints in reverse peeling order
+                    for (uint32_t i = size; i-- > 0;) {
+                        uint64_t hash = reverseOrder[i];
+                        uint8_t found = reverseH[i];
+                        h012[0] = slot(0, hash);
+                        h012[1] = slot(1, hash);
+                        h012[2] = slot(2, hash);
+                        h012[3] = h012[0];
+                        h012[4] = h012[1];
+                        fingerprints[h012[found]] = fingerprint(hash) ^ fingerprints[h012[found + 1]] ^ fingerprints[h012[found + 2]];
+                    }
+                    return true;
+                }
+            }
+
+            // Retry with a new seed
+            std::fill(reverseOrder.begin(), reverseOrder.end() - 1, 0);
+            std::fill(t2count.begin(), t2count.end(), 0);
+            std::fill(t2hash.begin(), t2hash.end(), 0);
+            seed = splitmix64(rngCounter);
+        }
+    }
+
+private:
+    static uint64_t mulhi(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+        return (uint64_t)(((__uint128_t)a * b) >> 64);
+#else
+        uint64_t aLo = (uint32_t)a, aHi = a >> 32, bLo = (uint32_t)b, bHi = b >> 32;
+        uint64_t mid = aHi * bLo + ((aLo * bLo) >> 32);
+        uint64_t mid2 = aLo * bHi + (uint32_t)mid;
+        return aHi * bHi + (mid >> 32) + (mid2 >> 32);
+#endif
+    }
+
+    static uint64_t splitmix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static uint8_t fingerprint(uint64_t hash) { return (uint8_t)(hash ^ (hash >> 32)); }
+    static uint8_t mod3(uint8_t x) { return x > 2 ? x - 3 : x; }
+
+    uint32_t slot(int index, uint64_t hash) const {
+        uint64_t h = mulhi(hash, segmentCountLength);
+        h += (uint64_t)index * segmentLength;
+        uint64_t hh = hash & ((1ULL << 36) - 1);
+        h ^= (hh >> (36 - 18 * index)) & segmentLengthMask;
+        return (uint32_t)h;
+    }
+
+    void allocate(uint32_t size) {
+        const uint32_t arity = 3;
+        segmentLength = size == 0 ? 4 : (uint32_t)1 << (int)(std::floor(std::log((double)size) / std::log(3.33) + 2.25));
+        if (segmentLength > 262144) segmentLength = 262144;
+        segmentLengthMask = segmentLength - 1;
+
+        double sizeFactor = size <= 1 ? 0.0 : std::fmax(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log((double)size));
+        uint32_t capacity = size <= 1 ? 0 : (uint32_t)std::round((double)size * sizeFactor);
+        uint32_t initSegmentCount = (capacity + segmentLength - 1) / segmentLength;
+        initSegmentCount = initSegmentCount > arity - 1 ? initSegmentCount - (arity - 1) : 0;
+        arrayLength = (initSegmentCount + arity - 1) * segmentLength;
+        segmentCount = (arrayLength + segmentLength - 1) / segmentLength;
+        segmentCount = segmentCount <= arity - 1 ? 1 : segmentCount - (arity - 1);
+        arrayLength = (segmentCount + arity - 1) * segmentLength;
+        segmentCountLength = segmentCount * segmentLength;
+        fingerprints.assign(arrayLength, 0);
+    }
+};
+
+// Set of binary fuse filters sharded by the top bits of the key, so a corpus
+// of hundreds of millions of keys can be built one shard at a time.
+//
+// File layout (little endian):
+//   char magic[8] "PGFUSE1\0", uint32_t shardBits, uint32_t reserved, uint64_t sourceCount
+//   per shard: uint64_t seed, uint32_t segmentLength, segmentCount, arrayLength, reserved
+//   per shard: uint8_t fingerprints[arrayLength]
+class FuseFilterSet {
+public:
+    uint32_t shardBits = 0;
+    uint64_t sourceCount = 0;  // Records in the corpus the filter was built from
+    std::vector<BinaryFuse8> shards;
+
+    uint32_t shardOf(uint64_t key) const { return shardBits == 0 ? 0 : (uint32_t)(key >> (64 - shardBits)); }
+
+    bool mayContain(uint64_t key) const {
+        if (shards.empty()) return true;
+        return shards[shardOf(key)].contains(key);
+    }
+
+    size_t sizeInBytes() const {
+        size_t total = 0;
+        for (const BinaryFuse8& shard : shards) total += shard.sizeInBytes();
+        return total;
+    }
+
+    bool save(const char* path) const {
+        FILE* out = fopen(path, "wb");
+        if (!out) return false;
+        uint32_t header[4];
+        memcpy(header, "PGFUSE1", 8);
+        header[2] = shardBits;
+        header[3] = 0;
+        fwrite(header, sizeof(header), 1, out);
+        fwrite(&sourceCount, sizeof(uint64_t), 1, out);
+        for (const BinaryFuse8& shard : shards) {
+            uint32_t params[4] = {shard.segmentLength, shard.segmentCount, shard.arrayLength, 0};
+            fwrite(&shard.seed, sizeof(uint64_t), 1, out);
+            fwrite(params, sizeof(params), 1, out);
+        }
+        for (const BinaryFuse8& shard : shards) fwrite(shard.fingerprints.data(), 1, shard.fingerprints.size(), out);
+        bool ok = ferror(out) == 0;
+        return fclose(out) == 0 && ok;
+    }
+
+    bool load(const char* path) {
+        shards.clear();
+        FILE* in = fopen(path, "rb");
+        if (!in) return false;
+        uint32_t header[4];
+        bool ok = fread(header, sizeof(header), 1, in) == 1 && memcmp(header, "PGFUSE1", 8) == 0 && header[2] <= 16 &&
+                  fread(&sourceCount, sizeof(uint64_t), 1, in) == 1;
+        if (ok) {
+            shardBits = header[2];
+            shards.resize((size_t)1 << shardBits);
+            for (BinaryFuse8& shard : shards) {
+                uint32_t params[4];
+                ok = ok && fread(&shard.seed, sizeof(uint64_t), 1, in) == 1 && fread(params, sizeof(params), 1, in) == 1;
+                // The three slots of a key must land in the array: the
+                // layout allocate() gives, in 64 bits so nothing wraps
+                uint64_t segmentLength = params[0], segmentCount = params[1];
+                ok = ok && segmentLength != 0 && (segmentLength & (segmentLength - 1)) == 0 && segmentLength <= 262144 &&
+                     segmentCount != 0 && (segmentCount + 2) * segmentLength == params[2];
+                if (!ok) break;
+                shard.segmentLength = params[0];
+                shard.segmentLengthMask = params[0] - 1;
+                shard.segmentCount = params[1];
+                shard.arrayLength = params[2];
+                shard.segmentCountLength = (uint32_t)(segmentCount * segmentLength);
+            }
+            for (BinaryFuse8& shard : shards) {
+                if (!ok) break;
+                shard.fingerprints.resize(shard.arrayLength);
+                ok = fread(shard.fingerprints.data(), 1, shard.arrayLength, in) == shard.arrayLength;
+            }
+        }
+        fclose(in);
+        if (!ok) shards.clear();
+        return ok;
+    }
+};
@@ -0,0 +1,178 @@
+#pragma once
+#include "secure_memory.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// LZ4 block format (lz4/doc/lz4_Block_format.md) without the library: a
+// greedy single-probe compressor and a bounds-checked decompressor, both
+// optionally with a dictionary that acts as if it preceded the input. Blocks
+// are at most a few hundred KB here.
+class Lz4Block {
+public:
+    static constexpr int HASH_LOG = 14;
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t LAST_LITERALS = 5;   // A block always ends with literals
+    static constexpr size_t MATCH_LIMIT = 12;    // No match starts this close to the end
+    static constexpr size_t MAX_OFFSET = 65535;
+
+    static size_t bound(size_t size) { return size + size / 255 + 16; }
+
+private:
+    std::vector<uint32_t> table = std::vector<uint32_t>((size_t)1 << HASH_LOG);
+    std::vector<uint32_t> dictTable;   // table after hashing the dictionary, copied in per block
+    std::vector<uint8_t> dictionary;   // The one dictTable was built from
+    std::vector<uint8_t> window;       // Dictionary followed by the input
+
+    void prepareDictionary(const uint8_t* dict, size_t dictSize) {
+        if (dictSize == dictionary.size() && memcmp(dict, dictionary.data(), dictSize) == 0) return;
+        secureZero(dictionary.data(), dictionary.size());
+        dictionary.assign(dict, dict + dictSize);
+        dictTable.assign((size_t)1 << HASH_LOG, 0);
+        for (size_t i = 0; i + MIN_MATCH <= dictSize; i++) dictTable[hash(read32(dict + i))] = (uint32_t)i;
+    }
+
+    static uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    static uint32_t hash(uint32_t v) { return (v * 2654435761u) >> (32 - HASH_LOG); }
+
+    static uint8_t* putLength(uint8_t* op, size_t length) {
+        for (; length >= 255; length -= 255) *op++ = 255;
+        *op++ = (uint8_t)length;
+        return op;
+    }
+
+    static uint8_t* putSequence(uint8_t* op, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+        uint8_t* token = op++;
+        *token = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+        if (literalLength >= 15) op = putLength(op, literalLength - 15);
+        if (literalLength > 0) memcpy(op, literals, literalLength);
+        op += literalLength;
+        if (matchLength == 0) return op;  // Last literals
+
+        *op++ = (uint8_t)offset;
+        *op++ = (uint8_t)(offset >> 8);
+        size_t extra = matchLength - MIN_MATCH;
+        *token |= (uint8_t)(extra < 15 ? extra : 15);
+        if (extra >= 15) op = putLength(op, extra - 15);
+        return op;
+    }
+
+    // Compress the size bytes at base + prefix; matches may reach back into
+    // the prefix bytes, the dictionary prepared before
+    size_t compressWindow(const uint8_t* base, size_t prefix, size_t size, uint8_t* dst) {
+        const uint8_t* ip = base + prefix;
+        const uint8_t* anchor = ip;
+        const uint8_t* end = ip + size;
+        uint8_t* op = dst;
+
+        if (size > MATCH_LIMIT) {
+            // Measured: a clean table is faster than skipping the clear and
+            // ignoring stale entries from earlier blocks
+            if (prefix > 0) std::copy(dictTable.begin(), dictTable.end(), table.begin());
+            else std::fill(table.begin(), table.end(), 0);
+            const uint8_t* matchEnd = end - LAST_LITERALS;
+            const uint8_t* searchEnd = end - MATCH_LIMIT;
+            unsigned misses = 0;
+            while (ip < searchEnd) {
+                uint32_t sequence = read32(ip);
+                uint32_t& slot = table[hash(sequence)];
+                const uint8_t* ref = base + slot;
+                slot = (uint32_t)(ip - base);
+                if (ref >= ip || (size_t)(ip - ref) > MAX_OFFSET || read32(ref) != sequence) {
+                    ip += 1 + (misses++ >> 6);  // Skip faster through incompressible data
+                    continue;
+                }
+                misses = 0;
+                size_t length = MIN_MATCH;
+                while (ip + length < matchEnd && ref[length] == ip[length]) length++;
+                op = putSequence(op, anchor, (size_t)(ip - anchor), (size_t)(ip - ref), length);
+                ip += length;
+                anchor = ip;
+            }
+        }
+        op = putSequence(op, anchor, (size_t)(end - anchor), 0, 0);
+        return (size_t)(op - dst);
+    }
+
+public:
+    Lz4Block() = default;
+    Lz4Block(const Lz4Block&) = delete;
+    Lz4Block& operator=(const Lz4Block&) = delete;
+    ~Lz4Block() { secureZero(dictionary.data(), dictionary.size()); }
+
+    // Compress size bytes into dst, which must hold bound(size); returns the
+    // compressed size. With a dictionary, decompress() needs the same one.
+    size_t compress(const uint8_t* src, size_t size, uint8_t* dst, const uint8_t* dict = nullptr, size_t dictSize = 0) {
+        if (dictSize > MAX_OFFSET) {
+            dict += dictSize - MAX_OFFSET;
+            dictSize = MAX_OFFSET;
+        }
+        if (dictSize == 0) return compressWindow(src, 0, size, dst);
+        prepareDictionary(dict, dictSize);
+        window.assign(dict, dict + dictSize);
+        window.insert(window.end(), src, src + size);
+        size_t compressed = compressWindow(window.data(), dictSize, size, dst);
+        secureZero(window.data(), window.size());
+        return compressed;
+    }
+
+    // Decompress exactly rawSize bytes; false on malformed or truncated input
+    static bool decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t rawSize, const uint8_t* dict = nullptr,
+                           size_t dictSize = 0) {
+        const uint8_t* ip = src;
+        const uint8_t* end = src + size;
+        uint8_t* op = dst;
+        uint8_t* outEnd = dst + rawSize;
+        auto readLength = [&](size_t& length) {
+            uint8_t b;
+            do {
+                if (ip >= end) return false;
+                b = *ip++;
+                length += b;
+            } while (b == 255);
+            return true;
+        };
+
+        while (ip < end) {
+            uint8_t token = *ip++;
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(literalLength)) return false;
+            if ((size_t)(end - ip) < literalLength || (size_t)(outEnd - op) < literalLength) return false;
+            if (literalLength > 0) memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+            if (ip == end) break;  // Last literals
+
+            if (end - ip < 2) return false;
+            size_t offset = ip[0] | (size_t)ip[1] << 8;
+            ip += 2;
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(matchLength)) return false;
+            matchLength += MIN_MATCH;
+            size_t produced = (size_t)(op - dst);
+            if (offset == 0 || offset > produced + dictSize || (size_t)(outEnd - op) < matchLength) return false;
+            if (offset > produced) {
+                size_t back = offset - produced;  // Starts in the dictionary
+                size_t fromDict = back < matchLength ? back : matchLength;
+                memcpy(op, dict + dictSize - back, fromDict);
+                op += fromDict;
+                matchLength -= fromDict;
+            }
+            const uint8_t* ref = op - offset;
+            if (offset >= matchLength) {
+                memcpy(op, ref, matchLength);
+            } else {
+                for (size_t i = 0; i < matchLength; i++) op[i] = ref[i];  // Overlapping copies repeat the pattern
+            }
+            op += matchLength;
+        }
+        return op == outEnd;
+    }
+};
@@ -0,0 +1,175 @@
+// libpassgen: the C ABI of include/passgen.h over the header-only modules.
+// No C++ exception crosses it; running out of memory is a status like any
+// other failure.
+
+#include "../include/passgen.h"
+#include "password_generator.h"
+#include "secure_memory.h"
+#include "vault.h"
+#include "vault_journal.h"
+#include "vault_sync.h"
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <system_error>
+
+struct passgen_generator {
+    PasswordGenerator generator;
+};
+
+struct passgen_vault {
+    Vault vault;
+
+    void wipe() {
+        for (std::string& password : vault.passwords) secureZero(&password[0], password.size());
+    }
+    ~passgen_vault() { wipe(); }
+};
+
+// Run body, turning std::bad_alloc into a status
+template <typename Body>
+static passgen_status Guarded(Body body) {
+    try {
+        return body();
+    } catch (const std::bad_alloc&) {
+        return PASSGEN_ERROR_MEMORY;
+    }
+}
+
+// Copy text into a caller's buffer of *size bytes, storing the size needed
+static passgen_status CopyOut(const std::string& text, char* out, size_t* size) {
+    size_t needed = text.size() + 1;
+    bool fits = out && *size >= needed;
+    if (fits) memcpy(out, text.c_str(), needed);
+    *size = needed;
+    return fits || !out ? PASSGEN_OK : PASSGEN_ERROR_BUFFER;
+}
+
+// The vault file is line based with '|' after the name; like imports and
+// restores, no '|' in names and no line breaks at all
+static bool Storable(const char* name, const char* password) {
+    return !strpbrk(name, "|\r\n") && !strpbrk(password, "\r\n");
+}
+
+extern "C" {
+
+uint32_t passgen_abi_version(void) { return PASSGEN_ABI_VERSION; }
+
+const char* passgen_status_string(passgen_status status) {
+    switch (status) {
+        case PASSGEN_OK: return "ok";
+        case PASSGEN_ERROR_ARGUMENT: return "invalid argument";
+        case PASSGEN_ERROR_BUFFER: return "buffer too small";
+        case PASSGEN_ERROR_NOT_FOUND: return "not found";
+        case PASSGEN_ERROR_IO: return "file can't be opened or written";
+        case PASSGEN_ERROR_FORMAT: return "file is damaged or uses a codec this build lacks";
+        case PASSGEN_ERROR_MEMORY: return "out of memory";
+    }
+    return "unknown status";
+}
+
+void passgen_wipe(void* data, size_t size) {
+    if (data) secureZero(data, size);
+}
+
+passgen_generator* passgen_generator_create(void) { return new (std::nothrow) passgen_generator(); }
+
+void passgen_generator_destroy(passgen_generator* generator) { delete generator; }
+
+passgen_status passgen_generate(passgen_generator* generator, int length, char* out, size_t outSize) {
+    if (!generator || !out || length < 4 || length > 1024) return PASSGEN_ERROR_ARGUMENT;
+    if (outSize < (size_t)length + 1) return PASSGEN_ERROR_BUFFER;
+    return Guarded([&] {
+        std::string password = generator->generator.generate(length);
+        memcpy(out, password.c_str(), password.size() + 1);
+        secureZero(&password[0], password.size());
+        return PASSGEN_OK;
+    });
+}
+
+passgen_vault* passgen_vault_create(void) { return new (std::nothrow) passgen_vault(); }
+
+void passgen_vault_destroy(passgen_vault* vault) { delete vault; }
+
+passgen_status passgen_vault_load(passgen_vault* vault, const char* path) {
+    if (!vault || !path) return PASSGEN_ERROR_ARGUMENT;
+    return Guarded([&] {
+        vault->wipe();
+        // Against a writer halfway between the file and its journal. Without a
+        // lock file, which a read-only directory can't get, no writer can
+        // take the lock either; replay() still catches a journal that changes
+        // while it is read.
+        VaultLock lock;
+        if (lock.open(path) && !lock.lock()) return PASSGEN_ERROR_IO;
+        if (!loadVault(vault->vault, path)) {
+            std::error_code error;
+            return std::filesystem::exists(path, error) ? PASSGEN_ERROR_FORMAT : PASSGEN_ERROR_IO;
+        }
+        return VaultJournal::replay(vault->vault, journalPathFor(path).c_str()) ? PASSGEN_OK : PASSGEN_ERROR_IO;
+    });
+}
+
+passgen_status passgen_vault_save(passgen_vault* vault, const char* path) {
+    if (!vault || !path) return PASSGEN_ERROR_ARGUMENT;
+    return Guarded([&] {
+        // The journal's edits are in the file now: it starts afresh, and
+        // running processes reload
+        VaultLock lock;
+        if (!lock.open(path) || !lock.lock() || !saveVault(vault->vault, path)) return PASSGEN_ERROR_IO;
+        return VaultJournal::restart(journalPathFor(path).c_str(), vault->vault.fileFingerprint) ? PASSGEN_OK
+                                                                                                : PASSGEN_ERROR_IO;
+    });
+}
+
+size_t passgen_vault_size(const passgen_vault* vault) { return vault ? vault->vault.size() : 0; }
+
+passgen_status passgen_vault_entry(const passgen_vault* vault, size_t index, char* name, size_t* nameSize,
+                                   char* password, size_t* passwordSize) {
+    if (!vault || index >= vault->vault.size() || !nameSize || !passwordSize) return PASSGEN_ERROR_ARGUMENT;
+    passgen_status nameStatus = CopyOut(vault->vault.serviceNames[index], name, nameSize);
+    passgen_status passwordStatus = CopyOut(vault->vault.passwords[index], password, passwordSize);
+    return nameStatus != PASSGEN_OK ? nameStatus : passwordStatus;
+}
+
+passgen_status passgen_vault_find(const passgen_vault* vault, const char* name, size_t* index) {
+    if (!vault || !name || !index) return PASSGEN_ERROR_ARGUMENT;
+    for (size_t i = 0; i < vault->vault.size(); i++) {
+        if (vault->vault.serviceNames[i] == name) {
+            *index = i;
+            return PASSGEN_OK;
+        }
+    }
+    return PASSGEN_ERROR_NOT_FOUND;
+}
+
+passgen_status passgen_vault_add(passgen_vault* vault, const char* name, const char* password) {
+    if (!vault || !name || !password || !Storable(name, password)) return PASSGEN_ERROR_ARGUMENT;
+    return Guarded([&] {
+        vault->vault.add(name, password);
+        vault->vault.revision++;
+        return PASSGEN_OK;
+    });
+}
+
+passgen_status passgen_vault_set_password(passgen_vault* vault, size_t index, const char* password) {
+    if (!vault || !password || index >= vault->vault.size() || !Storable("", password)) return PASSGEN_ERROR_ARGUMENT;
+    return Guarded([&] {
+        Vault& library = vault->vault;
+        library.replace(index, std::string(library.serviceNames[index]), password, (int64_t)time(nullptr));
+        library.revision++;
+        return PASSGEN_OK;
+    });
+}
+
+passgen_status passgen_vault_remove(passgen_vault* vault, size_t index) {
+    if (!vault || index >= vault->vault.size()) return PASSGEN_ERROR_ARGUMENT;
+    std::string& password = vault->vault.passwords[index];
+    secureZero(&password[0], password.size());
+    vault->vault.erase(index);
+    vault->vault.revision++;
+    return PASSGEN_OK;
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "profiler.h"
+#include "secure_memory.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <random>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <bcrypt.h>  // After windows.h, from secure_memory.h
+    #if defined(_MSC_VER)
+        #pragma comment(lib, "bcrypt")  // Also for programs linking passgen_static.lib
+    #endif
+#elif defined(__linux__)
+    #include <cerrno>
+    #include <sys/random.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+    #include <stdlib.h>
+#endif
+
+class PasswordGenerator {
+private:
+    std::string chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*";
+    std::random_device rd;  // Only where the OS has no call for random bytes
+
+public:
+    // length characters from the OS's random source (fillRandom()). As in
+    // generateBatch(), bytes past the last whole multiple of the character
+    // set are skipped so that every character is equally likely.
+    std::string generate(int length) {
+        PROFILE_ZONE("generate");
+        const unsigned setSize = (unsigned)chars.size();
+        const unsigned limit = 256 - 256 % setSize;
+        std::string password;
+        password.reserve(length > 0 ? length : 0);
+        uint8_t random[64];
+        while ((int)password.size() < length) {
+            size_t wanted = std::min(sizeof(random), (size_t)length - password.size() + 8);  // A few for the skipped bytes
+            fillRandom(random, wanted);
+            for (size_t i = 0; i < wanted && (int)password.size() < length; i++) {
+                if (random[i] < limit) password += chars[random[i] % setSize];
+            }
+        }
+        secureZero(random, sizeof(random));
+        return password;
+    }
+
+    // The policy most sites and directories ask for: a lowercase and an
+    // uppercase letter, a digit and a symbol. Under 4 characters no password has all four.
+    static bool meetsPolicy(const std::string& password) {
+        // Branch-free: random characters would mispredict every class test
+        unsigned classes = 0;
+        for (char c : password) {
+            unsigned lower = (unsigned)(c - 'a') < 26u;
+            unsigned upper = (unsigned)(c - 'A') < 26u;
+            unsigned digit = (unsigned)(c - '0') < 10u;
+            classes |= lower | upper << 1 | digit << 2 | (!(lower | upper | digit)) << 3;
+        }
+        return classes == 15;
+    }
+
+    // Fill out with bytes from the OS's cryptographic random source
+    void fillRandom(uint8_t* out, size_t size) {
+#if defined(_WIN32)
+        if (BCryptGenRandom(nullptr, out, (ULONG)size, BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0) return;
+#elif defined(__linux__)
+        while (size > 0) {
+            ssize_t got = getrandom(out, size, 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) break;
+            out += got;
+            size -= (size_t)got;
+        }
+        if (size == 0) return;
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+        arc4random_buf(out, size);
+        return;
+#endif
+        // No system call for it: random_device reads the same source
+        for (; size >= 4; out += 4, size -= 4) {
+            uint32_t word = rd();
+            memcpy(out, &word, 4);
+        }
+        for (uint32_t word = rd(); size > 0; size--, word >>= 8) *out++ = (uint8_t)word;
+    }
+
+    // Bulk generation, e.g. for provisioning: count passwords that meet the
+    // policy (length 4 or more), redrawn until they do. The bytes come from
+    // the OS (fillRandom()), RANDOM_BLOCK at a time, and go through a
+    // byte-to-character table. Bytes past the last whole multiple of the
+    // character set are skipped so that every character stays equally
+    // likely; branch-free, as a fifth of them are.
+    void generateBatch(std::vector<std::string>& passwords, size_t count, int length) {
+        PROFILE_ZONE("generate.batch");
+        static constexpr size_t RANDOM_BLOCK = 4096;
+        const unsigned setSize = (unsigned)chars.size();
+        const unsigned limit = 256 - 256 % setSize;
+        char table[256] = {};
+        for (unsigned byte = 0; byte < limit; byte++) table[byte] = chars[byte % setSize];
+        uint8_t random[RANDOM_BLOCK];
+        size_t used = RANDOM_BLOCK;
+        passwords.resize(count);
+        for (std::string& password : passwords) {
+            password.resize(length);
+            char* out = &password[0];
+            do {
+                for (int i = 0; i < length;) {
+                    if (used == RANDOM_BLOCK) {
+                        fillRandom(random, RANDOM_BLOCK);
+                        used = 0;
+                    }
+                    size_t end = std::min(RANDOM_BLOCK, used + (size_t)(length - i));
+                    for (; used < end; used++) {
+                        unsigned byte = random[used];
+                        out[i] = table[byte];
+                        i += byte < limit;
+                    }
+                }
+            } while (length >= 4 && !meetsPolicy(password));
+        }
+        secureZero(random, sizeof(random));
+    }
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+// Hot-path instrumentation.
+// Build with PASSGEN_PROFILE defined to enable timing zones, the frame-time
+// overlay (F3) and Chrome trace-event export (F4, writes passgen_trace.json).
+// Without it PROFILE_ZONE expands to nothing. The raylib overlay lives in
+// profiler_overlay.h so headless code can use zones without a window.
+
+#ifdef PASSGEN_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Single-producer ring of completed zones. Only the owning thread writes;
+// readers take a snapshot of [head - CAPACITY, head). Every slot is a small
+// seqlock: its sequence is odd while event i is written into it and 2i + 2
+// once it holds event i, so a reader keeps an event only if the sequence
+// read before and after copying it is 2i + 2.
+struct ProfileSlot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> startNs{0};
+    std::atomic<uint64_t> endNs{0};
+};
+
+struct ProfileRing {
+    static constexpr uint32_t CAPACITY = 16384;  // Power of two
+    ProfileSlot slots[CAPACITY];
+    std::atomic<uint64_t> head{0};
+    int threadIndex = 0;
+
+    void push(const char* name, uint64_t startNs, uint64_t endNs) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        ProfileSlot& slot = slots[h & (CAPACITY - 1)];
+        slot.sequence.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.startNs.store(startNs, std::memory_order_relaxed);
+        slot.endNs.store(endNs, std::memory_order_relaxed);
+        slot.sequence.store(2 * h + 2, std::memory_order_release);
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Event i, false if the writer has moved past it or is rewriting its slot
+    bool read(uint64_t i, ProfileEvent& event) const {
+        const ProfileSlot& slot = slots[i & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != 2 * i + 2) return false;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.endNs = slot.endNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == 2 * i + 2;
+    }
+};
+
+// Rings are never freed while a reader may hold one: a thread that exits
+// hands its ring back through ThreadRingOwner, and the next new thread
+// writes on in it. So at most MAX_THREADS rings (about 512 KB each) exist,
+// however many threads come and go; zones of threads past MAX_THREADS
+// running at once are counted as dropped.
+class Profiler {
+public:
+    static constexpr int MAX_THREADS = 64;
+    static constexpr int FRAME_HISTORY = 240;
+
+    struct FrameSample {
+        float ms;
+        int drawCalls;
+        int vertices;
+    };
+
+    // Never destroyed: threads may exit, and hand their rings back, after
+    // static destructors ran
+    static Profiler& instance() {
+        static Profiler* profiler = new Profiler();
+        return *profiler;
+    }
+
+    static uint64_t nowNs() {
+        static const auto origin = std::chrono::steady_clock::now();
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    // Ring of the calling thread, taken on first use; null, and the zone
+    // counted as dropped, while MAX_THREADS other threads hold one
+    ProfileRing* threadRing() {
+        struct ThreadRingOwner {
+            ProfileRing* ring = nullptr;
+            ~ThreadRingOwner() {
+                if (ring) Profiler::instance().releaseRing(ring);
+            }
+        };
+        thread_local ThreadRingOwner owner;
+        if (!owner.ring) owner.ring = acquireRing();
+        if (!owner.ring) dropped.fetch_add(1, std::memory_order_relaxed);
+        return owner.ring;
+    }
+
+    uint64_t droppedZones() const { return dropped.load(std::memory_order_relaxed); }
+    int ringsAllocated() const { return std::min(ringCount.load(std::memory_order_acquire), MAX_THREADS); }
+
+    void endFrame(int drawCalls, int vertices) {
+        uint64_t now = nowNs();
+        if (lastFrameNs != 0) {
+            frames[frameHead % FRAME_HISTORY] = {(now - lastFrameNs) / 1.0e6f, drawCalls, vertices};
+            frameHead++;
+        }
+        lastFrameNs = now;
+    }
+
+    int frameCount() const { return frameHead < FRAME_HISTORY ? frameHead : FRAME_HISTORY; }
+
+    // i = 0 is the oldest retained frame
+    const FrameSample& frame(int i) const {
+        int start = frameHead < FRAME_HISTORY ? 0 : frameHead % FRAME_HISTORY;
+        return frames[(start + i) % FRAME_HISTORY];
+    }
+
+    float percentile(float p) const {
+        int count = frameCount();
+        if (count == 0) return 0.0f;
+        float sorted[FRAME_HISTORY];
+        for (int i = 0; i < count; i++) sorted[i] = frames[i].ms;
+        int k = std::min(count - 1, (int)(p * count));
+        std::nth_element(sorted, sorted + k, sorted + count);
+        return sorted[k];
+    }
+
+    // Write every retained zone in Chrome trace-event JSON (chrome://tracing, Perfetto)
+    bool exportTrace(const char* path) {
+        FILE* file = fopen(path, "w");
+        if (!file) return false;
+
+        fputs("{\"traceEvents\":[", file);
+        bool first = true;
+        int count = ringsAllocated();
+        for (int r = 0; r < count; r++) {
+            ProfileRing* ring = rings[r].load(std::memory_order_acquire);
+            if (!ring) continue;
+
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t tail = head > ProfileRing::CAPACITY ? head - ProfileRing::CAPACITY : 0;
+            for (uint64_t i = tail; i < head; i++) {
+                // Skip slots the writer lapped while we were reading
+                ProfileEvent e;
+                if (!ring->read(i, e)) continue;
+
+                fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        first ? "" : ",", e.name, ring->threadIndex, e.startNs / 1000.0, (e.endNs - e.startNs) / 1000.0);
+                first = false;
+            }
+        }
+        fprintf(file, "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedZones\":%llu}}\n",
+                (unsigned long long)droppedZones());
+        fclose(file);
+        return true;
+    }
+
+    bool overlayVisible = false;
+
+private:
+    std::atomic<ProfileRing*> rings[MAX_THREADS] = {};
+    std::atomic<int> ringCount{0};
+    std::atomic<uint64_t> freeRings{0};  // Bit i: rings[i] was handed back
+    std::atomic<uint64_t> dropped{0};
+
+    static_assert(MAX_THREADS <= 64, "freeRings has a bit per ring");
+
+    ProfileRing* acquireRing() {
+        uint64_t free = freeRings.load(std::memory_order_acquire);
+        while (free != 0) {
+            uint64_t bit = free & (~free + 1);
+            if (freeRings.compare_exchange_weak(free, free & ~bit, std::memory_order_acq_rel)) {
+                int index = 0;
+                while (!(bit >> index & 1)) index++;
+                return rings[index].load(std::memory_order_acquire);
+            }
+        }
+        // Only counted up while there is room, so threads past the limit don't wrap it
+        int index = ringCount.load(std::memory_order_relaxed);
+        do {
+            if (index >= MAX_THREADS) return nullptr;
+        } while (!ringCount.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel));
+        ProfileRing* ring = new ProfileRing();
+        ring->threadIndex = index;
+        rings[index].store(ring, std::memory_order_release);
+        return ring;
+    }
+
+    void releaseRing(ProfileRing* ring) {
+        freeRings.fetch_or((uint64_t)1 << ring->threadIndex, std::memory_order_release);
+    }
+
+    FrameSample frames[FRAME_HISTORY] = {};
+    int frameHead = 0;
+    uint64_t lastFrameNs = 0;
+};
+
+class ProfileZone {
+private:
+    const char* name;
+    uint64_t startNs;
+
+public:
+    explicit ProfileZone(const char* zoneName) : name(zoneName), startNs(Profiler::nowNs()) {}
+    ~ProfileZone() {
+        ProfileRing* ring = Profiler::instance().threadRing();
+        if (ring) ring->push(name, startNs, Profiler::nowNs());
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include "raylib.h"
+#include "render_stats.h"
+#include "profiler.h"
+
+#ifdef PASSGEN_PROFILE
+
+// Per-frame bookkeeping and hotkeys, call once right before EndDrawing()
+inline void ProfilerEndFrame(Font font) {
+    Profiler& profiler = Profiler::instance();
+    const RenderStats& stats = FrameStats();
+    profiler.endFrame(stats.drawCalls, stats.vertices());
+
+    if (IsKeyPressed(KEY_F3)) profiler.overlayVisible = !profiler.overlayVisible;
+    if (IsKeyPressed(KEY_F4)) {
+        bool ok = profiler.exportTrace("passgen_trace.json");
+        TraceLog(ok ? LOG_INFO : LOG_WARNING, "PROFILER: trace export to passgen_trace.json %s", ok ? "done" : "failed");
+    }
+    if (!profiler.overlayVisible) return;
+
+    // Frame-time graph: one bar per frame, 16.6 ms budget line
+    const int graphX = 5, graphY = 5, graphW = Profiler::FRAME_HISTORY, graphH = 50;
+    const float msScale = graphH / 33.3f;
+    DrawRectangle(graphX, graphY, graphW, graphH + 34, Fade(BLACK, 0.8f));
+    int count = profiler.frameCount();
+    for (int i = 0; i < count; i++) {
+        float ms = profiler.frame(i).ms;
+        int h = std::min(graphH, (int)(ms * msScale));
+        DrawRectangle(graphX + i, graphY + graphH - h, 1, h, ms > 16.7f ? RED : LIME);
+    }
+    DrawLine(graphX, graphY + graphH - (int)(16.6f * msScale), graphX + graphW, graphY + graphH - (int)(16.6f * msScale), YELLOW);
+
+    DrawTextEx(font, TextFormat("p50 %.2f ms  p99 %.2f ms", profiler.percentile(0.50f), profiler.percentile(0.99f)),
+               {(float)graphX + 2, (float)graphY + graphH + 2}, 14, 1.0f, WHITE);
+    // Zones of threads beyond Profiler::MAX_THREADS at once aren't recorded
+    uint64_t dropped = profiler.droppedZones();
+    DrawTextEx(font, dropped > 0 ? TextFormat("draws %d  verts %d  dropped zones %llu", stats.drawCalls, stats.vertices(),
+                                              (unsigned long long)dropped)
+                                 : TextFormat("draws %d  verts %d", stats.drawCalls, stats.vertices()),
+               {(float)graphX + 2, (float)graphY + graphH + 18}, 14, 1.0f, WHITE);
+}
+
+#else
+
+inline void ProfilerEndFrame(Font) {}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+#include "raylib.h"
+
+// Per-frame draw statistics.
+// raylib batches quads until the bound texture or primitive mode changes, so
+// counting those switches gives the number of draw calls rlgl submits.
+struct RenderStats {
+    static constexpr unsigned int SHAPES_BATCH = 0;          // Default shapes texture
+    static constexpr unsigned int LINES_BATCH = 0xFFFFFFFF;  // RL_LINES primitive mode
+
+    int drawCalls = 0;
+    int quads = 0;
+    int lines = 0;
+    unsigned int currentBatch = 0xFFFFFFFE;
+
+    void reset() {
+        drawCalls = 0;
+        quads = 0;
+        lines = 0;
+        currentBatch = 0xFFFFFFFE;
+    }
+
+    void submit(unsigned int batch, int quadCount) {
+        if (batch != currentBatch) {
+            drawCalls++;
+            currentBatch = batch;
+        }
+        if (batch == LINES_BATCH) lines += quadCount;
+        else quads += quadCount;
+    }
+
+    int vertices() const { return quads * 4 + lines * 2; }
+};
+
+inline RenderStats& FrameStats() {
+    static RenderStats stats;
+    return stats;
+}
+
+// Counted wrappers around the raylib primitives used by the UI
+inline void DrawUiRect(Rectangle rec, Color color) {
+    DrawRectangleRec(rec, color);
+    FrameStats().submit(RenderStats::SHAPES_BATCH, 1);
+}
+
+inline void DrawUiRectLines(Rectangle rec, float thick, Color color) {
+    DrawRectangleLinesEx(rec, thick, color);
+    FrameStats().submit(RenderStats::SHAPES_BATCH, 4);
+}
+
+inline void DrawUiLine(int startX, int startY, int endX, int endY, Color color) {
+    DrawLine(startX, startY, endX, endY, color);
+    FrameStats().submit(RenderStats::LINES_BATCH, 1);
+}
+
+inline void DrawUiTexture(Texture2D texture, Rectangle source, Vector2 position, Color tint) {
+    DrawTextureRec(texture, source, position, tint);
+    FrameStats().submit(texture.id, 1);
+}
+
+inline void CountTextQuads(Font font, const char* text) {
+    // DrawTextEx skips spaces and tabs, every other byte is one glyph quad
+    int glyphs = 0;
+    for (const char* c = text; *c; c++) {
+        if (*c != ' ' && *c != '\t' && *c != '\n') glyphs++;
+    }
+    if (glyphs > 0) FrameStats().submit(font.texture.id, glyphs);
+}
@@ -0,0 +1,483 @@
+#pragma once
+#include "profiler.h"
+#include "secure_memory.h"
+#include "siphash.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER)
+    #include <xmmintrin.h>
+#endif
+
+enum ReuseFlags : uint8_t {
+    REUSE_NONE = 0,
+    REUSE_EXACT = 1,  // Another entry has the same password
+    REUSE_NEAR = 2    // Another entry has a trivially different password
+};
+
+// Finds reused and near-duplicate passwords in the library.
+//
+// Exact reuse: every password is reduced to a SipHash digest under a random
+// per-session key, and digests are counted in a hash map. The keys live in
+// page-locked memory; plaintext is read in place and never copied.
+//
+// Near duplicates: MinHash signatures over case-folded character 3-grams,
+// indexed by locality-sensitive hashing (BANDS bands of BAND_ROWS values).
+// Entries sharing a band are compared by signature, and pairs whose
+// estimated Jaccard similarity reaches NEAR_MATCHES / SIGNATURE_SIZE are
+// flagged. "P@ssW0rd789" and "P@ssW0rd790" share 8 of 14 shingles (0.57).
+//
+// sync() is incremental: it hashes the library, keeps the unchanged prefix
+// and suffix, and re-indexes only the entries in between, so a single edit,
+// delete or append costs one digest pass and a handful of index updates.
+// When most of the library changed (first load, import) the index is rebuilt
+// in bulk from radix-sorted band keys instead of probing once per entry.
+class ReuseAudit {
+public:
+    static constexpr int SIGNATURE_SIZE = 32;
+    static constexpr int BANDS = 12;
+    static constexpr int BAND_ROWS = 2;
+    static constexpr int NEAR_MATCHES = 13;
+    static constexpr size_t BULK_MIN = 4096;  // Smallest change rebuilt in bulk
+
+private:
+    struct Entry {
+        uint64_t digest;
+        uint32_t* digestCount;  // Value in digestCounts; nodes don't move on rehash
+        uint32_t nearCount;     // Near-duplicate partners with a different password
+        uint32_t stamp;         // Candidate de-duplication during a query
+        uint32_t signature[SIGNATURE_SIZE];
+    };
+
+    // Open-addressing multimap from band key to entry slot
+    struct BandSlot {
+        uint32_t key;
+        uint32_t slot;
+    };
+    static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+    // Keys live in locked memory: sipKey[2], the shingle hash key and per-function masks
+    SecureBuffer secure;
+    uint64_t* sipKey = nullptr;
+    uint64_t* hashKey = nullptr;
+    uint32_t* hashMix = nullptr;
+
+    std::vector<Entry> entries;          // By slot
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> order;         // Library index -> slot
+    std::unordered_map<uint64_t, uint32_t> digestCounts;
+    std::vector<BandSlot> bands;
+    size_t bandEntries = 0;
+    std::vector<uint64_t> digests;       // Scratch for sync()
+    uint32_t stampCounter = 0;
+    uint64_t syncedRevision = 0;
+    bool synced = false;
+    size_t exactCount = 0;
+    size_t nearTotal = 0;
+
+    static uint64_t mix64(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t digestOf(std::string_view password) const {
+        return sipHash24(sipKey, password.data(), password.size());
+    }
+
+    // Case-folded, with begin/end markers so short passwords still have
+    // shingles. Folding happens in a register, so this only reads shared state
+    // and signatures can be computed on several threads at once.
+    void computeSignature(std::string_view password, uint32_t* signature) const {
+        auto folded = [&](size_t i) -> uint64_t {
+            if (i == 0) return '^';
+            if (i > password.size()) return '$';
+            char c = password[i - 1];
+            return (uint8_t)(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+        };
+        size_t padded = password.size() + 2;
+
+        // One keyed 64-bit hash per shingle, split into two 32-bit halves that
+        // generate the SIGNATURE_SIZE hash functions as h1 + k * h2
+        uint32_t minimum[SIGNATURE_SIZE];
+        for (int k = 0; k < SIGNATURE_SIZE; k++) minimum[k] = 0xFFFFFFFF;
+        size_t shingles = padded >= 3 ? padded - 2 : 1;
+        for (size_t i = 0; i < shingles; i++) {
+            uint64_t shingle = folded(i) | folded(i + 1) << 8 | (padded >= 3 ? folded(i + 2) << 16 : 0);
+            uint64_t base = mix64(shingle ^ hashKey[0]);
+            uint32_t h1 = (uint32_t)base, h2 = (uint32_t)(base >> 32) | 1;
+            for (int k = 0; k < SIGNATURE_SIZE; k++) {
+                uint32_t h = (h1 + (uint32_t)k * h2) ^ hashMix[k];
+                minimum[k] = h < minimum[k] ? h : minimum[k];
+            }
+        }
+        for (int k = 0; k < SIGNATURE_SIZE; k++) signature[k] = minimum[k];
+    }
+
+    static uint32_t bandKey(const Entry& entry, int band) {
+        uint64_t v = (uint64_t)entry.signature[band * BAND_ROWS] << 32 | entry.signature[band * BAND_ROWS + 1];
+        return (uint32_t)mix64(v + (uint64_t)band * 0x9E3779B97F4A7C15ULL);
+    }
+
+    size_t bandMask() const { return bands.size() - 1; }
+
+    void bandInsert(uint32_t key, uint32_t slot) {
+        size_t i = key & bandMask();
+        while (bands[i].slot != EMPTY) i = (i + 1) & bandMask();
+        bands[i] = {key, slot};
+        bandEntries++;
+    }
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    void bandErase(uint32_t key, uint32_t slot) {
+        size_t i = key & bandMask();
+        while (bands[i].slot != EMPTY && !(bands[i].key == key && bands[i].slot == slot)) i = (i + 1) & bandMask();
+        if (bands[i].slot == EMPTY) return;
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & bandMask();
+            if (bands[j].slot == EMPTY) break;
+            size_t home = bands[j].key & bandMask();
+            bool movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+            if (movable) {
+                bands[i] = bands[j];
+                i = j;
+            }
+        }
+        bands[i].slot = EMPTY;
+        bandEntries--;
+    }
+
+    // Smallest power of two that keeps the load factor under 3/4
+    static size_t bandCapacity(size_t needed) {
+        size_t capacity = 1024;
+        while (needed * 4 >= capacity * 3) capacity *= 2;
+        return capacity;
+    }
+
+    void growBands(size_t needed) {
+        if (needed * 4 < bands.size() * 3) return;
+        size_t capacity = bandCapacity(needed);
+        std::vector<BandSlot> old;
+        old.swap(bands);
+        bands.assign(capacity, {0, EMPTY});
+        bandEntries = 0;
+        for (const BandSlot& b : old) {
+            if (b.slot != EMPTY) bandInsert(b.key, b.slot);
+        }
+    }
+
+    static int matches(const Entry& a, const Entry& b) {
+        int same = 0;
+        for (int k = 0; k < SIGNATURE_SIZE; k++) same += a.signature[k] == b.signature[k];
+        return same;
+    }
+
+    void countNear(Entry& a, Entry& b) {
+        nearTotal += (a.nearCount == 0) + (b.nearCount == 0);
+        a.nearCount++;
+        b.nearCount++;
+    }
+
+    // Adjust the near-duplicate counts of every indexed partner of slot by delta.
+    // When adding, the entry's own band keys go into the free cell that ends
+    // each probe chain, so the chain is walked only once.
+    void updatePartners(uint32_t slot, int delta) {
+        Entry& entry = entries[slot];
+        if (++stampCounter == 0) {
+            for (Entry& e : entries) e.stamp = 0;
+            stampCounter = 1;
+        }
+        entry.stamp = stampCounter;
+        for (int band = 0; band < BANDS; band++) {
+            uint32_t key = bandKey(entry, band);
+            size_t i = key & bandMask();
+            for (; bands[i].slot != EMPTY; i = (i + 1) & bandMask()) {
+                if (bands[i].key != key) continue;
+                Entry& other = entries[bands[i].slot];
+                if (other.stamp == stampCounter) continue;
+                other.stamp = stampCounter;
+                if (other.digest == entry.digest || matches(entry, other) < NEAR_MATCHES) continue;
+
+                if (delta > 0) {
+                    countNear(entry, other);
+                } else {
+                    other.nearCount--;
+                    nearTotal -= (other.nearCount == 0);
+                }
+            }
+            if (delta > 0) {
+                bands[i] = {key, slot};
+                bandEntries++;
+            }
+        }
+        if (delta < 0) {
+            nearTotal -= entry.nearCount > 0;
+            entry.nearCount = 0;
+        }
+    }
+
+    // Bulk indexing is bound by cache misses on the band table; fetch the
+    // next entries' probe chains while the current one is being processed
+    void prefetchBands(uint32_t slot) const {
+        const Entry& entry = entries[slot];
+        for (int band = 0; band < BANDS; band++) {
+            const BandSlot* cell = &bands[bandKey(entry, band) & bandMask()];
+#if defined(_MSC_VER)
+            _mm_prefetch((const char*)cell, _MM_HINT_T0);
+#else
+            __builtin_prefetch(cell);
+#endif
+        }
+    }
+
+    // Slot and exact-reuse bookkeeping; the signature is filled in by the caller
+    uint32_t createEntry(uint64_t digest) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = (uint32_t)entries.size();
+            entries.emplace_back();
+        }
+        Entry& entry = entries[slot];
+        entry.digest = digest;
+        entry.nearCount = 0;
+        entry.stamp = 0;
+
+        uint32_t& count = digestCounts[digest];
+        count++;
+        exactCount += count == 2 ? 2 : count > 2 ? 1 : 0;
+        entry.digestCount = &count;
+        return slot;
+    }
+
+    void removeEntry(uint32_t slot) {
+        Entry& entry = entries[slot];
+        uint32_t& count = *entry.digestCount;
+        exactCount -= count == 2 ? 2 : count > 2 ? 1 : 0;
+        if (--count == 0) digestCounts.erase(entry.digest);
+
+        for (int band = 0; band < BANDS; band++) bandErase(bandKey(entry, band), slot);
+        updatePartners(slot, -1);
+        secureZero(entry.signature, sizeof(entry.signature));
+        freeSlots.push_back(slot);
+    }
+
+    void clear() {
+        for (Entry& entry : entries) secureZero(entry.signature, sizeof(entry.signature));
+        entries.clear();
+        freeSlots.clear();
+        order.clear();
+        digestCounts.clear();
+        bands.clear();
+        bandEntries = 0;
+        exactCount = 0;
+        nearTotal = 0;
+    }
+
+    // Index every entry into an empty table at once. The (band key, band,
+    // slot) triples are radix-sorted with the key's home-bucket bits on top,
+    // so equal keys are adjacent and candidate pairs come out of one scan,
+    // and the table fills front to back instead of one random write per key.
+    void bulkIndex() {
+        size_t count = entries.size();
+        bands.assign(bandCapacity(count * BANDS), {0, EMPTY});
+        int homeBits = 0;
+        while (((size_t)1 << homeBits) < bands.size()) homeBits++;
+        auto rotate = [](uint32_t v, int bits) { return bits % 32 == 0 ? v : (v << bits) | (v >> (32 - bits)); };
+
+        // sort key (32 bits) | band (4) | slot (28)
+        std::vector<uint64_t> keys(count * BANDS), sorted(count * BANDS);
+        for (size_t slot = 0; slot < count; slot++) {
+            for (int band = 0; band < BANDS; band++) {
+                uint32_t sortKey = rotate(bandKey(entries[slot], band), 32 - homeBits);
+                keys[slot * BANDS + band] = (uint64_t)sortKey << 32 | (uint64_t)band << 28 | slot;
+            }
+        }
+        // LSD radix sort on the top 32 bits in three 11-bit digits
+        std::vector<size_t> offsets(2049);
+        for (int shift = 32; shift < 64; shift += 11) {
+            std::fill(offsets.begin(), offsets.end(), 0);
+            for (uint64_t k : keys) offsets[((k >> shift) & 0x7FF) + 1]++;
+            for (int b = 0; b < 2048; b++) offsets[b + 1] += offsets[b];
+            for (uint64_t k : keys) sorted[offsets[(k >> shift) & 0x7FF]++] = k;
+            keys.swap(sorted);
+        }
+        std::vector<uint64_t>().swap(sorted);
+
+        // Entries of a run with the same password have the same signature:
+        // only one of each is compared, and a near pair of passwords counts
+        // for every entry holding either
+        struct Member {
+            uint64_t digest;
+            uint32_t slot;
+        };
+        std::vector<Member> members;
+        std::vector<size_t> groups;  // Start of each password's members, then the end
+        auto credit = [&](size_t group, uint32_t partners) {
+            for (size_t m = groups[group]; m < groups[group + 1]; m++) {
+                Entry& entry = entries[members[m].slot];
+                nearTotal += entry.nearCount == 0;
+                entry.nearCount += partners;
+            }
+        };
+
+        size_t next = 0;     // First cell not yet filled; homes only increase
+        size_t wrapped = 0;  // Where the chains that ran past the end go on
+        for (size_t run = 0; run < keys.size();) {
+            size_t end = run + 1;
+            while (end < keys.size() && keys[end] >> 32 == keys[run] >> 32) end++;
+            uint32_t key = rotate((uint32_t)(keys[run] >> 32), homeBits);
+
+            for (size_t i = run; i < end; i++) {
+                uint32_t slot = (uint32_t)(keys[i] & 0x0FFFFFFF);
+                size_t cell = std::max<size_t>(key & bandMask(), next);
+                if (cell < bands.size()) {
+                    bands[cell] = {key, slot};
+                    bandEntries++;
+                    next = cell + 1;
+                } else {
+                    // Probe chain wrapped around the end; the front is filled up
+                    // to the first free cell, so the chain goes on from there
+                    while (bands[wrapped].slot != EMPTY) wrapped++;
+                    bands[wrapped++] = {key, slot};
+                    bandEntries++;
+                }
+            }
+            if (end - run < 2) {
+                run = end;
+                continue;
+            }
+
+            members.clear();
+            for (size_t i = run; i < end; i++) {
+                uint32_t slot = (uint32_t)(keys[i] & 0x0FFFFFFF);
+                members.push_back({entries[slot].digest, slot});
+            }
+            std::sort(members.begin(), members.end(), [](const Member& a, const Member& b) { return a.digest < b.digest; });
+            groups.clear();
+            for (size_t m = 0; m < members.size(); m++) {
+                if (m == 0 || members[m].digest != members[m - 1].digest) groups.push_back(m);
+            }
+            groups.push_back(members.size());
+
+            // A pair sharing several bands is counted in the first one only
+            int band = (int)(keys[run] >> 28 & 0xF);
+            for (size_t g = 0; g + 1 < groups.size(); g++) {
+                const Entry& a = entries[members[groups[g]].slot];
+                for (size_t h = g + 1; h + 1 < groups.size(); h++) {
+                    const Entry& b = entries[members[groups[h]].slot];
+                    if (matches(a, b) < NEAR_MATCHES) continue;
+                    bool earlier = false;
+                    for (int k = 0; k < band && !earlier; k++) earlier = bandKey(a, k) == bandKey(b, k);
+                    if (earlier) continue;
+                    credit(g, (uint32_t)(groups[h + 1] - groups[h]));
+                    credit(h, (uint32_t)(groups[g + 1] - groups[g]));
+                }
+            }
+            run = end;
+        }
+    }
+
+public:
+    ReuseAudit() {
+        size_t keyBytes = 3 * sizeof(uint64_t) + SIGNATURE_SIZE * sizeof(uint32_t);
+        secure.allocate(keyBytes);
+        sipKey = (uint64_t*)secure.data();
+        hashKey = sipKey + 2;
+        hashMix = (uint32_t*)(hashKey + 1);
+
+        std::random_device device;
+        auto random64 = [&]() { return (uint64_t)device() << 32 | device(); };
+        sipKey[0] = random64();
+        sipKey[1] = random64();
+        hashKey[0] = random64();
+        for (int k = 0; k < SIGNATURE_SIZE; k++) hashMix[k] = device();
+    }
+    ReuseAudit(const ReuseAudit&) = delete;
+    ReuseAudit& operator=(const ReuseAudit&) = delete;
+
+    // Bring the index up to date with a library revision of count entries,
+    // passwordAt(i) returning a std::string_view; cheap when nothing changed.
+    // parallel(n, body) runs body(first, last) over [0, n), possibly split
+    // across threads; the hashing passes go through it.
+    template <typename PasswordAt, typename ParallelFor>
+    void sync(uint64_t revision, size_t count, PasswordAt passwordAt, ParallelFor parallel) {
+        if (synced && syncedRevision == revision && order.size() == count) return;
+        PROFILE_ZONE("reuse.sync");
+
+        digests.resize(count);
+        parallel(count, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) digests[i] = digestOf(passwordAt(i));
+        });
+
+        // Unchanged prefix and suffix keep their slots
+        size_t oldCount = order.size();
+        size_t prefix = 0;
+        while (prefix < oldCount && prefix < count && entries[order[prefix]].digest == digests[prefix]) prefix++;
+        size_t suffix = 0;
+        while (suffix < oldCount - prefix && suffix < count - prefix &&
+               entries[order[oldCount - 1 - suffix]].digest == digests[count - 1 - suffix]) {
+            suffix++;
+        }
+
+        size_t changed = count - suffix - prefix;
+        bool bulk = changed >= BULK_MIN && changed * 2 >= count && count < ((size_t)1 << 28);
+        if (bulk) {
+            clear();
+            oldCount = prefix = suffix = 0;
+            changed = count;
+            digestCounts.reserve(count);
+            entries.reserve(count);
+        }
+
+        for (size_t i = prefix; i < oldCount - suffix; i++) removeEntry(order[i]);
+        order.erase(order.begin() + prefix, order.begin() + (oldCount - suffix));
+
+        std::vector<uint32_t> added(changed);
+        for (size_t i = 0; i < changed; i++) added[i] = createEntry(digests[prefix + i]);
+        parallel(changed, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) computeSignature(passwordAt(prefix + i), entries[added[i]].signature);
+        });
+
+        if (bulk) {
+            bulkIndex();
+        } else {
+            growBands(bandEntries + added.size() * BANDS);
+            const size_t lookahead = 4;
+            for (size_t i = 0; i < added.size(); i++) {
+                if (i + lookahead < added.size()) prefetchBands(added[i + lookahead]);
+                updatePartners(added[i], +1);
+            }
+        }
+        order.insert(order.begin() + prefix, added.begin(), added.end());
+
+        syncedRevision = revision;
+        synced = true;
+    }
+
+    template <typename PasswordAt>
+    void sync(uint64_t revision, size_t count, PasswordAt passwordAt) {
+        sync(revision, count, passwordAt, [](size_t n, auto body) { body(0, n); });
+    }
+
+    uint8_t flags(size_t index) const {
+        if (index >= order.size()) return REUSE_NONE;
+        const Entry& entry = entries[order[index]];
+        uint8_t result = REUSE_NONE;
+        if (*entry.digestCount > 1) result |= REUSE_EXACT;
+        if (entry.nearCount > 0) result |= REUSE_NEAR;
+        return result;
+    }
+
+    size_t reusedCount() const { return exactCount; }          // Entries sharing their password
+    size_t nearDuplicateCount() const { return nearTotal; }    // Entries with a near-duplicate
+    bool isLocked() const { return secure.isLocked(); }
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOGDI
+    #define NOUSER
+    #include <windows.h>
+    #undef near
+    #undef far
+#else
+    #include <sys/mman.h>
+#endif
+
+// Zeroing the compiler may not optimize away
+inline void secureZero(void* data, size_t size) {
+    volatile uint8_t* p = (volatile uint8_t*)data;
+    while (size--) *p++ = 0;
+}
+
+// Page-locked scratch memory for secrets and keys: never swapped out where
+// the OS allows it, and wiped before it is released. Locking is best effort;
+// the buffer still works (unlocked) if the process is over its mlock limit.
+class SecureBuffer {
+private:
+    uint8_t* base = nullptr;
+    size_t length = 0;
+    bool locked = false;
+
+public:
+    SecureBuffer() = default;
+    explicit SecureBuffer(size_t size) { allocate(size); }
+    ~SecureBuffer() { release(); }
+    SecureBuffer(const SecureBuffer&) = delete;
+    SecureBuffer& operator=(const SecureBuffer&) = delete;
+
+    bool allocate(size_t size) {
+        release();
+#if defined(_WIN32)
+        base = (uint8_t*)VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!base) return false;
+        locked = VirtualLock(base, size) != 0;
+#else
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return false;
+        base = (uint8_t*)p;
+        locked = mlock(base, size) == 0;
+    #if defined(MADV_DONTDUMP)
+        madvise(base, size, MADV_DONTDUMP);  // Keep secrets out of core dumps
+    #endif
+#endif
+        length = size;
+        return true;
+    }
+
+    void release() {
+        if (!base) return;
+        secureZero(base, length);
+#if defined(_WIN32)
+        if (locked) VirtualUnlock(base, length);
+        VirtualFree(base, 0, MEM_RELEASE);
+#else
+        if (locked) munlock(base, length);
+        munmap(base, length);
+#endif
+        base = nullptr;
+        length = 0;
+        locked = false;
+    }
+
+    uint8_t* data() { return base; }
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+    bool isLocked() const { return locked; }
+};
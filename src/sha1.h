@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// SHA-1, used only to match passwords against breach corpora that are
+// published as SHA-1 hashes (e.g. Have I Been Pwned). Not for new designs.
+struct Sha1Digest {
+    uint8_t bytes[20];
+};
+
+class Sha1 {
+private:
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t block[64];
+    size_t blockUsed = 0;
+    uint64_t totalBytes = 0;
+
+    static uint32_t rol(uint32_t v, int bits) { return (v << bits) | (v >> (32 - bits)); }
+
+    void compress(const uint8_t* data) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = ((uint32_t)data[i * 4] << 24) | ((uint32_t)data[i * 4 + 1] << 16) |
+                   ((uint32_t)data[i * 4 + 2] << 8) | (uint32_t)data[i * 4 + 3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        // One loop per round function keeps the rounds branch-free
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        auto step = [&](uint32_t f, uint32_t k, uint32_t wi) {
+            uint32_t t = rol(a, 5) + f + e + k + wi;
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        };
+        for (int i = 0; i < 20; i++) step(d ^ (b & (c ^ d)), 0x5A827999, w[i]);
+        for (int i = 20; i < 40; i++) step(b ^ c ^ d, 0x6ED9EBA1, w[i]);
+        for (int i = 40; i < 60; i++) step((b & c) | (d & (b | c)), 0x8F1BBCDC, w[i]);
+        for (int i = 60; i < 80; i++) step(b ^ c ^ d, 0xCA62C1D6, w[i]);
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+public:
+    void update(const void* data, size_t size) {
+        const uint8_t* p = (const uint8_t*)data;
+        totalBytes += size;
+        if (blockUsed > 0) {
+            size_t take = size < 64 - blockUsed ? size : 64 - blockUsed;
+            memcpy(block + blockUsed, p, take);
+            blockUsed += take;
+            p += take;
+            size -= take;
+            if (blockUsed < 64) return;
+            compress(block);
+            blockUsed = 0;
+        }
+        for (; size >= 64; p += 64, size -= 64) compress(p);
+        memcpy(block, p, size);
+        blockUsed = size;
+    }
+
+    Sha1Digest finish() {
+        uint64_t bits = totalBytes * 8;
+        block[blockUsed++] = 0x80;
+        if (blockUsed > 56) {
+            memset(block + blockUsed, 0, 64 - blockUsed);
+            compress(block);
+            blockUsed = 0;
+        }
+        memset(block + blockUsed, 0, 56 - blockUsed);
+        for (int i = 0; i < 8; i++) block[56 + i] = (uint8_t)(bits >> (56 - i * 8));
+        compress(block);
+        blockUsed = 0;
+
+        Sha1Digest digest;
+        for (int i = 0; i < 5; i++) {
+            digest.bytes[i * 4] = (uint8_t)(state[i] >> 24);
+            digest.bytes[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+            digest.bytes[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+            digest.bytes[i * 4 + 3] = (uint8_t)state[i];
+        }
+        return digest;
+    }
+
+    static Sha1Digest hash(std::string_view text) {
+        Sha1 sha;
+        sha.update(text.data(), text.size());
+        return sha.finish();
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// SipHash-2-4 (Aumasson & Bernstein): a keyed 64-bit hash, so digests of
+// secrets kept in memory can't be matched against a precomputed table.
+inline uint64_t sipHash24(const uint64_t key[2], const void* data, size_t size) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+
+    auto rotl = [](uint64_t x, int b) { return (x << b) | (x >> (64 - b)); };
+    auto round = [&]() {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    };
+
+    const uint8_t* p = (const uint8_t*)data;
+    size_t blocks = size / 8;
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t m = 0;
+        for (int b = 7; b >= 0; b--) m = (m << 8) | p[i * 8 + b];
+        v3 ^= m;
+        round();
+        round();
+        v0 ^= m;
+    }
+
+    uint64_t last = (uint64_t)size << 56;
+    for (size_t b = 0; b < size % 8; b++) last |= (uint64_t)p[blocks * 8 + b] << (8 * b);
+    v3 ^= last;
+    round();
+    round();
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    round();
+    round();
+    round();
+    round();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
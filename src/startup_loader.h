@@ -0,0 +1,151 @@
+#pragma once
+#include "raylib.h"
+#include "app_ui.h"
+#include "profiler.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Staged startup. main() brings up the window with a small rasterization of
+// the UI font and starts drawing; meanwhile the loader's thread rasterizes
+// the font at full size, decodes the window icon, and opens the vaults and
+// the breach corpus. poll() hands each result over on the main thread as it
+// becomes ready, uploading to the GPU there.
+//
+// Debug and profiling builds report the time to the first frame and to the
+// last hand-over (interactive) at launch.
+
+static constexpr int UI_FONT_FIRST_SIZE = 24;  // The largest size drawn, 1/25 of the full font's pixels
+
+class StartupLoader {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        const unsigned char* fontData = nullptr;
+        int fontDataSize = 0;
+        const unsigned char* iconData = nullptr;  // PNG
+        int iconDataSize = 0;
+        bool openVaults = true;                   // And the breach corpus
+        std::vector<std::string> vaultPaths;      // passwords.dat if empty
+    };
+
+private:
+    enum : int { FONT_READY = 1, ICON_READY = 2, LIBRARY_READY = 4, ALL_READY = 7 };
+
+    std::thread worker;
+    std::atomic<int> ready{0};  // Published by the worker
+    int handedOver = 0;
+    FontPixels font;
+    Image icon = {};
+
+    // Milliseconds; the loader's stages, then since launch
+    Clock::time_point launch;
+    double fontMs = 0.0, iconMs = 0.0, libraryMs = 0.0;
+    double firstFrameMs = 0.0, interactiveMs = 0.0;
+
+    static double msSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void run(AppState& app, Job job) {
+        Clock::time_point start = Clock::now();
+        {
+            PROFILE_ZONE("startup.font");
+            font = RasterizeUiFont(job.fontData, job.fontDataSize, UI_FONT_BASE_SIZE);
+        }
+        fontMs = msSince(start);
+        ready.fetch_or(FONT_READY, std::memory_order_release);
+
+        start = Clock::now();
+        {
+            PROFILE_ZONE("startup.icon");
+            icon = LoadImageFromMemory(".png", job.iconData, job.iconDataSize);
+        }
+        iconMs = msSince(start);
+        ready.fetch_or(ICON_READY, std::memory_order_release);
+
+        start = Clock::now();
+        if (job.openVaults) {
+            PROFILE_ZONE("startup.library");
+            // Vault files to open; the first is loaded from its encrypted
+            // file and journal, the others only indexed until Tab switches to them
+            OpenVaults(app, std::move(job.vaultPaths));
+
+            // Breached-password corpus is optional, see tools/breach_convert.cpp and tools/breach_filter.cpp
+            if (app.breachDb.open(app.breachDbPath)) app.breachDb.loadFilter(app.breachFilterPath);
+        }
+        libraryMs = msSince(start);
+        ready.fetch_or(LIBRARY_READY, std::memory_order_release);
+    }
+
+    void report() const {
+#if !defined(NDEBUG) || defined(PASSGEN_PROFILE)
+        TraceLog(LOG_INFO, "STARTUP: first frame after %.1f ms, interactive after %.1f ms "
+                 "(loader: font %.1f ms, icon %.1f ms, library %.1f ms)",
+                 firstFrameMs, interactiveMs, fontMs, iconMs, libraryMs);
+#endif
+    }
+
+public:
+    // launched: the start of main(), which the times are measured from
+    explicit StartupLoader(Clock::time_point launched) : launch(launched) {}
+    StartupLoader(const StartupLoader&) = delete;
+    StartupLoader& operator=(const StartupLoader&) = delete;
+    ~StartupLoader() {
+        if (worker.joinable()) worker.join();
+    }
+
+    // The library belongs to the loader until poll() hands it over
+    void start(AppState& app, Job job) {
+        app.libraryLoading = job.openVaults;
+        worker = std::thread([this, &app, job = std::move(job)]() mutable { run(app, std::move(job)); });
+    }
+
+    // Main thread, before each frame: take over what is ready. True once
+    // everything is.
+    bool poll(AppState& app, UiFonts& fonts) {
+        int now = ready.load(std::memory_order_acquire);
+        int fresh = now & ~handedOver;
+        if (fresh & FONT_READY) {
+            UnloadUiFonts(fonts);
+            fonts = UiFontsFrom(UploadFont(font));
+            // Measurements and chrome drawn with the small font
+            app.layout.clear();
+            app.chrome.invalidate();
+            app.measuredPassword[0] = '\0';
+        }
+        if ((fresh & ICON_READY) && icon.data) {
+            SetWindowIcon(icon);
+            UnloadImage(icon);
+            icon = Image();
+        }
+        if (fresh & LIBRARY_READY) app.libraryLoading = false;
+        handedOver = now;
+
+        if (handedOver != ALL_READY) return false;
+        if (worker.joinable()) {
+            worker.join();
+            interactiveMs = msSince(launch);
+            if (firstFrameMs > 0.0) report();
+        }
+        return true;
+    }
+
+    // Main thread, after each EndDrawing()
+    void frameDrawn() {
+        if (firstFrameMs > 0.0) return;
+        firstFrameMs = msSince(launch);
+        if (interactiveMs > 0.0) report();
+    }
+
+    // Wait for the loader and take over the rest; before CloseWindow(), as
+    // it uploads what is left
+    void finish(AppState& app, UiFonts& fonts) {
+        if (worker.joinable()) worker.join();
+        poll(app, fonts);
+    }
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker owns a deque: it pushes and pops
+// its own tasks at the back (newest, still hot in cache) while idle workers
+// steal from the front (oldest, and for parallelFor the largest ranges).
+// Tasks submitted from outside the pool go to a shared injection queue.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;  // One per worker, then the injection queue
+    std::vector<std::thread> threads;
+    std::atomic<int> queued{0};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false};
+
+    struct WorkerId {
+        const ThreadPool* pool = nullptr;
+        int index = -1;
+    };
+    static WorkerId& currentWorker() {
+        thread_local WorkerId id;
+        return id;
+    }
+
+    bool popBack(Queue& queue, Task& task) {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool popFront(Queue& queue, Task& task) {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    // self is the caller's worker index, or -1 for a thread outside the pool
+    bool findTask(int self, Task& task) {
+        if (queued.load(std::memory_order_acquire) == 0) return false;
+        int workers = (int)threads.size();
+        bool found = (self >= 0 && popBack(*queues[self], task)) || popFront(*queues[workers], task);
+        int start = self >= 0 ? self : 0;
+        for (int i = self >= 0 ? 1 : 0; !found && i < workers; i++) found = popFront(*queues[(start + i) % workers], task);
+        if (found) queued.fetch_sub(1, std::memory_order_relaxed);
+        return found;
+    }
+
+    void workerLoop(int self) {
+        currentWorker() = {this, self};
+        Task task;
+        for (;;) {
+            if (stopping.load(std::memory_order_acquire)) return;  // Before the queue: what is left there is dropped
+            if (findTask(self, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleepLock);
+            wake.wait(guard, [&]() { return stopping || queued.load(std::memory_order_acquire) > 0; });
+            if (stopping) return;
+        }
+    }
+
+public:
+    explicit ThreadPool(int threadCount = 0) {
+        if (threadCount <= 0) threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i <= threadCount; i++) queues.push_back(std::make_unique<Queue>());
+        for (int i = 0; i < threadCount; i++) threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    // Queued tasks that haven't started are dropped
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            stopping.store(true, std::memory_order_release);
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)threads.size(); }
+
+    void submit(Task task) {
+        const WorkerId& id = currentWorker();
+        Queue& queue = id.pool == this ? *queues[id.index] : *queues[threads.size()];
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        { std::lock_guard<std::mutex> guard(sleepLock); }
+        wake.notify_one();
+    }
+
+    // Run body(first, last) over [begin, end) in pieces of at most grain
+    // entries and call done() once after the last piece. Ranges are split in
+    // half on demand, so idle workers steal big chunks and split them further.
+    template <typename Body>
+    void parallelFor(size_t begin, size_t end, size_t grain, Body body, std::function<void()> done) {
+        struct Shared {
+            Body body;
+            std::function<void()> done;
+            std::atomic<size_t> remaining;
+            size_t grain;
+            Shared(Body b, std::function<void()> d, size_t count, size_t g)
+                : body(std::move(b)), done(std::move(d)), remaining(count), grain(g) {}
+        };
+        if (begin >= end) {
+            if (done) done();
+            return;
+        }
+        auto shared = std::make_shared<Shared>(std::move(body), std::move(done), end - begin, std::max<size_t>(1, grain));
+
+        struct Range {
+            static void run(ThreadPool* pool, std::shared_ptr<Shared> shared, size_t first, size_t last) {
+                while (last - first > shared->grain) {
+                    size_t mid = first + (last - first) / 2;
+                    pool->submit([pool, shared, mid, last]() { run(pool, shared, mid, last); });
+                    last = mid;
+                }
+                shared->body(first, last);
+                size_t count = last - first;
+                if (shared->remaining.fetch_sub(count, std::memory_order_acq_rel) == count && shared->done) shared->done();
+            }
+        };
+        submit([this, shared, begin, end]() { Range::run(this, shared, begin, end); });
+    }
+
+    // Blocking parallelFor. The caller runs queued tasks while it waits, so
+    // this is safe to call from inside a task, even on a one-thread pool.
+    template <typename Body>
+    void parallelForWait(size_t begin, size_t end, size_t grain, Body body) {
+        std::atomic<bool> finished{false};
+        parallelFor(begin, end, grain, std::move(body), [&finished]() { finished.store(true, std::memory_order_release); });
+
+        const WorkerId& id = currentWorker();
+        int self = id.pool == this ? id.index : -1;
+        Task task;
+        while (!finished.load(std::memory_order_acquire)) {
+            if (findTask(self, task)) {
+                task();
+                task = nullptr;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
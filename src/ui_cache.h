@@ -0,0 +1,77 @@
+#pragma once
+#include "raylib.h"
+#include "render_stats.h"
+
+// Measurements of constant strings, computed once and reused every frame.
+// Entries are keyed by the string literal's address, so only pass text with
+// static storage duration (never TextFormat() or c_str() results).
+class TextLayoutCache {
+private:
+    struct Entry {
+        const char* text;
+        unsigned int fontId;
+        float fontSize;
+        Vector2 size;
+    };
+
+    static constexpr int MAX_ENTRIES = 32;
+    Entry entries[MAX_ENTRIES];
+    int count = 0;
+
+public:
+    Vector2 measure(Font font, const char* text, float fontSize) {
+        for (int i = 0; i < count; i++) {
+            const Entry& e = entries[i];
+            if (e.text == text && e.fontId == font.texture.id && e.fontSize == fontSize) return e.size;
+        }
+
+        Vector2 size = MeasureTextEx(font, text, fontSize, 1.0f);
+        if (count < MAX_ENTRIES) entries[count++] = {text, font.texture.id, fontSize, size};
+        return size;
+    }
+
+    void clear() { count = 0; }
+};
+
+// Static UI chrome rendered once into a render texture and composited every
+// frame. The layer is rebuilt only when the window size or the view changes,
+// or when invalidate() is called (e.g. after a theme change).
+class StaticLayer {
+private:
+    RenderTexture2D target = {};
+    int width = 0;
+    int height = 0;
+    int viewKey = -1;
+
+public:
+    bool needsRebuild(int w, int h, int key) const {
+        return target.id == 0 || w != width || h != height || key != viewKey;
+    }
+
+    void beginRebuild(int w, int h, int key) {
+        if (target.id == 0 || w != width || h != height) {
+            if (target.id != 0) UnloadRenderTexture(target);
+            target = LoadRenderTexture(w, h);
+            SetTextureFilter(target.texture, TEXTURE_FILTER_POINT);
+            width = w;
+            height = h;
+        }
+        viewKey = key;
+        BeginTextureMode(target);
+    }
+
+    void endRebuild() { EndTextureMode(); }
+
+    void draw() const {
+        // Render textures are stored upside down in OpenGL, flip on the way out
+        DrawUiTexture(target.texture, {0.0f, 0.0f, (float)width, (float)-height}, {0.0f, 0.0f}, WHITE);
+    }
+
+    void invalidate() { viewKey = -1; }
+
+    void unload() {
+        if (target.id != 0) UnloadRenderTexture(target);
+        target = {};
+        viewKey = -1;
+    }
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include "raylib.h"
+#include "app_ui.h"
+#include "password_generator.h"
+
+// Deterministic UI input script, shared by bench/ui_bench.cpp and the
+// application's --script mode (the training run of PGO builds): hover and
+// scroll across rows, regenerate and rename entries in the library; drag the
+// slider and press SPACE in the generator.
+
+// Frames whose input doesn't mutate state (no clicks, SPACE or ENTER)
+inline bool IsSteadyState(const FrameInput& input) {
+    return !input.mousePressed && !input.keySpace && !input.keyEnter;
+}
+
+inline FrameInput ScriptedInput(int frame, bool library) {
+    FrameInput input;
+    if (library) {
+        int row = frame % 7;
+        input.mouse = {(frame / 7) % 2 ? 60.0f : 200.0f, 200.0f + row * 20.0f};
+        input.wheel = (frame % 120) < 60 ? -1.0f : 1.0f;
+
+        int phase = frame % 90;
+        if (phase == 10) {
+            input.mouse = {340.0f, 200.0f + row * 20.0f};  // GEN
+            input.mousePressed = true;
+        } else if (phase == 20) {
+            input.mouse = {60.0f, 200.0f};                  // Start editing the first visible row
+            input.mousePressed = true;
+        } else if (phase > 20 && phase < 24) {
+            input.chars[0] = 'a' + phase;
+            input.charCount = 1;
+        } else if (phase == 24) {
+            input.keyBackspace = true;
+        } else if (phase == 25) {
+            input.keyEnter = true;
+        }
+    } else {
+        input.mouse = {105.0f + (frame % 240), 73.0f};      // Sweep along the slider
+        input.mouseDown = true;
+        input.keySpace = (frame % 10) == 0;
+        input.keyC = (frame % 30) == 5;
+    }
+    return input;
+}
+
+// A library of generated entries that is never saved, nor copied to the clipboard
+inline void PrepareScriptedApp(AppState& app, int entries) {
+    app.persistLibrary = false;
+    app.useClipboard = false;
+
+    PasswordGenerator filler;
+    app.library.serviceNames.reserve(entries);
+    app.library.passwords.reserve(entries);
+    for (int i = 0; i < entries; i++) {
+        app.library.serviceNames.push_back(TextFormat("service-%06d", i));
+        app.library.passwords.push_back(filler.generate(16));
+    }
+}
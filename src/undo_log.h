@@ -0,0 +1,273 @@
+#pragma once
+#include "secure_memory.h"
+#include "vault.h"
+#include "vault_journal.h"
+#include "wire_format.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Undo and redo of library edits. Each command keeps what it takes to go
+// both ways, encoded like journal records: the entry an add or delete moved,
+// a replaced entry as the new version plus the old one as a delta of it. An
+// import keeps only its range while it is done, and the entries it removed
+// while it is undone. Undoing and redoing edit the vault and append the
+// matching journal records; the caller commits them like any other edit.
+//
+// Commands are kept in a ring bounded by count and by bytes; the oldest fall
+// off the end, so a long session never grows without limit.
+enum LibraryCommandKind : uint8_t {
+    COMMAND_ADD,      // data: the entry added at index
+    COMMAND_ERASE,    // data: the entry erased from index
+    COMMAND_REPLACE,  // data: the entry now at index, then the previous one as deltas
+    COMMAND_IMPORT    // Entries index to index + count; data: those entries while undone
+};
+
+struct LibraryCommand {
+    LibraryCommandKind kind = COMMAND_ADD;
+    uint32_t index = 0;
+    uint32_t count = 0;
+    std::vector<uint8_t> data;
+
+    LibraryCommand() = default;
+    LibraryCommand(LibraryCommand&&) = default;
+    LibraryCommand& operator=(LibraryCommand&& other) {
+        secureZero(data.data(), data.size());
+        kind = other.kind;
+        index = other.index;
+        count = other.count;
+        data = std::move(other.data);
+        return *this;
+    }
+    ~LibraryCommand() { secureZero(data.data(), data.size()); }
+
+    size_t memoryBytes() const { return sizeof(LibraryCommand) + data.capacity(); }
+};
+
+// Commands for edits that are about to happen, made from the vault before them
+inline LibraryCommand addCommand(size_t index, const std::string& serviceName, const std::string& password, int64_t modified) {
+    LibraryCommand command;
+    command.kind = COMMAND_ADD;
+    command.index = (uint32_t)index;
+    putEntry(command.data, serviceName, password, modified);
+    return command;
+}
+
+inline LibraryCommand eraseCommand(const Vault& vault, size_t index) {
+    LibraryCommand command;
+    command.kind = COMMAND_ERASE;
+    command.index = (uint32_t)index;
+    putEntry(command.data, vault.serviceNames[index], vault.passwords[index],
+             index < vault.modifiedAt.size() ? vault.modifiedAt[index] : 0);
+    return command;
+}
+
+inline LibraryCommand replaceCommand(const Vault& vault, size_t index, const std::string& serviceName,
+                                     const std::string& password, int64_t modified) {
+    LibraryCommand command;
+    command.kind = COMMAND_REPLACE;
+    command.index = (uint32_t)index;
+    putEntry(command.data, serviceName, password, modified);
+    putU64(command.data, (uint64_t)(index < vault.modifiedAt.size() ? vault.modifiedAt[index] : 0));
+    putDelta(command.data, serviceName, vault.serviceNames[index]);
+    putDelta(command.data, password, vault.passwords[index]);
+    return command;
+}
+
+inline LibraryCommand importCommand(size_t first, size_t count) {
+    LibraryCommand command;
+    command.kind = COMMAND_IMPORT;
+    command.index = (uint32_t)first;
+    command.count = (uint32_t)count;
+    return command;
+}
+
+class UndoLog {
+public:
+    static constexpr size_t DEFAULT_MAX_COMMANDS = 256;
+    static constexpr size_t DEFAULT_MAX_BYTES = 4 << 20;
+
+private:
+    std::vector<LibraryCommand> ring;
+    size_t first = 0;     // Oldest command
+    size_t done = 0;      // Commands that can be undone, from first
+    size_t redoable = 0;  // Undone commands after them
+    size_t bytes = 0;
+    size_t maxCommands = DEFAULT_MAX_COMMANDS;
+    size_t maxBytes = DEFAULT_MAX_BYTES;
+
+    LibraryCommand& at(size_t i) { return ring[(first + i) % ring.size()]; }
+
+    void dropOldest() {
+        bytes -= at(0).memoryBytes();
+        at(0) = LibraryCommand();
+        first = (first + 1) % ring.size();
+        done--;
+    }
+
+    void dropRedo() {
+        for (size_t i = done; i < done + redoable; i++) {
+            bytes -= at(i).memoryBytes();
+            at(i) = LibraryCommand();
+        }
+        redoable = 0;
+    }
+
+    // Version 0 of a command's entry: the one of ADD, ERASE, or the new one of
+    // REPLACE; version 1: the old one of REPLACE
+    static bool readEntry(const LibraryCommand& command, int version, std::string& name, std::string& password,
+                          int64_t& modified) {
+        const uint8_t* p = command.data.data();
+        const uint8_t* end = p + command.data.size();
+        if (!getEntry(p, end, modified, name, password)) return false;
+        if (version == 0) return true;
+        std::string newer = name, newerPassword = password;
+        bool ok = end - p >= 8;
+        if (ok) {
+            modified = (int64_t)getU64(p);
+            p += 8;
+            ok = getDelta(p, end, newer, name) && getDelta(p, end, newerPassword, password);
+        }
+        secureZero(&newerPassword[0], newerPassword.size());
+        return ok;
+    }
+
+    static bool setEntry(Vault& vault, VaultJournal* journal, size_t index, std::string& name, std::string& password,
+                         int64_t modified) {
+        if (index >= vault.size()) return false;
+        if (journal) journal->replace(index, name, password, modified);
+        vault.replace(index, std::move(name), std::move(password), modified);
+        return true;
+    }
+
+    static bool insertEntry(Vault& vault, VaultJournal* journal, size_t index, std::string& name, std::string& password,
+                            int64_t modified) {
+        if (index > vault.size()) return false;
+        if (journal) journal->insert(index, name, password, modified);
+        vault.insert(index, std::move(name), std::move(password), modified);
+        return true;
+    }
+
+    static bool eraseEntry(Vault& vault, VaultJournal* journal, size_t index) {
+        if (index >= vault.size()) return false;
+        if (journal) journal->erase(index);
+        secureZero(&vault.passwords[index][0], vault.passwords[index].size());
+        vault.erase(index);
+        return true;
+    }
+
+    // Apply a command forwards (redo) or backwards (undo)
+    bool apply(LibraryCommand& command, bool forward, Vault& vault, VaultJournal* journal) {
+        std::string name, password;
+        int64_t modified = 0;
+        bool ok = false;
+        switch (command.kind) {
+            case COMMAND_ADD:
+            case COMMAND_ERASE:
+                if ((command.kind == COMMAND_ADD) == forward) {
+                    ok = readEntry(command, 0, name, password, modified) &&
+                         insertEntry(vault, journal, command.index, name, password, modified);
+                } else {
+                    ok = eraseEntry(vault, journal, command.index);
+                }
+                break;
+            case COMMAND_REPLACE:
+                ok = readEntry(command, forward ? 0 : 1, name, password, modified) &&
+                     setEntry(vault, journal, command.index, name, password, modified);
+                break;
+            case COMMAND_IMPORT:
+                bytes -= command.memoryBytes();
+                if (forward && command.index == vault.size()) {
+                    // The entries come back from the command
+                    const uint8_t* p = command.data.data();
+                    const uint8_t* end = p + command.data.size();
+                    ok = true;
+                    while (ok && p < end) {
+                        ok = getEntry(p, end, modified, name, password);
+                        if (ok && journal) journal->add(name, password, modified);
+                        if (ok) vault.append(std::move(name), std::move(password), modified);
+                    }
+                    secureZero(command.data.data(), command.data.size());
+                    command.data = std::vector<uint8_t>();
+                } else if (!forward && command.index + (size_t)command.count == vault.size()) {
+                    // They move into the command, for redo
+                    for (size_t i = command.index; i < vault.size(); i++) {
+                        putEntry(command.data, vault.serviceNames[i], vault.passwords[i],
+                                 i < vault.modifiedAt.size() ? vault.modifiedAt[i] : 0);
+                        secureZero(&vault.passwords[i][0], vault.passwords[i].size());
+                    }
+                    if (journal) journal->truncate(command.index);
+                    vault.truncate(command.index);
+                    ok = true;
+                }
+                bytes += command.memoryBytes();
+                break;
+        }
+        secureZero(&password[0], password.size());
+        return ok;
+    }
+
+    void trim() {
+        while (done > 0 && (done + redoable > maxCommands || bytes > maxBytes)) dropOldest();
+        // A single undone import can be bigger than the budget; it stays undone but can't be redone
+        if (bytes > maxBytes) dropRedo();
+    }
+
+public:
+    UndoLog() { ring.resize(DEFAULT_MAX_COMMANDS + 1); }
+
+    void setLimits(size_t commands, size_t memory) {
+        clear();
+        maxCommands = commands > 0 ? commands : 1;
+        maxBytes = memory;
+        ring.resize(maxCommands + 1);
+    }
+
+    // Record an edit that was just made; anything undone before is lost
+    void push(LibraryCommand command) {
+        dropRedo();
+        bytes += command.memoryBytes();
+        at(done++) = std::move(command);
+        trim();
+    }
+
+    bool canUndo() const { return done > 0; }
+    bool canRedo() const { return redoable > 0; }
+    size_t memoryBytes() const { return bytes; }
+
+    // Take back the last edit. False if there is none, or the library no
+    // longer matches it (the command is dropped then).
+    bool undo(Vault& vault, VaultJournal* journal) {
+        if (done == 0) return false;
+        LibraryCommand& command = at(done - 1);
+        if (!apply(command, false, vault, journal)) {
+            dropRedo();
+            bytes -= command.memoryBytes();
+            command = LibraryCommand();
+            done--;
+            return false;
+        }
+        done--;
+        redoable++;
+        trim();
+        return true;
+    }
+
+    bool redo(Vault& vault, VaultJournal* journal) {
+        if (redoable == 0) return false;
+        LibraryCommand& command = at(done);
+        if (!apply(command, true, vault, journal)) {
+            dropRedo();
+            return false;
+        }
+        done++;
+        redoable--;
+        return true;
+    }
+
+    void clear() {
+        for (LibraryCommand& command : ring) command = LibraryCommand();
+        first = done = redoable = bytes = 0;
+    }
+};
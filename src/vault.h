@@ -0,0 +1,413 @@
+#pragma once
+#include "block_codec.h"
+#include "profiler.h"
+#include "secure_memory.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <string>
+#include <vector>
+
+// Encryption functions
+inline std::string encrypt(const std::string& data) {
+    std::string result = data;
+    for (size_t i = 0; i < result.length(); i++) {
+        result[i] ^= 0x7F;  // Simple XOR encryption
+    }
+    return result;
+}
+
+inline std::string decrypt(const std::string& data) {
+    return encrypt(data);  // XOR is symmetric, so encrypt = decrypt
+}
+
+// FNV-1a, identifies file contents (not a security measure)
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ULL) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ p[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+// fseek() and ftell() with 64-bit offsets; long is 32 bits on Windows, and
+// journals with entry history can grow past 2 GB
+inline bool seekFile(FILE* file, uint64_t offset, int origin = SEEK_SET) {
+#if defined(_WIN32)
+    return _fseeki64(file, (int64_t)offset, origin) == 0;
+#else
+    return fseeko(file, (off_t)offset, origin) == 0;
+#endif
+}
+
+// Position in the file, -1 on error
+inline int64_t tellFile(FILE* file) {
+#if defined(_WIN32)
+    return _ftelli64(file);
+#else
+    return (int64_t)ftello(file);
+#endif
+}
+
+// Password library: parallel lists of service names and their passwords
+struct Vault {
+    std::vector<std::string> serviceNames;
+    std::vector<std::string> passwords;
+    std::vector<int64_t> modifiedAt;  // Unix time of the last password change, 0 if unknown; may be shorter
+    uint64_t revision = 0;  // Bumped on every change, lets background work detect stale results
+    uint64_t fileFingerprint = 0;  // Contents of the vault file last loaded or saved, 0 if none
+
+    size_t size() const { return serviceNames.size(); }
+
+    void add(const std::string& serviceName, const std::string& password) {
+        serviceNames.push_back(serviceName);
+        passwords.push_back(password);
+        modifiedAt.resize(passwords.size() - 1, 0);
+        modifiedAt.push_back((int64_t)time(nullptr));
+    }
+
+    // Append without stamping the time, e.g. for imported or replayed entries
+    void append(std::string&& serviceName, std::string&& password, int64_t modified) {
+        serviceNames.push_back(std::move(serviceName));
+        passwords.push_back(std::move(password));
+        if (modified != 0) {
+            modifiedAt.resize(passwords.size() - 1, 0);
+            modifiedAt.push_back(modified);
+        }
+    }
+
+    // Drop entries past count, e.g. to roll back a failed import
+    void truncate(size_t count) {
+        serviceNames.resize(count);
+        passwords.resize(count);
+        if (modifiedAt.size() > count) modifiedAt.resize(count);
+    }
+
+    void setPassword(size_t index, const std::string& password) {
+        passwords[index] = password;
+        if (modifiedAt.size() <= index) modifiedAt.resize(index + 1, 0);
+        modifiedAt[index] = (int64_t)time(nullptr);
+    }
+
+    void erase(size_t index) {
+        serviceNames.erase(serviceNames.begin() + index);
+        passwords.erase(passwords.begin() + index);
+        if (index < modifiedAt.size()) modifiedAt.erase(modifiedAt.begin() + index);
+    }
+
+    // Put an entry back where it was, e.g. to undo erase()
+    void insert(size_t index, std::string&& serviceName, std::string&& password, int64_t modified) {
+        serviceNames.insert(serviceNames.begin() + index, std::move(serviceName));
+        passwords.insert(passwords.begin() + index, std::move(password));
+        if (modified != 0 || index < modifiedAt.size()) {
+            modifiedAt.resize(std::max(modifiedAt.size(), index), 0);
+            modifiedAt.insert(modifiedAt.begin() + index, modified);
+        }
+    }
+
+    // Overwrite an entry, time included
+    void replace(size_t index, std::string&& serviceName, std::string&& password, int64_t modified) {
+        serviceNames[index] = std::move(serviceName);
+        secureZero(&passwords[index][0], passwords[index].size());
+        passwords[index] = std::move(password);
+        if (modified != 0 || index < modifiedAt.size()) {
+            if (modifiedAt.size() <= index) modifiedAt.resize(index + 1, 0);
+            modifiedAt[index] = modified;
+        }
+    }
+};
+
+// Longest service name, in bytes, that imports and provisioning create and
+// the library's name editor holds
+const size_t MAX_SERVICE_NAME = 255;
+
+// Whether an entry fits the vault file's "name|password\n" lines
+inline bool vaultCanHold(const std::string& serviceName, const std::string& password) {
+    return serviceName.find_first_of("|\n") == std::string::npos && password.find('\n') == std::string::npos;
+}
+
+// Vault file, version 2. Entries are "name|password\n" lines as in the
+// original format, cut into segments of whole lines. Each segment is
+// compressed on its own and then encrypted, so saving and loading hold one
+// segment of file data at a time, and a damaged segment can't be misread.
+//
+// File:   "PGVAULT2", frames
+// Frame:  uint32 stored size, uint32 raw size, uint8 codec | flags, uint32
+//         checksum (FNV-1a of the stored bytes), stored bytes, encrypted
+// An optional first frame (VAULT_DICTIONARY) holds the dictionary the
+// segments were compressed with; the last (VAULT_END) the uint64 line count.
+// Files without the magic are in the original format, one encrypted text.
+enum VaultFrameFlags : uint8_t {
+    VAULT_CODEC_MASK = 0x0F,
+    VAULT_DICTIONARY = 0x40,
+    VAULT_END = 0x80
+};
+
+const size_t VAULT_SEGMENT_SIZE = 16 * 1024;
+const size_t VAULT_DICTIONARY_SIZE = 4 * 1024;
+const size_t VAULT_DICTIONARY_SAMPLE = 256 * 1024;  // Lines held back to train the dictionary on
+const size_t VAULT_FRAME_HEADER = 13;
+const size_t VAULT_MAX_FRAME = 16 << 20;
+
+struct VaultFileOptions {
+    BlockCodec codec = CODEC_LZ4;
+    int level = 0;  // zstd level, 0 for its default
+    bool dictionary = true;
+    size_t segmentSize = VAULT_SEGMENT_SIZE;
+};
+
+// Add the "name|password" lines in data up to its last line break; returns the bytes used
+inline size_t appendVaultLines(Vault& vault, const char* data, size_t size, uint64_t& lines) {
+    const char* p = data;
+    const char* end = data + size;
+    while (const char* lineEnd = (const char*)memchr(p, '\n', (size_t)(end - p))) {
+        if (const char* bar = (const char*)memchr(p, '|', (size_t)(lineEnd - p))) {
+            vault.serviceNames.emplace_back(p, (size_t)(bar - p));
+            vault.passwords.emplace_back(bar + 1, (size_t)(lineEnd - bar - 1));
+        }
+        lines++;
+        p = lineEnd + 1;
+    }
+    return (size_t)(p - data);
+}
+
+inline bool readVaultFrames(Vault& vault, FILE* in, uint64_t& hash) {
+    SegmentCodec codec;
+    std::vector<uint8_t> stored, raw;
+    uint64_t lines = 0;
+    bool ok = false;
+    for (bool first = true;; first = false) {
+        uint8_t header[VAULT_FRAME_HEADER];
+        if (fread(header, sizeof(header), 1, in) != 1) break;
+        uint32_t storedSize = 0, rawSize = 0, checksum = 0;
+        for (int i = 0; i < 4; i++) {
+            storedSize |= (uint32_t)header[i] << (i * 8);
+            rawSize |= (uint32_t)header[4 + i] << (i * 8);
+            checksum |= (uint32_t)header[9 + i] << (i * 8);
+        }
+        uint8_t flags = header[8];
+        if (storedSize > VAULT_MAX_FRAME || rawSize > VAULT_MAX_FRAME) break;
+        stored.resize(storedSize);
+        if (storedSize > 0 && fread(stored.data(), 1, storedSize, in) != storedSize) break;
+        hash = fnv1a64(header, sizeof(header), hash);
+        hash = fnv1a64(stored.data(), storedSize, hash);
+        if ((uint32_t)fnv1a64(stored.data(), storedSize) != checksum) break;
+
+        for (uint8_t& b : stored) b ^= 0x7F;
+        BlockCodec storedCodec = (BlockCodec)(flags & VAULT_CODEC_MASK);
+        raw.resize(rawSize);
+        if (!codecAvailable(storedCodec) || !codec.decompress(storedCodec, stored.data(), storedSize, raw.data(), rawSize)) break;
+        if (flags & VAULT_END) {
+            uint64_t count = 0;
+            for (int i = 0; i < 8 && rawSize == 8; i++) count |= (uint64_t)raw[i] << (i * 8);
+            ok = rawSize == 8 && count == lines;
+            break;
+        }
+        if (flags & VAULT_DICTIONARY) {
+            if (!first) break;
+            codec.setup(CODEC_NONE, 0, raw);
+        } else if (appendVaultLines(vault, (const char*)raw.data(), raw.size(), lines) != raw.size()) {
+            break;  // Segments hold whole lines
+        }
+    }
+    secureZero(stored.data(), stored.size());
+    secureZero(raw.data(), raw.size());
+    return ok;
+}
+
+inline bool readLegacyVault(Vault& vault, FILE* in, uint64_t& hash) {
+    std::vector<char> buffer(64 * 1024);
+    size_t carried = 0;  // Start of a line from the previous chunk
+    uint64_t lines = 0;
+    for (;;) {
+        if (buffer.size() - carried < 4096) buffer.resize(buffer.size() * 2);
+        size_t got = fread(buffer.data() + carried, 1, buffer.size() - carried, in);
+        hash = fnv1a64(buffer.data() + carried, got, hash);
+        for (size_t i = carried; i < carried + got; i++) buffer[i] ^= 0x7F;
+        size_t size = carried + got;
+        if (got == 0) {
+            if (size > 0) {
+                buffer.resize(size + 1);
+                buffer[size++] = '\n';  // Last line without a line break
+                appendVaultLines(vault, buffer.data(), size, lines);
+            }
+            break;
+        }
+        size_t used = appendVaultLines(vault, buffer.data(), size, lines);
+        carried = size - used;
+        memmove(buffer.data(), buffer.data() + used, carried);
+    }
+    secureZero(buffer.data(), buffer.size());
+    return !ferror(in);
+}
+
+// Load the library from the encrypted file; returns false if it doesn't
+// exist or can't be read, leaving the vault empty
+inline bool loadVault(Vault& vault, const char* path) {
+    PROFILE_ZONE("load");
+    FILE* in = fopen(path, "rb");
+    if (!in) return false;
+
+    vault.serviceNames.clear();
+    vault.passwords.clear();
+    vault.modifiedAt.clear();  // The file format has no timestamps
+    vault.revision++;
+    char magic[8];
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    bool ok;
+    if (fread(magic, 1, 8, in) == 8 && !memcmp(magic, "PGVAULT2", 8)) {
+        hash = fnv1a64(magic, 8, hash);
+        ok = readVaultFrames(vault, in, hash);
+    } else {
+        rewind(in);
+        ok = readLegacyVault(vault, in, hash);
+    }
+    fclose(in);
+    vault.fileFingerprint = ok ? hash : 0;
+    if (!ok) {
+        vault.serviceNames.clear();
+        vault.passwords.clear();
+    }
+    return ok;
+}
+
+// Writes a vault file segment by segment, so saving never holds a second
+// copy of the library. Goes to path.tmp and replaces the file in finish(),
+// so a failed save or restore leaves the old vault intact.
+class VaultFileWriter {
+private:
+    std::string path;
+    std::string tempPath;
+    FILE* out = nullptr;
+    VaultFileOptions options;
+    SegmentCodec codec;
+    bool started = false;        // Magic and dictionary written
+    bool ok = false;
+    std::vector<uint8_t> pending;  // Lines not written yet
+    std::vector<uint8_t> frame;
+    uint64_t lines = 0;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    void write(const void* data, size_t size) {
+        hash = fnv1a64(data, size, hash);
+        ok = ok && fwrite(data, 1, size, out) == size;
+    }
+
+    void writeFrame(uint8_t flags, const uint8_t* raw, size_t rawSize) {
+        frame.resize(VAULT_FRAME_HEADER + codec.bound(rawSize));
+        uint8_t* stored = frame.data() + VAULT_FRAME_HEADER;
+        size_t storedSize = rawSize;
+        if (flags) {
+            memcpy(stored, raw, rawSize);  // The dictionary and line count are stored as is
+        } else {
+            flags = codec.compress(raw, rawSize, stored, storedSize);
+        }
+        for (size_t i = 0; i < storedSize; i++) stored[i] ^= 0x7F;
+        uint32_t checksum = (uint32_t)fnv1a64(stored, storedSize);
+        for (int i = 0; i < 4; i++) {
+            frame[i] = (uint8_t)(storedSize >> (i * 8));
+            frame[4 + i] = (uint8_t)(rawSize >> (i * 8));
+            frame[9 + i] = (uint8_t)(checksum >> (i * 8));
+        }
+        frame[8] = flags;
+        write(frame.data(), VAULT_FRAME_HEADER + storedSize);
+    }
+
+    // Train the dictionary on the lines held back so far and write it
+    void start() {
+        write("PGVAULT2", 8);
+        std::vector<uint8_t> dictionary;
+        if (options.dictionary && options.codec != CODEC_NONE) {
+            dictionary = trainDictionary(pending.data(), pending.size(), VAULT_DICTIONARY_SIZE);
+        }
+        if (!dictionary.empty()) writeFrame(VAULT_DICTIONARY, dictionary.data(), dictionary.size());
+        codec.setup(options.codec, options.level, std::move(dictionary));
+        started = true;
+    }
+
+    // Write full segments of pending lines, and the rest too when final
+    void writeSegments(bool final) {
+        size_t begin = 0;
+        while (pending.size() - begin > options.segmentSize || (pending.size() - begin > 0 && final)) {
+            size_t cut = pending.size();
+            if (cut - begin > options.segmentSize) {
+                const uint8_t* from = pending.data() + begin + options.segmentSize - 1;
+                cut = (size_t)((const uint8_t*)memchr(from, '\n', pending.size() - (size_t)(from - pending.data())) - pending.data()) + 1;
+            }
+            writeFrame(0, pending.data() + begin, cut - begin);
+            begin = cut;
+        }
+        size_t rest = pending.size() - begin;
+        memmove(pending.data(), pending.data() + begin, rest);
+        secureZero(pending.data() + rest, begin);
+        pending.resize(rest);
+    }
+
+public:
+    ~VaultFileWriter() {
+        secureZero(pending.data(), pending.size());
+        if (out) {
+            fclose(out);
+            std::remove(tempPath.c_str());
+        }
+    }
+
+    bool open(const char* vaultPath, const VaultFileOptions& fileOptions = VaultFileOptions()) {
+        path = vaultPath;
+        tempPath = path + ".tmp";
+        options = fileOptions;
+        if (!codecAvailable(options.codec)) options.codec = CODEC_LZ4;
+        if (options.segmentSize == 0) options.segmentSize = VAULT_SEGMENT_SIZE;
+        pending.reserve(std::max(VAULT_DICTIONARY_SAMPLE, options.segmentSize) + 4096);
+        out = fopen(tempPath.c_str(), "wb");
+        ok = out != nullptr;
+        return ok;
+    }
+
+    // An entry the file can't hold fails the write: it would not load back
+    void add(const std::string& serviceName, const std::string& password) {
+        if (!vaultCanHold(serviceName, password)) ok = false;
+        if (!ok) return;
+        pending.insert(pending.end(), serviceName.begin(), serviceName.end());
+        pending.push_back('|');
+        pending.insert(pending.end(), password.begin(), password.end());
+        pending.push_back('\n');
+        lines++;
+        if (!started && pending.size() >= VAULT_DICTIONARY_SAMPLE) start();
+        if (started && pending.size() > options.segmentSize) writeSegments(false);
+    }
+
+    bool finish() {
+        if (!started) start();
+        writeSegments(true);
+        uint8_t count[8];
+        for (int i = 0; i < 8; i++) count[i] = (uint8_t)(lines >> (i * 8));
+        writeFrame(VAULT_END, count, sizeof(count));
+        ok = fclose(out) == 0 && ok;
+        out = nullptr;
+        std::error_code error;
+        if (ok) std::filesystem::rename(tempPath, path, error);
+        if (!ok || error) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Same value loadVault() computes for the finished file
+    uint64_t fingerprint() const { return hash; }
+};
+
+// Save the library to the encrypted file; false if it couldn't be written
+inline bool saveVault(Vault& vault, const char* path, const VaultFileOptions& options = VaultFileOptions()) {
+    PROFILE_ZONE("save");
+    VaultFileWriter writer;
+    if (!writer.open(path, options)) return false;
+    for (size_t j = 0; j < vault.serviceNames.size(); j++) writer.add(vault.serviceNames[j], vault.passwords[j]);
+    if (!writer.finish()) return false;
+    vault.fileFingerprint = writer.fingerprint();
+    return true;
+}
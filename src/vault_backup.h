@@ -0,0 +1,224 @@
+#pragma once
+#include "lz4_block.h"
+#include "profiler.h"
+#include "secure_memory.h"
+#include "vault.h"
+#include "vault_journal.h"
+#include "wire_format.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming backups. Entries are packed into chunks of about
+// BACKUP_CHUNK_SIZE bytes, each optionally LZ4-compressed, then encrypted
+// with the vault cipher and written as one frame, so memory use is one chunk
+// whatever the size of the library, and the output can be a pipe.
+//
+// Stream:  "PGBAK1\0\0", frames, end frame
+// Frame:   uint32 stored size, uint32 raw size, uint8 flags, uint32 checksum
+//          (FNV-1a of the stored bytes), stored bytes. Raw bytes are whole
+//          entries in wire format (int64 modifiedAt, name, password).
+// End:     flags BACKUP_END, raw bytes are the uint64 entry count, so a cut
+//          off backup is detected instead of silently restoring a prefix.
+enum BackupFrameFlags : uint8_t {
+    BACKUP_LZ4 = 1,
+    BACKUP_END = 2
+};
+
+const size_t BACKUP_CHUNK_SIZE = 64 * 1024;
+const size_t BACKUP_FRAME_HEADER = 13;
+const size_t BACKUP_MAX_FRAME = 16 << 20;
+
+class BackupWriter {
+private:
+    FILE* out = nullptr;
+    bool compressed = false;
+    bool ok = false;
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> frame;
+    Lz4Block lz4;
+    uint64_t entries = 0;
+    uint64_t written = 0;
+
+    bool writeFrame(uint8_t flags) {
+        frame.resize(BACKUP_FRAME_HEADER + Lz4Block::bound(raw.size()));
+        uint8_t* stored = frame.data() + BACKUP_FRAME_HEADER;
+        size_t storedSize = raw.size();
+        if (compressed && !(flags & BACKUP_END)) storedSize = lz4.compress(raw.data(), raw.size(), stored);
+        if (storedSize < raw.size()) {
+            flags |= BACKUP_LZ4;
+        } else {
+            memcpy(stored, raw.data(), raw.size());  // Stored as is when it doesn't shrink
+            storedSize = raw.size();
+        }
+        for (size_t i = 0; i < storedSize; i++) stored[i] ^= 0x7F;
+
+        uint32_t checksum = (uint32_t)fnv1a64(stored, storedSize);
+        uint32_t header[3] = {(uint32_t)storedSize, (uint32_t)raw.size(), checksum};
+        for (int i = 0; i < 4; i++) {
+            frame[i] = (uint8_t)(header[0] >> (i * 8));
+            frame[4 + i] = (uint8_t)(header[1] >> (i * 8));
+            frame[9 + i] = (uint8_t)(header[2] >> (i * 8));
+        }
+        frame[8] = flags;
+        size_t size = BACKUP_FRAME_HEADER + storedSize;
+        ok = ok && fwrite(frame.data(), 1, size, out) == size;
+        written += size;
+        secureZero(raw.data(), raw.size());
+        raw.clear();
+        return ok;
+    }
+
+public:
+    ~BackupWriter() { secureZero(raw.data(), raw.size()); }
+
+    bool begin(FILE* output, bool compress) {
+        out = output;
+        compressed = compress;
+        entries = 0;
+        raw.reserve(BACKUP_CHUNK_SIZE + 1024);
+        ok = fwrite("PGBAK1\0\0", 8, 1, out) == 1;
+        written = 8;
+        return ok;
+    }
+
+    bool add(std::string_view serviceName, std::string_view password, int64_t modified) {
+        putEntry(raw, serviceName, password, modified);
+        entries++;
+        return raw.size() < BACKUP_CHUNK_SIZE || writeFrame(0);
+    }
+
+    bool finish() {
+        if (!raw.empty()) writeFrame(0);
+        putU64(raw, entries);
+        writeFrame(BACKUP_END);
+        return ok && fflush(out) == 0;
+    }
+
+    uint64_t entryCount() const { return entries; }
+    uint64_t bytesWritten() const { return written; }
+};
+
+// Reads a backup stream frame by frame. onEntry(name, password, modifiedAt)
+// is called for every entry; it may move from the strings.
+class BackupReader {
+private:
+    std::vector<uint8_t> stored;
+    std::vector<uint8_t> raw;
+    const char* failure = "";
+
+    bool fail(const char* message) {
+        failure = message;
+        return false;
+    }
+
+public:
+    ~BackupReader() {
+        secureZero(stored.data(), stored.size());
+        secureZero(raw.data(), raw.size());
+    }
+
+    const char* error() const { return failure; }
+
+    template <typename OnEntry>
+    bool read(FILE* in, OnEntry onEntry) {
+        char magic[8];
+        if (fread(magic, 8, 1, in) != 1 || memcmp(magic, "PGBAK1\0\0", 8) != 0) return fail("not a passgen backup");
+
+        uint64_t entries = 0;
+        std::string name, password;
+        for (;;) {
+            uint8_t header[BACKUP_FRAME_HEADER];
+            if (fread(header, sizeof(header), 1, in) != 1) return fail("backup is truncated");
+            uint32_t storedSize = getU32(header), rawSize = getU32(header + 4);
+            uint8_t flags = header[8];
+            if (storedSize > BACKUP_MAX_FRAME || rawSize > BACKUP_MAX_FRAME) return fail("backup is corrupt");
+            stored.resize(storedSize);
+            if (storedSize > 0 && fread(stored.data(), 1, storedSize, in) != storedSize) return fail("backup is truncated");
+            if ((uint32_t)fnv1a64(stored.data(), storedSize) != getU32(header + 9)) return fail("backup is corrupt");
+
+            for (uint8_t& b : stored) b ^= 0x7F;
+            if (flags & BACKUP_LZ4) {
+                raw.resize(rawSize);
+                if (!Lz4Block::decompress(stored.data(), storedSize, raw.data(), rawSize)) return fail("backup is corrupt");
+            } else {
+                if (storedSize != rawSize) return fail("backup is corrupt");
+                raw.swap(stored);
+            }
+
+            if (flags & BACKUP_END) {
+                if (rawSize != 8 || getU64(raw.data()) != entries) return fail("backup is incomplete");
+                break;
+            }
+            const uint8_t* p = raw.data();
+            const uint8_t* end = p + raw.size();
+            while (p < end) {
+                int64_t modified;
+                if (!getEntry(p, end, modified, name, password)) return fail("backup is corrupt");
+                entries++;
+                onEntry(name, password, modified);
+            }
+            secureZero(&password[0], password.size());
+        }
+        return true;
+    }
+};
+
+// Write every entry of the vault as a backup stream
+inline bool exportVault(const Vault& vault, FILE* out, bool compress) {
+    PROFILE_ZONE("export");
+    BackupWriter writer;
+    bool ok = writer.begin(out, compress);
+    for (size_t i = 0; i < vault.size() && ok; i++) {
+        ok = writer.add(vault.serviceNames[i], vault.passwords[i], i < vault.modifiedAt.size() ? vault.modifiedAt[i] : 0);
+    }
+    return ok && writer.finish();
+}
+
+struct RestoreResult {
+    bool ok = false;
+    uint64_t restored = 0;
+    uint64_t skipped = 0;  // Entries the vault file can't hold ('|' in the name, a line break anywhere)
+    const char* error = "";
+};
+
+// Replace the vault file with the entries of a backup stream, chunk by chunk,
+// without loading either into memory. The vault file has no timestamps, so
+// they are dropped. The journal then starts afresh for the new file (see
+// VaultJournal::restart()): its edits belonged to the old one, its history
+// is kept. Hold the vault's lock.
+inline RestoreResult restoreBackup(FILE* in, const char* vaultPath) {
+    PROFILE_ZONE("restore");
+    RestoreResult result;
+    VaultFileWriter writer;
+    if (!writer.open(vaultPath)) {
+        result.error = "cannot write the vault file";
+        return result;
+    }
+    BackupReader reader;
+    bool ok = reader.read(in, [&](const std::string& name, const std::string& password, int64_t) {
+        if (name.find_first_of("|\r\n") != std::string::npos || password.find_first_of("\r\n") != std::string::npos) {
+            result.skipped++;
+            return;
+        }
+        writer.add(name, password);
+        result.restored++;
+    });
+    if (!ok) {
+        result.error = reader.error();
+        return result;  // writer's destructor drops the temp file
+    }
+    if (!writer.finish()) {
+        result.error = "cannot write the vault file";
+        return result;
+    }
+    if (!VaultJournal::restart(journalPathFor(vaultPath).c_str(), writer.fingerprint())) {
+        result.error = "cannot start the journal afresh";
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,538 @@
+#pragma once
+#include "profiler.h"
+#include "secure_memory.h"
+#include "vault.h"
+#include "vault_journal.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PASSGEN_IMPORT_SSE2 1
+    #include <emmintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+// Streaming importers for exports of other password managers:
+//   CSV  - Bitwarden, Chrome/Edge, Firefox, KeePass/KeePassXC (columns found by header name)
+//   JSON - Bitwarden ({"items": [{"name", "login": {"password"}}]}) or a plain array of
+//          {"name"|"title", "password"} objects
+// Files are read in IMPORT_CHUNK_SIZE pieces, so memory stays bounded by one
+// chunk plus the record being parsed, whatever the size of the export.
+enum ImportFormat {
+    IMPORT_AUTO = 0,  // By extension, then by the first character
+    IMPORT_CSV,
+    IMPORT_JSON
+};
+
+struct ImportResult {
+    bool ok = false;
+    size_t imported = 0;
+    size_t skipped = 0;       // Rows without a password, or with a line break in it
+    size_t shortened = 0;     // Names cut to MAX_SERVICE_NAME bytes
+    uint64_t bytes = 0;       // Input read
+    const char* error = "";
+};
+
+const size_t IMPORT_CHUNK_SIZE = 64 * 1024;
+const size_t IMPORT_BATCH_SIZE = 4096;
+
+// First byte in [p, end) equal to a, b or c, or end. Scalar version.
+inline const char* findAnyOfScalar(const char* p, const char* end, char a, char b, char c) {
+    while (p < end && *p != a && *p != b && *p != c) p++;
+    return p;
+}
+
+// Same, 16 bytes per step with SSE2 where available. Most of a CSV file is
+// plain field text, so this is where a parser spends its time.
+inline const char* findAnyOf(const char* p, const char* end, char a, char b, char c) {
+#if defined(PASSGEN_IMPORT_SSE2)
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c);
+    for (; end - p >= 16; p += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, va), _mm_cmpeq_epi8(bytes, vb)), _mm_cmpeq_epi8(bytes, vc));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask != 0) {
+    #if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return p + index;
+    #else
+            return p + __builtin_ctz(mask);
+    #endif
+        }
+    }
+#endif
+    return findAnyOfScalar(p, end, a, b, c);
+}
+
+inline void wipeString(std::string& s) {
+    secureZero(&s[0], s.size());
+    s.clear();
+}
+
+// Streaming RFC 4180 parser. feed() accepts the input in arbitrary pieces
+// and calls onRecord(fields, count) for every record. Quoted fields may
+// contain separators, line breaks and "" escapes; LF and CRLF both end a
+// record. Columns not marked by keepColumn() after the first record are
+// skipped without being copied.
+class CsvParser {
+private:
+    enum State { FIELD_START, UNQUOTED, QUOTED, QUOTE_SEEN };
+    State state = FIELD_START;
+    bool skipLineFeed = false;  // Just ended a record on CR
+    bool blankRecord = true;    // Nothing but the line break so far
+    std::vector<std::string> fields;
+    size_t fieldCount = 0;
+    std::vector<bool> kept;     // Empty: keep every column
+    bool capturing = true;
+
+    void beginField() {
+        if (fields.size() <= fieldCount) fields.emplace_back();
+        capturing = kept.empty() || (fieldCount < kept.size() && kept[fieldCount]);
+        wipeString(fields[fieldCount]);
+    }
+
+    void appendField(const char* p, const char* end) {
+        if (p != end) blankRecord = false;
+        if (capturing) fields[fieldCount].append(p, end - p);
+    }
+
+    template <typename OnRecord>
+    void endRecord(OnRecord& onRecord) {
+        fieldCount++;
+        if (!blankRecord) onRecord(fields.data(), fieldCount);
+        fieldCount = 0;
+        blankRecord = true;
+    }
+
+public:
+    ~CsvParser() {
+        for (std::string& field : fields) wipeString(field);
+    }
+
+    void keepColumn(size_t column) {
+        if (kept.size() <= column) kept.resize(column + 1, false);
+        kept[column] = true;
+    }
+
+    template <typename OnRecord>
+    void feed(const char* p, size_t size, OnRecord& onRecord) {
+        const char* end = p + size;
+        while (p < end) {
+            switch (state) {
+                case FIELD_START:
+                    if (skipLineFeed) {
+                        skipLineFeed = false;
+                        if (*p == '\n') {
+                            p++;
+                            break;
+                        }
+                    }
+                    beginField();
+                    if (*p == '"') {
+                        p++;
+                        state = QUOTED;
+                        blankRecord = false;
+                        break;
+                    }
+                    state = UNQUOTED;
+                    break;
+                case UNQUOTED: {
+                    const char* stop = findAnyOf(p, end, ',', '\n', '\r');
+                    appendField(p, stop);
+                    p = stop;
+                    if (p == end) break;
+                    char c = *p++;
+                    state = FIELD_START;
+                    if (c == ',') {
+                        fieldCount++;
+                        blankRecord = false;
+                    } else {
+                        endRecord(onRecord);
+                        skipLineFeed = c == '\r';
+                    }
+                    break;
+                }
+                case QUOTED: {
+                    const char* stop = findAnyOf(p, end, '"', '"', '"');
+                    appendField(p, stop);
+                    p = stop;
+                    if (p == end) break;
+                    p++;
+                    state = QUOTE_SEEN;
+                    break;
+                }
+                case QUOTE_SEEN:
+                    if (*p == '"') {
+                        appendField(p, p + 1);
+                        p++;
+                        state = QUOTED;
+                    } else {
+                        state = UNQUOTED;  // Closing quote; anything up to the separator is kept as is
+                    }
+                    break;
+            }
+        }
+    }
+
+    // End of input; false if it stopped inside a quoted field
+    template <typename OnRecord>
+    bool finish(OnRecord& onRecord) {
+        if (state == QUOTED) return false;
+        if (state != FIELD_START || fieldCount > 0) endRecord(onRecord);
+        state = FIELD_START;
+        return true;
+    }
+};
+
+// Streaming JSON reader that only keeps what an entry needs. Objects in the
+// top-level array or in an "items" array are entries; their "name"/"title"
+// and "password" (directly or inside "login") are captured, every other
+// string is skipped without being copied.
+class JsonEntryParser {
+private:
+    enum Role : uint8_t { ROLE_OTHER, ROLE_ITEMS, ROLE_ENTRY, ROLE_LOGIN };
+    enum Field : uint8_t { FIELD_NONE, FIELD_KEY, FIELD_NAME, FIELD_PASSWORD };
+    enum State : uint8_t { STRUCTURE, STRING, ESCAPE, UNICODE, LITERAL };
+
+    struct Frame {
+        bool object;
+        Role role;
+        bool expectKey;
+        std::string key;
+    };
+    static constexpr size_t MAX_DEPTH = 64;
+
+    std::vector<Frame> stack;
+    size_t depth = 0;           // Frames in use; the vector keeps their key buffers
+    State state = STRUCTURE;
+    Field field = FIELD_NONE;   // Where the current string goes
+    std::string text;           // Current captured string
+    uint32_t unicode = 0;
+    int unicodeDigits = 0;
+    uint32_t highSurrogate = 0;
+    std::string entryName, entryPassword;
+    bool complete = false;      // The top-level array or object was closed
+    bool failed = false;
+
+    Frame* top() { return depth > 0 ? &stack[depth - 1] : nullptr; }
+
+    void appendUtf8(uint32_t cp) {
+        if (field == FIELD_NONE) return;
+        if (cp < 0x80) {
+            text += (char)cp;
+        } else if (cp < 0x800) {
+            text += (char)(0xC0 | cp >> 6);
+            text += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            text += (char)(0xE0 | cp >> 12);
+            text += (char)(0x80 | (cp >> 6 & 0x3F));
+            text += (char)(0x80 | (cp & 0x3F));
+        } else {
+            text += (char)(0xF0 | cp >> 18);
+            text += (char)(0x80 | (cp >> 12 & 0x3F));
+            text += (char)(0x80 | (cp >> 6 & 0x3F));
+            text += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    void beginString() {
+        Frame* frame = top();
+        field = FIELD_NONE;
+        if (frame && frame->object && frame->expectKey) field = FIELD_KEY;
+        else if (frame && frame->role == ROLE_ENTRY && (frame->key == "name" || frame->key == "title")) field = FIELD_NAME;
+        else if (frame && (frame->role == ROLE_ENTRY || frame->role == ROLE_LOGIN) && frame->key == "password") field = FIELD_PASSWORD;
+        wipeString(text);
+        state = STRING;
+    }
+
+    void endString() {
+        if (field == FIELD_KEY) top()->key.swap(text);
+        else if (field == FIELD_NAME) entryName.swap(text);
+        else if (field == FIELD_PASSWORD) entryPassword.swap(text);
+        wipeString(text);
+        state = STRUCTURE;
+    }
+
+    void open(bool object) {
+        Frame* parent = top();
+        Role role = ROLE_OTHER;
+        if (!object && (!parent || (parent->object && parent->key == "items"))) role = ROLE_ITEMS;
+        else if (object && parent && parent->role == ROLE_ITEMS) role = ROLE_ENTRY;
+        else if (object && parent && parent->role == ROLE_ENTRY && parent->key == "login") role = ROLE_LOGIN;
+        if (depth == MAX_DEPTH) {
+            failed = true;
+            return;
+        }
+        if (stack.size() <= depth) stack.emplace_back();
+        Frame& frame = stack[depth++];
+        frame.object = object;
+        frame.role = role;
+        frame.expectKey = object;
+        frame.key.clear();
+        if (role == ROLE_ENTRY) {
+            wipeString(entryName);
+            wipeString(entryPassword);
+        }
+    }
+
+    template <typename OnEntry>
+    void close(bool object, OnEntry& onEntry) {
+        Frame* frame = top();
+        if (!frame || frame->object != object) {
+            failed = true;
+            return;
+        }
+        depth--;
+        complete = depth == 0;
+        if (frame->role == ROLE_ENTRY) onEntry(entryName, entryPassword);
+    }
+
+public:
+    ~JsonEntryParser() {
+        wipeString(text);
+        wipeString(entryName);
+        wipeString(entryPassword);
+    }
+
+    template <typename OnEntry>
+    bool feed(const char* p, size_t size, OnEntry& onEntry) {
+        const char* end = p + size;
+        while (p < end && !failed) {
+            switch (state) {
+                case STRUCTURE: {
+                    char c = *p++;
+                    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') break;
+                    if (complete) failed = true;  // Anything after the top-level value
+                    else if (c == '"') beginString();
+                    else if (c == '{' || c == '[') open(c == '{');
+                    else if (c == '}' || c == ']') close(c == '}', onEntry);
+                    else if (c == ':') { if (top()) top()->expectKey = false; }
+                    else if (c == ',') { if (top() && top()->object) top()->expectKey = true; }
+                    else if (top() && (c == '-' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z'))) state = LITERAL;
+                    else failed = true;
+                    break;
+                }
+                case LITERAL:
+                    // Numbers, true, false and null are never needed
+                    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') p++;
+                    if (p < end) state = STRUCTURE;
+                    break;
+                case STRING: {
+                    const char* stop = findAnyOf(p, end, '"', '\\', '"');
+                    if (field != FIELD_NONE) text.append(p, stop - p);
+                    p = stop;
+                    if (p == end) break;
+                    if (*p++ == '"') endString();
+                    else state = ESCAPE;
+                    break;
+                }
+                case ESCAPE: {
+                    char c = *p++;
+                    const char* from = "\"\\/bfnrt";
+                    const char* to = "\"\\/\b\f\n\r\t";
+                    const char* hit = strchr(from, c);
+                    if (c == 'u') {
+                        unicode = 0;
+                        unicodeDigits = 0;
+                        state = UNICODE;
+                    } else if (c != '\0' && hit) {
+                        appendUtf8((uint8_t)to[hit - from]);
+                        state = STRING;
+                    } else {
+                        failed = true;
+                    }
+                    break;
+                }
+                case UNICODE: {
+                    char c = *p++;
+                    int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+                    if (digit < 0) {
+                        failed = true;
+                        break;
+                    }
+                    unicode = unicode << 4 | (uint32_t)digit;
+                    if (++unicodeDigits < 4) break;
+                    if (unicode >= 0xD800 && unicode < 0xDC00) {
+                        highSurrogate = unicode;
+                    } else if (unicode >= 0xDC00 && unicode < 0xE000 && highSurrogate) {
+                        appendUtf8(0x10000 + ((highSurrogate - 0xD800) << 10) + (unicode - 0xDC00));
+                        highSurrogate = 0;
+                    } else {
+                        appendUtf8(unicode);
+                        highSurrogate = 0;
+                    }
+                    state = STRING;
+                    break;
+                }
+            }
+        }
+        return !failed;
+    }
+
+    // End of input; false unless exactly one complete value was read
+    bool finish() const { return !failed && complete && state != STRING && state != ESCAPE && state != UNICODE; }
+};
+
+// Parse an export, calling onEntry(name, password) for every entry with a
+// password. Entry strings may be moved from.
+template <typename OnEntry>
+bool parseExport(FILE* in, ImportFormat format, OnEntry onEntry, ImportResult& result) {
+    std::vector<char> chunk(IMPORT_CHUNK_SIZE);
+    size_t got = fread(chunk.data(), 1, chunk.size(), in);
+    const char* start = chunk.data();
+    if (got >= 3 && memcmp(start, "\xEF\xBB\xBF", 3) == 0) {
+        start += 3;  // UTF-8 byte order mark
+        got -= 3;
+    }
+    if (format == IMPORT_AUTO) {
+        const char* first = start;
+        while (first < start + got && (*first == ' ' || *first == '\t' || *first == '\r' || *first == '\n')) first++;
+        format = first < start + got && (*first == '{' || *first == '[') ? IMPORT_JSON : IMPORT_CSV;
+    }
+
+    bool ok = true;
+    if (format == IMPORT_JSON) {
+        JsonEntryParser parser;
+        auto entry = [&](std::string& name, std::string& password) {
+            if (password.empty()) result.skipped++;
+            else onEntry(name, password);
+        };
+        while (got > 0 && ok) {
+            result.bytes += got;
+            ok = parser.feed(start, got, entry);
+            start = chunk.data();
+            got = fread(chunk.data(), 1, chunk.size(), in);
+        }
+        if (!ok || !parser.finish()) {
+            result.error = "malformed JSON";
+            ok = false;
+        }
+    } else {
+        // Columns are found by header name; the URL stands in for a missing name
+        CsvParser parser;
+        size_t nameColumn = SIZE_MAX, passwordColumn = SIZE_MAX, urlColumn = SIZE_MAX;
+        bool header = true;
+        auto record = [&](std::string* fields, size_t count) {
+            if (header) {
+                header = false;
+                for (size_t i = 0; i < count; i++) {
+                    std::string column = fields[i];
+                    for (char& c : column) c = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+                    if (nameColumn == SIZE_MAX && (column == "name" || column == "title" || column == "service")) nameColumn = i;
+                    if (passwordColumn == SIZE_MAX && (column == "password" || column == "login_password")) passwordColumn = i;
+                    if (urlColumn == SIZE_MAX && (column == "url" || column == "login_uri" || column == "uri")) urlColumn = i;
+                }
+                if (nameColumn != SIZE_MAX) parser.keepColumn(nameColumn);
+                if (passwordColumn != SIZE_MAX) parser.keepColumn(passwordColumn);
+                if (urlColumn != SIZE_MAX) parser.keepColumn(urlColumn);
+                return;
+            }
+            if (passwordColumn >= count || fields[passwordColumn].empty()) {
+                result.skipped++;
+                return;
+            }
+            std::string none;
+            std::string* name = &none;
+            if (nameColumn < count && !fields[nameColumn].empty()) name = &fields[nameColumn];
+            else if (urlColumn < count) name = &fields[urlColumn];
+            onEntry(*name, fields[passwordColumn]);
+        };
+        while (got > 0) {
+            result.bytes += got;
+            parser.feed(start, got, record);
+            if (!header && passwordColumn == SIZE_MAX) break;
+            start = chunk.data();
+            got = fread(chunk.data(), 1, chunk.size(), in);
+        }
+        if (!header && passwordColumn == SIZE_MAX) {
+            result.error = "no password column in the CSV header";
+            ok = false;
+        } else if (!parser.finish(record)) {
+            result.error = "unterminated quoted field";
+            ok = false;
+        }
+    }
+    if (ferror(in)) {
+        result.error = "read error";
+        ok = false;
+    }
+    secureZero(chunk.data(), chunk.size());
+    return ok;
+}
+
+// Import an export of another password manager into the vault. Entries are
+// appended in batches of IMPORT_BATCH_SIZE and, when a journal is given,
+// written to it as one commit: either every entry is imported or none is.
+inline ImportResult importVault(Vault& vault, VaultJournal* journal, const char* path, ImportFormat format = IMPORT_AUTO) {
+    PROFILE_ZONE("import");
+    ImportResult result;
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        result.error = "cannot open the file";
+        return result;
+    }
+    if (format == IMPORT_AUTO) {
+        size_t length = strlen(path);
+        if (length >= 5 && strcmp(path + length - 5, ".json") == 0) format = IMPORT_JSON;
+        else if (length >= 4 && strcmp(path + length - 4, ".csv") == 0) format = IMPORT_CSV;
+    }
+
+    size_t before = vault.size();
+    bool journalOk = true;
+    std::vector<std::pair<std::string, std::string>> batch;
+    batch.reserve(IMPORT_BATCH_SIZE);
+    auto flush = [&]() {
+        // Grow geometrically; reserving just enough per batch would copy the vault every batch
+        size_t needed = vault.size() + batch.size();
+        if (vault.passwords.capacity() < needed) {
+            vault.serviceNames.reserve(needed * 2);
+            vault.passwords.reserve(needed * 2);
+        }
+        for (std::pair<std::string, std::string>& entry : batch) {
+            if (journal) journalOk = journalOk && journal->add(entry.first, entry.second, 0);
+            vault.append(std::move(entry.first), std::move(entry.second), 0);
+        }
+        result.imported += batch.size();
+        batch.clear();
+    };
+
+    // The vault file is line based with '|' after the name: names lose both,
+    // passwords with a line break can't be stored. Long names are cut.
+    bool parsed = parseExport(in, format, [&](std::string& name, std::string& password) {
+        if (password.find_first_of("\r\n") != std::string::npos) {
+            result.skipped++;
+            return;
+        }
+        for (char& c : name) c = c == '|' ? '/' : (c == '\r' || c == '\n') ? ' ' : c;
+        if (name.size() > MAX_SERVICE_NAME) {
+            size_t cut = MAX_SERVICE_NAME;
+            while (cut > 0 && ((uint8_t)name[cut] & 0xC0) == 0x80) cut--;  // Not inside a UTF-8 sequence
+            name.resize(cut);
+            result.shortened++;
+        }
+        batch.emplace_back(name.empty() ? std::string("imported") : std::move(name), std::move(password));
+        if (batch.size() == IMPORT_BATCH_SIZE) flush();
+    }, result);
+    fclose(in);
+    if (parsed) flush();
+
+    result.ok = parsed && journalOk && (!journal || journal->commit());
+    if (!result.ok) {
+        if (parsed) result.error = "cannot write the journal";
+        for (std::pair<std::string, std::string>& entry : batch) wipeString(entry.second);
+        vault.truncate(before);
+        if (journal) journal->rollback();
+        result.imported = 0;
+        return result;
+    }
+    if (result.imported > 0) vault.revision++;
+    return result;
+}
@@ -0,0 +1,782 @@
+#pragma once
+#include "profiler.h"
+#include "secure_memory.h"
+#include "vault.h"
+#include "wire_format.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+// Append-only log of library changes, kept next to the vault file. saveVault()
+// rewrites the whole file; the journal lets changes, from one edit to a big
+// import, be appended instead. Records only take effect once a COMMIT record
+// follows them, so a batch is applied completely or not at all, even if the
+// process dies while writing it. Edits address entries by index and are
+// replayed in order on top of the vault file.
+//
+// The journal belongs to one version of the vault file, identified by its
+// fingerprint. Once the vault is rewritten, a journal carrying the old
+// fingerprint is stale and its edits are ignored, so compaction needs no
+// second atomic step.
+//
+// HISTORY records keep earlier versions of entries. Each is keyed by a hash
+// of the version that replaced it, so it stays valid whatever the vault file
+// looks like and survives compaction: reset() carries over the records still
+// reachable from a live entry, up to historyLimit() versions deep. They are
+// only indexed at open (key and position); payloads are read and decrypted
+// when asked for.
+//
+// Several processes may share a journal (the GUI and passgen_cli, say). A
+// writer holds the vault's lock (see vault_sync.h) from before its first
+// record to its commit, and first takes in what the others committed with
+// catchUp(); readers merge() the new batches as they appear. Every fresh
+// start of the journal (compaction) increases the generation in its header,
+// which tells a process that its copy of the library is out of date.
+//
+// File:   "PGJRNL2\0", uint64 vault fingerprint, uint64 generation, records
+// Record: uint32 payload size, uint32 checksum (FNV-1a of type and payload
+//         as stored), uint8 type, payload XOR-encrypted like the vault file
+enum JournalRecordType : uint8_t {
+    JOURNAL_ADD = 1,      // int64 modifiedAt, string name, string password
+    JOURNAL_COMMIT = 2,   // uint32 records in the batch
+    JOURNAL_HISTORY = 3,  // uint64 key of the newer version, uint64 key of this one,
+                          // int64 modifiedAt, name and password as deltas of the newer
+    JOURNAL_SET = 4,      // uint32 index, then as ADD
+    JOURNAL_INSERT = 5,   // uint32 index, then as ADD
+    JOURNAL_ERASE = 6,    // uint32 index
+    JOURNAL_TRUNCATE = 7  // uint64 entries kept
+};
+
+// What merge() found
+enum JournalMerge {
+    MERGE_NONE,      // Nothing new
+    MERGE_APPENDED,  // Entries added at the end; indexes held elsewhere still hold
+    MERGE_EDITED,    // Entries changed, inserted or erased
+    MERGE_RELOAD     // Started afresh or unreadable: load the vault file and journal again
+};
+
+// passwords.dat -> passwords.journal
+inline std::string journalPathFor(const std::string& vaultPath) {
+    size_t dot = vaultPath.find_last_of('.');
+    size_t slash = vaultPath.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = vaultPath.size();
+    return vaultPath.substr(0, dot) + ".journal";
+}
+
+// An earlier version of an entry
+struct HistoryVersion {
+    std::string serviceName;
+    std::string password;
+    int64_t modifiedAt = 0;
+
+    ~HistoryVersion() { secureZero(&password[0], password.size()); }
+};
+
+class VaultJournal {
+public:
+    static constexpr size_t HEADER_SIZE = 24;
+    static constexpr size_t RECORD_HEADER_SIZE = 9;
+    static constexpr size_t MAX_PAYLOAD = 1 << 24;
+    static constexpr size_t HISTORY_KEYS_SIZE = 16;
+    static constexpr size_t HISTORY_SKIP_SEEK = 4096;
+    static constexpr size_t DEFAULT_HISTORY_LIMIT = 10;
+    static constexpr uint64_t COMPACT_EDIT_BYTES = 1 << 20;
+
+    // Identifies one version of an entry
+    static uint64_t historyKey(std::string_view serviceName, std::string_view password) {
+        uint64_t hash = fnv1a64(serviceName.data(), serviceName.size());
+        hash = fnv1a64("|", 1, hash);
+        return fnv1a64(password.data(), password.size(), hash);
+    }
+
+private:
+    // Open-addressed index of HISTORY records by the key of the newer version
+    struct HistorySlot {
+        uint64_t key;
+        uint64_t previous;  // Key of the version the record holds
+        uint64_t offset;    // Of the record in the file, 0 for an empty slot
+    };
+
+    std::string path;
+    FILE* file = nullptr;
+    uint64_t generation = 0;     // Of the journal as this process knows it
+    uint64_t committedSize = 0;  // End of the last complete batch
+    uint64_t writtenSize = 0;    // End of the file
+    uint32_t batchRecords = 0;   // Records appended since
+    uint64_t editBytes = 0;      // Edit records since the vault file was written
+    std::vector<uint8_t> record; // Encoding scratch, wiped after every write
+    std::vector<HistorySlot> history;
+    std::vector<HistorySlot> pendingHistory;  // Indexed on commit()
+    size_t historyCount = 0;
+    size_t maxVersions = DEFAULT_HISTORY_LIMIT;
+
+    // Frame the payload that was encoded after RECORD_HEADER_SIZE bytes of
+    // room at the front of record, encrypt it and write it
+    bool writeRecord(JournalRecordType type) {
+        uint32_t payloadSize = (uint32_t)(record.size() - RECORD_HEADER_SIZE);
+        for (size_t i = RECORD_HEADER_SIZE; i < record.size(); i++) record[i] ^= 0x7F;
+        record[8] = type;
+        uint32_t checksum = (uint32_t)fnv1a64(record.data() + 8, record.size() - 8);
+        for (int i = 0; i < 4; i++) {
+            record[i] = (uint8_t)(payloadSize >> (i * 8));
+            record[4 + i] = (uint8_t)(checksum >> (i * 8));
+        }
+        bool ok = fwrite(record.data(), 1, record.size(), file) == record.size();
+        writtenSize += record.size();
+        secureZero(record.data(), record.size());
+        record.clear();
+        return ok;
+    }
+
+    void beginRecord() {
+        record.clear();
+        record.resize(RECORD_HEADER_SIZE);
+    }
+
+    bool writeEdit(JournalRecordType type) {
+        batchRecords++;
+        editBytes += record.size();
+        return writeRecord(type);
+    }
+
+    bool writeHeader(uint64_t fingerprint) {
+        uint8_t header[HEADER_SIZE] = {'P', 'G', 'J', 'R', 'N', 'L', '2', 0};
+        for (int i = 0; i < 8; i++) {
+            header[8 + i] = (uint8_t)(fingerprint >> (i * 8));
+            header[16 + i] = (uint8_t)(generation >> (i * 8));
+        }
+        return fwrite(header, sizeof(header), 1, file) == 1;
+    }
+
+    struct Header {
+        uint64_t fingerprint = 0;
+        uint64_t generation = 0;
+    };
+
+    // Leaves in at the first record. False if it is no journal.
+    static bool readHeader(FILE* in, Header& header) {
+        uint8_t bytes[HEADER_SIZE];
+        if (fread(bytes, HEADER_SIZE, 1, in) != 1 || memcmp(bytes, "PGJRNL2", 8) != 0) return false;
+        header.fingerprint = getU64(bytes + 8);
+        header.generation = getU64(bytes + 16);
+        return true;
+    }
+
+    bool syncToDisk() {
+        if (fflush(file) != 0) return false;
+#if defined(_WIN32)
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // Decode an edit record and check it against a vault of the given number
+    // of entries, which is updated; apply it to vault unless that is null.
+    // Without entries (a stale journal) only the encoding is checked.
+    static bool replayEdit(JournalRecordType type, const uint8_t* p, size_t size, size_t* entries, Vault* vault,
+                           std::string& name, std::string& password) {
+        const uint8_t* end = p + size;
+        uint64_t index = entries ? *entries : 0;
+        int64_t modified;
+        switch (type) {
+            case JOURNAL_ADD:
+                if (!getEntry(p, end, modified, name, password) || p != end) return false;
+                if (vault) vault->append(std::move(name), std::move(password), modified);
+                if (entries) (*entries)++;
+                return true;
+            case JOURNAL_SET:
+            case JOURNAL_INSERT:
+                if (size < 4) return false;
+                index = getU32(p);
+                p += 4;
+                if (!getEntry(p, end, modified, name, password) || p != end) return false;
+                if (entries && index + (type == JOURNAL_SET) > *entries) return false;
+                if (vault && type == JOURNAL_SET) vault->replace(index, std::move(name), std::move(password), modified);
+                if (vault && type == JOURNAL_INSERT) vault->insert(index, std::move(name), std::move(password), modified);
+                if (entries && type == JOURNAL_INSERT) (*entries)++;
+                return true;
+            case JOURNAL_ERASE:
+                if (size != 4) return false;
+                index = getU32(p);
+                if (entries && index >= *entries) return false;
+                if (vault) vault->erase(index);
+                if (entries) (*entries)--;
+                return true;
+            case JOURNAL_TRUNCATE:
+                if (size != 8) return false;
+                index = getU64(p);
+                if (entries && index > *entries) return false;
+                if (vault) vault->truncate(index);
+                if (entries) *entries = index;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Call apply(type, payload, size, offset) for every record from start,
+    // where in is, before limit, with offset where the record starts,
+    // returning the end offset of the last complete batch (start if none).
+    // HISTORY records are passed with just their keys
+    // (HISTORY_KEYS_SIZE bytes) and the rest is skipped, neither checked nor
+    // decrypted.
+    template <typename Apply>
+    static uint64_t scan(FILE* in, uint64_t start, uint64_t limit, Apply apply) {
+        std::vector<uint8_t> payload;
+        uint64_t offset = start, committed = start;
+        uint32_t pending = 0;
+        uint8_t frame[RECORD_HEADER_SIZE];
+        while (offset < limit && fread(frame, sizeof(frame), 1, in) == 1) {
+            uint32_t size = getU32(frame);
+            if (size > MAX_PAYLOAD) break;
+            uint64_t recordStart = offset;
+            if (frame[8] == JOURNAL_HISTORY) {
+                // Small records are read through the stdio buffer, a seek would drop it
+                if (size < HISTORY_KEYS_SIZE) break;
+                size_t readSize = size <= HISTORY_SKIP_SEEK ? size : HISTORY_KEYS_SIZE;
+                payload.resize(readSize);
+                if (fread(payload.data(), 1, readSize, in) != readSize ||
+                    (readSize < size && !seekFile(in, size - readSize, SEEK_CUR))) {
+                    break;
+                }
+                payload.resize(HISTORY_KEYS_SIZE);
+            } else {
+                payload.resize(size);
+                if (size > 0 && fread(payload.data(), 1, size, in) != size) break;
+                uint64_t checksum = fnv1a64(frame + 8, 1);
+                if ((uint32_t)fnv1a64(payload.data(), size, checksum) != getU32(frame + 4)) break;
+            }
+            offset += sizeof(frame) + size;
+
+            for (uint8_t& b : payload) b ^= 0x7F;
+            if (frame[8] == JOURNAL_COMMIT) {
+                if (size != 4 || getU32(payload.data()) != pending) break;
+                committed = offset;
+                pending = 0;
+            } else {
+                if (!apply((JournalRecordType)frame[8], payload.data(), payload.size(), recordStart)) break;
+                pending++;
+            }
+        }
+        // A skipped record may claim to run past the end of the file
+        if (fseek(in, 0, SEEK_END) == 0 && (uint64_t)tellFile(in) < committed) committed = start;
+        secureZero(payload.data(), payload.size());
+        return committed;
+    }
+
+    HistorySlot* findHistory(uint64_t key) {
+        if (history.empty()) return nullptr;
+        size_t mask = history.size() - 1;
+        for (size_t i = (size_t)(key * 0x9E3779B97F4A7C15ULL) & mask;; i = (i + 1) & mask) {
+            if (history[i].offset == 0) return nullptr;
+            if (history[i].key == key) return &history[i];
+        }
+    }
+
+    // The latest record for a key replaces earlier ones
+    void indexHistory(uint64_t key, uint64_t previous, uint64_t offset) {
+        if ((historyCount + 1) * 4 > history.size() * 3) {
+            std::vector<HistorySlot> old(std::max<size_t>(64, history.size() * 2), HistorySlot{0, 0, 0});
+            old.swap(history);
+            historyCount = 0;
+            for (const HistorySlot& slot : old) {
+                if (slot.offset != 0) indexHistory(slot.key, slot.previous, slot.offset);
+            }
+        }
+        size_t mask = history.size() - 1;
+        size_t i = (size_t)(key * 0x9E3779B97F4A7C15ULL) & mask;
+        while (history[i].offset != 0 && history[i].key != key) i = (i + 1) & mask;
+        if (history[i].offset == 0) historyCount++;
+        history[i] = {key, previous, offset};
+    }
+
+    void clearHistory() {
+        history.clear();
+        pendingHistory.clear();
+        historyCount = 0;
+    }
+
+    // Offsets of the HISTORY records reachable from an entry of the vault
+    // within maxVersions versions, in file order
+    std::vector<uint64_t> retainedHistory(const Vault& vault) {
+        std::vector<uint64_t> offsets;
+        if (historyCount == 0 || maxVersions == 0) return offsets;
+        std::vector<uint8_t> kept(history.size(), 0);
+        for (size_t i = 0; i < vault.size(); i++) {
+            HistorySlot* slot = findHistory(historyKey(vault.serviceNames[i], vault.passwords[i]));
+            for (size_t depth = 0; slot && depth < maxVersions; depth++) {
+                uint8_t& mark = kept[(size_t)(slot - history.data())];
+                if (mark) break;  // Shared with another entry, or a cycle of reverts
+                mark = 1;
+                offsets.push_back(slot->offset);
+                slot = findHistory(slot->previous);
+            }
+        }
+        std::sort(offsets.begin(), offsets.end());
+        return offsets;
+    }
+
+    // Replace the journal with a fresh one for the vault's file, holding only
+    // the retained history (as one batch)
+    bool rewrite(const Vault& vault) { return rewrite(retainedHistory(vault), vault.fileFingerprint); }
+
+    // Replace the journal with a fresh one for the vault file of the given
+    // fingerprint, holding the HISTORY records at offsets. Reads them from
+    // the open file (if any), writes path.tmp and renames it over the
+    // journal. On failure the journal stays as it was, open for appending.
+    bool rewrite(const std::vector<uint64_t>& offsets, uint64_t fingerprint) {
+        FILE* source = file;
+        uint64_t sourceSize = writtenSize;
+        std::string tempPath = path + ".tmp";
+        std::error_code error;
+        auto fail = [&](FILE* live) {
+            std::filesystem::remove(tempPath, error);
+            generation--;
+            writtenSize = sourceSize;
+            file = live;
+            if (file && fseek(file, 0, SEEK_END) != 0) close();
+            return false;
+        };
+
+        file = fopen(tempPath.c_str(), "wb");
+        generation++;
+        bool ok = file && writeHeader(fingerprint);
+        writtenSize = HEADER_SIZE;
+
+        std::vector<HistorySlot> copied;
+        copied.reserve(offsets.size());
+        std::vector<uint8_t> bytes;
+        for (uint64_t offset : offsets) {
+            uint8_t frame[RECORD_HEADER_SIZE + HISTORY_KEYS_SIZE];
+            if (!ok || !seekFile(source, offset) || fread(frame, sizeof(frame), 1, source) != 1) {
+                ok = false;
+                break;
+            }
+            // Still encrypted; only the keys are decoded, for the new index
+            bytes.assign(frame, frame + sizeof(frame));
+            bytes.resize(RECORD_HEADER_SIZE + getU32(frame));
+            size_t rest = bytes.size() - sizeof(frame);
+            ok = fread(bytes.data() + sizeof(frame), 1, rest, source) == rest &&
+                 fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+            uint8_t keys[HISTORY_KEYS_SIZE];
+            for (size_t i = 0; i < HISTORY_KEYS_SIZE; i++) keys[i] = frame[RECORD_HEADER_SIZE + i] ^ 0x7F;
+            copied.push_back({getU64(keys), getU64(keys + 8), writtenSize});
+            writtenSize += bytes.size();
+        }
+        if (ok && !copied.empty()) {
+            beginRecord();
+            putU32(record, (uint32_t)copied.size());
+            ok = writeRecord(JOURNAL_COMMIT);
+        }
+        ok = ok && syncToDisk();
+        if (file) ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        if (!ok) return fail(source);
+
+        // Windows can't replace an open file: the live journal is closed for
+        // the rename and opened again if that fails
+        if (source) fclose(source);
+        std::filesystem::rename(tempPath, path, error);
+        if (error) return fail(fopen(path.c_str(), "r+b"));
+        file = fopen(path.c_str(), "r+b");
+        if (!file || fseek(file, 0, SEEK_END) != 0) {
+            close();
+            return false;
+        }
+        clearHistory();
+        for (const HistorySlot& slot : copied) indexHistory(slot.key, slot.previous, slot.offset);
+        committedSize = writtenSize;
+        batchRecords = 0;
+        editBytes = 0;
+        return true;
+    }
+
+public:
+    VaultJournal() = default;
+    ~VaultJournal() { close(); }
+    VaultJournal(const VaultJournal&) = delete;
+    VaultJournal& operator=(const VaultJournal&) = delete;
+
+    // Replay the committed batches of the journal at path into vault, which
+    // must have just been loaded from the vault file, then keep the journal
+    // open for appending. Uncommitted records are cut off; a journal of an
+    // older vault file is started afresh, with its history carried over.
+    // Hold the vault's lock, from before the vault file is loaded.
+    bool open(Vault& vault, const char* journalPath) {
+        PROFILE_ZONE("journal.open");
+        close();
+        path = journalPath;
+
+        uint64_t committed = 0;
+        bool current = false;
+        Header header;
+        if (FILE* in = fopen(journalPath, "rb")) {
+            bool valid = readHeader(in, header);
+            current = valid && header.fingerprint == vault.fileFingerprint;
+
+            // Validate first so that a batch cut short never reaches the vault
+            std::string name, password;
+            size_t entries = vault.size();
+            size_t* check = current ? &entries : nullptr;
+            if (valid) {
+                committed = scan(in, HEADER_SIZE, UINT64_MAX, [&](JournalRecordType type, const uint8_t* p, size_t size, uint64_t) {
+                    return type == JOURNAL_HISTORY || replayEdit(type, p, size, check, nullptr, name, password);
+                });
+            }
+            if (committed > HEADER_SIZE) {
+                seekFile(in, HEADER_SIZE);
+                size_t before = vault.size();
+                bool appendsOnly = true;
+                entries = vault.size();
+                uint64_t end = scan(in, HEADER_SIZE, committed, [&](JournalRecordType type, const uint8_t* p, size_t size, uint64_t offset) {
+                    if (type == JOURNAL_HISTORY) {
+                        indexHistory(getU64(p), getU64(p + 8), offset);
+                        return true;
+                    }
+                    appendsOnly = appendsOnly && type == JOURNAL_ADD;
+                    editBytes += RECORD_HEADER_SIZE + size;
+                    return replayEdit(type, p, size, check, current ? &vault : nullptr, name, password);
+                });
+                if (end != committed) {
+                    // Changed between the passes: appends can be taken back, other edits can't
+                    clearHistory();
+                    if (current && !appendsOnly) {
+                        secureZero(&password[0], password.size());
+                        fclose(in);
+                        return false;
+                    }
+                    vault.truncate(before);
+                    committed = 0;
+                    editBytes = 0;
+                }
+                if (current) vault.revision++;
+            }
+            secureZero(&password[0], password.size());
+            fclose(in);
+        }
+
+        // Generations go on from the journal there was, if any
+        generation = header.generation;
+        if (committed > HEADER_SIZE && !current) {
+            // Rewritten since: drop the folded-in ADD records, keep the history
+            file = fopen(journalPath, "rb");
+            if (!file || !rewrite(vault)) {
+                close();
+                return false;
+            }
+            return true;
+        }
+        if (committed == 0 || !current) {
+            // None, damaged, or of an older vault file with nothing to carry over
+            generation++;
+            file = fopen(journalPath, "w+b");
+            if (!file || !writeHeader(vault.fileFingerprint) || !syncToDisk()) {
+                close();
+                return false;
+            }
+            committed = HEADER_SIZE;
+        } else {
+            std::error_code error;
+            std::filesystem::resize_file(journalPath, committed, error);
+            file = error ? nullptr : fopen(journalPath, "r+b");
+            if (!file || fseek(file, 0, SEEK_END) != 0) {
+                close();
+                return false;
+            }
+        }
+        committedSize = writtenSize = committed;
+        batchRecords = 0;
+        return true;
+    }
+
+    // Start the journal at journalPath afresh for a vault file that was
+    // written without it (a restore, or passgen_vault_save()): the header
+    // takes the new file's fingerprint and the next generation, which tells
+    // running processes to reload. Edits are dropped, being in the file or
+    // replaced by it; all committed history is carried over, for the next
+    // compaction to prune. Hold the vault's lock.
+    static bool restart(const char* journalPath, uint64_t fingerprint) {
+        VaultJournal journal;
+        journal.path = journalPath;
+        std::vector<uint64_t> offsets;
+        Header header;
+        if (FILE* in = fopen(journalPath, "rb")) {
+            journal.file = in;
+            if (readHeader(in, header)) {
+                uint64_t committed = scan(in, HEADER_SIZE, UINT64_MAX, [&](JournalRecordType type, const uint8_t*, size_t, uint64_t offset) {
+                    if (type == JOURNAL_HISTORY) offsets.push_back(offset);
+                    return true;
+                });
+                // Records of a batch that was never committed don't count
+                offsets.erase(std::lower_bound(offsets.begin(), offsets.end(), committed), offsets.end());
+            }
+        }
+        journal.generation = header.generation;
+        return journal.rewrite(offsets, fingerprint);
+    }
+
+    // Replay the committed edits of the journal at path into vault, just
+    // loaded from the vault file, without opening the journal for writing:
+    // for readers next to a running application. A missing or stale journal
+    // has nothing to replay. False if the journal changed while it was read.
+    static bool replay(Vault& vault, const char* journalPath) {
+        FILE* in = fopen(journalPath, "rb");
+        if (!in) return true;
+        Header header;
+        bool ok = true;
+        if (readHeader(in, header) && header.fingerprint == vault.fileFingerprint) {
+            std::string name, password;
+            size_t entries = vault.size();
+            uint64_t committed = scan(in, HEADER_SIZE, UINT64_MAX, [&](JournalRecordType type, const uint8_t* p, size_t size, uint64_t) {
+                return type == JOURNAL_HISTORY || replayEdit(type, p, size, &entries, nullptr, name, password);
+            });
+            if (committed > HEADER_SIZE) {
+                seekFile(in, HEADER_SIZE);
+                entries = vault.size();
+                uint64_t end = scan(in, HEADER_SIZE, committed, [&](JournalRecordType type, const uint8_t* p, size_t size, uint64_t) {
+                    return type == JOURNAL_HISTORY || replayEdit(type, p, size, &entries, &vault, name, password);
+                });
+                ok = end == committed;
+                vault.revision++;
+            }
+            secureZero(&password[0], password.size());
+        }
+        fclose(in);
+        return ok;
+    }
+
+    // Whether the journal at path holds committed edits, which a reader of
+    // the vault file alone would miss. Reads the journal without changing it.
+    static bool hasEdits(const char* journalPath) {
+        FILE* in = fopen(journalPath, "rb");
+        if (!in) return false;
+        Header header;
+        uint64_t firstEdit = UINT64_MAX, committed = 0;
+        if (readHeader(in, header)) {
+            committed = scan(in, HEADER_SIZE, UINT64_MAX, [&](JournalRecordType type, const uint8_t*, size_t, uint64_t offset) {
+                if (type != JOURNAL_HISTORY) firstEdit = std::min(firstEdit, offset);
+                return true;
+            });
+        }
+        fclose(in);
+        return firstEdit < committed;
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+        editBytes = 0;
+        secureZero(record.data(), record.size());
+        record.clear();
+        clearHistory();
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t size() const { return committedSize; }
+
+    // Worth folding into the vault file: replaying it costs more than a save
+    bool wantsCompaction() const { return editBytes > COMPACT_EDIT_BYTES; }
+
+    // Batched appends. Nothing is visible to a later open() before commit().
+    bool add(std::string_view serviceName, std::string_view password, int64_t modified) {
+        if (!file) return false;
+        beginRecord();
+        putEntry(record, serviceName, password, modified);
+        return writeEdit(JOURNAL_ADD);
+    }
+
+    // Edits by index, matching Vault's replace(), insert(), erase() and truncate()
+    bool replace(size_t index, std::string_view serviceName, std::string_view password, int64_t modified) {
+        if (!file) return false;
+        beginRecord();
+        putU32(record, (uint32_t)index);
+        putEntry(record, serviceName, password, modified);
+        return writeEdit(JOURNAL_SET);
+    }
+
+    bool insert(size_t index, std::string_view serviceName, std::string_view password, int64_t modified) {
+        if (!file) return false;
+        beginRecord();
+        putU32(record, (uint32_t)index);
+        putEntry(record, serviceName, password, modified);
+        return writeEdit(JOURNAL_INSERT);
+    }
+
+    bool erase(size_t index) {
+        if (!file) return false;
+        beginRecord();
+        putU32(record, (uint32_t)index);
+        return writeEdit(JOURNAL_ERASE);
+    }
+
+    bool truncate(size_t entries) {
+        if (!file) return false;
+        beginRecord();
+        putU64(record, entries);
+        return writeEdit(JOURNAL_TRUNCATE);
+    }
+
+    // Close the batch and flush it to disk
+    bool commit() {
+        if (!file) return false;
+        beginRecord();
+        putU32(record, batchRecords);
+        if (!writeRecord(JOURNAL_COMMIT) || !syncToDisk()) return false;
+        committedSize = writtenSize;
+        batchRecords = 0;
+        for (const HistorySlot& slot : pendingHistory) indexHistory(slot.key, slot.previous, slot.offset);
+        pendingHistory.clear();
+        return true;
+    }
+
+    // Drop everything appended since the last commit()
+    bool rollback() {
+        if (!file) return false;
+        fclose(file);
+        file = nullptr;
+        batchRecords = 0;
+        pendingHistory.clear();
+        writtenSize = committedSize;
+        std::error_code error;
+        std::filesystem::resize_file(path, committedSize, error);
+        file = error ? nullptr : fopen(path.c_str(), "r+b");
+        return file && fseek(file, 0, SEEK_END) == 0;
+    }
+
+    // Start over after the vault file was rewritten with everything in it,
+    // keeping the history of the entries it holds. On failure the journal
+    // is left as it was, open, and wantsCompaction() still holds.
+    bool reset(const Vault& vault) {
+        if (!file) return false;
+        pendingHistory.clear();
+        return rewrite(vault);
+    }
+
+    // Take in the batches other processes committed since the last one this
+    // journal knows of, into vault, which holds everything up to there. Only
+    // the new records are read, so the cost follows the size of the change,
+    // not of the vault. Needs no lock: a batch still being written is left
+    // for the next call.
+    JournalMerge merge(Vault& vault) {
+        PROFILE_ZONE("journal.merge");
+        if (!file) return MERGE_RELOAD;
+        if (writtenSize != committedSize) return MERGE_NONE;  // In a batch of our own
+        FILE* in = fopen(path.c_str(), "rb");
+        if (!in) return MERGE_RELOAD;
+        Header header;
+        if (!readHeader(in, header) || header.generation != generation || header.fingerprint != vault.fileFingerprint ||
+            !seekFile(in, committedSize)) {
+            fclose(in);
+            return MERGE_RELOAD;
+        }
+
+        // Validate first, as open() does
+        std::string name, password;
+        size_t entries = vault.size();
+        uint64_t committed = scan(in, committedSize, UINT64_MAX, [&](JournalRecordType type, const uint8_t* p, size_t size, uint64_t) {
+            return type == JOURNAL_HISTORY || replayEdit(type, p, size, &entries, nullptr, name, password);
+        });
+        JournalMerge merged = MERGE_NONE;
+        if (committed > committedSize) {
+            seekFile(in, committedSize);
+            entries = vault.size();
+            bool appendsOnly = true;
+            uint64_t end = scan(in, committedSize, committed, [&](JournalRecordType type, const uint8_t* p, size_t size, uint64_t offset) {
+                if (type == JOURNAL_HISTORY) {
+                    indexHistory(getU64(p), getU64(p + 8), offset);
+                    return true;
+                }
+                appendsOnly = appendsOnly && type == JOURNAL_ADD;
+                editBytes += RECORD_HEADER_SIZE + size;
+                return replayEdit(type, p, size, &entries, &vault, name, password);
+            });
+            // Only a fresh start rewrites committed records, and that shows in the generation
+            merged = end != committed ? MERGE_RELOAD : appendsOnly ? MERGE_APPENDED : MERGE_EDITED;
+            committedSize = writtenSize = committed;
+            vault.revision++;
+        }
+        secureZero(&password[0], password.size());
+        fclose(in);
+        return merged;
+    }
+
+    // Under the vault's lock, before appending: merge(), then cut off a batch
+    // a process left unfinished when it died. Anything but MERGE_RELOAD
+    // leaves the journal ready for a batch of ours.
+    JournalMerge catchUp(Vault& vault) {
+        JournalMerge merged = merge(vault);
+        if (merged == MERGE_RELOAD) return merged;
+        if (fseek(file, 0, SEEK_END) != 0) return MERGE_RELOAD;
+        if ((uint64_t)tellFile(file) > committedSize && !rollback()) return MERGE_RELOAD;
+        return merged;
+    }
+
+    // Versions kept per entry when the journal is compacted
+    size_t historyLimit() const { return maxVersions; }
+    void setHistoryLimit(size_t versions) { maxVersions = versions; }
+    size_t historySize() const { return historyCount; }
+    size_t historyIndexBytes() const { return history.capacity() * sizeof(HistorySlot); }
+
+    // Record that an entry is about to change from the old version to the
+    // new one. Part of the batch like add(); previousVersion() sees it after
+    // commit().
+    bool addHistory(std::string_view oldName, std::string_view oldPassword, int64_t oldModified, std::string_view newName,
+                    std::string_view newPassword) {
+        if (!file) return false;
+        uint64_t key = historyKey(newName, newPassword), previous = historyKey(oldName, oldPassword);
+        if (key == previous) return true;  // Nothing changed
+        uint64_t offset = writtenSize;
+        beginRecord();
+        putU64(record, key);
+        putU64(record, previous);
+        putU64(record, (uint64_t)oldModified);
+        putDelta(record, newName, oldName);
+        putDelta(record, newPassword, oldPassword);
+        batchRecords++;
+        if (!writeRecord(JOURNAL_HISTORY)) return false;
+        pendingHistory.push_back({key, previous, offset});
+        return true;
+    }
+
+    // The version an entry had before it became (serviceName, password);
+    // reads and decrypts one record. False if there is none or it is damaged.
+    bool previousVersion(std::string_view serviceName, std::string_view password, HistoryVersion& version) {
+        PROFILE_ZONE("journal.history");
+        HistorySlot* slot = file ? findHistory(historyKey(serviceName, password)) : nullptr;
+        if (!slot) return false;
+
+        uint8_t frame[RECORD_HEADER_SIZE];
+        bool ok = seekFile(file, slot->offset) && fread(frame, sizeof(frame), 1, file) == 1 &&
+                  frame[8] == JOURNAL_HISTORY && getU32(frame) <= MAX_PAYLOAD;
+        std::vector<uint8_t> payload(ok ? getU32(frame) : 0);
+        ok = ok && fread(payload.data(), 1, payload.size(), file) == payload.size() &&
+             (uint32_t)fnv1a64(payload.data(), payload.size(), fnv1a64(frame + 8, 1)) == getU32(frame + 4);
+        fseek(file, 0, SEEK_END);  // Back to appending
+        if (ok) {
+            for (uint8_t& b : payload) b ^= 0x7F;
+            const uint8_t* p = payload.data() + HISTORY_KEYS_SIZE;
+            const uint8_t* end = payload.data() + payload.size();
+            ok = end - p >= 8;
+            if (ok) {
+                version.modifiedAt = (int64_t)getU64(p);
+                p += 8;
+                ok = getDelta(p, end, serviceName, version.serviceName) && getDelta(p, end, password, version.password) && p == end;
+            }
+        }
+        secureZero(payload.data(), payload.size());
+        return ok;
+    }
+};
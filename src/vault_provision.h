@@ -0,0 +1,153 @@
+#pragma once
+#include "password_generator.h"
+#include "profiler.h"
+#include "secure_memory.h"
+#include "vault.h"
+#include "vault_journal.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Batch provisioning: a new, generated password for each name of a list of
+// service accounts, all added as one journal commit. Used by passgen_cli
+// provision and by a names list dropped on the window.
+
+static constexpr int PROVISION_DEFAULT_LENGTH = 16;
+
+struct ProvisionResult {
+    bool ok = false;
+    size_t created = 0;
+    size_t skipped = 0;  // Blank lines, names over MAX_SERVICE_NAME bytes, names already in the vault or earlier in the list
+    size_t bytes = 0;    // Of the list
+    const char* error = "";
+};
+
+// One service name per line, surrounding blanks trimmed. The vault file is
+// line based with '|' after the name, so a '|' in a name becomes '/'. Names
+// longer than MAX_SERVICE_NAME are skipped rather than cut short.
+inline bool readProvisionNames(FILE* in, std::vector<std::string>& names, ProvisionResult& result) {
+    std::string line;
+    char chunk[1 << 16];
+    auto endLine = [&]() {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            result.skipped++;
+            line.clear();
+            return;
+        }
+        size_t last = line.find_last_not_of(" \t\r");
+        if (last - first + 1 > MAX_SERVICE_NAME) {
+            result.skipped++;
+            line.clear();
+            return;
+        }
+        names.emplace_back(line, first, last - first + 1);
+        for (char& c : names.back()) c = c == '|' ? '/' : c;
+        line.clear();
+    };
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        result.bytes += got;
+        const char* p = chunk;
+        const char* end = chunk + got;
+        while (p < end) {
+            const char* newline = (const char*)memchr(p, '\n', end - p);
+            if (!newline) {
+                line.append(p, end);
+                break;
+            }
+            line.append(p, newline);
+            endLine();
+            p = newline + 1;
+        }
+    }
+    if (!line.empty()) endLine();
+    return !ferror(in);
+}
+
+// Add the names of the list with a password each, to the vault and, when a
+// journal is given, to it as one commit: either every entry is added or none
+// is. Names the vault has already, or that come twice, are skipped; the new
+// entries are the last result.created of the vault.
+inline ProvisionResult provisionVault(Vault& vault, VaultJournal* journal, FILE* in, int length,
+                                      PasswordGenerator& generator) {
+    PROFILE_ZONE("provision");
+    ProvisionResult result;
+    std::vector<std::string> names;
+    if (!readProvisionNames(in, names, result)) {
+        result.error = "cannot read the list";
+        return result;
+    }
+
+    // Room for all first: the set below holds views of the vault's names
+    size_t before = vault.size();
+    vault.serviceNames.reserve(before + names.size());
+    vault.passwords.reserve(before + names.size());
+    std::unordered_set<std::string_view> taken(vault.serviceNames.begin(), vault.serviceNames.end());
+    taken.reserve(before + names.size());
+
+    std::vector<std::string> passwords;
+    generator.generateBatch(passwords, names.size(), length);
+    int64_t now = (int64_t)time(nullptr);
+    bool journalOk = true;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (taken.count(names[i])) {
+            result.skipped++;
+            continue;
+        }
+        if (journal) journalOk = journalOk && journal->add(names[i], passwords[i], now);
+        vault.append(std::move(names[i]), std::move(passwords[i]), now);
+        taken.insert(vault.serviceNames.back());
+    }
+    for (std::string& password : passwords) secureZero(&password[0], password.size());
+
+    result.created = vault.size() - before;
+    result.ok = journalOk && (!journal || journal->commit());
+    if (!result.ok) {
+        result.error = "cannot write the journal";
+        for (size_t i = before; i < vault.size(); i++) secureZero(&vault.passwords[i][0], vault.passwords[i].size());
+        vault.truncate(before);
+        if (journal) journal->rollback();
+        result.created = 0;
+        return result;
+    }
+    if (result.created > 0) vault.revision++;
+    return result;
+}
+
+// The entries from first on as "name,password" CSV with a header, for the
+// provisioning system; fields quoted where they need it
+inline bool writeProvisionCsv(const Vault& vault, size_t first, FILE* out) {
+    std::string buffer = "name,password\n";
+    auto field = [&](const std::string& text) {
+        if (text.find_first_of(",\"\r\n") == std::string::npos && (text.empty() || (text.front() != ' ' && text.back() != ' '))) {
+            buffer += text;
+            return;
+        }
+        buffer += '"';
+        for (char c : text) {
+            if (c == '"') buffer += '"';
+            buffer += c;
+        }
+        buffer += '"';
+    };
+    bool ok = true;
+    for (size_t i = first; i < vault.size() && ok; i++) {
+        field(vault.serviceNames[i]);
+        buffer += ',';
+        field(vault.passwords[i]);
+        buffer += '\n';
+        if (buffer.size() >= (1 << 16)) {
+            ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+            secureZero(&buffer[0], buffer.size());
+            buffer.clear();
+        }
+    }
+    ok = ok && fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+    secureZero(&buffer[0], buffer.size());
+    return ok && fflush(out) == 0;
+}
@@ -0,0 +1,441 @@
+#pragma once
+#include "block_codec.h"
+#include "profiler.h"
+#include "secure_memory.h"
+#include "vault.h"
+#include "vault_journal.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Decoded service names of vault file segments, shared by every vault of a
+// VaultSet and kept within a memory budget by evicting the least recently
+// used segment. Passwords are never cached.
+class NameCache {
+public:
+    static constexpr size_t DEFAULT_BUDGET = 16 << 20;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Slot {
+        uint64_t key = 0;
+        uint32_t newer = NONE;
+        uint32_t older = NONE;
+        size_t bytes = 0;
+        std::vector<std::string> names;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<uint64_t, uint32_t> index;
+    uint32_t newest = NONE;
+    uint32_t oldest = NONE;
+    size_t bytes = 0;
+    size_t budget = DEFAULT_BUDGET;
+
+    void unlink(uint32_t i) {
+        Slot& slot = slots[i];
+        (slot.newer == NONE ? newest : slots[slot.newer].older) = slot.older;
+        (slot.older == NONE ? oldest : slots[slot.older].newer) = slot.newer;
+        slot.newer = slot.older = NONE;
+    }
+
+    void pushNewest(uint32_t i) {
+        slots[i].older = newest;
+        if (newest != NONE) slots[newest].newer = i;
+        newest = i;
+        if (oldest == NONE) oldest = i;
+    }
+
+    void evict(uint32_t i) {
+        unlink(i);
+        index.erase(slots[i].key);
+        bytes -= slots[i].bytes;
+        slots[i].names = std::vector<std::string>();
+        freeSlots.push_back(i);
+        evictions++;
+    }
+
+public:
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    static uint64_t key(uint32_t vault, uint32_t segment) { return (uint64_t)vault << 32 | segment; }
+
+    // Lower the budget to evict now; the segment just added is always kept
+    void setBudget(size_t memory) {
+        budget = memory;
+        while (bytes > budget && oldest != newest) evict(oldest);
+    }
+
+    size_t memoryBytes() const { return bytes; }
+    size_t segments() const { return index.size(); }
+
+    // Null if not cached. The names stay valid until the next insert().
+    const std::vector<std::string>* find(uint64_t segmentKey) {
+        auto it = index.find(segmentKey);
+        if (it == index.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        unlink(it->second);
+        pushNewest(it->second);
+        return &slots[it->second].names;
+    }
+
+    const std::vector<std::string>& insert(uint64_t segmentKey, std::vector<std::string>&& names) {
+        auto it = index.find(segmentKey);
+        if (it != index.end()) evict(it->second);
+        uint32_t i;
+        if (!freeSlots.empty()) {
+            i = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            i = (uint32_t)slots.size();
+            slots.emplace_back();
+        }
+        Slot& slot = slots[i];
+        slot.key = segmentKey;
+        slot.names = std::move(names);
+        slot.bytes = sizeof(Slot) + slot.names.capacity() * sizeof(std::string);
+        for (const std::string& name : slot.names) slot.bytes += name.capacity() > 15 ? name.capacity() + 1 : 0;
+        bytes += slot.bytes;
+        index[segmentKey] = i;
+        pushNewest(i);
+        while (bytes > budget && oldest != i) evict(oldest);
+        return slot.names;
+    }
+
+    void clear() {
+        slots.clear();
+        freeSlots.clear();
+        index.clear();
+        newest = oldest = NONE;
+        bytes = 0;
+    }
+};
+
+// Names of one segment as a Bloom filter of their lowercase trigrams, so a
+// search can skip segments that can't match without decoding them
+struct TrigramFilter {
+    static constexpr int BITS_LOG = 13;
+    static constexpr size_t BITS = (size_t)1 << BITS_LOG;
+    uint64_t words[BITS / 64];
+
+    static uint8_t lower(char c) { return (uint8_t)(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c); }
+
+    static uint32_t trigramBit(uint32_t trigram) {
+        return (uint32_t)(((uint64_t)(trigram & 0xFFFFFF) * 0x9E3779B97F4A7C15ULL) >> (64 - BITS_LOG));
+    }
+
+    void clear() { memset(words, 0, sizeof(words)); }
+
+    void add(std::string_view name) {
+        uint32_t trigram = 0;
+        for (size_t i = 0; i < name.size(); i++) {
+            trigram = trigram << 8 | lower(name[i]);
+            if (i < 2) continue;
+            uint32_t bit = trigramBit(trigram);
+            words[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+
+    bool mayContain(std::string_view loweredQuery) const {
+        uint32_t trigram = 0;
+        for (size_t i = 0; i < loweredQuery.size(); i++) {
+            trigram = trigram << 8 | (uint8_t)loweredQuery[i];
+            if (i < 2) continue;
+            uint32_t bit = trigramBit(trigram);
+            if (!(words[bit / 64] >> (bit % 64) & 1)) return false;
+        }
+        return true;
+    }
+};
+
+inline std::string lowerAscii(std::string_view text) {
+    std::string lowered(text);
+    for (char& c : lowered) c = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    return lowered;
+}
+
+// Whether text contains loweredQuery, ignoring ASCII case in text
+inline bool containsIgnoreCase(std::string_view text, std::string_view loweredQuery) {
+    if (loweredQuery.size() > text.size()) return false;
+    for (size_t i = 0; i + loweredQuery.size() <= text.size(); i++) {
+        size_t j = 0;
+        while (j < loweredQuery.size()) {
+            char c = text[i + j];
+            if ((c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c) != loweredQuery[j]) break;
+            j++;
+        }
+        if (j == loweredQuery.size()) return true;
+    }
+    return false;
+}
+
+struct VaultMatch {
+    size_t vault;
+    std::string serviceName;
+};
+
+struct VaultSearchStats {
+    size_t segmentsSkipped = 0;  // Ruled out by the merged index
+    size_t segmentsSearched = 0;
+    size_t segmentsDecoded = 0;  // Not in the name cache
+    size_t vaultsExpanded = 0;   // Loaded in full, because their journal holds edits
+};
+
+// Several vault files open side by side, e.g. one per team or environment.
+// Opening a vault only reads its frame headers: where each segment is, and
+// the entry count. Names are decoded per segment on demand through a shared
+// NameCache; the whole library, passwords included, is only loaded when a
+// vault is expanded.
+//
+// Cross-vault search runs on a merged index: one trigram filter per segment
+// of every vault, in one array. A filter is built the first time its segment
+// is decoded, and rules the segment out of later searches when the query
+// can't match it. Vaults whose journal holds edits are expanded for search,
+// since their file alone is out of date.
+class VaultSet {
+private:
+    struct Segment {
+        uint64_t offset;  // Of the stored bytes
+        uint32_t storedSize;
+        uint32_t rawSize;
+        uint8_t codec;
+        bool filtered = false;  // Its filter in the merged index is built
+    };
+
+    struct Member {
+        std::string path;
+        uint32_t id = 0;  // Cache key; changes whenever the file is indexed again
+        bool legacy = false;
+        uint64_t entries = 0;
+        uint64_t fileSize = 0;
+        std::filesystem::file_time_type fileTime;
+        std::vector<Segment> segments;
+        size_t firstFilter = 0;  // Into filters
+        size_t filterSlots = 0;  // Reserved there
+        std::unique_ptr<SegmentCodec> codec;
+        std::unique_ptr<Vault> expanded;
+    };
+
+    std::vector<Member> members;
+    std::vector<TrigramFilter> filters;  // Merged index, members' segments in order
+    NameCache names;
+    uint32_t nextId = 1;
+
+    bool fileChanged(const Member& member) const {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(member.path, error);
+        if (error) return true;
+        return size != member.fileSize || std::filesystem::last_write_time(member.path, error) != member.fileTime;
+    }
+
+    // Read the frame headers of the vault file, skipping the segments
+    bool indexFile(Member& member) {
+        PROFILE_ZONE("vaultset.index");
+        member.id = nextId++;
+        member.segments.clear();
+        member.entries = 0;
+        member.legacy = false;
+        member.codec.reset(new SegmentCodec());
+        std::error_code error;
+        member.fileSize = std::filesystem::file_size(member.path, error);
+        member.fileTime = std::filesystem::last_write_time(member.path, error);
+        FILE* in = fopen(member.path.c_str(), "rb");
+        if (!in) return false;
+
+        char magic[8];
+        bool ok = false;
+        if (fread(magic, 1, 8, in) != 8 || memcmp(magic, "PGVAULT2", 8) != 0) {
+            // The original format is one block: it is its own single segment
+            member.legacy = true;
+            member.segments.push_back({0, 0, 0, CODEC_NONE});
+            ok = !error;
+        } else {
+            uint64_t offset = 8;
+            std::vector<uint8_t> small;
+            for (bool first = true;; first = false) {
+                uint8_t header[VAULT_FRAME_HEADER];
+                if (fread(header, sizeof(header), 1, in) != 1) break;
+                uint32_t storedSize = getU32(header), rawSize = getU32(header + 4);
+                uint8_t flags = header[8];
+                if (storedSize > VAULT_MAX_FRAME || rawSize > VAULT_MAX_FRAME) break;
+                offset += sizeof(header);
+                if (flags & (VAULT_END | VAULT_DICTIONARY)) {
+                    // Small frames stored as is: read them
+                    if ((flags & VAULT_DICTIONARY) && !first) break;
+                    small.resize(storedSize);
+                    if (storedSize != rawSize || (storedSize > 0 && fread(small.data(), 1, storedSize, in) != storedSize)) break;
+                    if ((uint32_t)fnv1a64(small.data(), storedSize) != getU32(header + 9)) break;
+                    for (uint8_t& b : small) b ^= 0x7F;
+                    if (flags & VAULT_END) {
+                        ok = storedSize == 8;
+                        if (ok) member.entries = getU64(small.data());
+                        break;
+                    }
+                    member.codec->setup(CODEC_NONE, 0, small);
+                } else {
+                    BlockCodec codec = (BlockCodec)(flags & VAULT_CODEC_MASK);
+                    if (!codecAvailable(codec) || !seekFile(in, storedSize, SEEK_CUR)) break;
+                    member.segments.push_back({offset, storedSize, rawSize, (uint8_t)codec});
+                }
+                offset += storedSize;
+            }
+            secureZero(small.data(), small.size());
+        }
+        fclose(in);
+
+        if (!ok) member.segments.clear();
+        // A vault reindexed with more segments than before moves to the end of the merged index
+        if (member.segments.size() > member.filterSlots) {
+            member.firstFilter = filters.size();
+            member.filterSlots = member.segments.size() + member.segments.size() / 4;
+            filters.resize(filters.size() + member.filterSlots);
+        }
+        return ok;
+    }
+
+    // Service names of one segment, from the cache or decoded from the file
+    const std::vector<std::string>* segmentNames(Member& member, size_t segment, FILE*& in, VaultSearchStats& stats) {
+        uint64_t cacheKey = NameCache::key(member.id, (uint32_t)segment);
+        if (const std::vector<std::string>* cached = names.find(cacheKey)) return cached;
+        stats.segmentsDecoded++;
+
+        std::vector<std::string> decoded;
+        if (member.legacy) {
+            Vault vault;
+            if (!loadVault(vault, member.path.c_str())) return nullptr;
+            for (std::string& password : vault.passwords) secureZero(&password[0], password.size());
+            decoded = std::move(vault.serviceNames);
+        } else {
+            const Segment& seg = member.segments[segment];
+            if (!in && !(in = fopen(member.path.c_str(), "rb"))) return nullptr;
+            std::vector<uint8_t> stored(seg.storedSize), raw(seg.rawSize);
+            uint8_t header[VAULT_FRAME_HEADER];  // For the checksum
+            bool ok = seekFile(in, seg.offset - sizeof(header)) && fread(header, sizeof(header), 1, in) == 1 &&
+                      fread(stored.data(), 1, stored.size(), in) == stored.size() &&
+                      (uint32_t)fnv1a64(stored.data(), stored.size()) == getU32(header + 9);
+            if (ok) {
+                for (uint8_t& b : stored) b ^= 0x7F;
+                ok = member.codec->decompress((BlockCodec)seg.codec, stored.data(), stored.size(), raw.data(), raw.size());
+            }
+            const char* p = (const char*)raw.data();
+            const char* end = p + (ok ? raw.size() : 0);
+            while (const char* lineEnd = (const char*)memchr(p, '\n', (size_t)(end - p))) {
+                if (const char* bar = (const char*)memchr(p, '|', (size_t)(lineEnd - p))) decoded.emplace_back(p, (size_t)(bar - p));
+                p = lineEnd + 1;
+            }
+            secureZero(stored.data(), stored.size());
+            secureZero(raw.data(), raw.size());
+            if (!ok) return nullptr;
+        }
+
+        Segment& seg = member.segments[segment];
+        if (!seg.filtered) {
+            TrigramFilter& filter = filters[member.firstFilter + segment];
+            filter.clear();
+            for (const std::string& name : decoded) filter.add(name);
+            seg.filtered = true;
+        }
+        return &names.insert(cacheKey, std::move(decoded));
+    }
+
+public:
+    NameCache& nameCache() { return names; }
+    size_t size() const { return members.size(); }
+    const std::string& path(size_t vault) const { return members[vault].path; }
+    bool isExpanded(size_t vault) const { return members[vault].expanded != nullptr; }
+    size_t segmentCount(size_t vault) const { return members[vault].segments.size(); }
+    size_t indexBytes() const { return filters.capacity() * sizeof(TrigramFilter); }
+
+    // Entries in the vault file (lines, for a file in the original format
+    // not decoded yet: 0), or in the library once expanded
+    uint64_t entryCount(size_t vault) const {
+        const Member& member = members[vault];
+        return member.expanded ? member.expanded->size() : member.entries;
+    }
+
+    // Add a vault file to the set, indexing it; false if it can't be read
+    bool open(const char* vaultPath) {
+        Member member;
+        member.path = vaultPath;
+        if (!indexFile(member)) return false;
+        members.push_back(std::move(member));
+        return true;
+    }
+
+    // The whole library of a vault, with its journal replayed; null if it
+    // can't be read. Stays loaded until collapse().
+    Vault* expand(size_t vault) {
+        PROFILE_ZONE("vaultset.expand");
+        Member& member = members[vault];
+        if (member.expanded && !fileChanged(member)) return member.expanded.get();
+        std::unique_ptr<Vault> library(new Vault());
+        if (!loadVault(*library, member.path.c_str())) return nullptr;
+        if (!VaultJournal::replay(*library, journalPathFor(member.path).c_str())) return nullptr;
+        if (fileChanged(member)) indexFile(member);
+        member.expanded = std::move(library);
+        return member.expanded.get();
+    }
+
+    void collapse(size_t vault) {
+        Member& member = members[vault];
+        if (!member.expanded) return;
+        for (std::string& password : member.expanded->passwords) secureZero(&password[0], password.size());
+        member.expanded.reset();
+    }
+
+    // Entries of every vault whose service name contains query, ignoring
+    // ASCII case, in vault and file order; at most limit of them
+    std::vector<VaultMatch> search(std::string_view query, size_t limit = SIZE_MAX, VaultSearchStats* statsOut = nullptr) {
+        PROFILE_ZONE("vaultset.search");
+        VaultSearchStats stats;
+        std::vector<VaultMatch> matches;
+        std::string lowered = lowerAscii(query);
+        for (size_t v = 0; v < members.size() && matches.size() < limit; v++) {
+            Member& member = members[v];
+            if (!member.expanded && VaultJournal::hasEdits(journalPathFor(member.path).c_str())) {
+                if (expand(v)) stats.vaultsExpanded++;
+            }
+            if (member.expanded) {
+                for (const std::string& name : member.expanded->serviceNames) {
+                    if (matches.size() >= limit) break;
+                    if (containsIgnoreCase(name, lowered)) matches.push_back({v, name});
+                }
+                continue;
+            }
+            if (fileChanged(member)) indexFile(member);
+
+            FILE* in = nullptr;
+            for (size_t s = 0; s < member.segments.size() && matches.size() < limit; s++) {
+                if (member.segments[s].filtered && !filters[member.firstFilter + s].mayContain(lowered)) {
+                    stats.segmentsSkipped++;
+                    continue;
+                }
+                stats.segmentsSearched++;
+                const std::vector<std::string>* segment = segmentNames(member, s, in, stats);
+                if (!segment) continue;
+                for (const std::string& name : *segment) {
+                    if (matches.size() >= limit) break;
+                    if (containsIgnoreCase(name, lowered)) matches.push_back({v, name});
+                }
+            }
+            if (in) fclose(in);
+        }
+        if (statsOut) *statsOut = stats;
+        return matches;
+    }
+};
@@ -0,0 +1,244 @@
+#pragma once
+#include "vault_journal.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+    // Keep windows.h from declaring names that clash with raylib (Rectangle, CloseWindow, ...)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOGDI
+    #define NOUSER
+    #include <windows.h>
+    #undef near
+    #undef far
+#else
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <unistd.h>
+    #if defined(__linux__)
+        #include <sys/inotify.h>
+    #endif
+#endif
+
+// Sharing a vault between processes: the GUI, passgen_cli and scripts may
+// all run against the same passwords.dat. Writers take the vault's lock, an
+// advisory lock on a file next to it, from before they read the vault to
+// after they commit or compact; see VaultJournal for how a running process
+// takes in the batches the others commit, and VaultWatcher for when.
+
+// passwords.dat -> passwords.lock. The journal is replaced when it is
+// compacted, so it can't carry the lock itself.
+inline std::string lockPathFor(const std::string& vaultPath) {
+    std::string path = journalPathFor(vaultPath);
+    return path.substr(0, path.size() - 8) + ".lock";
+}
+
+// Exclusive lock between processes; nested lock() calls of one process are
+// counted. Only processes that take it are kept out.
+class VaultLock {
+#if defined(_WIN32)
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+    int depth = 0;
+
+public:
+    VaultLock() = default;
+    ~VaultLock() { close(); }
+    VaultLock(const VaultLock&) = delete;
+    VaultLock& operator=(const VaultLock&) = delete;
+
+    // Create or open the lock file of the vault at vaultPath, unlocked. An
+    // existing one is opened read-only where it can't be written, e.g. in a
+    // read-only directory; locking needs no more.
+    bool open(const std::string& vaultPath) {
+        close();
+        std::string path = lockPathFor(vaultPath);
+#if defined(_WIN32)
+        const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+        handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, share, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            handle = CreateFileA(path.c_str(), GENERIC_READ, share, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        return fd >= 0;
+#endif
+    }
+
+    void close() {
+        depth = 0;  // Closing the file releases the lock
+#if defined(_WIN32)
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+#else
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+    }
+
+    // Waits for the process holding it, if any
+    bool lock() {
+        if (depth > 0) {
+            depth++;
+            return true;
+        }
+#if defined(_WIN32)
+        OVERLAPPED overlapped = {};
+        if (handle == INVALID_HANDLE_VALUE || !LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped)) return false;
+#else
+        int result;
+        do result = fd >= 0 ? flock(fd, LOCK_EX) : -1;
+        while (result != 0 && errno == EINTR);
+        if (result != 0) return false;
+#endif
+        depth = 1;
+        return true;
+    }
+
+    // Only if no other process holds it; never waits, e.g. on the UI thread
+    bool tryLock() {
+        if (depth > 0) {
+            depth++;
+            return true;
+        }
+#if defined(_WIN32)
+        OVERLAPPED overlapped = {};
+        if (handle == INVALID_HANDLE_VALUE ||
+            !LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped))
+            return false;
+#else
+        int result;
+        do result = fd >= 0 ? flock(fd, LOCK_EX | LOCK_NB) : -1;
+        while (result != 0 && errno == EINTR);
+        if (result != 0) return false;
+#endif
+        depth = 1;
+        return true;
+    }
+
+    void unlock() {
+        if (depth == 0 || --depth > 0) return;
+#if defined(_WIN32)
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(handle, 0, 1, 0, &overlapped);
+#else
+        flock(fd, LOCK_UN);
+#endif
+    }
+
+    bool isOpen() const {
+#if defined(_WIN32)
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        return fd >= 0;
+#endif
+    }
+    bool isLocked() const { return depth > 0; }
+};
+
+// Holds a VaultLock for a scope; check locked
+struct VaultLockGuard {
+    VaultLock& lock;
+    bool locked;
+
+    explicit VaultLockGuard(VaultLock& vaultLock) : lock(vaultLock), locked(vaultLock.lock()) {}
+    ~VaultLockGuard() {
+        if (locked) lock.unlock();
+    }
+    VaultLockGuard(const VaultLockGuard&) = delete;
+    VaultLockGuard& operator=(const VaultLockGuard&) = delete;
+};
+
+// Tells when a journal may have changed on disk, cheaply enough to ask every
+// frame. On Linux, inotify watches the journal's directory (compaction
+// renames a new journal into place); elsewhere the journal's size and time
+// are compared every POLL_INTERVAL. Changes of this process count too:
+// merging finds nothing new for them.
+class VaultWatcher {
+    std::string path;
+#if defined(__linux__)
+    int fd = -1;
+    std::string name;  // Of the journal in its directory
+#else
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{500};
+    std::chrono::steady_clock::time_point nextPoll;
+    uintmax_t size = 0;
+    std::filesystem::file_time_type time;
+#endif
+
+public:
+    VaultWatcher() = default;
+    ~VaultWatcher() { close(); }
+    VaultWatcher(const VaultWatcher&) = delete;
+    VaultWatcher& operator=(const VaultWatcher&) = delete;
+
+    // Start watching the journal at journalPath, replacing the last one
+    bool watch(const std::string& journalPath) {
+        close();
+        path = journalPath;
+#if defined(__linux__)
+        std::filesystem::path file(journalPath);
+        std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+        name = file.filename().string();
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) return false;
+        if (inotify_add_watch(fd, directory.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            close();
+            return false;
+        }
+        return true;
+#else
+        changed();
+        return true;
+#endif
+    }
+
+    void close() {
+#if defined(__linux__)
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        path.clear();
+    }
+
+#if defined(__linux__)
+    // Readable when changed() may be true, for an event loop
+    int descriptor() const { return fd; }
+#endif
+
+    // Whether the journal changed since the last call; never blocks
+    bool changed() {
+        if (path.empty()) return false;
+#if defined(__linux__)
+        bool touched = false;
+        alignas(inotify_event) char events[4096];
+        ssize_t got;
+        while ((got = read(fd, events, sizeof(events))) > 0) {
+            for (ssize_t offset = 0; offset < got;) {
+                const inotify_event* event = (const inotify_event*)(events + offset);
+                touched = touched || (event->mask & IN_Q_OVERFLOW) || (event->len > 0 && name == event->name);
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+        return touched;
+#else
+        auto now = std::chrono::steady_clock::now();
+        if (now < nextPoll) return false;
+        nextPoll = now + POLL_INTERVAL;
+        std::error_code error;
+        uintmax_t newSize = std::filesystem::file_size(path, error);
+        std::filesystem::file_time_type newTime = std::filesystem::last_write_time(path, error);
+        if (newSize == size && newTime == time) return false;
+        size = newSize;
+        time = newTime;
+        return true;
+#endif
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include "raylib.h"
+#include <cstdint>
+
+// Per-frame widget list with single-pass hit testing.
+//
+// Each frame runs in three phases: layout registers every interactive
+// rectangle with add(), resolve() hit-tests the mouse once against a coarse
+// spatial grid, then input handling queries clicked()/hovered() and drawing
+// runs separately. Widgets added later are on top of earlier ones.
+class WidgetLayer {
+public:
+    static constexpr int MAX_WIDGETS = 256;
+    static constexpr int CELL_SIZE = 50;
+    static constexpr int GRID_COLS = 10;   // Covers 500 x 400 px
+    static constexpr int GRID_ROWS = 8;
+    static constexpr int MAX_CELL_REFS = MAX_WIDGETS * 4;
+    static constexpr uint32_t NONE = 0;
+
+    void begin() {
+        count = 0;
+        hoveredId = NONE;
+    }
+
+    void add(uint32_t id, Rectangle bounds) {
+        if (count < MAX_WIDGETS) widgets[count++] = {id, bounds};
+    }
+
+    // Bucket widgets into grid cells and hit-test the mouse against its cell only
+    void resolve(Vector2 mouse, bool mouseDown, bool mousePressed) {
+        down = mouseDown;
+        pressed = mousePressed;
+        hoveredId = NONE;
+
+        int cellCounts[GRID_COLS * GRID_ROWS + 1] = {0};
+        for (int i = 0; i < count; i++) {
+            int c0, c1, r0, r1;
+            cellRange(widgets[i].bounds, c0, c1, r0, r1);
+            for (int r = r0; r <= r1; r++) {
+                for (int c = c0; c <= c1; c++) cellCounts[r * GRID_COLS + c + 1]++;
+            }
+        }
+        for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) cellCounts[i + 1] += cellCounts[i];
+        for (int i = 0; i <= GRID_COLS * GRID_ROWS; i++) cellStart[i] = cellCounts[i];
+
+        int fill[GRID_COLS * GRID_ROWS];
+        for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) fill[i] = cellStart[i];
+        for (int i = 0; i < count; i++) {
+            int c0, c1, r0, r1;
+            cellRange(widgets[i].bounds, c0, c1, r0, r1);
+            for (int r = r0; r <= r1; r++) {
+                for (int c = c0; c <= c1; c++) {
+                    int& slot = fill[r * GRID_COLS + c];
+                    if (slot < MAX_CELL_REFS) cellRefs[slot++] = (uint16_t)i;
+                }
+            }
+        }
+
+        if (mouse.x < 0 || mouse.y < 0) return;
+        int col = (int)mouse.x / CELL_SIZE;
+        int row = (int)mouse.y / CELL_SIZE;
+        if (col >= GRID_COLS || row >= GRID_ROWS) return;
+
+        int cell = row * GRID_COLS + col;
+        int end = cellStart[cell + 1] < MAX_CELL_REFS ? cellStart[cell + 1] : MAX_CELL_REFS;
+        for (int i = end - 1; i >= cellStart[cell]; i--) {
+            const Widget& w = widgets[cellRefs[i]];
+            if (CheckCollisionPointRec(mouse, w.bounds)) {
+                hoveredId = w.id;
+                break;
+            }
+        }
+    }
+
+    bool hovered(uint32_t id) const { return id != NONE && hoveredId == id; }
+    bool clicked(uint32_t id) const { return pressed && hovered(id); }
+    bool held(uint32_t id) const { return down && hovered(id); }
+    uint32_t hovered() const { return hoveredId; }
+
+private:
+    struct Widget {
+        uint32_t id;
+        Rectangle bounds;
+    };
+
+    Widget widgets[MAX_WIDGETS];
+    int count = 0;
+    int cellStart[GRID_COLS * GRID_ROWS + 1] = {0};
+    uint16_t cellRefs[MAX_CELL_REFS];
+    uint32_t hoveredId = NONE;
+    bool down = false;
+    bool pressed = false;
+
+    static int clampCell(float v, int cells) {
+        int c = (int)v / CELL_SIZE;
+        if (v < 0) c = 0;
+        return c < 0 ? 0 : (c >= cells ? cells - 1 : c);
+    }
+
+    static void cellRange(Rectangle b, int& c0, int& c1, int& r0, int& r1) {
+        c0 = clampCell(b.x, GRID_COLS);
+        c1 = clampCell(b.x + b.width, GRID_COLS);
+        r0 = clampCell(b.y, GRID_ROWS);
+        r1 = clampCell(b.y + b.height, GRID_ROWS);
+    }
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include "secure_memory.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Little-endian encoding shared by the journal and backup formats. Strings
+// are a uint32 length followed by the bytes.
+inline void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (i * 8)));
+}
+
+inline void putU64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back((uint8_t)(v >> (i * 8)));
+}
+
+inline void putString(std::vector<uint8_t>& out, std::string_view s) {
+    putU32(out, (uint32_t)s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+inline uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline uint64_t getU64(const uint8_t* p) {
+    return (uint64_t)getU32(p) | (uint64_t)getU32(p + 4) << 32;
+}
+
+// Reads a string at p and advances p; false if it runs past end
+inline bool getString(const uint8_t*& p, const uint8_t* end, std::string& out) {
+    if (end - p < 4) return false;
+    uint32_t size = getU32(p);
+    p += 4;
+    if ((size_t)(end - p) < size) return false;
+    out.assign((const char*)p, size);
+    p += size;
+    return true;
+}
+
+// An entry as stored in journal ADD records and backups:
+// int64 modifiedAt, string name, string password
+inline void putEntry(std::vector<uint8_t>& out, std::string_view name, std::string_view password, int64_t modified) {
+    putU64(out, (uint64_t)modified);
+    putString(out, name);
+    putString(out, password);
+}
+
+inline bool getEntry(const uint8_t*& p, const uint8_t* end, int64_t& modified, std::string& name, std::string& password) {
+    if (end - p < 8) return false;
+    modified = (int64_t)getU64(p);
+    p += 8;
+    return getString(p, end, name) && getString(p, end, password);
+}
+
+// LEB128: 7 bits per byte, low bits first
+inline void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    for (; v >= 0x80; v >>= 7) out.push_back((uint8_t)(v | 0x80));
+    out.push_back((uint8_t)v);
+}
+
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// older as an edit of newer: the lengths of the prefix and suffix they
+// share, then the bytes of older in between. A renamed entry or a password
+// with a changed digit costs a few bytes instead of the whole string.
+inline void putDelta(std::vector<uint8_t>& out, std::string_view newer, std::string_view older) {
+    size_t limit = newer.size() < older.size() ? newer.size() : older.size();
+    size_t prefix = 0;
+    while (prefix < limit && newer[prefix] == older[prefix]) prefix++;
+    size_t suffix = 0;
+    while (suffix < limit - prefix && newer[newer.size() - 1 - suffix] == older[older.size() - 1 - suffix]) suffix++;
+    putVarint(out, prefix);
+    putVarint(out, suffix);
+    putString(out, older.substr(prefix, older.size() - prefix - suffix));
+}
+
+inline bool getDelta(const uint8_t*& p, const uint8_t* end, std::string_view newer, std::string& older) {
+    uint64_t prefix, suffix;
+    if (!getVarint(p, end, prefix) || !getVarint(p, end, suffix) || prefix + suffix > newer.size()) return false;
+    std::string middle;
+    if (!getString(p, end, middle)) return false;
+    older.assign(newer.substr(0, prefix));
+    older += middle;
+    older += newer.substr(newer.size() - suffix);
+    secureZero(&middle[0], middle.size());
+    return true;
+}
@@ -0,0 +1,102 @@
+// Agent: lookups, and passwords generated from the OS's random source, over
+// the Unix socket (src/agent_server.h, src/agent_protocol.h); a watched
+// journal's commits wake it to reload. Linux only.
+//
+// As in password_generator_test.cpp, the test defines getrandom() itself
+// to see and script the bytes the agent's generator draws.
+
+#include "../src/agent_server.h"
+#include "../src/vault_sync.h"
+#include "test_support.h"
+#include <atomic>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <vector>
+
+static const char* SOCKET_PATH = "agent_test.sock";
+
+static std::atomic<bool> scripted{false};
+static std::atomic<uint8_t> scriptedByte{0};
+static std::atomic<uint64_t> randomCalls{0};
+
+extern "C" ssize_t getrandom(void* buffer, size_t size, unsigned int flags) {
+    randomCalls++;
+    if (!scripted) return syscall(SYS_getrandom, buffer, size, flags);
+    memset(buffer, scriptedByte, size);
+    return (ssize_t)size;
+}
+
+static void Serve() {
+    Vault vault;
+    vault.append("mail", "hunter2", 0);
+    vault.append("bank", "secret", 0);
+    AgentServer server;
+    CHECK(server.load(vault));
+    CHECK(vault.passwords[0] != "hunter2");  // Wiped once in locked memory
+    CHECK(server.listen(SOCKET_PATH));
+    std::thread serving([&]() { server.run(); });
+
+    AgentClient client;
+    CHECK(client.connect(SOCKET_PATH));
+    AgentStatus status;
+    std::string reply;
+    CHECK(client.request(AGENT_LOOKUP, "mail", status, reply) && status == AGENT_OK && reply == "hunter2");
+    CHECK(client.request(AGENT_LOOKUP, "none", status, reply) && status == AGENT_NOT_FOUND);
+
+    // Generated passwords come from getrandom(), byte by byte
+    uint64_t before = randomCalls;
+    char length = 20;
+    CHECK(client.request(AGENT_GENERATE, std::string_view(&length, 1), status, reply) && status == AGENT_OK);
+    CHECK(reply.size() == 20 && randomCalls > before);
+    scriptedByte = 27;  // 'B'
+    scripted = true;
+    CHECK(client.request(AGENT_GENERATE, std::string_view(&length, 1), status, reply) && status == AGENT_OK);
+    CHECK(reply == std::string(20, 'B'));
+    scripted = false;
+    std::string other;
+    CHECK(client.request(AGENT_GENERATE, std::string_view(&length, 1), status, reply) &&
+          client.request(AGENT_GENERATE, std::string_view(&length, 1), status, other) && reply != other);
+
+    length = AGENT_MAX_GENERATE + 1;
+    CHECK(client.request(AGENT_GENERATE, std::string_view(&length, 1), status, reply) && status == AGENT_BAD_REQUEST);
+
+    client.close();
+    server.wake();
+    serving.join();
+    server.close();
+}
+
+// As tools/passgen_agent.cpp: another process's commit makes run() return,
+// and the reload sees the new entry
+static void WatchedJournal() {
+    Vault vault;
+    vault.append("mail", "hunter2", 0);
+    CHECK(saveVault(vault, "agent_watch.dat"));
+    std::string journalPath = journalPathFor("agent_watch.dat");
+    remove(journalPath.c_str());  // From an earlier run
+    VaultJournal writer;
+    CHECK(writer.open(vault, journalPath.c_str()));
+
+    AgentServer server;
+    VaultWatcher watcher;
+    CHECK(server.listen("agent_watch.sock"));
+    CHECK(watcher.watch(journalPath) && server.watch(watcher.descriptor()));
+    watcher.changed();
+    std::thread serving([&]() { server.run(); });
+    CHECK(writer.add("bank", "secret", 0) && writer.commit());
+    serving.join();
+    CHECK(watcher.changed());
+
+    Vault reloaded;
+    CHECK(loadVault(reloaded, "agent_watch.dat") && VaultJournal::replay(reloaded, journalPath.c_str()));
+    CHECK(reloaded.size() == 2 && reloaded.serviceNames[1] == "bank");
+    writer.close();
+    server.close();
+}
+
+int main() {
+    Serve();
+    WatchedJournal();
+    return TestResult("agent_test");
+}
@@ -0,0 +1,141 @@
+// Backup stream: round trips with and without compression, rejection of
+// truncated or damaged streams, and restoring into the vault file, which a
+// bad backup must leave as it was (src/vault_backup.h).
+
+#include "../src/vault_backup.h"
+#include "test_support.h"
+#include <random>
+#include <string>
+#include <vector>
+
+static const char* BACKUP_PATH = "backup_test.pgb";
+static const char* VAULT_PATH = "backup_test.dat";
+
+// Times and any bytes in names and passwords: the stream holds what the
+// library does, not only what the vault file can
+static Vault MakeVault(size_t entries, unsigned seed) {
+    Vault vault;
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < entries; i++) {
+        std::string password;
+        for (int j = 0; j < 8 + (int)(rng() % 24); j++) password += (char)(33 + rng() % 94);
+        vault.append("service-" + std::to_string(i) + ".example.com", std::move(password), 1700000000 + (int64_t)i);
+    }
+    return vault;
+}
+
+static bool WriteBackup(const Vault& vault, bool compress) {
+    FILE* out = fopen(BACKUP_PATH, "wb");
+    if (!out) return false;
+    bool ok = exportVault(vault, out, compress);
+    return fclose(out) == 0 && ok;
+}
+
+// Entries of the backup at path, false with an error as the reader gives it
+static bool ReadBackup(const char* path, Vault& vault, std::string& error) {
+    FILE* in = fopen(path, "rb");
+    if (!in) return false;
+    BackupReader reader;
+    bool ok = reader.read(in, [&](std::string& name, std::string& password, int64_t modified) {
+        vault.append(std::move(name), std::move(password), modified);
+    });
+    fclose(in);
+    error = reader.error();
+    return ok;
+}
+
+static void RoundTrips() {
+    for (bool compress : {false, true}) {
+        for (size_t entries : {(size_t)0, (size_t)1, (size_t)20000}) {
+            Vault saved = MakeVault(entries, (unsigned)entries);
+            saved.append("name|with bar", "line\nbreak", 0);
+            CHECK(WriteBackup(saved, compress));
+            Vault read;
+            std::string error;
+            CHECK(ReadBackup(BACKUP_PATH, read, error));
+            CHECK(read.serviceNames == saved.serviceNames && read.passwords == saved.passwords);
+            CHECK(read.modifiedAt == saved.modifiedAt);
+        }
+    }
+
+    // Compression pays off on a typical library
+    Vault vault = MakeVault(20000, 1);
+    CHECK(WriteBackup(vault, false));
+    size_t plain = ReadFile(BACKUP_PATH).size();
+    CHECK(WriteBackup(vault, true));
+    CHECK(ReadFile(BACKUP_PATH).size() < plain);
+}
+
+// Every prefix, and every byte flipped, is rejected
+static void DamagedStreams() {
+    for (bool compress : {false, true}) {
+        Vault saved = MakeVault(3000, 5);  // A few frames
+        CHECK(WriteBackup(saved, compress));
+        std::vector<uint8_t> stream = ReadFile(BACKUP_PATH);
+        const std::string damagedPath = "backup_test_damaged.pgb";
+
+        int accepted = 0;
+        for (size_t size = 0; size < stream.size(); size += 1 + size / 64) {
+            WriteFile(damagedPath, stream, size);
+            Vault read;
+            std::string error;
+            if (ReadBackup(damagedPath.c_str(), read, error)) accepted++;
+        }
+        for (size_t size = stream.size() - 64; size < stream.size(); size++) {
+            WriteFile(damagedPath, stream, size);
+            Vault read;
+            std::string error;
+            if (ReadBackup(damagedPath.c_str(), read, error)) accepted++;
+        }
+        CHECK(accepted == 0);
+
+        // Headers of every frame, and a sample of the stored bytes
+        accepted = 0;
+        for (size_t i = 0; i < stream.size(); i += (i < 8 + BACKUP_FRAME_HEADER || i + 64 > stream.size()) ? 1 : 97) {
+            std::vector<uint8_t> damaged = stream;
+            damaged[i] ^= 0xFF;
+            WriteFile(damagedPath, damaged);
+            Vault read;
+            std::string error;
+            if (ReadBackup(damagedPath.c_str(), read, error)) {
+                if (accepted++ == 0) fprintf(stderr, "  flipped byte %zu accepted\n", i);
+            }
+        }
+        CHECK(accepted == 0);
+    }
+}
+
+static void Restore() {
+    // Entries the vault file can't hold are skipped
+    Vault saved = MakeVault(5000, 9);
+    saved.append("name|with bar", "secret", 0);
+    saved.append("name", "line\nbreak", 0);
+    CHECK(WriteBackup(saved, true));
+    FILE* in = fopen(BACKUP_PATH, "rb");
+    RestoreResult result = restoreBackup(in, VAULT_PATH);
+    fclose(in);
+    CHECK(result.ok);
+    CHECK(result.restored == 5000 && result.skipped == 2);
+    Vault restored;
+    CHECK(loadVault(restored, VAULT_PATH));
+    saved.truncate(5000);
+    CHECK(restored.serviceNames == saved.serviceNames && restored.passwords == saved.passwords);
+
+    // A cut off backup leaves the vault file alone
+    std::vector<uint8_t> before = ReadFile(VAULT_PATH);
+    std::vector<uint8_t> stream = ReadFile(BACKUP_PATH);
+    WriteFile(BACKUP_PATH, stream, stream.size() / 2);
+    in = fopen(BACKUP_PATH, "rb");
+    result = restoreBackup(in, VAULT_PATH);
+    fclose(in);
+    CHECK(!result.ok);
+    CHECK(ReadFile(VAULT_PATH) == before);
+    CHECK(!std::filesystem::exists(std::string(VAULT_PATH) + ".tmp"));
+}
+
+int main() {
+    RoundTrips();
+    DamagedStreams();
+    Restore();
+    return TestResult("backup_test");
+}
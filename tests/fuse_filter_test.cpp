@@ -0,0 +1,127 @@
+// Binary fuse filters: every key is found, few others are, tiny shards
+// work, and a sharded set round-trips through its file. Truncated files and
+// shard parameters that would put slots outside the array are rejected
+// (src/fuse_filter.h).
+
+#include "../src/fuse_filter.h"
+#include "test_support.h"
+#include <algorithm>
+#include <vector>
+
+static const char* FILTER_PATH = "fuse_filter_test.bin";
+
+// Distinct keys, sorted so they are grouped by shard
+static std::vector<uint64_t> MakeKeys(size_t count, uint64_t seed) {
+    std::vector<uint64_t> keys(count);
+    for (uint64_t& key : keys) {
+        seed += 0x9E3779B97F4A7C15ULL;
+        key = BinaryFuse8::murmur64(seed);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+static bool ContainsAll(const FuseFilterSet& filter, const std::vector<uint64_t>& keys) {
+    for (uint64_t key : keys) {
+        if (!filter.mayContain(key)) return false;
+    }
+    return true;
+}
+
+static FuseFilterSet Build(const std::vector<uint64_t>& keys, uint32_t shardBits) {
+    FuseFilterSet filter;
+    filter.shardBits = shardBits;
+    filter.sourceCount = keys.size();
+    filter.shards.resize((size_t)1 << shardBits);
+    size_t next = 0;
+    for (uint32_t shard = 0; shard < filter.shards.size(); shard++) {
+        size_t first = next;
+        while (next < keys.size() && filter.shardOf(keys[next]) == shard) next++;
+        CHECK(filter.shards[shard].populate(keys.data() + first, (uint32_t)(next - first)));
+    }
+    return filter;
+}
+
+static void Membership() {
+    for (size_t count : {(size_t)0, (size_t)1, (size_t)2, (size_t)3, (size_t)100, (size_t)200000}) {
+        std::vector<uint64_t> keys = MakeKeys(count, count);
+        BinaryFuse8 filter;
+        CHECK(filter.populate(keys.data(), (uint32_t)keys.size()));
+        bool all = true;
+        for (uint64_t key : keys) all = all && filter.contains(key);
+        CHECK(all);
+    }
+
+    // About 1/256 of other keys pass
+    std::vector<uint64_t> keys = MakeKeys(200000, 1);
+    FuseFilterSet filter = Build(keys, 3);
+    CHECK(ContainsAll(filter, keys));
+    std::vector<uint64_t> others = MakeKeys(200000, 2);
+    size_t passed = 0;
+    for (uint64_t key : others) passed += filter.mayContain(key) && !std::binary_search(keys.begin(), keys.end(), key);
+    CHECK(passed < others.size() / 100);
+}
+
+static void Files() {
+    std::vector<uint64_t> keys = MakeKeys(3000, 3);
+    FuseFilterSet saved = Build(keys, 2);
+    CHECK(saved.save(FILTER_PATH));
+    FuseFilterSet loaded;
+    CHECK(loaded.load(FILTER_PATH));
+    CHECK(loaded.shardBits == 2 && loaded.sourceCount == keys.size() && loaded.shards.size() == 4);
+    CHECK(ContainsAll(loaded, keys));
+    bool same = loaded.shards.size() == saved.shards.size();
+    for (size_t i = 0; same && i < saved.shards.size(); i++) same = loaded.shards[i].fingerprints == saved.shards[i].fingerprints;
+    CHECK(same);
+
+    // Shards of no key, one and two keys
+    std::vector<uint64_t> few = {1, 2, 0x8000000000000000ULL};
+    CHECK(Build(few, 1).save(FILTER_PATH) && loaded.load(FILTER_PATH));
+    CHECK(ContainsAll(loaded, few));
+    CHECK(Build(few, 4).save(FILTER_PATH) && loaded.load(FILTER_PATH));
+    CHECK(ContainsAll(loaded, few) && loaded.shards.size() == 16);
+
+    // Every prefix is rejected; a rejected file leaves no shards
+    CHECK(saved.save(FILTER_PATH));
+    std::vector<uint8_t> file = ReadFile(FILTER_PATH);
+    const char* damagedPath = "fuse_filter_test_damaged.bin";
+    int accepted = 0;
+    for (size_t size = 0; size < file.size(); size++) {
+        WriteFile(damagedPath, file, size);
+        if (loaded.load(damagedPath) || !loaded.shards.empty()) accepted++;
+    }
+    CHECK(accepted == 0);
+
+    // Header, then the parameters of the second shard
+    auto put32 = [](std::vector<uint8_t>& bytes, size_t offset, uint32_t value) { memcpy(&bytes[offset], &value, 4); };
+    auto rejected = [&](size_t offset, uint32_t value) {
+        std::vector<uint8_t> damaged = file;
+        put32(damaged, offset, value);
+        WriteFile(damagedPath, damaged);
+        return !loaded.load(damagedPath) && loaded.shards.empty();
+    };
+    uint32_t segmentLength = saved.shards[1].segmentLength;
+    uint32_t segmentCount = saved.shards[1].segmentCount;
+    const size_t params = 24 + 24 + 8;
+    CHECK(rejected(0, 0));
+    CHECK(rejected(8, 17));                            // shardBits
+    CHECK(rejected(params, 0));                        // segmentLength
+    CHECK(rejected(params, segmentLength + 1));        // Not a power of two
+    CHECK(rejected(params, 524288));                   // Larger than allocate() makes
+    CHECK(rejected(params + 4, 0));                    // segmentCount
+    CHECK(rejected(params + 4, segmentCount + 1));     // Slots past the array
+    CHECK(rejected(params + 4, 0xFFFFFFFF));           // Wraps in 32 bits
+    CHECK(rejected(params + 8, saved.shards[1].arrayLength - 1));
+    std::vector<uint8_t> grown = file;
+    put32(grown, params, segmentLength * 2);
+    put32(grown, params + 8, (segmentCount + 2) * segmentLength * 2);  // Consistent, but the data runs out
+    WriteFile(damagedPath, grown);
+    CHECK(!loaded.load(damagedPath) && loaded.shards.empty());
+}
+
+int main() {
+    Membership();
+    Files();
+    return TestResult("fuse_filter_test");
+}
@@ -0,0 +1,161 @@
+// Import: CSV exports found by header name, quoting, line breaks and byte
+// order marks, records across read chunks; JSON exports of Bitwarden and
+// plain arrays with escapes. A rejected export leaves the vault and its
+// journal as they were (src/vault_import.h).
+
+#include "../src/vault_import.h"
+#include "test_support.h"
+#include <string>
+#include <vector>
+
+static const char* VAULT_PATH = "import_test.dat";
+
+static Vault MakeVault() {
+    Vault vault;
+    vault.append("existing", "entry", 0);
+    return vault;
+}
+
+static ImportResult Import(Vault& vault, const char* path, const std::string& text, VaultJournal* journal = nullptr) {
+    WriteFile(path, text);
+    return importVault(vault, journal, path);
+}
+
+static bool EntryIs(const Vault& vault, size_t index, const char* name, const char* password) {
+    return index < vault.size() && vault.serviceNames[index] == name && vault.passwords[index] == password;
+}
+
+static void Csv() {
+    // Bitwarden: name before the password, columns in between skipped
+    Vault vault = MakeVault();
+    ImportResult result = Import(vault, "bitwarden.csv",
+                                 "folder,favorite,type,name,notes,fields,reprompt,login_uri,login_username,login_password,login_totp\n"
+                                 ",,login,Mail,\"a note, with comma\",,0,https://mail.example.com,me,hunter2,\n"
+                                 ",,login,\"Quoted \"\"name\"\"\",\"two\nline note\",,0,,me,\"p,w\",\n"
+                                 ",,note,Secure note,text,,0,,,,\n");
+    CHECK(result.ok && result.imported == 2 && result.skipped == 1);
+    CHECK(vault.size() == 3);
+    CHECK(EntryIs(vault, 1, "Mail", "hunter2"));
+    CHECK(EntryIs(vault, 2, "Quoted \"name\"", "p,w"));
+
+    // Chrome: CRLF, a byte order mark, the URL for a missing name
+    vault = MakeVault();
+    result = Import(vault, "chrome.csv",
+                    "\xEF\xBB\xBFname,url,username,password\r\n"
+                    "Bank,https://bank.example.com,me,secret\r\n"
+                    ",https://shop.example.com,me,other\r\n"
+                    "a|b,https://x.example.com,me,pipe|in password");
+    CHECK(result.ok && result.imported == 3 && result.skipped == 0);
+    CHECK(EntryIs(vault, 1, "Bank", "secret"));
+    CHECK(EntryIs(vault, 2, "https://shop.example.com", "other"));
+    CHECK(EntryIs(vault, 3, "a/b", "pipe|in password"));
+
+    // A name with a line break is kept on one line; a password with one can't be stored
+    vault = MakeVault();
+    result = Import(vault, "breaks.csv", "title,password\n\"two\nlines\",fine\nname,\"two\r\nlines\"\n");
+    CHECK(result.ok && result.imported == 1 && result.skipped == 1);
+    CHECK(EntryIs(vault, 1, "two lines", "fine"));
+
+    // Names the library's editor can't hold are cut, not inside a UTF-8 sequence
+    std::string longName = std::string(MAX_SERVICE_NAME - 1, 'n') + "\xC3\xA9" + "tail";
+    vault = MakeVault();
+    result = Import(vault, "long.csv", "name,password\n" + longName + ",secret\nshort,other\n");
+    CHECK(result.ok && result.imported == 2 && result.shortened == 1);
+    CHECK(EntryIs(vault, 1, std::string(MAX_SERVICE_NAME - 1, 'n').c_str(), "secret"));
+
+    // Records, and a quoted field, across the 64 KB read chunks
+    std::string big = "name,password\n";
+    size_t rows = 0;
+    while (big.size() < 3 * IMPORT_CHUNK_SIZE) {
+        big += "service-" + std::to_string(rows) + ",\"pass,\"\"word\"\"-" + std::to_string(rows) + "\"\n";
+        rows++;
+    }
+    vault = MakeVault();
+    result = Import(vault, "big.csv", big);
+    CHECK(result.ok && result.imported == rows && result.bytes == big.size());
+    bool same = vault.size() == rows + 1;
+    for (size_t i = 0; same && i < rows; i++) {
+        same = EntryIs(vault, i + 1, ("service-" + std::to_string(i)).c_str(), ("pass,\"word\"-" + std::to_string(i)).c_str());
+    }
+    CHECK(same);
+
+    // Rejected: the vault keeps its entries
+    vault = MakeVault();
+    result = Import(vault, "nopassword.csv", "name,url\nMail,https://mail.example.com\n");
+    CHECK(!result.ok && result.imported == 0 && vault.size() == 1);
+    result = Import(vault, "unterminated.csv", "name,password\nMail,\"secret\nBank,other\n");
+    CHECK(!result.ok && result.imported == 0 && vault.size() == 1);
+    CHECK(EntryIs(vault, 0, "existing", "entry"));
+}
+
+static void Json() {
+    const std::string bitwarden =
+        "{\"encrypted\": false, \"folders\": [], \"items\": ["
+        "{\"id\": \"1\", \"type\": 1, \"name\": \"Mail\", \"notes\": null, \"favorite\": false,"
+        " \"fields\": [{\"name\": \"pin\", \"value\": \"1234\"}],"
+        " \"login\": {\"uris\": [{\"uri\": \"https://mail.example.com\"}], \"username\": \"me\", \"password\": \"hunter2\"}},"
+        "{\"id\": \"2\", \"type\": 2, \"name\": \"Note\", \"secureNote\": {\"type\": 0}},"
+        "{\"id\": \"3\", \"type\": 1, \"name\": \"Esc\\\"aped\\\\ \\u00e9\\ud83d\\ude00\", \"login\": {\"password\": \"tab\\there\"}},"
+        "{\"id\": \"4\", \"type\": 1, \"name\": \"a|b\", \"login\": {\"password\": \"line\\nbreak\"}}"
+        "]}";
+    Vault vault = MakeVault();
+    ImportResult result = Import(vault, "bitwarden.json", bitwarden);
+    CHECK(result.ok && result.imported == 2 && result.skipped == 2);
+    CHECK(EntryIs(vault, 1, "Mail", "hunter2"));
+    CHECK(EntryIs(vault, 2, "Esc\"aped\\ \xC3\xA9\xF0\x9F\x98\x80", "tab\there"));
+
+    const std::string array = " [{\"title\": \"Bank\", \"password\": \"secret\", \"n\": [1, 2.5e3, true, null]},"
+                              " {\"name\": \"a|b\", \"password\": \"x\"}]";
+    vault = MakeVault();
+    result = Import(vault, "array.json", array);
+    CHECK(result.ok && result.imported == 2);
+    CHECK(EntryIs(vault, 1, "Bank", "secret"));
+    CHECK(EntryIs(vault, 2, "a/b", "x"));
+
+    // Every truncation is rejected and leaves the vault alone
+    for (const std::string* text : {&bitwarden, &array}) {
+        int accepted = 0;
+        for (size_t size = 1; size < text->size(); size++) {
+            vault = MakeVault();
+            result = Import(vault, "truncated.json", text->substr(0, size));
+            if (result.ok || result.imported != 0 || vault.size() != 1) {
+                if (accepted++ == 0) fprintf(stderr, "  truncated at %zu accepted\n", size);
+            }
+        }
+        CHECK(accepted == 0);
+    }
+    vault = MakeVault();
+    CHECK(!Import(vault, "trailing.json", array + "]").ok && vault.size() == 1);
+    CHECK(!Import(vault, "two.json", array + array).ok && vault.size() == 1);
+    CHECK(!Import(vault, "empty.json", "").ok && !Import(vault, "blank.json", " \n").ok && vault.size() == 1);
+    CHECK(!Import(vault, "bad_escape.json", "[{\"name\": \"\\x\", \"password\": \"p\"}]").ok && vault.size() == 1);
+}
+
+// With a journal: one commit on success, nothing on failure
+static void Journal() {
+    std::string journalPath = journalPathFor(VAULT_PATH);
+    remove(journalPath.c_str());
+    Vault vault = MakeVault();
+    CHECK(saveVault(vault, VAULT_PATH));
+    VaultJournal journal;
+    CHECK(journal.open(vault, journalPath.c_str()));
+
+    uint64_t before = journal.size();
+    ImportResult result = Import(vault, "journal.csv", "name,password\nMail,\"secret\nBank,other\n", &journal);
+    CHECK(!result.ok && vault.size() == 1 && journal.size() == before);
+
+    result = Import(vault, "journal.csv", "name,password\nMail,secret\nBank,other\n", &journal);
+    CHECK(result.ok && result.imported == 2 && journal.size() > before);
+    journal.close();
+
+    Vault replayed;
+    CHECK(loadVault(replayed, VAULT_PATH) && VaultJournal::replay(replayed, journalPath.c_str()));
+    CHECK(replayed.serviceNames == vault.serviceNames && replayed.passwords == vault.passwords);
+}
+
+int main() {
+    Csv();
+    Json();
+    Journal();
+    return TestResult("import_test");
+}
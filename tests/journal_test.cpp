@@ -0,0 +1,204 @@
+// Journal: committed batches replay on top of the vault file; a cut off or
+// damaged journal replays the batches before the damage and nothing after; entry
+// history survives compaction and restart(); another handle merges the
+// batches (src/vault_journal.h).
+
+#include "../src/vault_journal.h"
+#include "test_support.h"
+#include <string>
+#include <vector>
+
+static const char* VAULT_PATH = "journal_test.dat";
+static const char* COPY_PATH = "journal_test_copy.dat";
+
+struct Entries {
+    std::vector<std::string> names;
+    std::vector<std::string> passwords;
+};
+
+static Entries Snapshot(const Vault& vault) { return {vault.serviceNames, vault.passwords}; }
+
+static bool Same(const Vault& vault, const Entries& entries) {
+    return vault.serviceNames == entries.names && vault.passwords == entries.passwords;
+}
+
+static Vault MakeVault(size_t entries) {
+    Vault vault;
+    for (size_t i = 0; i < entries; i++) vault.append("service-" + std::to_string(i), "password-" + std::to_string(i), 0);
+    return vault;
+}
+
+// A vault file and a journal of three committed batches of every kind of
+// edit, then one left uncommitted. states[k] is the library after batch k;
+// ends[k] where batch k ends in the journal.
+struct Fixture {
+    std::vector<Entries> states;
+    std::vector<uint64_t> ends;
+};
+
+static Fixture WriteFixture() {
+    Fixture fixture;
+    std::string journalPath = journalPathFor(VAULT_PATH);
+    remove(journalPath.c_str());
+    Vault vault = MakeVault(10);
+    CHECK(saveVault(vault, VAULT_PATH));
+    VaultJournal journal;
+    CHECK(journal.open(vault, journalPath.c_str()));
+    fixture.states.push_back(Snapshot(vault));
+    fixture.ends.push_back(journal.size());
+
+    for (int i = 0; i < 3; i++) {
+        std::string name = "added-" + std::to_string(i);
+        CHECK(journal.add(name, "new", 100 + i));
+        vault.append(std::move(name), "new", 100 + i);
+    }
+    CHECK(journal.commit());
+    fixture.states.push_back(Snapshot(vault));
+    fixture.ends.push_back(journal.size());
+
+    CHECK(journal.replace(2, "renamed", "changed", 200));
+    vault.replace(2, "renamed", "changed", 200);
+    CHECK(journal.insert(0, "first", "inserted", 201));
+    vault.insert(0, "first", "inserted", 201);
+    CHECK(journal.erase(5));
+    vault.erase(5);
+    CHECK(journal.commit());
+    fixture.states.push_back(Snapshot(vault));
+    fixture.ends.push_back(journal.size());
+
+    CHECK(journal.truncate(8));
+    vault.truncate(8);
+    CHECK(journal.commit());
+    fixture.states.push_back(Snapshot(vault));
+    fixture.ends.push_back(journal.size());
+
+    CHECK(journal.add("never", "committed", 0));
+    return fixture;
+}
+
+// Open a copy of the vault file with the given journal bytes; the state it
+// replays to, or -1
+static int OpenCopy(const Fixture& fixture, const std::vector<uint8_t>& journalBytes, size_t size, bool& opened) {
+    std::filesystem::copy_file(VAULT_PATH, COPY_PATH, std::filesystem::copy_options::overwrite_existing);
+    std::string journalPath = journalPathFor(COPY_PATH);
+    WriteFile(journalPath, journalBytes, size);
+
+    // A reader that only replays must agree with open()
+    Vault replayed;
+    bool loaded = loadVault(replayed, COPY_PATH) && VaultJournal::replay(replayed, journalPath.c_str());
+    Vault vault;
+    VaultJournal journal;
+    opened = loaded && loadVault(vault, COPY_PATH) && journal.open(vault, journalPath.c_str());
+    for (size_t k = 0; k < fixture.states.size(); k++) {
+        if (Same(vault, fixture.states[k])) return Same(replayed, fixture.states[k]) ? (int)k : -1;
+    }
+    return -1;
+}
+
+// The last batch that ends at or before offset
+static int BatchesBefore(const Fixture& fixture, uint64_t offset) {
+    int k = 0;
+    while (k + 1 < (int)fixture.ends.size() && fixture.ends[k + 1] <= offset) k++;
+    return k;
+}
+
+static void Replay() {
+    Fixture fixture = WriteFixture();
+    std::vector<uint8_t> journal = ReadFile(journalPathFor(VAULT_PATH));
+    bool opened;
+    CHECK(OpenCopy(fixture, journal, journal.size(), opened) == 3);
+    CHECK(opened);
+
+    // Cut off anywhere: the batches completed before the cut
+    int wrong = 0;
+    for (size_t size = 0; size <= journal.size(); size++) {
+        int expected = size < VaultJournal::HEADER_SIZE ? 0 : BatchesBefore(fixture, size);
+        if (OpenCopy(fixture, journal, size, opened) != expected || !opened) wrong++;
+    }
+    CHECK(wrong == 0);
+
+    // A damaged record ends the journal there
+    wrong = 0;
+    for (size_t i = VaultJournal::HEADER_SIZE; i < journal.size(); i++) {
+        std::vector<uint8_t> damaged = journal;
+        damaged[i] ^= 0xFF;
+        int expected = BatchesBefore(fixture, i);
+        if (OpenCopy(fixture, damaged, damaged.size(), opened) != expected || !opened) {
+            if (wrong++ == 0) fprintf(stderr, "  flipped byte %zu: not batch %d\n", i, expected);
+        }
+    }
+    CHECK(wrong == 0);
+
+    // A journal of another vault file is ignored
+    std::vector<uint8_t> stale = journal;
+    stale[8] ^= 1;
+    CHECK(OpenCopy(fixture, stale, stale.size(), opened) == 0);
+    CHECK(opened);
+}
+
+// Earlier versions are found after reopening, compaction and restart()
+static void History() {
+    std::string journalPath = journalPathFor(VAULT_PATH);
+    remove(journalPath.c_str());
+    Vault vault = MakeVault(3);
+    CHECK(saveVault(vault, VAULT_PATH));
+    VaultJournal journal;
+    CHECK(journal.open(vault, journalPath.c_str()));
+    CHECK(journal.addHistory("service-1", "password-1", 50, "service-1", "changed"));
+    CHECK(journal.replace(1, "service-1", "changed", 60));
+    vault.replace(1, "service-1", "changed", 60);
+    CHECK(journal.commit());
+
+    auto previousIs = [](VaultJournal& journal, const char* password) {
+        HistoryVersion version;
+        return journal.previousVersion("service-1", "changed", version) && version.serviceName == "service-1" &&
+               version.password == password && version.modifiedAt == 50;
+    };
+    CHECK(previousIs(journal, "password-1"));
+
+    journal.close();
+    Vault reopened;
+    CHECK(loadVault(reopened, VAULT_PATH) && journal.open(reopened, journalPath.c_str()));
+    CHECK(Same(reopened, Snapshot(vault)));
+    CHECK(previousIs(journal, "password-1"));
+
+    // Compaction: the vault file takes the edit, the journal keeps the history
+    CHECK(saveVault(reopened, VAULT_PATH) && journal.reset(reopened));
+    CHECK(journal.historySize() == 1);
+    CHECK(previousIs(journal, "password-1"));
+
+    // Another handle sees the fresh start; after restart() as well
+    Vault other;
+    VaultJournal otherJournal;
+    CHECK(loadVault(other, VAULT_PATH) && otherJournal.open(other, journalPath.c_str()));
+    CHECK(journal.add("appended", "entry", 0) && journal.commit());
+    reopened.append("appended", "entry", 0);
+    CHECK(otherJournal.merge(other) == MERGE_APPENDED);
+    CHECK(Same(other, Snapshot(reopened)));
+    CHECK(journal.replace(0, "service-0", "edited", 0) && journal.commit());
+    reopened.replace(0, "service-0", "edited", 0);
+    CHECK(otherJournal.merge(other) == MERGE_EDITED);
+    CHECK(Same(other, Snapshot(reopened)));
+
+    CHECK(saveVault(reopened, VAULT_PATH) && VaultJournal::restart(journalPath.c_str(), reopened.fileFingerprint));
+    CHECK(otherJournal.merge(other) == MERGE_RELOAD);
+    Vault restarted;
+    VaultJournal restartedJournal;
+    CHECK(loadVault(restarted, VAULT_PATH) && restartedJournal.open(restarted, journalPath.c_str()));
+    CHECK(Same(restarted, Snapshot(reopened)));
+    CHECK(previousIs(restartedJournal, "password-1"));
+
+    // A damaged history record is reported, not misread
+    restartedJournal.close();
+    std::vector<uint8_t> bytes = ReadFile(journalPath);
+    bytes[bytes.size() - 20] ^= 0xFF;  // Inside the only HISTORY record, before its COMMIT
+    WriteFile(journalPath, bytes);
+    CHECK(loadVault(restarted, VAULT_PATH) && restartedJournal.open(restarted, journalPath.c_str()));
+    CHECK(!previousIs(restartedJournal, "password-1"));
+}
+
+int main() {
+    Replay();
+    History();
+    return TestResult("journal_test");
+}
@@ -0,0 +1,135 @@
+// LZ4 blocks: round trips with and without a dictionary, matches reaching
+// back into the dictionary, and rejection of truncated blocks, a wrong raw
+// size and a missing dictionary. Garbage must fail without writing past the
+// output (src/lz4_block.h).
+
+#include "../src/lz4_block.h"
+#include "test_support.h"
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+static Bytes VaultLines(size_t lines, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::string text;
+    for (size_t i = 0; i < lines; i++) {
+        text += "service-" + std::to_string(rng() % 100000) + ".example.com|";
+        for (int j = 0; j < 16; j++) text += (char)('a' + rng() % 26);
+        text += '\n';
+    }
+    return Bytes(text.begin(), text.end());
+}
+
+static Bytes Random(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    Bytes bytes(size);
+    for (uint8_t& b : bytes) b = (uint8_t)rng();
+    return bytes;
+}
+
+static Bytes Compress(const Bytes& src, const Bytes& dict = Bytes()) {
+    Lz4Block lz4;
+    Bytes block(Lz4Block::bound(src.size()));
+    block.resize(lz4.compress(src.data(), src.size(), block.data(), dict.data(), dict.size()));
+    return block;
+}
+
+// Decompresses into a buffer of exactly rawSize bytes
+static bool Decompress(const Bytes& block, size_t size, size_t rawSize, Bytes& out, const Bytes& dict = Bytes()) {
+    out.assign(rawSize, 0);
+    return Lz4Block::decompress(block.data(), size, out.data(), rawSize, dict.data(), dict.size());
+}
+
+static bool RoundTrips(const Bytes& src, const Bytes& dict = Bytes()) {
+    Bytes block = Compress(src, dict);
+    Bytes out;
+    return block.size() <= Lz4Block::bound(src.size()) && Decompress(block, block.size(), src.size(), out, dict) &&
+           out == src;
+}
+
+static void RoundTrips() {
+    CHECK(RoundTrips(Bytes()));
+    CHECK(RoundTrips(Bytes(1, 'x')));
+    CHECK(RoundTrips(Bytes(12, 'x')));  // Too short for a match
+    CHECK(RoundTrips(Bytes(13, 'x')));
+    CHECK(RoundTrips(Random(10000, 1)));
+    CHECK(RoundTrips(Bytes(300000, 0)));  // Overlapping matches, long lengths
+
+    Bytes lines = VaultLines(5000, 2);
+    CHECK(RoundTrips(lines));
+    CHECK(Compress(lines).size() < lines.size() * 3 / 4);
+
+    // Longer repeats than a 16-bit offset reaches
+    Bytes far = Random(70000, 3);
+    far.insert(far.end(), far.begin(), far.begin() + 1000);
+    CHECK(RoundTrips(far));
+}
+
+static void Dictionaries() {
+    Bytes dict = VaultLines(500, 4);
+    Bytes lines = VaultLines(200, 5);
+    CHECK(RoundTrips(lines, dict));
+    CHECK(Compress(lines, dict).size() < Compress(lines).size());
+
+    // Matches that start in the dictionary and run on into the output
+    Bytes pattern;
+    for (int i = 0; i < 4000; i++) pattern.push_back((uint8_t)(i % 251));
+    Bytes repeated(pattern.begin() + 100, pattern.end());
+    CHECK(RoundTrips(repeated, pattern));
+    CHECK(Compress(repeated, pattern).size() < 64);
+
+    // Only the last MAX_OFFSET bytes of a larger dictionary are used
+    Bytes large = Random(100000, 6);
+    Bytes tail(large.end() - 2000, large.end());
+    CHECK(RoundTrips(tail, large));
+    CHECK(Compress(tail, large).size() < 64);
+    Bytes head(large.begin(), large.begin() + 2000);
+    CHECK(RoundTrips(head, large));
+
+    // Without the dictionary, or with another one, the block doesn't decode
+    Bytes block = Compress(dict, dict);
+    Bytes out;
+    CHECK(!Decompress(block, block.size(), dict.size(), out));
+    Bytes other = VaultLines(500, 7);
+    CHECK(!Decompress(block, block.size(), dict.size(), out, other) || out != dict);
+}
+
+static void DamagedBlocks() {
+    Bytes dict = VaultLines(500, 8);
+    Bytes src = VaultLines(2000, 9);
+    for (const Bytes& d : {Bytes(), dict}) {
+        Bytes block = Compress(src, d);
+        Bytes out;
+        int accepted = 0;
+        for (size_t size = 0; size < block.size(); size++) {
+            if (Decompress(block, size, src.size(), out, d)) accepted++;
+        }
+        CHECK(accepted == 0);
+        CHECK(!Decompress(block, block.size(), src.size() - 1, out, d));
+        CHECK(!Decompress(block, block.size(), src.size() + 1, out, d));
+
+        // A flipped byte fails or decodes to other bytes, never past the output
+        for (size_t i = 0; i < block.size(); i += 7) {
+            Bytes damaged = block;
+            damaged[i] ^= 0xFF;
+            Decompress(damaged, damaged.size(), src.size(), out, d);
+        }
+    }
+
+    int accepted = 0;
+    for (unsigned seed = 0; seed < 2000; seed++) {
+        Bytes garbage = Random(1 + seed % 300, seed);
+        Bytes out;
+        if (Decompress(garbage, garbage.size(), seed % 1000, out, seed % 2 ? dict : Bytes())) accepted++;
+    }
+    CHECK(accepted < 20);
+}
+
+int main() {
+    RoundTrips();
+    Dictionaries();
+    DamagedBlocks();
+    return TestResult("lz4_test");
+}
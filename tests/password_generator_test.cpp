@@ -0,0 +1,99 @@
+// Password generator: every character comes from the OS's random source
+// through fillRandom(), not from a seeded engine, and is mapped without
+// bias; batches meet the policy (src/password_generator.h).
+//
+// On Linux the test defines getrandom() itself, ahead of the C library's,
+// so it sees and can script every byte the generator draws.
+
+#include "../src/password_generator.h"
+#include "test_support.h"
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <sys/syscall.h>
+    #include <unistd.h>
+
+// Scripted: bytes cycle through scriptedBytes from the start; otherwise the real call
+static std::vector<uint8_t> scriptedBytes;
+static size_t scriptedNext = 0;
+static uint64_t randomCalls = 0;
+
+extern "C" ssize_t getrandom(void* buffer, size_t size, unsigned int flags) {
+    randomCalls++;
+    if (scriptedBytes.empty()) return syscall(SYS_getrandom, buffer, size, flags);
+    uint8_t* out = (uint8_t*)buffer;
+    for (size_t i = 0; i < size; i++) out[i] = scriptedBytes[scriptedNext++ % scriptedBytes.size()];
+    return (ssize_t)size;
+}
+
+static void DrawsFromTheOs() {
+    PasswordGenerator generator;
+    uint64_t before = randomCalls;
+    std::string password = generator.generate(16);
+    CHECK(password.size() == 16);
+    CHECK(randomCalls > before);
+
+    // The character is the byte modulo the set of 70
+    auto script = [](std::vector<uint8_t> bytes) {
+        scriptedBytes = std::move(bytes);
+        scriptedNext = 0;
+    };
+    script({69});
+    CHECK(generator.generate(10) == "**********");
+    script({0, 1, 2, 3});
+    CHECK(generator.generate(8) == "abcdabcd");
+
+    // Bytes from 210 on would favour the first characters, and are skipped
+    script({255, 210, 0});
+    CHECK(generator.generate(30) == std::string(30, 'a'));
+
+    script({0, 26, 52, 62});  // a, A, 0, !
+    std::vector<std::string> batch;
+    before = randomCalls;
+    generator.generateBatch(batch, 3, 8);
+    CHECK(randomCalls > before);
+    CHECK(batch.size() == 3 && batch[0] == "aA0!aA0!");
+    script({});
+}
+#endif
+
+// From the real source: passwords differ, every character turns up about
+// as often as the others, and batches meet the policy
+static void Distribution() {
+    PasswordGenerator generator;
+    const std::string set = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*";
+    size_t counts[256] = {};
+    std::string previous;
+    bool repeated = false, outside = false;
+    const int passwords = 20000, length = 35;
+    for (int i = 0; i < passwords; i++) {
+        std::string password = generator.generate(length);
+        repeated = repeated || password == previous;
+        for (char c : password) {
+            counts[(uint8_t)c]++;
+            outside = outside || set.find(c) == std::string::npos;
+        }
+        previous = std::move(password);
+    }
+    CHECK(!repeated && !outside);
+    double expected = (double)passwords * length / set.size();
+    bool even = true;
+    for (char c : set) even = even && counts[(uint8_t)c] > expected * 0.9 && counts[(uint8_t)c] < expected * 1.1;
+    CHECK(even);
+    CHECK(generator.generate(0).empty() && generator.generate(-1).empty());
+
+    std::vector<std::string> batch;
+    generator.generateBatch(batch, 1000, 8);
+    bool policy = true;
+    for (const std::string& password : batch) policy = policy && password.size() == 8 && PasswordGenerator::meetsPolicy(password);
+    CHECK(policy);
+}
+
+int main() {
+#if defined(__linux__)
+    DrawsFromTheOs();
+#endif
+    Distribution();
+    return TestResult("password_generator_test");
+}
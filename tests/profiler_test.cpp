@@ -0,0 +1,109 @@
+// Profiler ring: a reader copying events while the owning thread keeps
+// pushing, and lapping it, gets each event whole or not at all. Rings of
+// exited threads are reused, and zones of threads past MAX_THREADS are
+// counted as dropped (src/profiler.h, built with PASSGEN_PROFILE).
+
+#include "../src/profiler.h"
+#include "test_support.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static const char* NAMES[] = {"alpha", "beta", "gamma", "delta"};
+
+// Event i is {NAMES[i % 4], i, 2i}; anything else read back is torn
+static void ConcurrentReader() {
+    std::unique_ptr<ProfileRing> ring(new ProfileRing());
+    const uint64_t events = 20000000;
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for (uint64_t i = 0; i < events; i++) ring->push(NAMES[i % 4], i, 2 * i);
+        done.store(true, std::memory_order_release);
+    });
+
+    uint64_t read = 0, torn = 0, passes = 0;
+    while (!done.load(std::memory_order_acquire) || passes == 0) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t tail = head > ProfileRing::CAPACITY ? head - ProfileRing::CAPACITY : 0;
+        for (uint64_t i = tail; i < head; i++) {
+            ProfileEvent e;
+            if (!ring->read(i, e)) continue;
+            read++;
+            if (e.name != NAMES[i % 4] || e.startNs != i || e.endNs != 2 * i) torn++;
+        }
+        passes++;
+    }
+    writer.join();
+    CHECK(torn == 0);
+    CHECK(read > 0);
+
+    // Once the writer stops, the last CAPACITY events are all there
+    uint64_t complete = 0;
+    for (uint64_t i = events - ProfileRing::CAPACITY; i < events; i++) {
+        ProfileEvent e;
+        complete += ring->read(i, e) && e.startNs == i;
+    }
+    CHECK(complete == ProfileRing::CAPACITY);
+    ProfileEvent e;
+    CHECK(!ring->read(events - ProfileRing::CAPACITY - 1, e));  // Overwritten
+    CHECK(!ring->read(events, e));                              // Not written yet
+}
+
+// Zones of several threads end up in the trace
+static void Export() {
+    std::thread threads[4];
+    for (std::thread& thread : threads) {
+        thread = std::thread([]() {
+            for (int i = 0; i < 1000; i++) PROFILE_ZONE("worker");
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    CHECK(Profiler::instance().exportTrace("profiler_test.json"));
+    std::vector<uint8_t> trace = ReadFile("profiler_test.json");
+    std::string text(trace.begin(), trace.end());
+    size_t zones = 0;
+    for (size_t at = text.find("\"worker\""); at != std::string::npos; at = text.find("\"worker\"", at + 1)) zones++;
+    CHECK(zones == 4000);
+}
+
+// Threads one after another share one ring; past MAX_THREADS at once, zones
+// are dropped and counted
+static void RecycledRings() {
+    Profiler& profiler = Profiler::instance();
+    int before = profiler.ringsAllocated();
+    for (int i = 0; i < 500; i++) std::thread([]() { PROFILE_ZONE("short"); }).join();
+    CHECK(profiler.ringsAllocated() <= before + 1);
+    CHECK(profiler.droppedZones() == 0);
+
+    const int extra = 8;
+    std::mutex lock;
+    std::condition_variable allDone;
+    int finished = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < Profiler::MAX_THREADS + extra; i++) {
+        threads.emplace_back([&]() {
+            { PROFILE_ZONE("crowded"); }
+            // Keep the ring until every thread has asked for one
+            std::unique_lock<std::mutex> guard(lock);
+            finished++;
+            allDone.notify_all();
+            allDone.wait(guard, [&]() { return finished == Profiler::MAX_THREADS + extra; });
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    CHECK(profiler.ringsAllocated() == Profiler::MAX_THREADS);
+    CHECK(profiler.droppedZones() == (uint64_t)extra);
+
+    CHECK(profiler.exportTrace("profiler_test_dropped.json"));
+    std::vector<uint8_t> trace = ReadFile("profiler_test_dropped.json");
+    CHECK(std::string(trace.begin(), trace.end()).find("\"droppedZones\":8") != std::string::npos);
+}
+
+int main() {
+    ConcurrentReader();
+    Export();
+    RecycledRings();
+    return TestResult("profiler_test");
+}
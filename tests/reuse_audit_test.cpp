@@ -0,0 +1,83 @@
+// Reuse audit: the index built in bulk and the one kept up to date entry
+// by entry flag the same entries, exact duplicates and near duplicates
+// alike (src/reuse_audit.h).
+
+#include "../src/reuse_audit.h"
+#include "test_support.h"
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// Every 20th password repeats an earlier one, every 15th changes the last
+// character of one
+static std::vector<std::string> Library(size_t count) {
+    const std::string set = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*";
+    std::mt19937 rng(7);
+    std::vector<std::string> passwords;
+    for (size_t i = 0; i < count; i++) {
+        if (i % 20 == 19) {
+            passwords.push_back(passwords[rng() % i]);
+        } else if (i % 15 == 14) {
+            std::string near = passwords[rng() % i];
+            near.back() = near.back() == 'x' ? 'y' : 'x';
+            passwords.push_back(near);
+        } else {
+            std::string password;
+            for (int c = 0; c < 14; c++) password += set[rng() % set.size()];
+            passwords.push_back(password);
+        }
+    }
+    return passwords;
+}
+
+static std::vector<uint8_t> Flags(const ReuseAudit& audit, size_t count) {
+    std::vector<uint8_t> flags(count);
+    for (size_t i = 0; i < count; i++) flags[i] = audit.flags(i);
+    return flags;
+}
+
+static void BulkMatchesIncremental() {
+    std::vector<std::string> all = Library(3 * ReuseAudit::BULK_MIN);
+    std::vector<std::string> library;
+    auto passwordAt = [&](size_t i) { return std::string_view(library[i]); };
+    ReuseAudit audit;
+    uint64_t revision = 0;
+
+    // Appends and erasures under BULK_MIN each, then the whole library at once
+    for (size_t next = 0; next < all.size();) {
+        size_t batch = std::min((size_t)1000, all.size() - next);
+        library.insert(library.end(), all.begin() + next, all.begin() + next + batch);
+        next += batch;
+        audit.sync(++revision, library.size(), passwordAt);
+    }
+    for (size_t i = 100; i < 5000; i += 500) {
+        library.erase(library.begin() + i);
+        audit.sync(++revision, library.size(), passwordAt);
+    }
+    std::vector<uint8_t> incremental = Flags(audit, library.size());
+    size_t reused = audit.reusedCount(), near = audit.nearDuplicateCount();
+
+    audit.sync(++revision, 0, passwordAt);
+    CHECK(audit.reusedCount() == 0 && audit.nearDuplicateCount() == 0);
+    audit.sync(++revision, library.size(), passwordAt);
+    CHECK(Flags(audit, library.size()) == incremental);
+    CHECK(audit.reusedCount() == reused && audit.nearDuplicateCount() == near);
+
+    // Exact reuse is exactly the passwords that occur more than once
+    std::map<std::string, int> occurrences;
+    for (const std::string& password : library) occurrences[password]++;
+    bool exact = true;
+    size_t nearFlagged = 0;
+    for (size_t i = 0; i < library.size(); i++) {
+        exact = exact && ((incremental[i] & REUSE_EXACT) != 0) == (occurrences[library[i]] > 1);
+        nearFlagged += (incremental[i] & REUSE_NEAR) != 0;
+    }
+    CHECK(exact);
+    CHECK(nearFlagged >= library.size() / 15);  // Both ends of most near pairs
+}
+
+int main() {
+    BulkMatchesIncremental();
+    return TestResult("reuse_audit_test");
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Shared by the tests in this directory. Each is a program that runs its
+// cases, reports every failed CHECK() on stderr and exits with 1 if any
+// failed. ctest runs each in an empty directory of its own, so files are
+// written to the working directory.
+
+static int checkFailures = 0;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            fprintf(stderr, "FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition);        \
+            checkFailures++;                                                              \
+        }                                                                                 \
+    } while (0)
+
+// Exit status of the test
+inline int TestResult(const char* name) {
+    if (checkFailures > 0) {
+        fprintf(stderr, "%s: %d checks failed\n", name, checkFailures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+// Whole file, empty if it can't be read
+inline std::vector<uint8_t> ReadFile(const std::string& path) {
+    std::vector<uint8_t> bytes;
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return bytes;
+    uint8_t chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), in)) > 0) bytes.insert(bytes.end(), chunk, chunk + got);
+    fclose(in);
+    return bytes;
+}
+
+// The first size bytes of data as the whole file
+inline bool WriteFile(const std::string& path, const std::vector<uint8_t>& data, size_t size) {
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+    bool ok = (size == 0 || fwrite(data.data(), 1, size, out) == size);
+    return fclose(out) == 0 && ok;
+}
+
+inline bool WriteFile(const std::string& path, const std::vector<uint8_t>& data) {
+    return WriteFile(path, data, data.size());
+}
+
+inline bool WriteFile(const std::string& path, const std::string& text) {
+    return WriteFile(path, std::vector<uint8_t>(text.begin(), text.end()));
+}
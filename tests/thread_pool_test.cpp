@@ -0,0 +1,113 @@
+// Thread pool: tasks submitted by several threads, from outside the pool and
+// from its workers, each run exactly once; parallelFor covers a range once;
+// destroying a busy pool joins its workers (src/thread_pool.h).
+
+#include "../src/thread_pool.h"
+#include "test_support.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static bool WaitFor(const std::atomic<size_t>& counter, size_t target) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (counter.load() < target) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Four producers, each task submitting a second one from its worker
+static void EveryTaskOnce() {
+    const size_t producers = 4, perProducer = 20000, tasks = producers * perProducer * 2;
+    std::unique_ptr<std::atomic<uint8_t>[]> runs(new std::atomic<uint8_t>[tasks]);
+    for (size_t i = 0; i < tasks; i++) runs[i] = 0;
+    std::atomic<size_t> finished{0};
+    {
+        ThreadPool pool(3);
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; p++) {
+            threads.emplace_back([&, p]() {
+                for (size_t i = 0; i < perProducer; i++) {
+                    size_t task = (p * perProducer + i) * 2;
+                    pool.submit([&, task]() {
+                        runs[task]++;
+                        finished++;
+                        pool.submit([&, task]() {
+                            runs[task + 1]++;
+                            finished++;
+                        });
+                    });
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+        CHECK(WaitFor(finished, tasks));
+    }
+    bool once = true;
+    for (size_t i = 0; i < tasks; i++) once = once && runs[i] == 1;
+    CHECK(once);
+    CHECK(finished == tasks);
+}
+
+// Every index once, done() once after the last; the waiting form also from
+// inside a task of a one-thread pool
+static void ParallelFor() {
+    const size_t count = 100000;
+    std::unique_ptr<std::atomic<uint8_t>[]> covered(new std::atomic<uint8_t>[count]);
+    for (size_t i = 0; i < count; i++) covered[i] = 0;
+    std::atomic<size_t> dones{0};
+    {
+        ThreadPool pool(4);
+        pool.parallelFor(0, count, 64,
+            [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++) covered[i]++;
+            },
+            [&]() { dones++; });
+        CHECK(WaitFor(dones, 1));
+    }
+    bool once = true;
+    for (size_t i = 0; i < count; i++) once = once && covered[i] == 1;
+    CHECK(once && dones == 1);
+
+    ThreadPool single(1);
+    std::atomic<size_t> sum{0}, finished{0};
+    single.submit([&]() {
+        single.parallelForWait(0, 1000, 10, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) sum += i;
+        });
+        finished++;
+    });
+    CHECK(WaitFor(finished, 1));
+    CHECK(sum == 999 * 1000 / 2);
+}
+
+// The destructor returns with tasks still queued and running; queued ones
+// are dropped, none runs after it
+static void Shutdown() {
+    std::atomic<size_t> started{0};
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 10000; i++) {
+            pool.submit([&]() {
+                started++;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            });
+        }
+        CHECK(WaitFor(started, 2));
+    }
+    size_t afterJoin = started;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(started == afterJoin && afterJoin < 10000);
+
+    { ThreadPool idle(4); }  // Joins sleeping workers
+}
+
+int main() {
+    EveryTaskOnce();
+    ParallelFor();
+    Shutdown();
+    return TestResult("thread_pool_test");
+}
@@ -0,0 +1,191 @@
+// Vault file: round trips of the segmented format (version 2) with every
+// codec, the original format, and rejection of truncated or damaged files.
+// Entries the file can't hold must fail the save and leave the old file
+// (src/vault.h, and passgen_vault_add() of libpassgen). passgen_vault_load()
+// reads vaults whose lock file can't be created.
+
+#include "../include/passgen.h"
+#include "../src/vault.h"
+#include "test_support.h"
+#include <random>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+static const char* VAULT_PATH = "vault_file_test.dat";
+static const char* DAMAGED_PATH = "vault_file_test_damaged.dat";
+
+// Names and passwords as the library holds them; passwords may contain '|'
+static Vault MakeVault(size_t entries, unsigned seed) {
+    Vault vault;
+    std::mt19937 rng(seed);
+    const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*|";
+    for (size_t i = 0; i < entries; i++) {
+        std::string password;
+        for (int j = 0; j < 8 + (int)(rng() % 24); j++) password += chars[rng() % (sizeof(chars) - 1)];
+        vault.append("service-" + std::to_string(i) + ".example.com", std::move(password), 0);
+    }
+    return vault;
+}
+
+static bool SameEntries(const Vault& a, const Vault& b) {
+    return a.serviceNames == b.serviceNames && a.passwords == b.passwords;
+}
+
+static void RoundTrip(const char* label, size_t entries, const VaultFileOptions& options) {
+    Vault saved = MakeVault(entries, (unsigned)entries);
+    bool ok = saveVault(saved, VAULT_PATH, options);
+    CHECK(ok);
+    Vault loaded;
+    bool loadedOk = loadVault(loaded, VAULT_PATH);
+    CHECK(loadedOk);
+    CHECK(SameEntries(saved, loaded));
+    CHECK(loaded.fileFingerprint == saved.fileFingerprint);
+    if (!ok || !loadedOk || !SameEntries(saved, loaded)) fprintf(stderr, "  in round trip: %s\n", label);
+}
+
+// First frame after the magic, e.g. to see that a dictionary was written
+static uint8_t FirstFrameFlags(const std::vector<uint8_t>& file) {
+    return file.size() > 8 + VAULT_FRAME_HEADER ? file[8 + 8] : 0;
+}
+
+static void RoundTrips() {
+    VaultFileOptions options;
+    RoundTrip("empty", 0, options);
+    RoundTrip("one entry", 1, options);
+
+    // Enough lines to train a dictionary, in many small segments
+    options.segmentSize = 1024;
+    RoundTrip("lz4 with dictionary", 5000, options);
+    CHECK(FirstFrameFlags(ReadFile(VAULT_PATH)) & VAULT_DICTIONARY);
+
+    options.dictionary = false;
+    RoundTrip("lz4", 5000, options);
+    CHECK(!(FirstFrameFlags(ReadFile(VAULT_PATH)) & VAULT_DICTIONARY));
+
+    options.codec = CODEC_NONE;
+    RoundTrip("stored", 5000, options);
+
+    if (codecAvailable(CODEC_ZSTD)) {
+        options.codec = CODEC_ZSTD;
+        options.dictionary = true;
+        RoundTrip("zstd with dictionary", 5000, options);
+    }
+
+    // Segments larger than the dictionary sample
+    RoundTrip("default options", 20000, VaultFileOptions());
+}
+
+// The original format: one encrypted text of "name|password" lines, the
+// last possibly without a line break
+static void LegacyFormat() {
+    CHECK(WriteFile(VAULT_PATH, encrypt("mail|hunter2\r\nbank|a|b\nno bar line\nlast|x")));
+    Vault vault;
+    CHECK(loadVault(vault, VAULT_PATH));
+    CHECK(vault.size() == 3);
+    if (vault.size() == 3) {
+        CHECK(vault.serviceNames[0] == "mail" && vault.passwords[0] == "hunter2\r");
+        CHECK(vault.serviceNames[1] == "bank" && vault.passwords[1] == "a|b");
+        CHECK(vault.serviceNames[2] == "last" && vault.passwords[2] == "x");
+    }
+    CHECK(vault.fileFingerprint != 0);
+}
+
+// Every prefix of a file, and every byte flipped past the magic, is
+// rejected and leaves the vault empty
+static void DamagedFiles() {
+    VaultFileOptions options;
+    options.segmentSize = 256;
+    Vault saved = MakeVault(60, 7);
+    CHECK(saveVault(saved, VAULT_PATH, options));
+    std::vector<uint8_t> file = ReadFile(VAULT_PATH);
+    CHECK(file.size() > 1000);
+
+    int accepted = 0;
+    for (size_t size = 8; size < file.size(); size++) {
+        WriteFile(DAMAGED_PATH, file, size);
+        Vault vault;
+        if (loadVault(vault, DAMAGED_PATH) || vault.size() != 0) accepted++;
+    }
+    CHECK(accepted == 0);
+
+    accepted = 0;
+    for (size_t i = 8; i < file.size(); i++) {
+        std::vector<uint8_t> damaged = file;
+        damaged[i] ^= 0xFF;
+        WriteFile(DAMAGED_PATH, damaged);
+        Vault vault;
+        if (loadVault(vault, DAMAGED_PATH) || vault.size() != 0) {
+            if (accepted++ == 0) fprintf(stderr, "  flipped byte %zu accepted\n", i);
+        }
+    }
+    CHECK(accepted == 0);
+}
+
+// '|' in a name or a line break in an entry would not load back as written
+static void UnstorableEntries() {
+    Vault good = MakeVault(10, 3);
+    CHECK(saveVault(good, VAULT_PATH));
+    std::vector<uint8_t> before = ReadFile(VAULT_PATH);
+
+    const char* names[] = {"bad|name", "bad\nname", "fine"};
+    const char* passwords[] = {"secret", "secret", "two\nlines"};
+    for (int i = 0; i < 3; i++) {
+        Vault bad = good;
+        bad.append(names[i], passwords[i], 0);
+        CHECK(!saveVault(bad, VAULT_PATH));
+        CHECK(ReadFile(VAULT_PATH) == before);
+        CHECK(!std::filesystem::exists(std::string(VAULT_PATH) + ".tmp"));
+    }
+
+    // libpassgen turns them away before they reach the library
+    passgen_vault* vault = passgen_vault_create();
+    CHECK(vault != nullptr);
+    if (!vault) return;
+    CHECK(passgen_vault_add(vault, "bad|name", "secret") == PASSGEN_ERROR_ARGUMENT);
+    CHECK(passgen_vault_add(vault, "name", "two\r\nlines") == PASSGEN_ERROR_ARGUMENT);
+    CHECK(passgen_vault_add(vault, "name", "a|b") == PASSGEN_OK);
+    CHECK(passgen_vault_set_password(vault, 0, "bad\nvalue") == PASSGEN_ERROR_ARGUMENT);
+    CHECK(passgen_vault_size(vault) == 1);
+    CHECK(passgen_vault_save(vault, VAULT_PATH) == PASSGEN_OK);
+    CHECK(passgen_vault_load(vault, VAULT_PATH) == PASSGEN_OK);
+    CHECK(passgen_vault_size(vault) == 1);
+    passgen_vault_destroy(vault);
+}
+
+#if !defined(_WIN32)
+// As in a read-only directory, which the test can't rely on when run as
+// root: a lock file that opens read-only, then one that can't be opened
+static void UnlockableVault() {
+    const char* path = "vault_file_test_unlockable.dat";
+    const char* lockPath = "vault_file_test_unlockable.lock";
+    Vault good = MakeVault(10, 4);
+    CHECK(saveVault(good, path));
+    passgen_vault* vault = passgen_vault_create();
+    CHECK(vault != nullptr);
+    if (!vault) return;
+
+    std::filesystem::remove_all(lockPath);
+    std::filesystem::create_directory(lockPath);  // Opens, but not for writing
+    CHECK(passgen_vault_load(vault, path) == PASSGEN_OK && passgen_vault_size(vault) == 10);
+    std::filesystem::remove_all(lockPath);
+    CHECK(symlink("missing/directory/x.lock", lockPath) == 0);  // Can't be created
+    CHECK(passgen_vault_load(vault, path) == PASSGEN_OK && passgen_vault_size(vault) == 10);
+    std::filesystem::remove(lockPath);
+    passgen_vault_destroy(vault);
+}
+#endif
+
+int main() {
+    RoundTrips();
+    LegacyFormat();
+    DamagedFiles();
+    UnstorableEntries();
+#if !defined(_WIN32)
+    UnlockableVault();
+#endif
+    return TestResult("vault_file_test");
+}
@@ -0,0 +1,140 @@
+// Converts a downloaded Have I Been Pwned style SHA-1 corpus into the
+// compact sorted binary file read by BreachDb (src/breach_db.h).
+//
+//   breach_convert <pwned-passwords-sha1-ordered-by-hash.txt> <breach_corpus.bin>
+//   breach_convert --query <breach_corpus.bin> <password>...
+//   breach_convert --bench <breach_corpus.bin> [lookups]
+//
+// Input lines are "<40 hex digits>[:count]", ordered by hash as published.
+// The conversion streams, so memory use stays constant for any corpus size.
+// Put the resulting breach_corpus.bin next to passwords.dat to enable the
+// per-row breach check in the library view.
+
+#include "../src/breach_db.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool ParseDigest(const char* line, Sha1Digest& digest) {
+    for (int i = 0; i < 20; i++) {
+        int hi = HexValue(line[i * 2]);
+        int lo = hi < 0 ? -1 : HexValue(line[i * 2 + 1]);
+        if (lo < 0) return false;
+        digest.bytes[i] = (uint8_t)(hi << 4 | lo);
+    }
+    char end = line[40];
+    return end == ':' || end == '\r' || end == '\n' || end == '\0';
+}
+
+static int Convert(const char* inputPath, const char* outputPath) {
+    FILE* in = fopen(inputPath, "rb");
+    if (!in) {
+        fprintf(stderr, "ERROR: cannot open %s\n", inputPath);
+        return 1;
+    }
+    static char readBuffer[1 << 20];
+    setvbuf(in, readBuffer, _IOFBF, sizeof(readBuffer));
+
+    BreachDbWriter writer;
+    if (!writer.begin(outputPath)) {
+        fprintf(stderr, "ERROR: cannot create %s\n", outputPath);
+        fclose(in);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    char line[256];
+    uint64_t lineNumber = 0, skipped = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineNumber++;
+        Sha1Digest digest;
+        if (!ParseDigest(line, digest)) {
+            skipped++;
+            continue;
+        }
+        if (!writer.add(digest)) {
+            fprintf(stderr, "ERROR: line %llu is out of order; download the corpus ordered by hash or sort it first\n",
+                    (unsigned long long)lineNumber);
+            fclose(in);
+            return 1;
+        }
+        if ((lineNumber & 0xFFFFFF) == 0) fprintf(stderr, "\r%llu hashes...", (unsigned long long)writer.written());
+    }
+    fclose(in);
+
+    if (!writer.finish()) {
+        fprintf(stderr, "ERROR: writing %s failed\n", outputPath);
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "\r%llu hashes written (%llu malformed lines skipped) in %.1f s\n",
+            (unsigned long long)writer.written(), (unsigned long long)skipped, seconds);
+    return 0;
+}
+
+static int Query(const char* dbPath, int count, char** passwords) {
+    BreachDb db;
+    if (!db.open(dbPath)) {
+        fprintf(stderr, "ERROR: %s is not a breach corpus file\n", dbPath);
+        return 1;
+    }
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        bool breached = db.containsPassword(passwords[i]);
+        printf("%s: %s\n", passwords[i], breached ? "BREACHED" : "not found");
+        found += breached;
+    }
+    return found > 0 ? 2 : 0;
+}
+
+// Random lookups: half are known members read back from the file, half random digests
+static int Bench(const char* dbPath, int lookups) {
+    BreachDb db;
+    MappedFile raw;
+    if (!db.open(dbPath) || !raw.open(dbPath)) {
+        fprintf(stderr, "ERROR: %s is not a breach corpus file\n", dbPath);
+        return 1;
+    }
+
+    std::mt19937_64 rng(42);
+    std::vector<Sha1Digest> queries(lookups);
+    const uint8_t* records = raw.data() + sizeof(BreachDbHeader) + BREACH_FANOUT_SIZE * sizeof(uint64_t);
+    for (int i = 0; i < lookups; i++) {
+        if (i % 2 == 0 && db.count() > 0) {
+            memcpy(queries[i].bytes, records + (rng() % db.count()) * 20, 20);
+        } else {
+            for (int b = 0; b < 20; b++) queries[i].bytes[b] = (uint8_t)rng();
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int hits = 0;
+    for (const Sha1Digest& q : queries) hits += db.contains(q);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("records:   %llu\n", (unsigned long long)db.count());
+    printf("lookups:   %d (%d hits)\n", lookups, hits);
+    printf("latency:   %.3f us/lookup\n", seconds * 1e6 / lookups);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && !strcmp(argv[1], "--query")) return Query(argv[2], argc - 3, argv + 3);
+    if (argc >= 3 && !strcmp(argv[1], "--bench")) return Bench(argv[2], argc > 3 ? atoi(argv[3]) : 1000000);
+    if (argc == 3) return Convert(argv[1], argv[2]);
+
+    fprintf(stderr, "usage: %s <hashes.txt> <breach_corpus.bin>\n", argv[0]);
+    fprintf(stderr, "       %s --query <breach_corpus.bin> <password>...\n", argv[0]);
+    fprintf(stderr, "       %s --bench <breach_corpus.bin> [lookups]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,141 @@
+// Builds the in-memory binary fuse filter that BreachDb consults before the
+// exact lookup, and benchmarks it against the plain corpus.
+//
+//   breach_filter <breach_corpus.bin> <breach_corpus.filter>
+//   breach_filter --bench <breach_corpus.bin> <breach_corpus.filter> [queries]
+//
+// The filter is sharded by the top bits of each hash so that building it
+// never holds more than SHARD_KEYS keys (about 30 bytes each while peeling)
+// in memory, whatever the corpus size. Put the resulting file next to
+// breach_corpus.bin; it is ignored if it was built from a different corpus.
+
+#include "../src/breach_db.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static const uint64_t SHARD_KEYS = 1 << 24;
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int Build(const char* dbPath, const char* filterPath) {
+    BreachDb db;
+    if (!db.open(dbPath)) {
+        fprintf(stderr, "ERROR: %s is not a breach corpus file\n", dbPath);
+        return 1;
+    }
+
+    FuseFilterSet filter;
+    filter.sourceCount = db.count();
+    while (filter.shardBits < 16 && (db.count() >> filter.shardBits) > SHARD_KEYS) filter.shardBits++;
+    filter.shards.resize((size_t)1 << filter.shardBits);
+
+    // Records are sorted, so every shard is a contiguous run of the file
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> keys;
+    uint64_t next = 0;
+    for (uint32_t shard = 0; shard < filter.shards.size(); shard++) {
+        keys.clear();
+        for (; next < db.count(); next++) {
+            uint64_t key = BreachFilterKey(db.record(next));
+            if (filter.shardOf(key) != shard) break;
+            if (keys.empty() || keys.back() != key) keys.push_back(key);
+        }
+        if (!filter.shards[shard].populate(keys.data(), (uint32_t)keys.size())) {
+            fprintf(stderr, "ERROR: shard %u did not converge\n", shard);
+            return 1;
+        }
+        if (filter.shards.size() > 1) fprintf(stderr, "\rshard %u/%zu...", shard + 1, filter.shards.size());
+    }
+    double seconds = SecondsSince(start);
+
+    if (!filter.save(filterPath)) {
+        fprintf(stderr, "ERROR: writing %s failed\n", filterPath);
+        return 1;
+    }
+    fprintf(stderr, "\r%llu hashes, %u shard bits, %.1f MB (%.2f bits/hash) built in %.2f s\n",
+            (unsigned long long)db.count(), filter.shardBits, filter.sizeInBytes() / 1048576.0,
+            db.count() ? filter.sizeInBytes() * 8.0 / db.count() : 0.0, seconds);
+    return 0;
+}
+
+// Negative queries are random digests confirmed absent by the exact lookup;
+// positive queries are members read back from the corpus
+static int Bench(const char* dbPath, const char* filterPath, int queries) {
+    BreachDb exact, filtered;
+    FuseFilterSet filter;
+    if (!exact.open(dbPath) || !filtered.open(dbPath) || exact.count() == 0) {
+        fprintf(stderr, "ERROR: %s is not a breach corpus file\n", dbPath);
+        return 1;
+    }
+    auto loadStart = std::chrono::steady_clock::now();
+    if (!filtered.loadFilter(filterPath) || !filter.load(filterPath)) {
+        fprintf(stderr, "ERROR: %s is missing or was built from another corpus\n", filterPath);
+        return 1;
+    }
+    double loadSeconds = SecondsSince(loadStart) / 2;
+
+    std::mt19937_64 rng(7);
+    std::vector<Sha1Digest> negatives, positives(queries);
+    negatives.reserve(queries);
+    while ((int)negatives.size() < queries) {
+        Sha1Digest d;
+        for (int b = 0; b < 20; b++) d.bytes[b] = (uint8_t)rng();
+        if (!exact.contains(d)) negatives.push_back(d);
+    }
+    for (Sha1Digest& d : positives) memcpy(d.bytes, exact.record(rng() % exact.count()), 20);
+
+    int falsePositives = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Sha1Digest& d : negatives) falsePositives += filter.mayContain(BreachFilterKey(d.bytes));
+    double filterOnly = SecondsSince(start);
+
+    int hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (const Sha1Digest& d : negatives) hits += exact.contains(d);
+    double exactNegative = SecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (const Sha1Digest& d : negatives) hits += filtered.contains(d);
+    double filteredNegative = SecondsSince(start);
+
+    int found = 0;
+    start = std::chrono::steady_clock::now();
+    for (const Sha1Digest& d : positives) found += exact.contains(d);
+    double exactPositive = SecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (const Sha1Digest& d : positives) found += filtered.contains(d);
+    double filteredPositive = SecondsSince(start);
+
+    if (hits != 0 || found != 2 * queries) {
+        fprintf(stderr, "ERROR: filtered lookups disagree with the corpus\n");
+        return 1;
+    }
+
+    double us = 1e6 / queries;
+    printf("records:              %llu\n", (unsigned long long)exact.count());
+    printf("filter size:          %.2f MB (%.2f bits/hash), loaded in %.1f ms\n", filter.sizeInBytes() / 1048576.0,
+           filter.sizeInBytes() * 8.0 / exact.count(), loadSeconds * 1000);
+    printf("false positive rate:  %.4f%% (%d of %d)\n", 100.0 * falsePositives / queries, falsePositives, queries);
+    printf("filter query:         %.3f us\n", filterOnly * us);
+    printf("negative, exact only: %.3f us\n", exactNegative * us);
+    printf("negative, filtered:   %.3f us\n", filteredNegative * us);
+    printf("positive, exact only: %.3f us\n", exactPositive * us);
+    printf("positive, filtered:   %.3f us\n", filteredPositive * us);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && !strcmp(argv[1], "--bench")) return Bench(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 1000000);
+    if (argc == 3) return Build(argv[1], argv[2]);
+
+    fprintf(stderr, "usage: %s <breach_corpus.bin> <breach_corpus.filter>\n", argv[0]);
+    fprintf(stderr, "       %s --bench <breach_corpus.bin> <breach_corpus.filter> [queries]\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,135 @@
+// Library agent for scripts: keeps the unlocked library in locked memory and
+// answers password lookups and generation over a Unix domain socket (see
+// src/agent_server.h for the server, src/agent_protocol.h for the protocol).
+//
+//   passgen_agent [--vault passwords.dat] [--socket path] [--allow-uid uid]...
+//
+// The socket defaults to $XDG_RUNTIME_DIR/passgen-agent.sock. Only the user
+// running the agent, and any --allow-uid, may connect. The agent stays in
+// the foreground; start it with & or from a service manager. It reloads the
+// vault file and its journal when the journal changes, e.g. after edits in
+// the GUI or passgen_cli, and on SIGHUP; SIGINT and SIGTERM stop it and
+// remove the socket.
+//
+//   passgen_cli get <service>
+//
+// prints a password from a running agent.
+
+#include "../src/agent_server.h"
+#include "../src/vault.h"
+#include "../src/vault_journal.h"
+#include "../src/vault_sync.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+
+static AgentServer* agent = nullptr;
+static volatile sig_atomic_t stopRequested = 0;
+static volatile sig_atomic_t reloadRequested = 0;
+
+static void OnSignal(int signal) {
+    if (signal == SIGHUP) reloadRequested = 1;
+    else stopRequested = 1;
+    if (agent) agent->wake();
+}
+
+// Vault file plus committed journal edits; the journal is only read, so a
+// running GUI keeps appending to it undisturbed. The vault's lock keeps a
+// compaction from falling between reading the two.
+static bool LoadLibrary(AgentServer& server, const char* vaultPath) {
+    VaultLock lock;
+    if (lock.open(vaultPath)) lock.lock();  // Released when it is closed
+    Vault vault;
+    if (!loadVault(vault, vaultPath)) {
+        fprintf(stderr, "ERROR: cannot read %s\n", vaultPath);
+        return false;
+    }
+    std::string journalPath = journalPathFor(vaultPath);
+    if (!VaultJournal::replay(vault, journalPath.c_str())) {
+        fprintf(stderr, "ERROR: %s changed while it was read\n", journalPath.c_str());
+        for (std::string& password : vault.passwords) secureZero(&password[0], password.size());
+        return false;
+    }
+    if (!server.load(vault)) {
+        fprintf(stderr, "ERROR: cannot allocate memory for %zu entries\n", vault.size());
+        for (std::string& password : vault.passwords) secureZero(&password[0], password.size());
+        return false;
+    }
+    fprintf(stderr, "%zu entries loaded from %s%s\n", server.entryCount(), vaultPath,
+            server.secretsLocked() ? "" : " (memory not locked: over the mlock limit)");
+    return true;
+}
+
+static int Usage(const char* program) {
+    fprintf(stderr, "usage: %s [--vault passwords.dat] [--socket path] [--allow-uid uid]...\n", program);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    const char* vaultPath = "passwords.dat";
+    std::string socketPath = agentSocketPath();
+    AgentServer server;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--vault") && i + 1 < argc) vaultPath = argv[++i];
+        else if (!strcmp(argv[i], "--socket") && i + 1 < argc) socketPath = argv[++i];
+        else if (!strcmp(argv[i], "--allow-uid") && i + 1 < argc) server.allowUid((uid_t)strtoul(argv[++i], nullptr, 10));
+        else return Usage(argv[0]);
+    }
+
+    if (socketPath.empty()) {
+        fprintf(stderr, "ERROR: /tmp/passgen-agent-%u is not a private directory; set XDG_RUNTIME_DIR or pass --socket\n",
+                (unsigned)getuid());
+        return 1;
+    }
+    if (!LoadLibrary(server, vaultPath)) return 1;
+    if (!server.listen(socketPath.c_str())) {
+        fprintf(stderr, "ERROR: cannot listen on %s: %s\n", socketPath.c_str(), strerror(errno));
+        return 1;
+    }
+
+    agent = &server;
+    struct sigaction action = {};
+    action.sa_handler = OnSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGHUP, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    fprintf(stderr, "listening on %s\n", socketPath.c_str());
+
+    // Commits and compactions of other processes wake run(); without the
+    // watch, only SIGHUP reloads
+    VaultWatcher watcher;
+    if (!watcher.watch(journalPathFor(vaultPath)) || !server.watch(watcher.descriptor()))
+        fprintf(stderr, "%s can't be watched; reload with SIGHUP\n", journalPathFor(vaultPath).c_str());
+
+    while (!stopRequested) {
+        if (!server.run()) {
+            fprintf(stderr, "ERROR: epoll: %s\n", strerror(errno));
+            break;
+        }
+        bool journalChanged = watcher.changed();
+        if (reloadRequested || journalChanged) {
+            reloadRequested = 0;
+            // A vault that can't be read keeps the library loaded before
+            LoadLibrary(server, vaultPath);
+        }
+    }
+    fprintf(stderr, "%llu requests served, %llu peers rejected\n", (unsigned long long)server.served,
+            (unsigned long long)server.rejected);
+    agent = nullptr;
+    server.close();
+    return stopRequested ? 0 : 1;
+}
+
+#else
+
+int main() {
+    fprintf(stderr, "ERROR: the agent needs Linux (epoll, SO_PEERCRED)\n");
+    return 1;
+}
+
+#endif
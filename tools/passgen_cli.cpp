@@ -0,0 +1,387 @@
+// Headless access to the password library, for scripts and large jobs.
+//
+//   passgen_cli [--vault passwords.dat] import <export.csv|export.json> [--format csv|json]
+//   passgen_cli [--vault passwords.dat] provision <names.txt|-> [--length N] [--csv <accounts.csv|->]
+//   passgen_cli [--vault passwords.dat] count
+//   passgen_cli [--vault passwords.dat] export <backup.pgb|-> [--compress]
+//   passgen_cli [--vault passwords.dat] restore <backup.pgb|->
+//   passgen_cli [--vault passwords.dat] compact [--codec none|lz4|zstd[:level]]
+//   passgen_cli [--vault passwords.dat] history <service> [--show]
+//   passgen_cli [--vault passwords.dat]... search <text> [--limit N]
+//   passgen_cli get <service> [--socket path]
+//
+// import streams an export of another password manager (see
+// src/vault_import.h) into the vault's journal as one commit; a running GUI
+// merges the entries in as soon as it is committed. The vault file itself
+// is not rewritten.
+//
+// provision reads a list of service names, one per line, and adds each to
+// the vault's journal with a new password of --length characters (16 by
+// default) that has a lowercase and an uppercase letter, a digit and a
+// symbol; all entries as one commit. Names already in the vault are skipped.
+// --csv writes the new entries as "name,password" for a provisioning system
+// once they are committed; the file holds the passwords in the clear.
+//
+// export writes an encrypted backup of the vault and its journal, chunk by
+// chunk, to a file or stdout (e.g. piped into a scheduled upload); restore
+// replaces the vault file from one, streaming the same way (see
+// src/vault_backup.h). The journal starts afresh for the restored file, so
+// a running GUI reloads.
+//
+// compact folds the journal into the vault file and rewrites it with the
+// given segment codec (lz4 by default; zstd needs a build with
+// PASSGEN_HAVE_ZSTD, and so does every build that reads the file after).
+// Entry history is kept, up to the journal's retention limit.
+//
+// history lists the earlier versions of every entry named <service>, newest
+// first, from the journal. Passwords are only printed with --show.
+//
+// search lists the entries of every --vault whose name contains <text>,
+// ignoring case, as "<vault>\t<name>". The vaults are opened lazily and
+// searched through a merged index (see src/vault_set.h). Every other command
+// works on the first --vault.
+//
+// get prints the password of <service> from a running passgen_agent (see
+// tools/passgen_agent.cpp), without reading the vault; Linux only.
+//
+// Commands that read the vault hold its lock (see src/vault_sync.h) until
+// they are done, so a GUI editing it meanwhile waits for them, and they
+// for it.
+
+#include "../src/agent_protocol.h"
+#include "../src/vault.h"
+#include "../src/vault_backup.h"
+#include "../src/vault_import.h"
+#include "../src/vault_journal.h"
+#include "../src/vault_provision.h"
+#include "../src/vault_set.h"
+#include "../src/vault_sync.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <fcntl.h>
+    #include <io.h>
+#endif
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// "-" is stdin/stdout, switched to binary mode where that matters
+static FILE* OpenStream(const char* path, bool write) {
+    if (!strcmp(path, "-")) {
+        FILE* stream = write ? stdout : stdin;
+#if defined(_WIN32)
+        _setmode(_fileno(stream), _O_BINARY);
+#endif
+        return stream;
+    }
+    return fopen(path, write ? "wb" : "rb");
+}
+
+static int Import(Vault& vault, VaultJournal& journal, const char* path, ImportFormat format) {
+    auto start = std::chrono::steady_clock::now();
+    ImportResult result = importVault(vault, &journal, path, format);
+    double seconds = SecondsSince(start);
+    if (!result.ok) {
+        fprintf(stderr, "ERROR: %s: %s\n", path, result.error);
+        return 1;
+    }
+    if (result.shortened > 0) fprintf(stderr, "%zu names cut to %zu bytes\n", result.shortened, MAX_SERVICE_NAME);
+    fprintf(stderr, "%zu entries imported, %zu skipped, %.1f MB in %.2f s (%.1f MB/s)\n", result.imported, result.skipped,
+            result.bytes / 1e6, seconds, seconds > 0.0 ? result.bytes / 1e6 / seconds : 0.0);
+    return 0;
+}
+
+static int Provision(Vault& vault, VaultJournal& journal, const char* path, int length, const char* csvPath) {
+    FILE* in = OpenStream(path, false);
+    if (!in) {
+        fprintf(stderr, "ERROR: cannot open %s\n", path);
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    PasswordGenerator generator;
+    size_t first = vault.size();
+    ProvisionResult result = provisionVault(vault, &journal, in, length, generator);
+    if (in != stdin) fclose(in);
+    if (!result.ok) {
+        fprintf(stderr, "ERROR: %s: %s\n", path, result.error);
+        return 1;
+    }
+    if (csvPath) {
+        FILE* out = OpenStream(csvPath, true);
+        bool ok = out && writeProvisionCsv(vault, first, out);
+        if (out && out != stdout) ok = fclose(out) == 0 && ok;
+        if (!ok) {
+            // The entries are committed; only the copy for the provisioning system is missing
+            fprintf(stderr, "ERROR: cannot write %s; the entries were added\n", csvPath);
+            return 1;
+        }
+    }
+    fprintf(stderr, "%zu entries provisioned, %zu skipped in %.2f s\n", result.created, result.skipped, SecondsSince(start));
+    return 0;
+}
+
+static int Export(const Vault& vault, const char* path, bool compress) {
+    FILE* out = OpenStream(path, true);
+    if (!out) {
+        fprintf(stderr, "ERROR: cannot write %s\n", path);
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool ok = exportVault(vault, out, compress);
+    if (out != stdout) ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "ERROR: writing %s failed\n", path);
+        if (out != stdout) remove(path);
+        return 1;
+    }
+    fprintf(stderr, "%zu entries exported in %.2f s\n", vault.size(), SecondsSince(start));
+    return 0;
+}
+
+static int Restore(const char* vaultPath, const char* path) {
+    FILE* in = OpenStream(path, false);
+    if (!in) {
+        fprintf(stderr, "ERROR: cannot open %s\n", path);
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    RestoreResult result = restoreBackup(in, vaultPath);
+    if (in != stdin) fclose(in);
+    if (!result.ok) {
+        fprintf(stderr, "ERROR: %s: %s\n", path, result.error);
+        return 1;
+    }
+    fprintf(stderr, "%llu entries restored, %llu skipped in %.2f s\n", (unsigned long long)result.restored,
+            (unsigned long long)result.skipped, SecondsSince(start));
+    return 0;
+}
+
+static int Compact(Vault& vault, VaultJournal& journal, const char* vaultPath, const VaultFileOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    if (!saveVault(vault, vaultPath, options) || !journal.reset(vault)) {
+        fprintf(stderr, "ERROR: cannot write %s\n", vaultPath);
+        return 1;
+    }
+    fprintf(stderr, "%zu entries written with %s in %.2f s\n", vault.size(), codecName(options.codec), SecondsSince(start));
+    return 0;
+}
+
+static int History(const Vault& vault, VaultJournal& journal, const char* service, bool show) {
+    size_t found = 0;
+    for (size_t i = 0; i < vault.size(); i++) {
+        if (vault.serviceNames[i] != service) continue;
+        found++;
+        printf("%s (current)\t%s\n", service, show ? vault.passwords[i].c_str() : "");
+        std::string name = vault.serviceNames[i], password = vault.passwords[i];
+        HistoryVersion version;
+        // Bounded: reverted and redone edits can make the chain loop
+        for (size_t depth = 0; depth < journal.historySize() && journal.previousVersion(name, password, version); depth++) {
+            char date[32] = "unknown date";
+            time_t modified = (time_t)version.modifiedAt;
+            if (modified > 0) strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&modified));
+            printf("  -%zu  %s\t%s\t%s\n", depth + 1, date, version.serviceName.c_str(), show ? version.password.c_str() : "");
+            name = version.serviceName;
+            secureZero(&password[0], password.size());
+            password = version.password;
+        }
+        secureZero(&password[0], password.size());
+    }
+    if (found == 0) {
+        fprintf(stderr, "ERROR: no entry named %s\n", service);
+        return 1;
+    }
+    return 0;
+}
+
+static int Search(const std::vector<const char*>& vaultPaths, const char* text, size_t limit) {
+    VaultSet vaults;
+    for (const char* path : vaultPaths) {
+        if (!vaults.open(path)) {
+            std::error_code error;
+            if (!std::filesystem::exists(path, error)) fprintf(stderr, "ERROR: cannot open %s\n", path);
+            else fprintf(stderr, "ERROR: %s is damaged or uses a codec this build lacks\n", path);
+            return 1;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    VaultSearchStats stats;
+    std::vector<VaultMatch> matches = vaults.search(text, limit, &stats);
+    for (const VaultMatch& match : matches) printf("%s\t%s\n", vaults.path(match.vault).c_str(), match.serviceName.c_str());
+    fprintf(stderr, "%zu matches in %.2f s, %zu segments searched, %zu ruled out by the index\n", matches.size(),
+            SecondsSince(start), stats.segmentsSearched, stats.segmentsSkipped);
+    return 0;
+}
+
+static int Get(const char* service, const std::string& socketPath) {
+#if defined(__linux__)
+    AgentClient agent;
+    if (socketPath.empty()) {
+        fprintf(stderr, "ERROR: /tmp/passgen-agent-%u is not a private directory; set XDG_RUNTIME_DIR or pass --socket\n",
+                (unsigned)getuid());
+        return 1;
+    }
+    if (!agent.connect(socketPath.c_str())) {
+        fprintf(stderr, "ERROR: no agent of yours listening on %s\n", socketPath.c_str());
+        return 1;
+    }
+    AgentStatus status;
+    std::string password;
+    if (!agent.request(AGENT_LOOKUP, service, status, password)) {
+        fprintf(stderr, "ERROR: the agent closed the connection\n");
+        return 1;
+    }
+    if (status != AGENT_OK) {
+        fprintf(stderr, "ERROR: no entry named %s\n", service);
+        return 1;
+    }
+    printf("%s\n", password.c_str());
+    secureZero(&password[0], password.size());
+    return 0;
+#else
+    (void)service;
+    (void)socketPath;
+    fprintf(stderr, "ERROR: the agent needs Linux\n");
+    return 1;
+#endif
+}
+
+static int Usage(const char* program) {
+    fprintf(stderr, "usage: %s [--vault passwords.dat] import <export.csv|export.json> [--format csv|json]\n", program);
+    fprintf(stderr, "       %s [--vault passwords.dat] provision <names.txt|-> [--length N] [--csv <accounts.csv|->]\n", program);
+    fprintf(stderr, "       %s [--vault passwords.dat] count\n", program);
+    fprintf(stderr, "       %s [--vault passwords.dat] export <backup.pgb|-> [--compress]\n", program);
+    fprintf(stderr, "       %s [--vault passwords.dat] restore <backup.pgb|->\n", program);
+    fprintf(stderr, "       %s [--vault passwords.dat] compact [--codec none|lz4|zstd[:level]]\n", program);
+    fprintf(stderr, "       %s [--vault passwords.dat] history <service> [--show]\n", program);
+    fprintf(stderr, "       %s [--vault passwords.dat]... search <text> [--limit N]\n", program);
+    fprintf(stderr, "       %s get <service> [--socket path]\n", program);
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> vaultPaths;
+    int arg = 1;
+    while (arg + 1 < argc && !strcmp(argv[arg], "--vault")) {
+        vaultPaths.push_back(argv[arg + 1]);
+        arg += 2;
+    }
+    if (vaultPaths.empty()) vaultPaths.push_back("passwords.dat");
+    const char* vaultPath = vaultPaths[0];
+    if (arg >= argc) return Usage(argv[0]);
+    const char* command = argv[arg++];
+
+    // Asks the agent, which holds the library already
+    if (!strcmp(command, "get") && arg < argc) {
+        const char* service = argv[arg++];
+        std::string socketPath = agentSocketPath();
+        if (arg + 2 == argc && !strcmp(argv[arg], "--socket")) {
+            socketPath = argv[arg + 1];
+            arg += 2;
+        }
+        if (arg != argc) return Usage(argv[0]);
+        return Get(service, socketPath);
+    }
+
+    // Reads the vaults' indexes, not the whole files
+    if (!strcmp(command, "search") && arg < argc) {
+        const char* text = argv[arg++];
+        size_t limit = SIZE_MAX;
+        if (arg + 2 == argc && !strcmp(argv[arg], "--limit")) {
+            limit = (size_t)strtoull(argv[arg + 1], nullptr, 10);
+            arg += 2;
+        }
+        if (arg != argc) return Usage(argv[0]);
+        return Search(vaultPaths, text, limit);
+    }
+
+    VaultLock lock;
+    if (!lock.open(vaultPath) || !lock.lock()) {
+        fprintf(stderr, "ERROR: cannot lock %s\n", lockPathFor(vaultPath).c_str());
+        return 1;
+    }
+
+    // Replaces the file without loading it
+    if (!strcmp(command, "restore")) {
+        if (arg + 1 != argc) return Usage(argv[0]);
+        return Restore(vaultPath, argv[arg]);
+    }
+
+    Vault vault;
+    std::error_code error;
+    if (!loadVault(vault, vaultPath) && std::filesystem::exists(vaultPath, error)) {
+        fprintf(stderr, "ERROR: %s is damaged or uses a codec this build lacks\n", vaultPath);
+        return 1;
+    }
+    VaultJournal journal;
+    std::string journalPath = journalPathFor(vaultPath);
+    if (!journal.open(vault, journalPath.c_str())) {
+        fprintf(stderr, "ERROR: cannot open %s\n", journalPath.c_str());
+        return 1;
+    }
+
+    if (!strcmp(command, "count") && arg == argc) {
+        printf("%zu\n", vault.size());
+        return 0;
+    }
+    if (!strcmp(command, "import") && arg < argc) {
+        const char* path = argv[arg++];
+        ImportFormat format = IMPORT_AUTO;
+        if (arg + 1 < argc && !strcmp(argv[arg], "--format")) {
+            if (!strcmp(argv[arg + 1], "csv")) format = IMPORT_CSV;
+            else if (!strcmp(argv[arg + 1], "json")) format = IMPORT_JSON;
+            else return Usage(argv[0]);
+            arg += 2;
+        }
+        if (arg != argc) return Usage(argv[0]);
+        return Import(vault, journal, path, format);
+    }
+    if (!strcmp(command, "provision") && arg < argc) {
+        const char* path = argv[arg++];
+        int length = PROVISION_DEFAULT_LENGTH;
+        const char* csvPath = nullptr;
+        while (arg + 1 < argc) {
+            if (!strcmp(argv[arg], "--length")) length = atoi(argv[arg + 1]);
+            else if (!strcmp(argv[arg], "--csv")) csvPath = argv[arg + 1];
+            else break;
+            arg += 2;
+        }
+        if (arg != argc || length < 4 || length > 128) return Usage(argv[0]);
+        return Provision(vault, journal, path, length, csvPath);
+    }
+    if (!strcmp(command, "export") && arg < argc) {
+        const char* path = argv[arg++];
+        bool compress = arg < argc && !strcmp(argv[arg], "--compress");
+        if (arg + compress != argc) return Usage(argv[0]);
+        return Export(vault, path, compress);
+    }
+    if (!strcmp(command, "compact")) {
+        VaultFileOptions options;
+        if (arg + 2 == argc && !strcmp(argv[arg], "--codec")) {
+            if (!parseCodec(argv[arg + 1], options.codec, options.level)) {
+                fprintf(stderr, "ERROR: unknown or unavailable codec %s\n", argv[arg + 1]);
+                return 1;
+            }
+            arg += 2;
+        }
+        if (arg != argc) return Usage(argv[0]);
+        return Compact(vault, journal, vaultPath, options);
+    }
+    if (!strcmp(command, "history") && arg < argc) {
+        const char* service = argv[arg++];
+        bool show = arg < argc && !strcmp(argv[arg], "--show");
+        if (arg + show != argc) return Usage(argv[0]);
+        return History(vault, journal, service, show);
+    }
+    return Usage(argv[0]);
+}